@@ -0,0 +1,375 @@
+// NOTE(Ryan): Headless platform for batch simulation and rendering.
+// Drives the game's update_and_render with an offscreen pixel buffer and sound buffer, fed from a recorded
+// .hmi input stream, as fast as the game can run: no window, no vsync, no audio device and no frame timer.
+// Every frame gets a fixed frame_dt and sample count derived from the recording's frame rate, so a run is
+// reproducible on any machine. Frames can be dumped as binary PPM and audio as a 16-bit stereo WAV.
+//
+// usage: headless-hh [--input file.hmi] [--game file.so] [--assets file.hha] [--frames n] [--width w] [--height h]
+//                    [--threads n] [--dump-frames dir] [--dump-every n] [--dump-audio file.wav]
+//                    [--dump-trace file.json]
+//
+// IMPORTANT(Ryan): A recording replays against freshly zeroed game memory. Loop-edit snapshots only live
+// for the process that took them, so record from startup for anything meant to be replayed here.
+
+#define HH_HEADLESS
+#include "hh.h"
+
+#define HEADLESS_DEFAULT_FRAME_RATE 60
+#define HEADLESS_SAMPLES_PER_SECOND 48000
+
+typedef struct {
+  char const* input_file_name;
+  char const* object_file_name;
+  char const* asset_pack_file_name;
+  u64 max_frame_count;
+  uint width;
+  uint height;
+  int thread_count;
+  char const* frame_dump_directory;
+  uint frame_dump_interval;
+  char const* audio_dump_file_name;
+  char const* trace_dump_file_name;
+} HeadlessOptions;
+
+typedef struct {
+  SDL_RWops* handle;
+  u32 sample_count;
+} HeadlessWavWriter;
+
+INTERNAL STATUS
+headless_parse_options(HeadlessOptions* options, int argc, char* argv[argc + 1])
+{
+  options->width = 1920;
+  options->height = 1080;
+  options->thread_count = -1;
+  options->frame_dump_interval = 1;
+
+  for (int arg_i = 1; arg_i < argc; ++arg_i) {
+    char const* option = argv[arg_i];
+    if (arg_i + 1 >= argc) {
+      SDL_LogCritical("Missing value for '%s'", option);
+      return FAILED;
+    }
+    char const* value = argv[++arg_i];
+
+    if (strcmp(option, "--input") == 0) {
+      options->input_file_name = value;
+    } else if (strcmp(option, "--game") == 0) {
+      options->object_file_name = value;
+    } else if (strcmp(option, "--assets") == 0) {
+      options->asset_pack_file_name = value;
+    } else if (strcmp(option, "--frames") == 0) {
+      options->max_frame_count = strtoull(value, NULL, 10);
+    } else if (strcmp(option, "--width") == 0) {
+      options->width = (uint)strtoul(value, NULL, 10);
+    } else if (strcmp(option, "--height") == 0) {
+      options->height = (uint)strtoul(value, NULL, 10);
+    } else if (strcmp(option, "--threads") == 0) {
+      options->thread_count = (int)strtol(value, NULL, 10);
+    } else if (strcmp(option, "--dump-frames") == 0) {
+      options->frame_dump_directory = value;
+    } else if (strcmp(option, "--dump-every") == 0) {
+      options->frame_dump_interval = (uint)strtoul(value, NULL, 10);
+    } else if (strcmp(option, "--dump-audio") == 0) {
+      options->audio_dump_file_name = value;
+    } else if (strcmp(option, "--dump-trace") == 0) {
+      options->trace_dump_file_name = value;
+    } else {
+      SDL_LogCritical("Unknown option '%s'", option);
+      return FAILED;
+    }
+  }
+
+  if (options->width == 0 || options->height == 0 || options->frame_dump_interval == 0) {
+    SDL_LogCritical("Width, height and dump interval must be non-zero");
+    return FAILED;
+  }
+  // NOTE(Ryan): Without a recording there is nothing to end the run, so a frame count is required
+  if (options->input_file_name == NULL && options->max_frame_count == 0) {
+    SDL_LogCritical("Need --input or --frames to know when to stop");
+    return FAILED;
+  }
+
+  return SUCCEEDED;
+}
+
+INTERNAL void
+headless_write_wav_header(HeadlessWavWriter* writer)
+{
+  u32 data_size = writer->sample_count * sizeof(int16) * SDL_AUDIO_CHANNELS;
+  SDL_RWseek(writer->handle, 0, RW_SEEK_SET);
+  SDL_WriteBE32(writer->handle, 0x52494646); // 'RIFF'
+  SDL_WriteLE32(writer->handle, 36 + data_size);
+  SDL_WriteBE32(writer->handle, 0x57415645); // 'WAVE'
+  SDL_WriteBE32(writer->handle, 0x666d7420); // 'fmt '
+  SDL_WriteLE32(writer->handle, 16);
+  SDL_WriteLE16(writer->handle, 1); // PCM
+  SDL_WriteLE16(writer->handle, SDL_AUDIO_CHANNELS);
+  SDL_WriteLE32(writer->handle, HEADLESS_SAMPLES_PER_SECOND);
+  SDL_WriteLE32(writer->handle, HEADLESS_SAMPLES_PER_SECOND * sizeof(int16) * SDL_AUDIO_CHANNELS);
+  SDL_WriteLE16(writer->handle, sizeof(int16) * SDL_AUDIO_CHANNELS);
+  SDL_WriteLE16(writer->handle, 16);
+  SDL_WriteBE32(writer->handle, 0x64617461); // 'data'
+  SDL_WriteLE32(writer->handle, data_size);
+}
+
+INTERNAL STATUS
+headless_open_wav(HeadlessWavWriter* writer, char const* file_name)
+{
+  writer->handle = SDL_RWFromFile(file_name, "wb");
+  if (writer->handle == NULL) {
+    SDL_LogWarn("Unable to create '%s': %s", file_name, SDL_GetError());
+    return FAILED;
+  }
+  writer->sample_count = 0;
+  // NOTE(Ryan): Sizes are unknown until close, so the header is written now and patched then
+  headless_write_wav_header(writer);
+  return SUCCEEDED;
+}
+
+INTERNAL void
+headless_write_wav(HeadlessWavWriter* writer, HHSoundBuffer* sound_buffer)
+{
+  // NOTE(Ryan): Samples are already little endian S16 on every platform we build for
+  SDL_RWwrite(writer->handle, sound_buffer->samples, sizeof(int16) * SDL_AUDIO_CHANNELS, sound_buffer->sample_count);
+  writer->sample_count += sound_buffer->sample_count;
+}
+
+INTERNAL void
+headless_close_wav(HeadlessWavWriter* writer)
+{
+  headless_write_wav_header(writer);
+  SDL_RWclose(writer->handle);
+  writer->handle = NULL;
+}
+
+// NOTE(Ryan): Pixels are 0xXXRRGGBB words, written out as packed RGB rows
+INTERNAL STATUS
+headless_dump_frame(HHPixelBuffer* pixel_buffer, u8* row_scratch, char const* directory, u64 frame_index)
+{
+  char file_name[512] = {0};
+  snprintf(file_name, sizeof(file_name), "%s/frame-%06llu.ppm", directory, (unsigned long long)frame_index);
+  SDL_RWops* handle = SDL_RWFromFile(file_name, "wb");
+  if (handle == NULL) {
+    SDL_LogWarn("Unable to create '%s': %s", file_name, SDL_GetError());
+    return FAILED;
+  }
+
+  char header[64] = {0};
+  int header_size = snprintf(header, sizeof(header), "P6\n%u %u\n255\n", pixel_buffer->width, pixel_buffer->height);
+  SDL_RWwrite(handle, header, 1, header_size);
+
+  STATUS result = SUCCEEDED;
+  u8* row = (u8 *)pixel_buffer->memory;
+  for (uint y = 0; y < pixel_buffer->height; ++y) {
+    u32* pixel = (u32 *)row;
+    u8* rgb = row_scratch;
+    for (uint x = 0; x < pixel_buffer->width; ++x) {
+      *rgb++ = (u8)(pixel[x] >> 16);
+      *rgb++ = (u8)(pixel[x] >> 8);
+      *rgb++ = (u8)pixel[x];
+    }
+    if (SDL_RWwrite(handle, row_scratch, 3, pixel_buffer->width) != pixel_buffer->width) {
+      SDL_LogWarn("Unable to write '%s': %s", file_name, SDL_GetError());
+      result = FAILED;
+      break;
+    }
+    row += pixel_buffer->pitch;
+  }
+
+  SDL_RWclose(handle);
+  return result;
+}
+
+int
+main(int argc, char* argv[argc + 1])
+{
+  SDL_LogSetAllPriority(SDL_LOG_PRIORITY_WARN);
+
+  HeadlessOptions options = {0};
+  if (headless_parse_options(&options, argc, argv) == FAILED) {
+    SDL_LogCritical("usage: %s [--input file.hmi] [--game file.so] [--assets file.hha] [--frames n] [--width w] [--height h] "
+                    "[--threads n] [--dump-frames dir] [--dump-every n] [--dump-audio file.wav] [--dump-trace file.json]", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // NOTE(Ryan): No subsystems; shared objects, files, threads and the performance counter need none
+  if (SDL_Init(0) < 0) {
+    SDL_LogCritical("Unable to initialize SDL: %s", SDL_GetError());
+    return EXIT_FAILURE;
+  }
+  sdl_get_info();
+  if (options.object_file_name != NULL) {
+    snprintf(sdl_info.abs_object_file_name, sizeof(sdl_info.abs_object_file_name), "%s", options.object_file_name);
+  }
+
+  SDLHHApi hh_api = {0};
+  if (sdl_load_hh_api(&hh_api) == FAILED) {
+    return EXIT_FAILURE;
+  }
+
+  SDLInputStream input_stream = {0};
+  bool have_input_stream = false;
+  u32 frame_rate = HEADLESS_DEFAULT_FRAME_RATE;
+  if (options.input_file_name != NULL) {
+    if (sdl_open_input_stream_for_read(&input_stream, options.input_file_name) == FAILED) {
+      return EXIT_FAILURE;
+    }
+    have_input_stream = true;
+    frame_rate = (input_stream.frame_rate != 0) ? input_stream.frame_rate : HEADLESS_DEFAULT_FRAME_RATE;
+    if (input_stream.build_id != hh_api.last_modification_time) {
+      SDL_LogWarn("Recording '%s' was made with a different game build", options.input_file_name);
+    }
+    if (options.max_frame_count == 0 || options.max_frame_count > input_stream.frame_count) {
+      options.max_frame_count = input_stream.frame_count;
+    }
+  }
+
+  HHMemory memory = {0};
+  memory.permanent_storage_size = MEGABYTES(64);
+  memory.transient_storage_size = GIGABYTES(1);
+  u64 total_memory_size = memory.permanent_storage_size + memory.transient_storage_size;
+  // NOTE(Ryan): Same base as the windowed build, so pointers in game state match between the two
+  memory.permanent_storage = sdl_reserve_memory_block(total_memory_size, SDL_HH_MEMORY_BASE_ADDRESS);
+  if (memory.permanent_storage == NULL) {
+    SDL_LogCritical("Unable to allocate %llu bytes of hh memory: %s", (unsigned long long)total_memory_size, strerror(errno));
+    return EXIT_FAILURE;
+  }
+  memory.transient_storage = ((u8 *)memory.permanent_storage + memory.permanent_storage_size);
+  // NOTE(Ryan): The game module picks its row kernels from this on its first frame (hh_bind_render_kernels)
+  memory.cpu_features = sdl_info.cpu_features;
+  memory.cache_line_size = sdl_info.l1_cache_line_size;
+  memory.platform_debug_write_entire_file = platform_debug_write_entire_file;
+
+  HHAssetPack asset_pack = {0};
+  char asset_pack_file_name[512] = {0};
+  if (options.asset_pack_file_name != NULL) {
+    snprintf(asset_pack_file_name, sizeof(asset_pack_file_name), "%s", options.asset_pack_file_name);
+  } else {
+    snprintf(asset_pack_file_name, sizeof(asset_pack_file_name), "%s%s", sdl_info.base_path, SDL_HH_ASSET_PACK_FILE_NAME);
+  }
+  // NOTE(Ryan): An explicitly named pack is required, the default one is not
+  if (sdl_open_asset_pack(&asset_pack, asset_pack_file_name) == FAILED && options.asset_pack_file_name != NULL) {
+    return EXIT_FAILURE;
+  }
+  memory.asset_pack = &asset_pack;
+  memory.asset_stream = sdl_create_asset_stream(&asset_pack, asset_pack_file_name);
+  memory.platform_begin_asset_read = platform_begin_asset_read;
+
+  // NOTE(Ryan): --threads 0 runs everything on this thread; default is one per logical core
+  uint thread_count = (options.thread_count < 0) ? (uint)sdl_info.num_logical_cores : (uint)options.thread_count;
+  if (thread_count > 0) {
+    memory.job_queue = sdl_create_job_queue(thread_count);
+    if (memory.job_queue == NULL) {
+      SDL_LogWarn("Unable to create job queue, running single threaded");
+    } else {
+      memory.job_queue_thread_count = memory.job_queue->thread_count;
+    }
+  }
+  memory.platform_add_job = platform_add_job;
+  memory.platform_wait_for_jobs = platform_wait_for_jobs;
+  memory.platform_get_thread_index = platform_get_thread_index;
+
+#if defined(HH_PROFILE)
+  SDLProfiler* profiler = sdl_create_profiler();
+  if (profiler != NULL) {
+    memory.profiler = &profiler->profiler;
+  }
+  hh_bind_profiler(&memory);
+#else
+  if (options.trace_dump_file_name != NULL) {
+    SDL_LogWarn("Built without HH_PROFILE, no trace will be written");
+  }
+#endif
+
+  HHPixelBuffer pixel_buffer = {0};
+  pixel_buffer.width = options.width;
+  pixel_buffer.height = options.height;
+  pixel_buffer.pitch = options.width * BYTES_PER_PIXEL;
+  pixel_buffer.memory = calloc(pixel_buffer.pitch * pixel_buffer.height, 1);
+
+  HHSoundBuffer sound_buffer = {0};
+  sound_buffer.samples_per_second = HEADLESS_SAMPLES_PER_SECOND;
+  sound_buffer.samples = calloc(HEADLESS_SAMPLES_PER_SECOND / frame_rate + 1, sizeof(int16) * SDL_AUDIO_CHANNELS);
+
+  u8* row_scratch = malloc(options.width * 3);
+  if (pixel_buffer.memory == NULL || sound_buffer.samples == NULL || row_scratch == NULL) {
+    SDL_LogCritical("Unable to allocate headless buffers: %s", strerror(errno));
+    return EXIT_FAILURE;
+  }
+
+  HeadlessWavWriter wav_writer = {0};
+  bool have_wav_writer = (options.audio_dump_file_name != NULL) &&
+                         headless_open_wav(&wav_writer, options.audio_dump_file_name) == SUCCEEDED;
+
+  HHInput input = {0};
+  input.controllers[0].is_connected = true;
+  float frame_dt = 1.0f / frame_rate;
+
+  u64 start_counter = SDL_GetPerformanceCounter();
+  u64 frame_index = 0;
+  for (; frame_index < options.max_frame_count; ++frame_index) {
+    if (have_input_stream && !sdl_read_input_stream(&input_stream, &input)) {
+      SDL_LogWarn("Recording '%s' ended early at frame %llu", options.input_file_name, (unsigned long long)frame_index);
+      break;
+    }
+    // NOTE(Ryan): Recorded frame_dt is what the game saw live, so keep it; only synthesise it when missing
+    if (!have_input_stream || input.frame_dt <= 0.0f) {
+      input.frame_dt = frame_dt;
+    }
+
+    // NOTE(Ryan): Integer running total, so a rate that does not divide the sample rate does not drift
+    u64 samples_before = (frame_index * HEADLESS_SAMPLES_PER_SECOND) / frame_rate;
+    u64 samples_after = ((frame_index + 1) * HEADLESS_SAMPLES_PER_SECOND) / frame_rate;
+    sound_buffer.sample_count = (uint)(samples_after - samples_before);
+
+    {
+      TIMED_BLOCK("update_and_render");
+      hh_api.update_and_render(&pixel_buffer, &input, &sound_buffer, &memory);
+    }
+
+    // NOTE(Ryan): No devices to rumble
+    memset(memory.rumble_requests, 0, sizeof(memory.rumble_requests));
+
+    if (options.frame_dump_directory != NULL && (frame_index % options.frame_dump_interval) == 0) {
+      headless_dump_frame(&pixel_buffer, row_scratch, options.frame_dump_directory, frame_index);
+    }
+    if (have_wav_writer) {
+      headless_write_wav(&wav_writer, &sound_buffer);
+    }
+
+#if defined(HH_PROFILE)
+    if (profiler != NULL) {
+      sdl_profiler_end_frame(profiler);
+    }
+#endif
+  }
+  u64 elapsed_ticks = SDL_GetPerformanceCounter() - start_counter;
+
+  double elapsed_seconds = (double)elapsed_ticks / SDL_GetPerformanceFrequency();
+  printf("%llu frames in %.3fs (%.1f frames/s)\n", (unsigned long long)frame_index, elapsed_seconds,
+         (elapsed_seconds > 0.0) ? frame_index / elapsed_seconds : 0.0);
+
+#if defined(HH_PROFILE)
+  if (profiler != NULL && options.trace_dump_file_name != NULL) {
+    sdl_write_profiler_trace(profiler, options.trace_dump_file_name);
+  }
+#endif
+  if (have_wav_writer) {
+    headless_close_wav(&wav_writer);
+  }
+  if (have_input_stream) {
+    sdl_close_input_stream(&input_stream);
+  }
+  if (memory.job_queue != NULL) {
+    sdl_destroy_job_queue(memory.job_queue);
+  }
+  sdl_unload_hh_api(&hh_api);
+  if (memory.asset_stream != NULL) {
+    sdl_destroy_asset_stream(memory.asset_stream);
+  }
+  sdl_close_asset_pack(&asset_pack);
+  SDL_Quit();
+
+  return 0;
+}
@@ -0,0 +1,183 @@
+// NOTE(Ryan): Bump allocators over HHMemory storage. Nothing here ever calls malloc;
+// memory is returned by rewinding an arena to a marker or ending a temporary memory scope.
+
+#include <stdalign.h>
+
+#define HH_ARENA_DEFAULT_ALIGNMENT 16
+
+typedef struct {
+  u8* base;
+  size_t size;
+  size_t used;
+  uint temp_count;
+#if defined(DEBUG)
+  char const* name;
+  size_t high_water_mark;
+#endif
+} HHMemoryArena;
+
+typedef struct {
+  HHMemoryArena* arena;
+  size_t used;
+} HHTemporaryMemory;
+
+#define HH_ARENA_PUSH_STRUCT(arena, type) \
+  ((type *)hh_arena_push_size_aligned((arena), sizeof(type), alignof(type)))
+#define HH_ARENA_PUSH_ARRAY(arena, count, type) \
+  ((type *)hh_arena_push_size_aligned((arena), (count) * sizeof(type), alignof(type)))
+
+INTERNAL void
+hh_arena_init(HHMemoryArena* arena, char const* name, void* base, size_t size)
+{
+  arena->base = (u8 *)base;
+  arena->size = size;
+  arena->used = 0;
+  arena->temp_count = 0;
+#if defined(DEBUG)
+  arena->name = name;
+  arena->high_water_mark = 0;
+#else
+  (void)name;
+#endif
+}
+
+INTERNAL size_t
+hh_arena_alignment_offset(HHMemoryArena* arena, size_t alignment)
+{
+  HH_ASSERT((alignment & (alignment - 1)) == 0);
+
+  uintptr_t next_address = (uintptr_t)(arena->base + arena->used);
+  size_t alignment_mask = alignment - 1;
+  return (next_address & alignment_mask) ? alignment - (next_address & alignment_mask) : 0;
+}
+
+INTERNAL size_t
+hh_arena_size_remaining(HHMemoryArena* arena, size_t alignment)
+{
+  size_t alignment_offset = hh_arena_alignment_offset(arena, alignment);
+  return (arena->used + alignment_offset < arena->size) ? arena->size - (arena->used + alignment_offset) : 0;
+}
+
+INTERNAL void*
+hh_arena_push_size_aligned(HHMemoryArena* arena, size_t size, size_t alignment)
+{
+  size_t alignment_offset = hh_arena_alignment_offset(arena, alignment);
+  HH_ASSERT(arena->used + alignment_offset + size <= arena->size);
+
+  void* result = arena->base + arena->used + alignment_offset;
+  arena->used += alignment_offset + size;
+
+#if defined(DEBUG)
+  if (arena->used > arena->high_water_mark) {
+    arena->high_water_mark = arena->used;
+  }
+#endif
+
+  return result;
+}
+
+INTERNAL void*
+hh_arena_push_size(HHMemoryArena* arena, size_t size)
+{
+  return hh_arena_push_size_aligned(arena, size, HH_ARENA_DEFAULT_ALIGNMENT);
+}
+
+INTERNAL void*
+hh_arena_push_copy(HHMemoryArena* arena, void const* source, size_t size)
+{
+  void* result = hh_arena_push_size(arena, size);
+  memcpy(result, source, size);
+  return result;
+}
+
+// NOTE(Ryan): Markers give stack-style push/pop without a temporary memory scope
+INTERNAL size_t
+hh_arena_get_marker(HHMemoryArena* arena)
+{
+  return arena->used;
+}
+
+INTERNAL void
+hh_arena_pop_to_marker(HHMemoryArena* arena, size_t marker)
+{
+  HH_ASSERT(marker <= arena->used);
+  arena->used = marker;
+}
+
+INTERNAL void
+hh_arena_clear(HHMemoryArena* arena)
+{
+  HH_ASSERT(arena->temp_count == 0);
+  arena->used = 0;
+}
+
+INTERNAL HHTemporaryMemory
+hh_begin_temporary_memory(HHMemoryArena* arena)
+{
+  HHTemporaryMemory result = {0};
+  result.arena = arena;
+  result.used = arena->used;
+  ++arena->temp_count;
+
+  return result;
+}
+
+INTERNAL void
+hh_end_temporary_memory(HHTemporaryMemory temporary_memory)
+{
+  HHMemoryArena* arena = temporary_memory.arena;
+  HH_ASSERT(arena->used >= temporary_memory.used);
+  HH_ASSERT(arena->temp_count > 0);
+
+  arena->used = temporary_memory.used;
+  --arena->temp_count;
+}
+
+// NOTE(Ryan): Call at the end of a frame to catch scopes that were never ended
+INTERNAL void
+hh_arena_check(HHMemoryArena* arena)
+{
+#if defined(DEBUG)
+  HH_ASSERT(arena->temp_count == 0);
+#else
+  (void)arena;
+#endif
+}
+
+INTERNAL void
+hh_arena_sub_arena(HHMemoryArena* sub_arena, char const* name, HHMemoryArena* arena, size_t size, size_t alignment)
+{
+  hh_arena_init(sub_arena, name, hh_arena_push_size_aligned(arena, size, alignment), size);
+}
+
+// NOTE(Ryan): One scratch arena per job queue thread so jobs can allocate without synchronisation.
+// Padded to a cache line as each arena's 'used' is written by a different core.
+
+typedef struct {
+  alignas(64) HHMemoryArena arena;
+} HHThreadArena;
+
+typedef struct {
+  uint thread_count;
+  HHThreadArena thread_arenas[HH_MAX_JOB_THREADS];
+} HHThreadArenas;
+
+INTERNAL void
+hh_init_thread_arenas(HHThreadArenas* thread_arenas, HHMemoryArena* arena, uint thread_count, size_t size_per_thread)
+{
+  HH_ASSERT(thread_count <= HH_MAX_JOB_THREADS);
+
+  thread_arenas->thread_count = thread_count;
+  for (uint thread_i = 0; thread_i < thread_count; ++thread_i) {
+    hh_arena_sub_arena(&thread_arenas->thread_arenas[thread_i].arena, "thread", arena, size_per_thread, 64);
+  }
+}
+
+INTERNAL HHMemoryArena*
+hh_get_thread_arena(HHMemory* memory, HHThreadArenas* thread_arenas)
+{
+  uint thread_index = (memory->platform_get_thread_index != NULL) ? memory->platform_get_thread_index() : 0;
+  HH_ASSERT(thread_index < thread_arenas->thread_count);
+
+  return &thread_arenas->thread_arenas[thread_index].arena;
+}
@@ -0,0 +1,493 @@
+// NOTE(Ryan): Streams assets out of the pack into a fixed budget carved from transient storage.
+// hh_request_asset() either hands back the cached copy or queues the asset and returns NULL; the game keeps
+// drawing whatever it has and picks the asset up on a later frame. Once a frame, hh_update_asset_cache()
+// collects finished reads and starts new ones, highest priority first, with at most
+// HH_ASSET_CACHE_MAX_IN_FLIGHT reads outstanding. Asking again for a queued or loading asset is free (and can
+// only raise its priority), so there is never more than one read per asset.
+//
+// Memory is an address ordered list of blocks, allocated first fit. When nothing fits, loaded assets are
+// evicted least recently used first and their blocks merged with free neighbours, but never an asset used in
+// the current frame. So a pointer from hh_request_asset() stays valid until the next hh_update_asset_cache().
+//
+// Without a platform stream every request is served straight from the pack mapping, with no copy.
+
+#define HH_ASSET_ID_NONE UINT32_MAX
+#define HH_ASSET_CACHE_MAX_IN_FLIGHT 16
+// NOTE(Ryan): Also the header size, so every payload starts on a pack aligned boundary
+#define HH_ASSET_CACHE_ALIGNMENT HH_ASSET_PAYLOAD_ALIGNMENT
+
+typedef enum {
+  HH_ASSET_PRIORITY_LOW,
+  HH_ASSET_PRIORITY_NORMAL,
+  HH_ASSET_PRIORITY_HIGH,
+  HH_ASSET_PRIORITY_COUNT
+} HHAssetPriority;
+
+typedef enum {
+  HH_ASSET_STATE_UNLOADED,
+  HH_ASSET_STATE_QUEUED,
+  HH_ASSET_STATE_LOADING,
+  HH_ASSET_STATE_LOADED
+} HHAssetState;
+
+typedef struct HHAssetBlock {
+  struct HHAssetBlock* prev;
+  struct HHAssetBlock* next;
+  // NOTE(Ryan): Including this header
+  u64 size;
+  u32 asset_id;
+  bool is_used;
+} HHAssetBlock;
+
+_Static_assert(sizeof(HHAssetBlock) <= HH_ASSET_CACHE_ALIGNMENT, "asset block header outgrew its alignment");
+
+typedef struct {
+  u32 state;
+  u32 priority;
+  u32 heap_index;
+  // NOTE(Ryan): Most recently used at the head, linked by asset id while loaded
+  u32 lru_prev;
+  u32 lru_next;
+  u64 request_sequence;
+  u64 last_used_frame;
+  HHAssetBlock* block;
+} HHCachedAsset;
+
+typedef struct {
+  u32 asset_id;
+  HHAssetRead read;
+} HHAssetCacheRead;
+
+typedef struct {
+  u64 request_count;
+  u64 hit_count;
+  u64 miss_count;
+  // NOTE(Ryan): Requests for an asset that was already queued or loading
+  u64 dedup_count;
+  u64 load_count;
+  u64 failed_load_count;
+  // NOTE(Ryan): Reads the platform dropped before starting them, which are simply requested again
+  u64 cancelled_load_count;
+  u64 eviction_count;
+  u64 loaded_bytes;
+  u64 evicted_bytes;
+  // NOTE(Ryan): Frames where the best queued asset could not be given memory
+  u64 stall_count;
+} HHAssetCacheStats;
+
+typedef struct {
+  HHAssetPack const* pack;
+  HHAssetStream* stream;
+  HHPlatformBeginAssetRead* platform_begin_asset_read;
+
+  HHCachedAsset* assets;
+  u64 frame_index;
+  u64 request_sequence;
+
+  // NOTE(Ryan): Binary max heap of queued asset ids
+  u32* queue;
+  u32 queue_count;
+
+  u32 lru_head;
+  u32 lru_tail;
+
+  HHAssetCacheRead reads[HH_ASSET_CACHE_MAX_IN_FLIGHT];
+  u32 read_count;
+
+  HHAssetBlock sentinel;
+  u64 budget;
+  u64 used_bytes;
+
+  HHAssetCacheStats stats;
+} HHAssetCache;
+
+INTERNAL u32
+hh_get_asset_id(HHAssetPack const* pack, char const* name)
+{
+  HHAssetEntry const* entry = hh_find_asset(pack, name);
+  return (entry != NULL) ? (u32)(entry - pack->entries) : HH_ASSET_ID_NONE;
+}
+
+INTERNAL bool
+hh_asset_cache_is_before(HHAssetCache* cache, u32 first_id, u32 second_id)
+{
+  HHCachedAsset* first = &cache->assets[first_id];
+  HHCachedAsset* second = &cache->assets[second_id];
+  if (first->priority != second->priority) {
+    return first->priority > second->priority;
+  }
+  return first->request_sequence < second->request_sequence;
+}
+
+INTERNAL void
+hh_asset_cache_swap_queue(HHAssetCache* cache, u32 first_index, u32 second_index)
+{
+  SWAP(cache->queue[first_index], cache->queue[second_index]);
+  cache->assets[cache->queue[first_index]].heap_index = first_index;
+  cache->assets[cache->queue[second_index]].heap_index = second_index;
+}
+
+INTERNAL void
+hh_asset_cache_sift_up(HHAssetCache* cache, u32 heap_index)
+{
+  while (heap_index > 0) {
+    u32 parent_index = (heap_index - 1) / 2;
+    if (!hh_asset_cache_is_before(cache, cache->queue[heap_index], cache->queue[parent_index])) {
+      break;
+    }
+    hh_asset_cache_swap_queue(cache, heap_index, parent_index);
+    heap_index = parent_index;
+  }
+}
+
+INTERNAL u32
+hh_asset_cache_pop_queue(HHAssetCache* cache)
+{
+  u32 asset_id = cache->queue[0];
+  hh_asset_cache_swap_queue(cache, 0, --cache->queue_count);
+
+  u32 heap_index = 0;
+  while (true) {
+    u32 best_index = heap_index;
+    u32 left_index = heap_index * 2 + 1;
+    u32 right_index = left_index + 1;
+    if (left_index < cache->queue_count && hh_asset_cache_is_before(cache, cache->queue[left_index], cache->queue[best_index])) {
+      best_index = left_index;
+    }
+    if (right_index < cache->queue_count && hh_asset_cache_is_before(cache, cache->queue[right_index], cache->queue[best_index])) {
+      best_index = right_index;
+    }
+    if (best_index == heap_index) {
+      break;
+    }
+    hh_asset_cache_swap_queue(cache, heap_index, best_index);
+    heap_index = best_index;
+  }
+
+  return asset_id;
+}
+
+INTERNAL void
+hh_asset_cache_unlink_lru(HHAssetCache* cache, u32 asset_id)
+{
+  HHCachedAsset* asset = &cache->assets[asset_id];
+  if (asset->lru_prev != HH_ASSET_ID_NONE) {
+    cache->assets[asset->lru_prev].lru_next = asset->lru_next;
+  } else {
+    cache->lru_head = asset->lru_next;
+  }
+  if (asset->lru_next != HH_ASSET_ID_NONE) {
+    cache->assets[asset->lru_next].lru_prev = asset->lru_prev;
+  } else {
+    cache->lru_tail = asset->lru_prev;
+  }
+  asset->lru_prev = asset->lru_next = HH_ASSET_ID_NONE;
+}
+
+INTERNAL void
+hh_asset_cache_push_lru(HHAssetCache* cache, u32 asset_id)
+{
+  HHCachedAsset* asset = &cache->assets[asset_id];
+  asset->lru_prev = HH_ASSET_ID_NONE;
+  asset->lru_next = cache->lru_head;
+  if (cache->lru_head != HH_ASSET_ID_NONE) {
+    cache->assets[cache->lru_head].lru_prev = asset_id;
+  } else {
+    cache->lru_tail = asset_id;
+  }
+  cache->lru_head = asset_id;
+}
+
+INTERNAL HHAssetBlock*
+hh_asset_cache_find_block(HHAssetCache* cache, u64 size)
+{
+  for (HHAssetBlock* block = cache->sentinel.next; block != &cache->sentinel; block = block->next) {
+    if (!block->is_used && block->size >= size) {
+      // NOTE(Ryan): Split unless the remainder could not hold even a header and one aligned payload line
+      if (block->size - size >= 2 * HH_ASSET_CACHE_ALIGNMENT) {
+        HHAssetBlock* remainder = (HHAssetBlock *)((u8 *)block + size);
+        remainder->size = block->size - size;
+        remainder->is_used = false;
+        remainder->prev = block;
+        remainder->next = block->next;
+        block->next->prev = remainder;
+        block->next = remainder;
+        block->size = size;
+      }
+      block->is_used = true;
+      return block;
+    }
+  }
+  return NULL;
+}
+
+INTERNAL void
+hh_asset_cache_merge_block(HHAssetCache* cache, HHAssetBlock* block)
+{
+  HHAssetBlock* next = block->next;
+  if (next != &cache->sentinel && !next->is_used) {
+    block->size += next->size;
+    block->next = next->next;
+    next->next->prev = block;
+  }
+}
+
+INTERNAL void
+hh_asset_cache_free_block(HHAssetCache* cache, HHAssetBlock* block)
+{
+  block->is_used = false;
+  hh_asset_cache_merge_block(cache, block);
+  if (block->prev != &cache->sentinel && !block->prev->is_used) {
+    hh_asset_cache_merge_block(cache, block->prev);
+  }
+}
+
+INTERNAL void
+hh_asset_cache_evict(HHAssetCache* cache, u32 asset_id)
+{
+  HHCachedAsset* asset = &cache->assets[asset_id];
+  hh_asset_cache_unlink_lru(cache, asset_id);
+  cache->used_bytes -= asset->block->size;
+  cache->stats.evicted_bytes += asset->block->size;
+  ++cache->stats.eviction_count;
+  hh_asset_cache_free_block(cache, asset->block);
+  asset->block = NULL;
+  asset->state = HH_ASSET_STATE_UNLOADED;
+}
+
+// NOTE(Ryan): Header plus payload, rounded up to the alignment
+INTERNAL u64
+hh_asset_cache_block_size(u64 payload_size)
+{
+  return HH_ASSET_CACHE_ALIGNMENT + ((payload_size + HH_ASSET_CACHE_ALIGNMENT - 1) & ~(u64)(HH_ASSET_CACHE_ALIGNMENT - 1));
+}
+
+// NOTE(Ryan): Evicts from the cold end until the size fits; NULL if only assets in use this frame are left.
+// The caller rules out sizes over the whole budget, which no amount of eviction would fit.
+INTERNAL HHAssetBlock*
+hh_asset_cache_allocate(HHAssetCache* cache, u64 payload_size)
+{
+  u64 size = hh_asset_cache_block_size(payload_size);
+
+  HHAssetBlock* block = hh_asset_cache_find_block(cache, size);
+  while (block == NULL && cache->lru_tail != HH_ASSET_ID_NONE &&
+         cache->assets[cache->lru_tail].last_used_frame < cache->frame_index) {
+    hh_asset_cache_evict(cache, cache->lru_tail);
+    block = hh_asset_cache_find_block(cache, size);
+  }
+  if (block != NULL) {
+    cache->used_bytes += block->size;
+  }
+  return block;
+}
+
+INTERNAL bool
+hh_init_asset_cache(HHAssetCache* cache, HHMemory* memory, HHMemoryArena* arena, u64 budget)
+{
+  memset(cache, 0, sizeof(*cache));
+  cache->pack = memory->asset_pack;
+  cache->stream = memory->asset_stream;
+  cache->platform_begin_asset_read = memory->platform_begin_asset_read;
+  cache->lru_head = cache->lru_tail = HH_ASSET_ID_NONE;
+  for (u32 read_i = 0; read_i < HH_ASSET_CACHE_MAX_IN_FLIGHT; ++read_i) {
+    cache->reads[read_i].asset_id = HH_ASSET_ID_NONE;
+  }
+  cache->sentinel.next = cache->sentinel.prev = &cache->sentinel;
+  cache->sentinel.is_used = true;
+
+  u32 asset_count = (cache->pack != NULL) ? cache->pack->asset_count : 0;
+  if (asset_count == 0) {
+    return true;
+  }
+  cache->assets = HH_ARENA_PUSH_ARRAY(arena, asset_count, HHCachedAsset);
+  cache->queue = HH_ARENA_PUSH_ARRAY(arena, asset_count, u32);
+  for (u32 asset_i = 0; asset_i < asset_count; ++asset_i) {
+    HHCachedAsset* asset = &cache->assets[asset_i];
+    memset(asset, 0, sizeof(*asset));
+    asset->lru_prev = asset->lru_next = HH_ASSET_ID_NONE;
+  }
+
+  // NOTE(Ryan): The budget only matters when streaming; the mapping is used directly otherwise.
+  // It is clamped to what the arena has left.
+  if (cache->stream != NULL) {
+    u64 size_remaining = hh_arena_size_remaining(arena, HH_ASSET_CACHE_ALIGNMENT);
+    budget = (budget < size_remaining) ? budget : size_remaining;
+    budget &= ~(u64)(HH_ASSET_CACHE_ALIGNMENT - 1);
+    if (budget < 2 * HH_ASSET_CACHE_ALIGNMENT) {
+      return false;
+    }
+    HHAssetBlock* block = (HHAssetBlock *)hh_arena_push_size_aligned(arena, budget, HH_ASSET_CACHE_ALIGNMENT);
+    block->size = budget;
+    block->is_used = false;
+    block->prev = block->next = &cache->sentinel;
+    cache->sentinel.next = cache->sentinel.prev = block;
+    cache->budget = budget;
+  }
+
+  return true;
+}
+
+// NOTE(Ryan): The asset's bytes, laid out as in the pack, or NULL while it is on its way
+INTERNAL void const*
+hh_request_asset(HHAssetCache* cache, u32 asset_id, HHAssetPriority priority)
+{
+  if (cache->pack == NULL || asset_id >= cache->pack->asset_count) {
+    return NULL;
+  }
+  ++cache->stats.request_count;
+  HHAssetEntry const* entry = &cache->pack->entries[asset_id];
+  if (cache->stream == NULL) {
+    ++cache->stats.hit_count;
+    return hh_get_asset_payload(cache->pack, entry);
+  }
+
+  HHCachedAsset* asset = &cache->assets[asset_id];
+  asset->last_used_frame = cache->frame_index;
+  switch (asset->state) {
+    case HH_ASSET_STATE_LOADED: {
+      ++cache->stats.hit_count;
+      hh_asset_cache_unlink_lru(cache, asset_id);
+      hh_asset_cache_push_lru(cache, asset_id);
+      return (u8 *)asset->block + HH_ASSET_CACHE_ALIGNMENT;
+    } break;
+    case HH_ASSET_STATE_QUEUED: {
+      ++cache->stats.dedup_count;
+      if (priority > asset->priority) {
+        asset->priority = priority;
+        hh_asset_cache_sift_up(cache, asset->heap_index);
+      }
+    } break;
+    case HH_ASSET_STATE_LOADING: {
+      ++cache->stats.dedup_count;
+    } break;
+    default: {
+      ++cache->stats.miss_count;
+      asset->state = HH_ASSET_STATE_QUEUED;
+      asset->priority = priority;
+      asset->request_sequence = cache->request_sequence++;
+      asset->heap_index = cache->queue_count;
+      cache->queue[cache->queue_count++] = asset_id;
+      hh_asset_cache_sift_up(cache, asset->heap_index);
+    } break;
+  }
+
+  return NULL;
+}
+
+INTERNAL void
+hh_update_asset_cache(HHAssetCache* cache)
+{
+  ++cache->frame_index;
+  if (cache->stream == NULL) {
+    return;
+  }
+
+  for (u32 read_i = 0; read_i < HH_ASSET_CACHE_MAX_IN_FLIGHT; ++read_i) {
+    HHAssetCacheRead* cache_read = &cache->reads[read_i];
+    if (cache_read->asset_id == HH_ASSET_ID_NONE ||
+        atomic_load_explicit(&cache_read->read.state, memory_order_acquire) == HH_ASSET_READ_PENDING) {
+      continue;
+    }
+
+    HHCachedAsset* asset = &cache->assets[cache_read->asset_id];
+    u32 read_state = atomic_load_explicit(&cache_read->read.state, memory_order_relaxed);
+    if (read_state == HH_ASSET_READ_SUCCEEDED) {
+      asset->state = HH_ASSET_STATE_LOADED;
+      hh_asset_cache_push_lru(cache, cache_read->asset_id);
+      ++cache->stats.load_count;
+      cache->stats.loaded_bytes += cache_read->read.size;
+    } else {
+      // NOTE(Ryan): Unloaded again, so a later request retries
+      cache->used_bytes -= asset->block->size;
+      hh_asset_cache_free_block(cache, asset->block);
+      asset->block = NULL;
+      asset->state = HH_ASSET_STATE_UNLOADED;
+      if (read_state == HH_ASSET_READ_CANCELLED) {
+        ++cache->stats.cancelled_load_count;
+      } else {
+        ++cache->stats.failed_load_count;
+      }
+    }
+    cache_read->asset_id = HH_ASSET_ID_NONE;
+    --cache->read_count;
+  }
+
+  while (cache->queue_count > 0 && cache->read_count < HH_ASSET_CACHE_MAX_IN_FLIGHT) {
+    u32 asset_id = cache->queue[0];
+    HHCachedAsset* asset = &cache->assets[asset_id];
+    HHAssetEntry const* entry = &cache->pack->entries[asset_id];
+    if (asset->block == NULL) {
+      if (hh_asset_cache_block_size(entry->payload_size) > cache->budget) {
+        // NOTE(Ryan): Can never fit, so fail it rather than stall everything queued behind it
+        hh_asset_cache_pop_queue(cache);
+        asset->state = HH_ASSET_STATE_UNLOADED;
+        ++cache->stats.failed_load_count;
+        continue;
+      }
+      asset->block = hh_asset_cache_allocate(cache, entry->payload_size);
+      if (asset->block == NULL) {
+        // NOTE(Ryan): Highest priority first is strict, so nothing smaller jumps ahead into the space
+        ++cache->stats.stall_count;
+        break;
+      }
+      asset->block->asset_id = asset_id;
+    }
+
+    // NOTE(Ryan): Slots never move, the platform holds a pointer to the read until it finishes
+    HHAssetCacheRead* cache_read = &cache->reads[0];
+    while (cache_read->asset_id != HH_ASSET_ID_NONE) {
+      ++cache_read;
+    }
+    memset(&cache_read->read, 0, sizeof(cache_read->read));
+    cache_read->read.offset = entry->payload_offset;
+    cache_read->read.size = entry->payload_size;
+    cache_read->read.dest = (u8 *)asset->block + HH_ASSET_CACHE_ALIGNMENT;
+    if (!cache->platform_begin_asset_read(cache->stream, &cache_read->read)) {
+      // NOTE(Ryan): Block is kept, so next frame only has to resubmit
+      break;
+    }
+    hh_asset_cache_pop_queue(cache);
+    cache_read->asset_id = asset_id;
+    asset->state = HH_ASSET_STATE_LOADING;
+    ++cache->read_count;
+  }
+}
+
+INTERNAL bool
+hh_request_bitmap(HHAssetCache* cache, u32 asset_id, HHAssetPriority priority, HHBitmap* bitmap)
+{
+  if (cache->pack == NULL || asset_id >= cache->pack->asset_count ||
+      cache->pack->entries[asset_id].type != HH_ASSET_TYPE_BITMAP) {
+    return false;
+  }
+  void const* payload = hh_request_asset(cache, asset_id, priority);
+  if (payload == NULL) {
+    return false;
+  }
+  HHAssetEntry const* entry = &cache->pack->entries[asset_id];
+  bitmap->width = entry->bitmap.width;
+  bitmap->height = entry->bitmap.height;
+  bitmap->pitch = entry->bitmap.pitch;
+  bitmap->pixels = (u32 const *)payload;
+  return true;
+}
+
+// NOTE(Ryan): A playing sound must stay requested every frame, or its samples can be evicted under the mixer
+INTERNAL bool
+hh_request_sound(HHAssetCache* cache, u32 asset_id, HHAssetPriority priority, HHSound* sound)
+{
+  if (cache->pack == NULL || asset_id >= cache->pack->asset_count ||
+      cache->pack->entries[asset_id].type != HH_ASSET_TYPE_SOUND) {
+    return false;
+  }
+  void const* payload = hh_request_asset(cache, asset_id, priority);
+  if (payload == NULL) {
+    return false;
+  }
+  HHAssetEntry const* entry = &cache->pack->entries[asset_id];
+  sound->samples_per_second = entry->sound.samples_per_second;
+  sound->sample_count = entry->sound.sample_count;
+  sound->channel_count = entry->sound.channel_count;
+  sound->samples = (int16 *)payload;
+  return true;
+}
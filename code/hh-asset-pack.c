@@ -0,0 +1,156 @@
+// NOTE(Ryan): Opens the packed asset archive once at startup. On Linux and Windows the file is mapped
+// read-only and never copied, so the only cost of touching an asset is the page faults that bring it in.
+// Elsewhere it is read whole into one allocation. The header and entry table are checked here, once, so the
+// game can trust every offset and size it is handed.
+
+#if defined(LINUX)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+#define SDL_HH_ASSET_PACK_FILE_NAME "hh.hha"
+
+INTERNAL STATUS
+sdl_validate_asset_pack(HHAssetPack* pack, char const* file_name)
+{
+  if (pack->size < sizeof(HHAssetPackHeader)) {
+    SDL_LogWarn("Asset pack '%s' is too small to hold a header", file_name);
+    return FAILED;
+  }
+  HHAssetPackHeader const* header = (HHAssetPackHeader const *)pack->base;
+  if (header->magic != HH_ASSET_PACK_MAGIC || header->version != HH_ASSET_PACK_VERSION) {
+    SDL_LogWarn("Asset pack '%s' has magic 0x%x version %u, expected 0x%x version %u", file_name,
+                header->magic, header->version, HH_ASSET_PACK_MAGIC, HH_ASSET_PACK_VERSION);
+    return FAILED;
+  }
+  if (header->file_size != pack->size) {
+    SDL_LogWarn("Asset pack '%s' is %llu bytes, header says %llu", file_name,
+                (unsigned long long)pack->size, (unsigned long long)header->file_size);
+    return FAILED;
+  }
+  if (header->asset_count > (pack->size - sizeof(HHAssetPackHeader)) / sizeof(HHAssetEntry)) {
+    SDL_LogWarn("Asset pack '%s' entry table runs past the end of the file", file_name);
+    return FAILED;
+  }
+
+  pack->asset_count = header->asset_count;
+  pack->entries = (HHAssetEntry const *)(pack->base + sizeof(HHAssetPackHeader));
+
+  for (u32 entry_i = 0; entry_i < pack->asset_count; ++entry_i) {
+    HHAssetEntry const* entry = &pack->entries[entry_i];
+    bool is_valid = entry->payload_offset % HH_ASSET_PAYLOAD_ALIGNMENT == 0 &&
+                    entry->payload_offset <= pack->size && entry->payload_size <= pack->size - entry->payload_offset &&
+                    memchr(entry->name, '\0', HH_ASSET_NAME_LENGTH) != NULL &&
+                    (entry_i == 0 || entry->name_hash >= pack->entries[entry_i - 1].name_hash) &&
+                    hh_is_asset_entry_valid(entry);
+    if (!is_valid) {
+      SDL_LogWarn("Asset pack '%s' entry %u ('%.*s') is malformed", file_name, entry_i,
+                  HH_ASSET_NAME_LENGTH, entry->name);
+      return FAILED;
+    }
+  }
+
+  return SUCCEEDED;
+}
+
+INTERNAL void
+sdl_close_asset_pack(HHAssetPack* asset_pack)
+{
+  if (asset_pack->base != NULL) {
+#if defined(LINUX)
+    munmap((void *)asset_pack->base, asset_pack->size);
+#elif defined(WINDOWS)
+    UnmapViewOfFile(asset_pack->base);
+#else
+    free((void *)asset_pack->base);
+#endif
+  }
+  memset(asset_pack, 0, sizeof(*asset_pack));
+}
+
+// NOTE(Ryan): On failure the pack is left empty, so lookups fail rather than the game crashing
+INTERNAL STATUS
+sdl_open_asset_pack(HHAssetPack* asset_pack, char const* file_name)
+{
+  memset(asset_pack, 0, sizeof(*asset_pack));
+
+#if defined(LINUX)
+  int fd = open(file_name, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    SDL_LogWarn("Unable to open asset pack '%s': %s", file_name, strerror(errno));
+    return FAILED;
+  }
+  struct stat file_stat = {0};
+  if (fstat(fd, &file_stat) < 0 || file_stat.st_size == 0) {
+    SDL_LogWarn("Unable to obtain size of asset pack '%s': %s", file_name, strerror(errno));
+    close(fd);
+    return FAILED;
+  }
+  void* base = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // NOTE(Ryan): The mapping holds its own reference to the file
+  close(fd);
+  if (base == MAP_FAILED) {
+    SDL_LogWarn("Unable to map asset pack '%s': %s", file_name, strerror(errno));
+    return FAILED;
+  }
+  asset_pack->base = (u8 const *)base;
+  asset_pack->size = file_stat.st_size;
+#elif defined(WINDOWS)
+  HANDLE file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    SDL_LogWarn("Unable to open asset pack '%s': error %lu", file_name, GetLastError());
+    return FAILED;
+  }
+  LARGE_INTEGER file_size = {0};
+  HANDLE mapping = NULL;
+  if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  }
+  void* base = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+  if (base == NULL) {
+    SDL_LogWarn("Unable to map asset pack '%s': error %lu", file_name, GetLastError());
+  }
+  if (mapping != NULL) {
+    CloseHandle(mapping);
+  }
+  CloseHandle(file);
+  if (base == NULL) {
+    return FAILED;
+  }
+  asset_pack->base = (u8 const *)base;
+  asset_pack->size = file_size.QuadPart;
+#else
+  SDL_RWops* handle = SDL_RWFromFile(file_name, "rb");
+  if (handle == NULL) {
+    SDL_LogWarn("Unable to open asset pack '%s': %s", file_name, SDL_GetError());
+    return FAILED;
+  }
+  int64 file_size = SDL_RWsize(handle);
+  void* base = (file_size > 0) ? malloc(file_size) : NULL;
+  if (base == NULL || SDL_RWread(handle, base, file_size, 1) != 1) {
+    SDL_LogWarn("Unable to read asset pack '%s': %s", file_name, SDL_GetError());
+    free(base);
+    SDL_RWclose(handle);
+    return FAILED;
+  }
+  SDL_RWclose(handle);
+  asset_pack->base = (u8 const *)base;
+  asset_pack->size = file_size;
+#endif
+
+  if (sdl_validate_asset_pack(asset_pack, file_name) == FAILED) {
+    sdl_close_asset_pack(asset_pack);
+    return FAILED;
+  }
+
+#if defined(LINUX)
+  // NOTE(Ryan): The table is binary searched at every lookup, so fault it in now rather than piecemeal
+  u64 page_size = sysconf(_SC_PAGESIZE);
+  u64 table_size = sizeof(HHAssetPackHeader) + (u64)asset_pack->asset_count * sizeof(HHAssetEntry);
+  madvise((void *)asset_pack->base, (table_size + page_size - 1) & ~(page_size - 1), MADV_WILLNEED);
+#endif
+
+  return SUCCEEDED;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+// NOTE(Ryan): On-disk layout of the packed asset archive (.hha) written by hh-asset-packer.
+//
+//   HHAssetPackHeader
+//   HHAssetEntry[asset_count], sorted by name_hash
+//   payloads, each starting on an HH_ASSET_PAYLOAD_ALIGNMENT boundary
+//
+// The platform maps the whole file read-only once and hands the game an HHAssetPack through HHMemory,
+// so assets are used in place: a bitmap's pixels or a sound's samples are pointers into the mapping and
+// loading one costs page faults, not a file open, read and allocation. All fields are little endian.
+
+#define HH_ASSET_PACK_MAGIC (('H' << 0) | ('H' << 8) | ('A' << 16) | ('P' << 24))
+// NOTE(Ryan): 2: bitmaps are premultiplied alpha
+#define HH_ASSET_PACK_VERSION 2
+#define HH_ASSET_NAME_LENGTH 48
+// NOTE(Ryan): Cache line, so SIMD kernels can use aligned loads on row 0 and no two assets share a line
+#define HH_ASSET_PAYLOAD_ALIGNMENT 64
+
+typedef enum {
+  HH_ASSET_TYPE_BITMAP = 1,
+  HH_ASSET_TYPE_SOUND = 2
+} HHAssetType;
+
+typedef struct {
+  u32 magic;
+  u32 version;
+  u32 asset_count;
+  u32 reserved;
+  // NOTE(Ryan): Total size of the pack, so a truncated file is caught at open
+  u64 file_size;
+} HHAssetPackHeader;
+
+typedef struct {
+  u64 name_hash;
+  char name[HH_ASSET_NAME_LENGTH];
+  u32 type;
+  u32 reserved;
+  u64 payload_offset;
+  u64 payload_size;
+  union {
+    // NOTE(Ryan): 32bpp premultiplied 0xAARRGGBB, top row first
+    struct {
+      u32 width;
+      u32 height;
+      u32 pitch;
+    } bitmap;
+    // NOTE(Ryan): S16, interleaved when channel_count is 2
+    struct {
+      u32 samples_per_second;
+      u32 sample_count;
+      u32 channel_count;
+    } sound;
+  };
+} HHAssetEntry;
+
+_Static_assert(sizeof(HHAssetPackHeader) == 24, "asset pack header layout changed");
+_Static_assert(sizeof(HHAssetEntry) == 96, "asset entry layout changed");
+
+// NOTE(Ryan): base is NULL when no pack is loaded, in which case every lookup fails
+typedef struct {
+  u8 const* base;
+  u64 size;
+  u32 asset_count;
+  HHAssetEntry const* entries;
+} HHAssetPack;
+
+// NOTE(Ryan): 64-bit FNV-1a
+static inline u64
+hh_hash_asset_name(char const* name)
+{
+  u64 hash = 0xcbf29ce484222325ULL;
+  for (char const* name_cursor = name; *name_cursor != '\0'; ++name_cursor) {
+    hash ^= (u8)*name_cursor;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// NOTE(Ryan): Binary search on the hash; the name compare only guards against a collision.
+// Resolve names once and keep the entry, this is not meant for every frame.
+static inline HHAssetEntry const*
+hh_find_asset(HHAssetPack const* pack, char const* name)
+{
+  u64 name_hash = hh_hash_asset_name(name);
+  u32 low = 0;
+  u32 high = pack->asset_count;
+  while (low < high) {
+    u32 middle = low + (high - low) / 2;
+    if (pack->entries[middle].name_hash < name_hash) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  for (u32 entry_i = low; entry_i < pack->asset_count && pack->entries[entry_i].name_hash == name_hash; ++entry_i) {
+    if (strncmp(pack->entries[entry_i].name, name, HH_ASSET_NAME_LENGTH) == 0) {
+      return &pack->entries[entry_i];
+    }
+  }
+  return NULL;
+}
+
+// NOTE(Ryan): The checks on an entry that don't depend on where it sits in the file. The packer runs these too,
+// so it never writes an entry that would make the loader refuse the whole pack.
+static inline bool
+hh_is_asset_entry_valid(HHAssetEntry const* entry)
+{
+  if (entry->type == HH_ASSET_TYPE_BITMAP) {
+    // NOTE(Ryan): Rows are read as whole u32 pixels, so the pitch must keep every row 4-byte aligned
+    return entry->bitmap.pitch % BYTES_PER_PIXEL == 0 &&
+           entry->bitmap.pitch >= (u64)entry->bitmap.width * BYTES_PER_PIXEL &&
+           (u64)entry->bitmap.pitch * entry->bitmap.height <= entry->payload_size;
+  }
+  if (entry->type == HH_ASSET_TYPE_SOUND) {
+    return (entry->sound.channel_count == 1 || entry->sound.channel_count == 2) &&
+           entry->sound.samples_per_second != 0 &&
+           (u64)entry->sound.sample_count * entry->sound.channel_count * sizeof(int16) <= entry->payload_size;
+  }
+  return false;
+}
+
+static inline void const*
+hh_get_asset_payload(HHAssetPack const* pack, HHAssetEntry const* entry)
+{
+  return pack->base + entry->payload_offset;
+}
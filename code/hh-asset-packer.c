@@ -0,0 +1,432 @@
+// NOTE(Ryan): Offline tool that builds the packed asset archive described in hh-asset-pack.h.
+// The manifest has one asset per line, "name path", with '#' starting a comment. The type comes from the
+// path's extension:
+//   .bmp  uncompressed 24 or 32 bit, stored as top-down premultiplied 0xAARRGGBB (24 bit gets opaque alpha)
+//   .wav  16 bit PCM, mono or stereo
+// The pack is written next to the output and renamed over it when complete, so a running game never maps a
+// half-written pack.
+//
+// usage: hh-asset-packer manifest.txt output.hha
+
+#include "hh-platform.h"
+
+#include <stdio.h>
+#include <ctype.h>
+#include <strings.h>
+
+typedef struct {
+  u8* data;
+  u64 size;
+} PackerFile;
+
+typedef struct {
+  HHAssetEntry entry;
+  PackerFile source;
+  // NOTE(Ryan): Converted payload, may point into source
+  u8 const* payload;
+  u8* owned_payload;
+} PackerAsset;
+
+typedef struct {
+  PackerAsset* assets;
+  u32 asset_count;
+  u32 asset_capacity;
+} Packer;
+
+INTERNAL STATUS
+packer_read_entire_file(char const* file_name, PackerFile* file)
+{
+  FILE* handle = fopen(file_name, "rb");
+  if (handle == NULL) {
+    fprintf(stderr, "Unable to open '%s': %s\n", file_name, strerror(errno));
+    return FAILED;
+  }
+
+  STATUS result = FAILED;
+  if (fseek(handle, 0, SEEK_END) != 0) {
+    fprintf(stderr, "Unable to seek '%s': %s\n", file_name, strerror(errno));
+    goto __CLOSE_FILE__;
+  }
+  long file_size = ftell(handle);
+  if (file_size < 0 || fseek(handle, 0, SEEK_SET) != 0) {
+    fprintf(stderr, "Unable to obtain size of '%s': %s\n", file_name, strerror(errno));
+    goto __CLOSE_FILE__;
+  }
+  file->data = malloc((file_size > 0) ? file_size : 1);
+  if (file->data == NULL) {
+    fprintf(stderr, "Unable to allocate %ld bytes for '%s'\n", file_size, file_name);
+    goto __CLOSE_FILE__;
+  }
+  if (fread(file->data, 1, file_size, handle) != (size_t)file_size) {
+    fprintf(stderr, "Unable to read '%s': %s\n", file_name, strerror(errno));
+    free(file->data);
+    file->data = NULL;
+    goto __CLOSE_FILE__;
+  }
+  file->size = file_size;
+  result = SUCCEEDED;
+
+__CLOSE_FILE__:
+  fclose(handle);
+  return result;
+}
+
+INTERNAL u16
+packer_read_u16(u8 const* bytes)
+{
+  return (u16)(bytes[0] | (bytes[1] << 8));
+}
+
+INTERNAL u32
+packer_read_u32(u8 const* bytes)
+{
+  return (u32)bytes[0] | ((u32)bytes[1] << 8) | ((u32)bytes[2] << 16) | ((u32)bytes[3] << 24);
+}
+
+// NOTE(Ryan): Position of the lowest set bit and the width of the run, for a BI_BITFIELDS channel mask
+INTERNAL void
+packer_get_mask_shift(u32 mask, u32* shift, u32* bit_count)
+{
+  *shift = (mask != 0) ? (u32)__builtin_ctz(mask) : 0;
+  *bit_count = (mask != 0) ? (u32)__builtin_popcount(mask) : 0;
+}
+
+INTERNAL u32
+packer_extract_channel(u32 value, u32 mask, u32 default_value)
+{
+  if (mask == 0) {
+    return default_value;
+  }
+  u32 shift = 0;
+  u32 bit_count = 0;
+  packer_get_mask_shift(mask, &shift, &bit_count);
+  u32 channel = (value & mask) >> shift;
+  u32 channel_max = (bit_count >= 32) ? UINT32_MAX : ((1u << bit_count) - 1);
+  return (channel * 255 + channel_max / 2) / channel_max;
+}
+
+INTERNAL STATUS
+packer_load_bitmap(PackerAsset* asset, char const* path)
+{
+  u8 const* data = asset->source.data;
+  u64 size = asset->source.size;
+  if (size < 54 || data[0] != 'B' || data[1] != 'M') {
+    fprintf(stderr, "'%s' is not a BMP file\n", path);
+    return FAILED;
+  }
+
+  u32 pixel_offset = packer_read_u32(data + 10);
+  u32 info_size = packer_read_u32(data + 14);
+  int32 width = (int32)packer_read_u32(data + 18);
+  int32 height = (int32)packer_read_u32(data + 22);
+  u16 bits_per_pixel = packer_read_u16(data + 28);
+  u32 compression = packer_read_u32(data + 30);
+
+  // NOTE(Ryan): 0 is BI_RGB, 3 BI_BITFIELDS whose masks follow a 40 byte header or live inside a larger one
+  u32 red_mask = 0x00ff0000, green_mask = 0x0000ff00, blue_mask = 0x000000ff, alpha_mask = 0;
+  if (compression == 3 && size >= 14 + 40 + 12) {
+    red_mask = packer_read_u32(data + 54);
+    green_mask = packer_read_u32(data + 58);
+    blue_mask = packer_read_u32(data + 62);
+    alpha_mask = (info_size >= 56 && size >= 14 + 56) ? packer_read_u32(data + 66) : 0;
+  } else if (compression != 0) {
+    fprintf(stderr, "'%s' is compressed (%u), only uncompressed BMPs are supported\n", path, compression);
+    return FAILED;
+  }
+  if (bits_per_pixel == 32 && compression == 0) {
+    // NOTE(Ryan): Plain 32 bit BI_RGB has an unused top byte by the spec, but most tools put alpha there
+    alpha_mask = 0xff000000;
+  }
+
+  bool is_top_down = (height < 0);
+  u32 abs_height = is_top_down ? (u32)-(int64)height : (u32)height;
+  if (width <= 0 || abs_height == 0 || (bits_per_pixel != 24 && bits_per_pixel != 32)) {
+    fprintf(stderr, "'%s' is %dx%d at %u bpp, expected 24 or 32 bpp\n", path, width, height, bits_per_pixel);
+    return FAILED;
+  }
+  u64 source_pitch = (((u64)width * bits_per_pixel + 31) / 32) * 4;
+  if (pixel_offset > size || source_pitch * abs_height > size - pixel_offset) {
+    fprintf(stderr, "'%s' is truncated\n", path);
+    return FAILED;
+  }
+
+  u32 pitch = (u32)width * BYTES_PER_PIXEL;
+  asset->owned_payload = malloc((u64)pitch * abs_height);
+  if (asset->owned_payload == NULL) {
+    fprintf(stderr, "Unable to allocate pixels for '%s'\n", path);
+    return FAILED;
+  }
+
+  for (u32 y = 0; y < abs_height; ++y) {
+    u32 source_y = is_top_down ? y : abs_height - 1 - y;
+    u8 const* source_row = data + pixel_offset + source_y * source_pitch;
+    u32* dest_row = (u32 *)(asset->owned_payload + (u64)y * pitch);
+    for (u32 x = 0; x < (u32)width; ++x) {
+      u32 value = 0;
+      if (bits_per_pixel == 32) {
+        value = packer_read_u32(source_row + x * 4);
+      } else {
+        value = source_row[x * 3] | (source_row[x * 3 + 1] << 8) | (source_row[x * 3 + 2] << 16);
+      }
+      u32 red = packer_extract_channel(value, red_mask, 0);
+      u32 green = packer_extract_channel(value, green_mask, 0);
+      u32 blue = packer_extract_channel(value, blue_mask, 0);
+      u32 alpha = packer_extract_channel(value, alpha_mask, 255);
+      // NOTE(Ryan): Premultiplied, so the blitter needs no per-channel divide and filtering doesn't bleed colour
+      // out of transparent texels
+      red = (red * alpha + 127) / 255;
+      green = (green * alpha + 127) / 255;
+      blue = (blue * alpha + 127) / 255;
+      dest_row[x] = (alpha << 24) | (red << 16) | (green << 8) | blue;
+    }
+  }
+
+  asset->entry.type = HH_ASSET_TYPE_BITMAP;
+  asset->entry.bitmap.width = (u32)width;
+  asset->entry.bitmap.height = abs_height;
+  asset->entry.bitmap.pitch = pitch;
+  asset->entry.payload_size = (u64)pitch * abs_height;
+  asset->payload = asset->owned_payload;
+  return SUCCEEDED;
+}
+
+INTERNAL STATUS
+packer_load_sound(PackerAsset* asset, char const* path)
+{
+  u8 const* data = asset->source.data;
+  u64 size = asset->source.size;
+  if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+    fprintf(stderr, "'%s' is not a WAV file\n", path);
+    return FAILED;
+  }
+
+  u16 format = 0, channel_count = 0, bits_per_sample = 0;
+  u32 samples_per_second = 0;
+  u8 const* samples = NULL;
+  u32 samples_size = 0;
+  // NOTE(Ryan): Chunks are word aligned; anything other than fmt and data (LIST, fact, ...) is skipped
+  for (u64 chunk_offset = 12; chunk_offset + 8 <= size; ) {
+    u8 const* chunk = data + chunk_offset;
+    u32 chunk_size = packer_read_u32(chunk + 4);
+    if (chunk_size > size - chunk_offset - 8) {
+      fprintf(stderr, "'%s' has a truncated '%.4s' chunk\n", path, (char const *)chunk);
+      return FAILED;
+    }
+    if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16) {
+      format = packer_read_u16(chunk + 8);
+      channel_count = packer_read_u16(chunk + 10);
+      samples_per_second = packer_read_u32(chunk + 12);
+      bits_per_sample = packer_read_u16(chunk + 22);
+      // NOTE(Ryan): WAVE_FORMAT_EXTENSIBLE carries the real format in the first two bytes of its sub-format GUID
+      if (format == 0xfffe && chunk_size >= 26) {
+        format = packer_read_u16(chunk + 32);
+      }
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      samples = chunk + 8;
+      samples_size = chunk_size;
+    }
+    chunk_offset += 8 + chunk_size + (chunk_size & 1);
+  }
+
+  if (format != 1 || bits_per_sample != 16 || (channel_count != 1 && channel_count != 2) || samples == NULL) {
+    fprintf(stderr, "'%s' is format %u, %u bit, %u channels, expected 16 bit PCM mono or stereo\n",
+            path, format, bits_per_sample, channel_count);
+    return FAILED;
+  }
+  if (samples_per_second == 0) {
+    fprintf(stderr, "'%s' has a sample rate of 0\n", path);
+    return FAILED;
+  }
+
+  asset->entry.type = HH_ASSET_TYPE_SOUND;
+  asset->entry.sound.samples_per_second = samples_per_second;
+  asset->entry.sound.channel_count = channel_count;
+  asset->entry.sound.sample_count = samples_size / (sizeof(int16) * channel_count);
+  asset->entry.payload_size = (u64)asset->entry.sound.sample_count * sizeof(int16) * channel_count;
+  // NOTE(Ryan): Already little endian S16, so the payload is the data chunk as is
+  asset->payload = samples;
+  return SUCCEEDED;
+}
+
+INTERNAL STATUS
+packer_add_asset(Packer* packer, char const* name, char const* path)
+{
+  if (strlen(name) >= HH_ASSET_NAME_LENGTH) {
+    fprintf(stderr, "Asset name '%s' is longer than %d characters\n", name, HH_ASSET_NAME_LENGTH - 1);
+    return FAILED;
+  }
+  if (packer->asset_count == packer->asset_capacity) {
+    u32 new_capacity = (packer->asset_capacity != 0) ? packer->asset_capacity * 2 : 256;
+    PackerAsset* new_assets = realloc(packer->assets, new_capacity * sizeof(PackerAsset));
+    if (new_assets == NULL) {
+      fprintf(stderr, "Unable to grow asset list to %u\n", new_capacity);
+      return FAILED;
+    }
+    packer->assets = new_assets;
+    packer->asset_capacity = new_capacity;
+  }
+
+  PackerAsset* asset = &packer->assets[packer->asset_count];
+  memset(asset, 0, sizeof(*asset));
+  strcpy(asset->entry.name, name);
+  asset->entry.name_hash = hh_hash_asset_name(name);
+  if (packer_read_entire_file(path, &asset->source) == FAILED) {
+    return FAILED;
+  }
+
+  char const* extension = strrchr(path, '.');
+  STATUS result = FAILED;
+  if (extension != NULL && strcasecmp(extension, ".bmp") == 0) {
+    result = packer_load_bitmap(asset, path);
+  } else if (extension != NULL && strcasecmp(extension, ".wav") == 0) {
+    result = packer_load_sound(asset, path);
+  } else {
+    fprintf(stderr, "'%s' has no known asset extension (.bmp, .wav)\n", path);
+  }
+  // NOTE(Ryan): Backstop for anything the loaders above let through, as one bad entry fails the whole pack
+  if (result == SUCCEEDED && !hh_is_asset_entry_valid(&asset->entry)) {
+    fprintf(stderr, "'%s' converts to an entry the game would reject\n", path);
+    result = FAILED;
+  }
+
+  if (result == FAILED) {
+    free(asset->owned_payload);
+    free(asset->source.data);
+    return FAILED;
+  }
+  ++packer->asset_count;
+  return SUCCEEDED;
+}
+
+INTERNAL int
+packer_compare_assets(void const* a, void const* b)
+{
+  HHAssetEntry const* first = &((PackerAsset const *)a)->entry;
+  HHAssetEntry const* second = &((PackerAsset const *)b)->entry;
+  if (first->name_hash != second->name_hash) {
+    return (first->name_hash < second->name_hash) ? -1 : 1;
+  }
+  return strcmp(first->name, second->name);
+}
+
+INTERNAL STATUS
+packer_load_manifest(Packer* packer, char const* manifest_file_name)
+{
+  FILE* manifest = fopen(manifest_file_name, "r");
+  if (manifest == NULL) {
+    fprintf(stderr, "Unable to open manifest '%s': %s\n", manifest_file_name, strerror(errno));
+    return FAILED;
+  }
+
+  STATUS result = SUCCEEDED;
+  char line[1024] = {0};
+  for (uint line_number = 1; fgets(line, sizeof(line), manifest) != NULL; ++line_number) {
+    char* comment = strchr(line, '#');
+    if (comment != NULL) {
+      *comment = '\0';
+    }
+    char name[HH_ASSET_NAME_LENGTH * 2] = {0};
+    char path[sizeof(line)] = {0};
+    int field_count = sscanf(line, "%95s %1023[^\n]", name, path);
+    if (field_count <= 0) {
+      continue;
+    }
+    // NOTE(Ryan): Trailing whitespace is not part of the path
+    for (size_t path_length = strlen(path); path_length > 0 && isspace((u8)path[path_length - 1]); --path_length) {
+      path[path_length - 1] = '\0';
+    }
+    if (field_count != 2 || path[0] == '\0') {
+      fprintf(stderr, "%s:%u: expected 'name path'\n", manifest_file_name, line_number);
+      result = FAILED;
+      break;
+    }
+    if (packer_add_asset(packer, name, path) == FAILED) {
+      fprintf(stderr, "%s:%u: unable to add '%s'\n", manifest_file_name, line_number, name);
+      result = FAILED;
+      break;
+    }
+  }
+
+  fclose(manifest);
+  return result;
+}
+
+INTERNAL STATUS
+packer_write_pack(Packer* packer, char const* output_file_name)
+{
+  qsort(packer->assets, packer->asset_count, sizeof(PackerAsset), packer_compare_assets);
+  for (u32 asset_i = 1; asset_i < packer->asset_count; ++asset_i) {
+    if (packer_compare_assets(&packer->assets[asset_i - 1], &packer->assets[asset_i]) == 0) {
+      fprintf(stderr, "Asset '%s' is listed more than once\n", packer->assets[asset_i].entry.name);
+      return FAILED;
+    }
+  }
+
+  u64 offset = sizeof(HHAssetPackHeader) + (u64)packer->asset_count * sizeof(HHAssetEntry);
+  for (u32 asset_i = 0; asset_i < packer->asset_count; ++asset_i) {
+    HHAssetEntry* entry = &packer->assets[asset_i].entry;
+    offset = (offset + HH_ASSET_PAYLOAD_ALIGNMENT - 1) & ~(u64)(HH_ASSET_PAYLOAD_ALIGNMENT - 1);
+    entry->payload_offset = offset;
+    offset += entry->payload_size;
+  }
+
+  HHAssetPackHeader header = {0};
+  header.magic = HH_ASSET_PACK_MAGIC;
+  header.version = HH_ASSET_PACK_VERSION;
+  header.asset_count = packer->asset_count;
+  header.file_size = offset;
+
+  char temp_file_name[512] = {0};
+  snprintf(temp_file_name, sizeof(temp_file_name), "%s.tmp", output_file_name);
+  FILE* output = fopen(temp_file_name, "wb");
+  if (output == NULL) {
+    fprintf(stderr, "Unable to create '%s': %s\n", temp_file_name, strerror(errno));
+    return FAILED;
+  }
+
+  bool is_written = fwrite(&header, sizeof(header), 1, output) == 1;
+  for (u32 asset_i = 0; is_written && asset_i < packer->asset_count; ++asset_i) {
+    is_written = fwrite(&packer->assets[asset_i].entry, sizeof(HHAssetEntry), 1, output) == 1;
+  }
+  u8 const padding[HH_ASSET_PAYLOAD_ALIGNMENT] = {0};
+  for (u32 asset_i = 0; is_written && asset_i < packer->asset_count; ++asset_i) {
+    PackerAsset* asset = &packer->assets[asset_i];
+    long position = ftell(output);
+    is_written = position >= 0 && (u64)position <= asset->entry.payload_offset &&
+                 fwrite(padding, 1, asset->entry.payload_offset - position, output) == asset->entry.payload_offset - position &&
+                 fwrite(asset->payload, 1, asset->entry.payload_size, output) == asset->entry.payload_size;
+  }
+  is_written = (fclose(output) == 0) && is_written;
+
+  if (!is_written || rename(temp_file_name, output_file_name) != 0) {
+    fprintf(stderr, "Unable to write '%s': %s\n", output_file_name, strerror(errno));
+    remove(temp_file_name);
+    return FAILED;
+  }
+
+  printf("%s: %u assets, %llu bytes\n", output_file_name, packer->asset_count, (unsigned long long)header.file_size);
+  return SUCCEEDED;
+}
+
+int
+main(int argc, char* argv[argc + 1])
+{
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s manifest.txt output.hha\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Packer packer = {0};
+  STATUS result = packer_load_manifest(&packer, argv[1]);
+  if (result == SUCCEEDED) {
+    result = packer_write_pack(&packer, argv[2]);
+  }
+
+  for (u32 asset_i = 0; asset_i < packer.asset_count; ++asset_i) {
+    free(packer.assets[asset_i].owned_payload);
+    free(packer.assets[asset_i].source.data);
+  }
+  free(packer.assets);
+
+  return (result == SUCCEEDED) ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,443 @@
+// NOTE(Ryan): Background reads of asset pack bytes into game memory, so a cold asset never costs the frame
+// thread a disk wait. The game queues HHAssetReads with platform_begin_asset_read and polls their state.
+//
+// With HH_USE_IO_URING (Linux, link -luring) one thread keeps up to SDL_ASSET_STREAM_DEPTH chunk reads in flight
+// on an io_uring against the pack file. Otherwise, or if the ring cannot be created (old kernel, seccomp), a
+// couple of threads copy out of the pack's mapping and take its page faults instead of the frame thread. If the ring
+// later refuses submissions outright, its thread carries on as a copy thread.
+// Either way large assets move in SDL_ASSET_STREAM_CHUNK_SIZE pieces, so shutdown is never stuck behind one.
+//
+// IMPORTANT(Ryan): Destinations are usually in the replay-protected memory block, where a kernel write fails with
+// EFAULT while a snapshot is live. So io_uring reads land in platform staging buffers and are copied out here.
+// The reads themselves live there too, so the platform quiesces the stream around every snapshot take and restore.
+
+#if defined(HH_USE_IO_URING)
+  #include <liburing.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+// NOTE(Ryan): Power of two
+#define SDL_ASSET_STREAM_QUEUE_LENGTH 256
+#define SDL_ASSET_STREAM_CHUNK_SIZE KILOBYTES(256)
+#define SDL_ASSET_STREAM_DEPTH 8
+#define SDL_ASSET_STREAM_COPY_THREAD_COUNT 2
+
+typedef struct {
+  HHAssetRead* read;
+  u64 offset;
+  u64 size;
+} SDLAssetStreamChunk;
+
+struct HHAssetStream {
+  HHAssetPack const* pack;
+
+  // NOTE(Ryan): Pushed by the game thread, popped by the stream threads, all under the lock
+  atomic_flag lock;
+  u32 read_index;
+  u32 write_index;
+  HHAssetRead* requests[SDL_ASSET_STREAM_QUEUE_LENGTH];
+  // NOTE(Ryan): Popped but not yet finished; raised under the lock, so a drained queue plus zero here means idle
+  _Atomic u32 active_read_count;
+
+  SDL_sem* request_semaphore;
+  _Atomic bool is_running;
+  uint thread_count;
+  SDL_Thread* threads[SDL_ASSET_STREAM_COPY_THREAD_COUNT];
+
+#if defined(HH_USE_IO_URING)
+  bool is_using_io_uring;
+  bool has_registered_staging;
+  // NOTE(Ryan): Set by the stream thread when it gives up on the ring; the kernel may still own the staging buffers
+  bool has_ring_failed;
+  int fd;
+  struct io_uring ring;
+  u8* staging;
+  SDLAssetStreamChunk chunks[SDL_ASSET_STREAM_DEPTH];
+#endif
+};
+
+INTERNAL HHAssetRead*
+sdl_asset_stream_pop(HHAssetStream* stream)
+{
+  HHAssetRead* read = NULL;
+  while (atomic_flag_test_and_set_explicit(&stream->lock, memory_order_acquire)) {
+    SDL_CPUPauseInstruction();
+  }
+  if (stream->read_index != stream->write_index) {
+    read = stream->requests[stream->read_index++ & (SDL_ASSET_STREAM_QUEUE_LENGTH - 1)];
+    atomic_fetch_add_explicit(&stream->active_read_count, 1, memory_order_relaxed);
+  }
+  atomic_flag_clear_explicit(&stream->lock, memory_order_release);
+  return read;
+}
+
+INTERNAL void
+sdl_asset_stream_finish(HHAssetRead* read)
+{
+  bool has_succeeded = !read->has_failed && read->completed_size == read->size;
+  atomic_store_explicit(&read->state, has_succeeded ? HH_ASSET_READ_SUCCEEDED : HH_ASSET_READ_FAILED,
+                        memory_order_release);
+}
+
+// NOTE(Ryan): For reads that came through sdl_asset_stream_pop(); the read is not touched again after this
+INTERNAL void
+sdl_asset_stream_retire(HHAssetStream* stream, HHAssetRead* read)
+{
+  sdl_asset_stream_finish(read);
+  atomic_fetch_sub_explicit(&stream->active_read_count, 1, memory_order_release);
+}
+
+bool
+platform_begin_asset_read(HHAssetStream* stream, HHAssetRead* read)
+{
+  read->completed_size = 0;
+  read->chunks_in_flight = 0;
+  read->has_failed = (read->offset > stream->pack->size || read->size > stream->pack->size - read->offset);
+  // NOTE(Ryan): Nothing to move, so the stream threads never see an empty read
+  if (read->has_failed || read->size == 0) {
+    sdl_asset_stream_finish(read);
+    return true;
+  }
+
+  while (atomic_flag_test_and_set_explicit(&stream->lock, memory_order_acquire)) {
+    SDL_CPUPauseInstruction();
+  }
+  bool is_queued = (stream->write_index - stream->read_index < SDL_ASSET_STREAM_QUEUE_LENGTH);
+  if (is_queued) {
+    atomic_store_explicit(&read->state, HH_ASSET_READ_PENDING, memory_order_relaxed);
+    stream->requests[stream->write_index++ & (SDL_ASSET_STREAM_QUEUE_LENGTH - 1)] = read;
+  }
+  atomic_flag_clear_explicit(&stream->lock, memory_order_release);
+
+  if (is_queued) {
+    SDL_SemPost(stream->request_semaphore);
+  }
+  return is_queued;
+}
+
+INTERNAL void
+sdl_asset_stream_copy_read(HHAssetStream* stream, HHAssetRead* read)
+{
+  while (!read->has_failed && read->completed_size < read->size) {
+    if (!atomic_load_explicit(&stream->is_running, memory_order_relaxed)) {
+      read->has_failed = true;
+      break;
+    }
+    u64 chunk_size = read->size - read->completed_size;
+    chunk_size = (chunk_size < SDL_ASSET_STREAM_CHUNK_SIZE) ? chunk_size : SDL_ASSET_STREAM_CHUNK_SIZE;
+    memcpy((u8 *)read->dest + read->completed_size, stream->pack->base + read->offset + read->completed_size, chunk_size);
+    read->completed_size += chunk_size;
+  }
+  sdl_asset_stream_retire(stream, read);
+}
+
+INTERNAL int
+sdl_asset_stream_copy_thread(void* data)
+{
+  HHAssetStream* stream = (HHAssetStream *)data;
+
+  while (atomic_load_explicit(&stream->is_running, memory_order_relaxed)) {
+    HHAssetRead* read = sdl_asset_stream_pop(stream);
+    if (read == NULL) {
+      SDL_SemWait(stream->request_semaphore);
+      continue;
+    }
+    sdl_asset_stream_copy_read(stream, read);
+  }
+
+  return 0;
+}
+
+#if defined(HH_USE_IO_URING)
+INTERNAL void
+sdl_asset_stream_submit_chunk(HHAssetStream* stream, uint chunk_i)
+{
+  SDLAssetStreamChunk* chunk = &stream->chunks[chunk_i];
+  // NOTE(Ryan): Never more than SDL_ASSET_STREAM_DEPTH in flight and the ring has twice that, so there is always an sqe
+  struct io_uring_sqe* sqe = io_uring_get_sqe(&stream->ring);
+  u8* staging = stream->staging + chunk_i * SDL_ASSET_STREAM_CHUNK_SIZE;
+  if (stream->has_registered_staging) {
+    io_uring_prep_read_fixed(sqe, stream->fd, staging, chunk->size, chunk->read->offset + chunk->offset, 0);
+  } else {
+    io_uring_prep_read(sqe, stream->fd, staging, chunk->size, chunk->read->offset + chunk->offset);
+  }
+  io_uring_sqe_set_data(sqe, (void *)(uintptr_t)chunk_i);
+}
+
+// NOTE(Ryan): Returns true if the chunk's slot is free again
+INTERNAL bool
+sdl_asset_stream_complete_chunk(HHAssetStream* stream, uint chunk_i, int result)
+{
+  SDLAssetStreamChunk* chunk = &stream->chunks[chunk_i];
+  HHAssetRead* read = chunk->read;
+
+  if (result == -EAGAIN || result == -EINTR) {
+    sdl_asset_stream_submit_chunk(stream, chunk_i);
+    return false;
+  }
+  if (result <= 0) {
+    SDL_LogWarn("Unable to stream %llu bytes at %llu: %s", (unsigned long long)chunk->size,
+                (unsigned long long)(read->offset + chunk->offset), (result < 0) ? strerror(-result) : "end of file");
+    read->has_failed = true;
+  } else {
+    u8* staging = stream->staging + chunk_i * SDL_ASSET_STREAM_CHUNK_SIZE;
+    memcpy((u8 *)read->dest + chunk->offset, staging, result);
+    read->completed_size += result;
+    // NOTE(Ryan): Short read, so ask for the rest into the same staging buffer
+    if ((u64)result < chunk->size) {
+      chunk->offset += result;
+      chunk->size -= result;
+      sdl_asset_stream_submit_chunk(stream, chunk_i);
+      return false;
+    }
+  }
+
+  chunk->read = NULL;
+  return true;
+}
+
+// NOTE(Ryan): Drops every chunk of the read still in a slot and copies the whole read out of the mapping instead
+INTERNAL void
+sdl_asset_stream_copy_abandoned_read(HHAssetStream* stream, HHAssetRead* read)
+{
+  for (uint chunk_i = 0; chunk_i < SDL_ASSET_STREAM_DEPTH; ++chunk_i) {
+    if (stream->chunks[chunk_i].read == read) {
+      stream->chunks[chunk_i].read = NULL;
+    }
+  }
+  read->completed_size = 0;
+  read->chunks_in_flight = 0;
+  sdl_asset_stream_copy_read(stream, read);
+}
+
+INTERNAL int
+sdl_asset_stream_uring_thread(void* data)
+{
+  HHAssetStream* stream = (HHAssetStream *)data;
+  HHAssetRead* current_read = NULL;
+  u64 current_offset = 0;
+  uint in_flight_count = 0;
+
+  while (atomic_load_explicit(&stream->is_running, memory_order_relaxed) || in_flight_count > 0) {
+    bool is_running = atomic_load_explicit(&stream->is_running, memory_order_relaxed);
+
+    // NOTE(Ryan): Fill every free slot with the next chunk, in request order
+    for (uint chunk_i = 0; is_running && chunk_i < SDL_ASSET_STREAM_DEPTH; ++chunk_i) {
+      if (stream->chunks[chunk_i].read != NULL) {
+        continue;
+      }
+      if (current_read == NULL) {
+        current_read = sdl_asset_stream_pop(stream);
+        current_offset = 0;
+        if (current_read == NULL) {
+          break;
+        }
+      }
+      SDLAssetStreamChunk* chunk = &stream->chunks[chunk_i];
+      chunk->read = current_read;
+      chunk->offset = current_offset;
+      chunk->size = current_read->size - current_offset;
+      chunk->size = (chunk->size < SDL_ASSET_STREAM_CHUNK_SIZE) ? chunk->size : SDL_ASSET_STREAM_CHUNK_SIZE;
+      sdl_asset_stream_submit_chunk(stream, chunk_i);
+      ++current_read->chunks_in_flight;
+      ++in_flight_count;
+
+      current_offset += chunk->size;
+      if (current_offset >= current_read->size || current_read->has_failed) {
+        current_read = NULL;
+      }
+    }
+    if (in_flight_count == 0) {
+      if (is_running) {
+        SDL_SemWait(stream->request_semaphore);
+      }
+      continue;
+    }
+
+    struct io_uring_cqe* cqe = NULL;
+    int result = io_uring_submit_and_wait(&stream->ring, 1);
+    // NOTE(Ryan): Anything else will fail the same way next time round, so rather than spin, stop using the ring.
+    // Chunks it already took are never reaped; their reads are redone by copying and the staging buffers leak
+    if (result < 0 && result != -EINTR && result != -EAGAIN && result != -EBUSY) {
+      SDL_LogWarn("Unable to submit asset stream reads, streaming assets with copies: %s", strerror(-result));
+      stream->has_ring_failed = true;
+      if (current_read != NULL) {
+        sdl_asset_stream_copy_abandoned_read(stream, current_read);
+      }
+      for (uint chunk_i = 0; chunk_i < SDL_ASSET_STREAM_DEPTH; ++chunk_i) {
+        if (stream->chunks[chunk_i].read != NULL) {
+          sdl_asset_stream_copy_abandoned_read(stream, stream->chunks[chunk_i].read);
+        }
+      }
+      return sdl_asset_stream_copy_thread(stream);
+    }
+    unsigned head = 0;
+    unsigned cqe_count = 0;
+    io_uring_for_each_cqe(&stream->ring, head, cqe) {
+      uint chunk_i = (uint)(uintptr_t)io_uring_cqe_get_data(cqe);
+      HHAssetRead* read = stream->chunks[chunk_i].read;
+      if (sdl_asset_stream_complete_chunk(stream, chunk_i, cqe->res)) {
+        --in_flight_count;
+        --read->chunks_in_flight;
+        // NOTE(Ryan): Done once nothing is in flight and nothing more will be issued for it
+        if (read->chunks_in_flight == 0 && read != current_read) {
+          sdl_asset_stream_retire(stream, read);
+        }
+      }
+      ++cqe_count;
+    }
+    io_uring_cq_advance(&stream->ring, cqe_count);
+
+    // NOTE(Ryan): A read that failed part way stops issuing chunks
+    if (current_read != NULL && current_read->has_failed) {
+      if (current_read->chunks_in_flight == 0) {
+        sdl_asset_stream_retire(stream, current_read);
+      }
+      current_read = NULL;
+    }
+  }
+
+  if (current_read != NULL) {
+    current_read->has_failed = true;
+    if (current_read->chunks_in_flight == 0) {
+      sdl_asset_stream_retire(stream, current_read);
+    }
+  }
+  return 0;
+}
+
+INTERNAL bool
+sdl_init_asset_stream_uring(HHAssetStream* stream, char const* file_name)
+{
+  stream->fd = open(file_name, O_RDONLY | O_CLOEXEC);
+  if (stream->fd < 0) {
+    SDL_LogWarn("Unable to open asset pack '%s' for streaming: %s", file_name, strerror(errno));
+    return false;
+  }
+  int result = io_uring_queue_init(SDL_ASSET_STREAM_DEPTH * 2, &stream->ring, 0);
+  if (result < 0) {
+    SDL_LogWarn("Unable to create io_uring, streaming assets with threads: %s", strerror(-result));
+    close(stream->fd);
+    return false;
+  }
+  stream->staging = aligned_alloc(4096, SDL_ASSET_STREAM_DEPTH * SDL_ASSET_STREAM_CHUNK_SIZE);
+  if (stream->staging == NULL) {
+    SDL_LogWarn("Unable to allocate asset stream staging buffers");
+    io_uring_queue_exit(&stream->ring);
+    close(stream->fd);
+    return false;
+  }
+  // NOTE(Ryan): Pinning the staging buffers once saves the kernel mapping them on every read
+  struct iovec staging_iovec = {.iov_base = stream->staging, .iov_len = SDL_ASSET_STREAM_DEPTH * SDL_ASSET_STREAM_CHUNK_SIZE};
+  stream->has_registered_staging = (io_uring_register_buffers(&stream->ring, &staging_iovec, 1) == 0);
+  return true;
+}
+#endif
+
+INTERNAL HHAssetStream*
+sdl_create_asset_stream(HHAssetPack const* pack, char const* file_name)
+{
+  if (pack->base == NULL) {
+    return NULL;
+  }
+
+  HHAssetStream* stream = SDL_calloc(1, sizeof(HHAssetStream));
+  if (stream == NULL) {
+    SDL_LogWarn("Unable to allocate asset stream");
+    return NULL;
+  }
+  stream->pack = pack;
+  stream->request_semaphore = SDL_CreateSemaphore(0);
+  if (stream->request_semaphore == NULL) {
+    SDL_LogWarn("Unable to create asset stream semaphore: %s", SDL_GetError());
+    SDL_free(stream);
+    return NULL;
+  }
+  atomic_flag_clear(&stream->lock);
+  atomic_store(&stream->is_running, true);
+
+#if defined(HH_USE_IO_URING)
+  stream->is_using_io_uring = sdl_init_asset_stream_uring(stream, file_name);
+  if (stream->is_using_io_uring) {
+    stream->threads[0] = SDL_CreateThread(sdl_asset_stream_uring_thread, "hh-stream", stream);
+    if (stream->threads[0] != NULL) {
+      stream->thread_count = 1;
+      return stream;
+    }
+    SDL_LogWarn("Unable to create asset stream thread: %s", SDL_GetError());
+    io_uring_queue_exit(&stream->ring);
+    free(stream->staging);
+    close(stream->fd);
+    stream->is_using_io_uring = false;
+  }
+#else
+  (void)file_name;
+#endif
+
+  for (uint thread_i = 0; thread_i < SDL_ASSET_STREAM_COPY_THREAD_COUNT; ++thread_i) {
+    stream->threads[thread_i] = SDL_CreateThread(sdl_asset_stream_copy_thread, "hh-stream", stream);
+    if (stream->threads[thread_i] == NULL) {
+      SDL_LogWarn("Unable to create asset stream thread %u: %s", thread_i, SDL_GetError());
+      break;
+    }
+    ++stream->thread_count;
+  }
+  if (stream->thread_count == 0) {
+    SDL_DestroySemaphore(stream->request_semaphore);
+    SDL_free(stream);
+    return NULL;
+  }
+
+  return stream;
+}
+
+// NOTE(Ryan): Called on the game thread before a replay snapshot is taken or restored. Queued reads are cancelled,
+// so the game requests them again, and reads already started are waited on. Afterwards no read in game memory is
+// pending and no stream thread will write there, so a snapshot never captures or resurrects a read in flight.
+INTERNAL void
+sdl_quiesce_asset_stream(HHAssetStream* stream)
+{
+  if (stream == NULL) {
+    return;
+  }
+
+  while (atomic_flag_test_and_set_explicit(&stream->lock, memory_order_acquire)) {
+    SDL_CPUPauseInstruction();
+  }
+  while (stream->read_index != stream->write_index) {
+    HHAssetRead* read = stream->requests[stream->read_index++ & (SDL_ASSET_STREAM_QUEUE_LENGTH - 1)];
+    atomic_store_explicit(&read->state, HH_ASSET_READ_CANCELLED, memory_order_release);
+  }
+  atomic_flag_clear_explicit(&stream->lock, memory_order_release);
+
+  // NOTE(Ryan): At most a few chunks per active read, and only on a replay key press
+  while (atomic_load_explicit(&stream->active_read_count, memory_order_acquire) > 0) {
+    SDL_Delay(1);
+  }
+}
+
+// NOTE(Ryan): Reads still queued are left pending; anything already started finishes or fails first
+INTERNAL void
+sdl_destroy_asset_stream(HHAssetStream* stream)
+{
+  atomic_store(&stream->is_running, false);
+  for (uint thread_i = 0; thread_i < stream->thread_count; ++thread_i) {
+    SDL_SemPost(stream->request_semaphore);
+  }
+  for (uint thread_i = 0; thread_i < stream->thread_count; ++thread_i) {
+    SDL_WaitThread(stream->threads[thread_i], NULL);
+  }
+
+#if defined(HH_USE_IO_URING)
+  if (stream->is_using_io_uring) {
+    io_uring_queue_exit(&stream->ring);
+    if (!stream->has_ring_failed) {
+      free(stream->staging);
+    }
+    close(stream->fd);
+  }
+#endif
+  SDL_DestroySemaphore(stream->request_semaphore);
+  SDL_free(stream);
+}
@@ -0,0 +1,39 @@
+// NOTE(Ryan): Game side view of the asset pack. Bitmaps and sounds handed out here point straight into the
+// platform's read-only mapping: never write through them, and there is nothing to free.
+
+typedef struct {
+  uint width;
+  uint height;
+  uint pitch;
+  // NOTE(Ryan): Premultiplied 0xAARRGGBB, top row first
+  u32 const* pixels;
+} HHBitmap;
+
+INTERNAL bool
+hh_get_bitmap(HHAssetPack const* pack, char const* name, HHBitmap* bitmap)
+{
+  HHAssetEntry const* entry = hh_find_asset(pack, name);
+  if (entry == NULL || entry->type != HH_ASSET_TYPE_BITMAP) {
+    return false;
+  }
+  bitmap->width = entry->bitmap.width;
+  bitmap->height = entry->bitmap.height;
+  bitmap->pitch = entry->bitmap.pitch;
+  bitmap->pixels = (u32 const *)hh_get_asset_payload(pack, entry);
+  return true;
+}
+
+// NOTE(Ryan): HHSound.samples is not const so the mixer can also play generated sounds; it only reads it
+INTERNAL bool
+hh_get_sound(HHAssetPack const* pack, char const* name, HHSound* sound)
+{
+  HHAssetEntry const* entry = hh_find_asset(pack, name);
+  if (entry == NULL || entry->type != HH_ASSET_TYPE_SOUND) {
+    return false;
+  }
+  sound->samples_per_second = entry->sound.samples_per_second;
+  sound->sample_count = entry->sound.sample_count;
+  sound->channel_count = entry->sound.channel_count;
+  sound->samples = (int16 *)hh_get_asset_payload(pack, entry);
+  return true;
+}
@@ -0,0 +1,119 @@
+// NOTE(Ryan): Single producer/single consumer ring of interleaved stereo S16 frames.
+// The main thread is the only writer and the audio device's thread (SDL callback or ALSA writer) the only reader,
+// so each index is stored by one side only and nothing blocks. Indices increase forever and are masked on access.
+// Each frame the game is asked for exactly enough samples to bring the queue up to the target latency
+// plus one frame of playback, so a long frame eats into the queued latency rather than growing it.
+
+#define SDL_AUDIO_CHANNELS 2
+#define SDL_AUDIO_TARGET_LATENCY_MS 40
+
+typedef struct {
+  int16* samples;
+  u32 capacity;
+  u32 samples_per_second;
+  u32 target_latency_frames;
+  // NOTE(Ryan): Written by different threads, so kept on separate cache lines
+  alignas(64) _Atomic u64 write_index;
+  alignas(64) _Atomic u64 read_index;
+  _Atomic u64 underrun_count;
+} SDLAudioRing;
+
+INTERNAL STATUS
+sdl_init_audio_ring(SDLAudioRing* ring, u32 samples_per_second, u32 target_latency_ms)
+{
+  ring->samples_per_second = samples_per_second;
+  ring->target_latency_frames = (samples_per_second * target_latency_ms) / 1000;
+
+  // NOTE(Ryan): Room for the target latency plus a few frames of slack, rounded up so indices can be masked
+  u32 min_capacity = ring->target_latency_frames + samples_per_second / 10;
+  ring->capacity = 1;
+  while (ring->capacity < min_capacity) {
+    ring->capacity <<= 1;
+  }
+
+  ring->samples = calloc(ring->capacity, sizeof(int16) * SDL_AUDIO_CHANNELS);
+  if (ring->samples == NULL) {
+    SDL_LogWarn("Unable to allocate audio ring: %s", strerror(errno));
+    return FAILED;
+  }
+  atomic_store(&ring->write_index, 0);
+  atomic_store(&ring->read_index, 0);
+  atomic_store(&ring->underrun_count, 0);
+
+  return SUCCEEDED;
+}
+
+INTERNAL u32
+sdl_audio_ring_queued_frames(SDLAudioRing* ring)
+{
+  u64 read_index = atomic_load_explicit(&ring->read_index, memory_order_acquire);
+  u64 write_index = atomic_load_explicit(&ring->write_index, memory_order_relaxed);
+  return (u32)(write_index - read_index);
+}
+
+// NOTE(Ryan): Producer side. How many frames the game should mix for a frame lasting frame_dt seconds.
+INTERNAL u32
+sdl_audio_ring_frames_to_write(SDLAudioRing* ring, float frame_dt)
+{
+  u32 queued_frames = sdl_audio_ring_queued_frames(ring);
+  u32 frames_per_game_frame = (u32)(ring->samples_per_second * frame_dt + 0.5f);
+  u32 wanted_frames = ring->target_latency_frames + frames_per_game_frame;
+
+  u32 frames_to_write = (queued_frames < wanted_frames) ? wanted_frames - queued_frames : 0;
+  if (frames_to_write > ring->capacity - queued_frames) {
+    frames_to_write = ring->capacity - queued_frames;
+  }
+  return frames_to_write;
+}
+
+// NOTE(Ryan): Producer side.
+INTERNAL u32
+sdl_audio_ring_write(SDLAudioRing* ring, int16 const* samples, u32 frame_count)
+{
+  u64 write_index = atomic_load_explicit(&ring->write_index, memory_order_relaxed);
+  u64 read_index = atomic_load_explicit(&ring->read_index, memory_order_acquire);
+  u32 free_frames = ring->capacity - (u32)(write_index - read_index);
+  if (frame_count > free_frames) {
+    frame_count = free_frames;
+  }
+
+  u32 start = (u32)(write_index & (ring->capacity - 1));
+  u32 first_count = (start + frame_count <= ring->capacity) ? frame_count : ring->capacity - start;
+  u32 frame_size = sizeof(int16) * SDL_AUDIO_CHANNELS;
+  memcpy(ring->samples + start * SDL_AUDIO_CHANNELS, samples, first_count * frame_size);
+  memcpy(ring->samples, samples + first_count * SDL_AUDIO_CHANNELS, (frame_count - first_count) * frame_size);
+
+  atomic_store_explicit(&ring->write_index, write_index + frame_count, memory_order_release);
+  return frame_count;
+}
+
+// NOTE(Ryan): Consumer side. Any frames the ring cannot supply are filled with silence and counted as an underrun.
+INTERNAL u32
+sdl_audio_ring_read(SDLAudioRing* ring, int16* samples, u32 frame_count)
+{
+  u64 read_index = atomic_load_explicit(&ring->read_index, memory_order_relaxed);
+  u64 write_index = atomic_load_explicit(&ring->write_index, memory_order_acquire);
+  u32 available_frames = (u32)(write_index - read_index);
+  u32 read_count = (frame_count < available_frames) ? frame_count : available_frames;
+
+  u32 start = (u32)(read_index & (ring->capacity - 1));
+  u32 first_count = (start + read_count <= ring->capacity) ? read_count : ring->capacity - start;
+  u32 frame_size = sizeof(int16) * SDL_AUDIO_CHANNELS;
+  memcpy(samples, ring->samples + start * SDL_AUDIO_CHANNELS, first_count * frame_size);
+  memcpy(samples + first_count * SDL_AUDIO_CHANNELS, ring->samples, (read_count - first_count) * frame_size);
+
+  atomic_store_explicit(&ring->read_index, read_index + read_count, memory_order_release);
+
+  if (read_count < frame_count) {
+    memset(samples + read_count * SDL_AUDIO_CHANNELS, 0, (frame_count - read_count) * frame_size);
+    atomic_fetch_add_explicit(&ring->underrun_count, 1, memory_order_relaxed);
+  }
+  return read_count;
+}
+
+INTERNAL void
+sdl_audio_callback(void* user_data, u8* stream, int stream_size)
+{
+  SDLAudioRing* ring = (SDLAudioRing *)user_data;
+  sdl_audio_ring_read(ring, (int16 *)stream, stream_size / (sizeof(int16) * SDL_AUDIO_CHANNELS));
+}
@@ -0,0 +1,788 @@
+// NOTE(Ryan): Micro-benchmarks for the per-frame hot paths: gradient row kernels and the tiled renderer across
+// resolutions and thread counts, the sprite blitter, rotated and scaled quads, whole sprite frames drawn
+// directly and through a tiled render group, X11 presents (XPutImage against MIT-SHM), stick transforms, the mixer and the audio ring. Built with release flags by unix-build.bash as hh-bench.
+//
+// Each case is sized so one sample lasts at least BENCH_MIN_SAMPLE_MS, run once to warm caches and page in
+// buffers, then sampled --repeats times. Reported are the median and minimum time per iteration, the median
+// absolute deviation as a noise figure, and cycles per unit (pixel, stick or sample frame) from the time
+// stamp counter. A regression is a median shift well outside the noise.
+//
+// usage: hh-bench [--filter substring] [--repeats n] [--csv]
+
+#define HH_HEADLESS
+#include "hh.c"
+
+#if defined(LINUX)
+  #include <X11/Xlib.h>
+  #include <X11/Xutil.h>
+  #include <X11/extensions/XShm.h>
+  #include <sys/ipc.h>
+  #include <sys/shm.h>
+#endif
+
+#define BENCH_MIN_SAMPLE_MS 2
+#define BENCH_MAX_REPEATS 255
+
+typedef void (BenchFunction)(void* data);
+
+typedef struct {
+  char const* filter;
+  uint repeats;
+  bool print_csv;
+} BenchOptions;
+
+INTERNAL int
+bench_compare_doubles(void const* a, void const* b)
+{
+  double first = *(double const *)a;
+  double second = *(double const *)b;
+  return (first < second) ? -1 : (first > second);
+}
+
+INTERNAL double
+bench_median(double* values, uint count)
+{
+  qsort(values, count, sizeof(double), bench_compare_doubles);
+  return (count % 2) ? values[count / 2] : 0.5 * (values[count / 2 - 1] + values[count / 2]);
+}
+
+// NOTE(Ryan): units_per_iteration is what cycles are divided by, e.g. the pixel count of one frame
+INTERNAL void
+bench_run(BenchOptions* options, char const* name, BenchFunction* function, void* data, u64 units_per_iteration)
+{
+  if (options->filter != NULL && strstr(name, options->filter) == NULL) {
+    return;
+  }
+
+  u64 counter_frequency = SDL_GetPerformanceFrequency();
+  u64 start_counter = SDL_GetPerformanceCounter();
+  function(data);
+  u64 single_ticks = SDL_GetPerformanceCounter() - start_counter;
+  u64 min_sample_ticks = (counter_frequency * BENCH_MIN_SAMPLE_MS) / 1000;
+  u64 iteration_count = (single_ticks >= min_sample_ticks) ? 1 : min_sample_ticks / (single_ticks + 1) + 1;
+
+  for (u64 iteration_i = 0; iteration_i < iteration_count; ++iteration_i) {
+    function(data);
+  }
+
+  double sample_ns[BENCH_MAX_REPEATS] = {0};
+  double sample_cycles[BENCH_MAX_REPEATS] = {0};
+  for (uint repeat_i = 0; repeat_i < options->repeats; ++repeat_i) {
+    u64 sample_start_cycles = hh_read_cycle_counter();
+    u64 sample_start_counter = SDL_GetPerformanceCounter();
+    for (u64 iteration_i = 0; iteration_i < iteration_count; ++iteration_i) {
+      function(data);
+    }
+    u64 sample_ticks = SDL_GetPerformanceCounter() - sample_start_counter;
+    u64 sample_cycle_count = hh_read_cycle_counter() - sample_start_cycles;
+    sample_ns[repeat_i] = (1e9 * sample_ticks) / counter_frequency / iteration_count;
+    sample_cycles[repeat_i] = (double)sample_cycle_count / iteration_count;
+  }
+
+  double median_ns = bench_median(sample_ns, options->repeats);
+  // NOTE(Ryan): bench_median() sorts in place
+  double min_ns = sample_ns[0];
+  double deviations[BENCH_MAX_REPEATS] = {0};
+  for (uint repeat_i = 0; repeat_i < options->repeats; ++repeat_i) {
+    deviations[repeat_i] = fabs(sample_ns[repeat_i] - median_ns);
+  }
+  double deviation_ns = bench_median(deviations, options->repeats);
+  double cycles_per_unit = bench_median(sample_cycles, options->repeats) / units_per_iteration;
+
+  if (options->print_csv) {
+    printf("%s,%.1f,%.1f,%.1f,%.4f\n", name, median_ns, min_ns, deviation_ns, cycles_per_unit);
+  } else {
+    printf("%-40s %12.1f ns %12.1f ns min  +-%5.1f%%  %9.4f cycles/unit\n", name, median_ns, min_ns,
+           (median_ns > 0.0) ? 100.0 * deviation_ns / median_ns : 0.0, cycles_per_unit);
+  }
+  fflush(stdout);
+}
+
+typedef struct {
+  uint width;
+  uint height;
+} BenchResolution;
+
+GLOBAL BenchResolution bench_resolutions[] = {
+  {640, 360}, {1280, 720}, {1920, 1080}, {3840, 2160}
+};
+
+typedef struct {
+  HHPixelBuffer* pixel_buffer;
+  HHMemory* memory;
+  uint frame_index;
+} BenchRenderData;
+
+INTERNAL void
+bench_render_gradient(void* data)
+{
+  BenchRenderData* render_data = (BenchRenderData *)data;
+  hh_render_gradient(render_data->pixel_buffer, render_data->frame_index, render_data->frame_index * 2);
+  ++render_data->frame_index;
+}
+
+INTERNAL void
+bench_render_gradient_tiled(void* data)
+{
+  BenchRenderData* render_data = (BenchRenderData *)data;
+  hh_render_gradient_tiled(render_data->memory, render_data->pixel_buffer, render_data->frame_index, render_data->frame_index * 2);
+  ++render_data->frame_index;
+}
+
+typedef struct {
+  char const* name;
+  HHRenderGradientRow* row;
+  u32 required_features;
+} BenchGradientKernel;
+
+GLOBAL BenchGradientKernel bench_gradient_kernels[] = {
+  {"scalar", hh_render_gradient_row_scalar, 0},
+#if defined(HH_X86)
+  {"sse2", hh_render_gradient_row_sse2, HH_CPU_FEATURE_SSE2},
+  {"avx2", hh_render_gradient_row_avx2, HH_CPU_FEATURE_AVX2},
+#endif
+#if defined(HH_NEON)
+  {"neon", hh_render_gradient_row_neon, HH_CPU_FEATURE_NEON},
+#endif
+};
+
+INTERNAL void
+bench_renderer(BenchOptions* options)
+{
+  BenchResolution* largest = &bench_resolutions[ARRAY_SIZE(bench_resolutions) - 1];
+  HHPixelBuffer pixel_buffer = {0};
+  pixel_buffer.memory = aligned_alloc(64, largest->width * largest->height * BYTES_PER_PIXEL);
+  if (pixel_buffer.memory == NULL) {
+    SDL_LogWarn("Unable to allocate benchmark pixel buffer: %s", strerror(errno));
+    return;
+  }
+  char name[128] = {0};
+
+  for (uint kernel_i = 0; kernel_i < ARRAY_SIZE(bench_gradient_kernels); ++kernel_i) {
+    BenchGradientKernel* kernel = &bench_gradient_kernels[kernel_i];
+    if ((sdl_info.cpu_features & kernel->required_features) != kernel->required_features) {
+      continue;
+    }
+    hh_render_gradient_row = kernel->row;
+    for (uint resolution_i = 0; resolution_i < ARRAY_SIZE(bench_resolutions); ++resolution_i) {
+      BenchResolution* resolution = &bench_resolutions[resolution_i];
+      pixel_buffer.width = resolution->width;
+      pixel_buffer.height = resolution->height;
+      pixel_buffer.pitch = resolution->width * BYTES_PER_PIXEL;
+      BenchRenderData render_data = {.pixel_buffer = &pixel_buffer};
+      snprintf(name, sizeof(name), "gradient/%s/%ux%u", kernel->name, resolution->width, resolution->height);
+      bench_run(options, name, bench_render_gradient, &render_data, (u64)resolution->width * resolution->height);
+    }
+  }
+
+  // NOTE(Ryan): Tiled path with the kernel the game would pick, doubling threads up to the core count
+  hh_select_render_kernels(sdl_info.cpu_features);
+  for (uint thread_count = 1; ; thread_count *= 2) {
+    if (thread_count > (uint)sdl_info.num_logical_cores) {
+      thread_count = sdl_info.num_logical_cores;
+    }
+    HHMemory memory = {0};
+    memory.cache_line_size = sdl_info.l1_cache_line_size;
+    memory.job_queue = sdl_create_job_queue(thread_count);
+    memory.platform_add_job = platform_add_job;
+    memory.platform_wait_for_jobs = platform_wait_for_jobs;
+    memory.platform_get_thread_index = platform_get_thread_index;
+    if (memory.job_queue == NULL) {
+      break;
+    }
+    memory.job_queue_thread_count = memory.job_queue->thread_count;
+
+    for (uint resolution_i = 0; resolution_i < ARRAY_SIZE(bench_resolutions); ++resolution_i) {
+      BenchResolution* resolution = &bench_resolutions[resolution_i];
+      pixel_buffer.width = resolution->width;
+      pixel_buffer.height = resolution->height;
+      pixel_buffer.pitch = resolution->width * BYTES_PER_PIXEL;
+      BenchRenderData render_data = {.pixel_buffer = &pixel_buffer, .memory = &memory};
+      snprintf(name, sizeof(name), "gradient_tiled/%ux%u/t%u", resolution->width, resolution->height, thread_count);
+      bench_run(options, name, bench_render_gradient_tiled, &render_data, (u64)resolution->width * resolution->height);
+    }
+
+    sdl_destroy_job_queue(memory.job_queue);
+    if (thread_count >= (uint)sdl_info.num_logical_cores) {
+      break;
+    }
+  }
+
+  free(pixel_buffer.memory);
+}
+
+typedef struct {
+  char const* name;
+  HHBlitRow* row;
+  u32 required_features;
+} BenchBlitKernel;
+
+GLOBAL BenchBlitKernel bench_blit_kernels[] = {
+  {"scalar", hh_blit_row_scalar, 0},
+#if defined(HH_X86)
+  {"sse2", hh_blit_row_sse2, HH_CPU_FEATURE_SSE2},
+  {"avx2", hh_blit_row_avx2, HH_CPU_FEATURE_AVX2},
+#endif
+};
+
+#define BENCH_SPRITE_SIZE 64
+#define BENCH_SPRITE_POSITION_COUNT 4096
+
+typedef struct {
+  HHPixelBuffer* pixel_buffer;
+  HHBitmap* bitmap;
+  float (*positions)[2];
+  uint sprite_count;
+  uint frame_index;
+  // NOTE(Ryan): For the render group cases
+  HHMemory* memory;
+  HHMemoryArena* arena;
+  // NOTE(Ryan): For the quad cases
+  float x_axis[2];
+  float y_axis[2];
+} BenchBlitData;
+
+// NOTE(Ryan): Fractional positions partly off screen, so clipping and the fringe columns are on the path
+INTERNAL void
+bench_draw_sprites(void* data)
+{
+  BenchBlitData* blit_data = (BenchBlitData *)data;
+  for (uint sprite_i = 0; sprite_i < blit_data->sprite_count; ++sprite_i) {
+    float* position = blit_data->positions[(sprite_i + blit_data->frame_index) % BENCH_SPRITE_POSITION_COUNT];
+    hh_draw_bitmap(blit_data->pixel_buffer, blit_data->bitmap, position[0], position[1], 0.75f);
+  }
+  ++blit_data->frame_index;
+}
+
+INTERNAL void
+bench_draw_quads(void* data)
+{
+  BenchBlitData* blit_data = (BenchBlitData *)data;
+  for (uint sprite_i = 0; sprite_i < blit_data->sprite_count; ++sprite_i) {
+    float* position = blit_data->positions[(sprite_i + blit_data->frame_index) % BENCH_SPRITE_POSITION_COUNT];
+    hh_draw_quad(blit_data->pixel_buffer, blit_data->bitmap, position[0], position[1], blit_data->x_axis[0],
+                 blit_data->x_axis[1], blit_data->y_axis[0], blit_data->y_axis[1], 0.75f);
+  }
+  ++blit_data->frame_index;
+}
+
+// NOTE(Ryan): A whole frame, clear then sprites, drawn straight into the buffer one sprite at a time
+INTERNAL void
+bench_draw_frame(void* data)
+{
+  BenchBlitData* blit_data = (BenchBlitData *)data;
+  hh_clear_clipped(blit_data->pixel_buffer, hh_get_buffer_clip_rect(blit_data->pixel_buffer), 0xff202020);
+  bench_draw_sprites(data);
+}
+
+// NOTE(Ryan): The same frame through a render group, including the pushes and the sort
+INTERNAL void
+bench_draw_frame_grouped(void* data)
+{
+  BenchBlitData* blit_data = (BenchBlitData *)data;
+  HHTemporaryMemory temporary_memory = hh_begin_temporary_memory(blit_data->arena);
+  HHRenderGroup group = {0};
+  hh_begin_render_group(&group, blit_data->arena, blit_data->arena->size);
+  hh_push_clear(&group, 0, 0xff202020);
+  for (uint sprite_i = 0; sprite_i < blit_data->sprite_count; ++sprite_i) {
+    float* position = blit_data->positions[(sprite_i + blit_data->frame_index) % BENCH_SPRITE_POSITION_COUNT];
+    hh_push_bitmap(&group, 1, blit_data->bitmap, position[0], position[1], 0.75f);
+  }
+  hh_render_group_to_output(blit_data->memory, &group, blit_data->pixel_buffer);
+  hh_end_temporary_memory(temporary_memory);
+  ++blit_data->frame_index;
+}
+
+// NOTE(Ryan): Kernels are meant to be bit-identical, so a mismatch is reported rather than timed past
+INTERNAL bool
+bench_check_blit_kernel(HHBlitRow* row, u32 const* top_row, u32 const* bottom_row, u32 const* dest, uint count)
+{
+  u32* expected = malloc(count * sizeof(u32));
+  u32* actual = malloc(count * sizeof(u32));
+  bool is_identical = (expected != NULL && actual != NULL);
+  HHBlitWeights weights_list[] = {{0, 0, 0, 256}, {64, 64, 64, 64}, {3, 41, 17, 131}, {0, 0, 0, 0}};
+  for (uint weights_i = 0; is_identical && weights_i < ARRAY_SIZE(weights_list); ++weights_i) {
+    memcpy(expected, dest, count * sizeof(u32));
+    memcpy(actual, dest, count * sizeof(u32));
+    hh_blit_row_scalar(expected, top_row, bottom_row, count, weights_list[weights_i]);
+    row(actual, top_row, bottom_row, count, weights_list[weights_i]);
+    is_identical = (memcmp(expected, actual, count * sizeof(u32)) == 0);
+  }
+  free(expected);
+  free(actual);
+  return is_identical;
+}
+
+typedef struct {
+  char const* name;
+  HHQuadRow* row;
+  u32 required_features;
+} BenchQuadKernel;
+
+GLOBAL BenchQuadKernel bench_quad_kernels[] = {
+  {"scalar", hh_draw_quad_row_scalar, 0},
+#if defined(HH_X86)
+  {"sse2", hh_draw_quad_row_sse2, HH_CPU_FEATURE_SSE2},
+  {"avx2", hh_draw_quad_row_avx2, HH_CPU_FEATURE_AVX2},
+#endif
+};
+
+// NOTE(Ryan): The quad colour math is float, so kernels may differ from the scalar one by a step per channel
+INTERNAL bool
+bench_check_quad_kernel(HHQuadRow* row, HHBitmap const* bitmap, u32 const* dest, uint count)
+{
+  u32* expected = malloc(count * sizeof(u32));
+  u32* actual = malloc(count * sizeof(u32));
+  bool is_close = (expected != NULL && actual != NULL);
+  // NOTE(Ryan): Starting off the bitmap's left edge and leaving through its bottom, at an awkward slope
+  HHQuadSpan span = {.pixels = bitmap->pixels, .pitch = bitmap->pitch, .width = bitmap->width,
+                     .height = bitmap->height, .texel_x = -0x18000, .texel_y = 0x2340, .step_x = 0x9e37,
+                     .step_y = 0x5b41};
+  u32 alpha_scales[] = {256, 192, 1};
+  for (uint alpha_i = 0; is_close && alpha_i < ARRAY_SIZE(alpha_scales); ++alpha_i) {
+    span.alpha_scale = alpha_scales[alpha_i];
+    memcpy(expected, dest, count * sizeof(u32));
+    memcpy(actual, dest, count * sizeof(u32));
+    hh_draw_quad_row_scalar(expected, count, &span);
+    row(actual, count, &span);
+    for (uint pixel_i = 0; is_close && pixel_i < count; ++pixel_i) {
+      for (uint shift = 0; shift < 32; shift += 8) {
+        int difference = (int)((expected[pixel_i] >> shift) & 0xff) - (int)((actual[pixel_i] >> shift) & 0xff);
+        is_close = is_close && (difference >= -1 && difference <= 1);
+      }
+    }
+  }
+  free(expected);
+  free(actual);
+  return is_close;
+}
+
+INTERNAL void
+bench_blitter(BenchOptions* options)
+{
+  BenchResolution* resolution = &bench_resolutions[2];
+  HHPixelBuffer pixel_buffer = {.width = resolution->width, .height = resolution->height};
+  pixel_buffer.pitch = pixel_buffer.width * BYTES_PER_PIXEL;
+  pixel_buffer.memory = aligned_alloc(64, pixel_buffer.pitch * pixel_buffer.height);
+  u32* pixels = malloc(BENCH_SPRITE_SIZE * BENCH_SPRITE_SIZE * sizeof(u32));
+  float (*positions)[2] = malloc(BENCH_SPRITE_POSITION_COUNT * sizeof(*positions));
+  if (pixel_buffer.memory == NULL || pixels == NULL || positions == NULL) {
+    SDL_LogWarn("Unable to allocate benchmark blit buffers: %s", strerror(errno));
+    return;
+  }
+  memset(pixel_buffer.memory, 0x40, pixel_buffer.pitch * pixel_buffer.height);
+
+  // NOTE(Ryan): A premultiplied disc with a soft edge, so every alpha value from 0 to 255 turns up
+  for (uint y = 0; y < BENCH_SPRITE_SIZE; ++y) {
+    for (uint x = 0; x < BENCH_SPRITE_SIZE; ++x) {
+      float dx = (x + 0.5f) / BENCH_SPRITE_SIZE * 2.0f - 1.0f;
+      float dy = (y + 0.5f) / BENCH_SPRITE_SIZE * 2.0f - 1.0f;
+      float coverage = 1.0f - sqrtf(dx * dx + dy * dy);
+      u32 alpha = (u32)(255.0f * ((coverage < 0.0f) ? 0.0f : (coverage > 0.25f) ? 1.0f : coverage * 4.0f));
+      u32 red = alpha * x / BENCH_SPRITE_SIZE;
+      u32 green = alpha * y / BENCH_SPRITE_SIZE;
+      pixels[y * BENCH_SPRITE_SIZE + x] = (alpha << 24) | (red << 16) | (green << 8) | (alpha / 2);
+    }
+  }
+  HHBitmap bitmap = {.width = BENCH_SPRITE_SIZE, .height = BENCH_SPRITE_SIZE,
+                     .pitch = BENCH_SPRITE_SIZE * BYTES_PER_PIXEL, .pixels = pixels};
+
+  u32 random_state = 0x9e3779b9;
+  for (uint position_i = 0; position_i < BENCH_SPRITE_POSITION_COUNT; ++position_i) {
+    for (uint axis_i = 0; axis_i < 2; ++axis_i) {
+      random_state = random_state * 1664525 + 1013904223;
+      float extent = (float)((axis_i == 0) ? pixel_buffer.width : pixel_buffer.height) + BENCH_SPRITE_SIZE;
+      positions[position_i][axis_i] = (random_state >> 8) / (float)(1 << 24) * extent - BENCH_SPRITE_SIZE;
+    }
+  }
+
+  uint sprite_counts[] = {1000, 4000, 16000};
+  char name[128] = {0};
+  for (uint kernel_i = 0; kernel_i < ARRAY_SIZE(bench_blit_kernels); ++kernel_i) {
+    BenchBlitKernel* kernel = &bench_blit_kernels[kernel_i];
+    if ((sdl_info.cpu_features & kernel->required_features) != kernel->required_features) {
+      continue;
+    }
+    // NOTE(Ryan): Odd length to cover the scalar tail; the sprite rows and the framebuffer make varied inputs
+    uint check_count = BENCH_SPRITE_SIZE * 2 - 3;
+    if (!bench_check_blit_kernel(kernel->row, pixels, pixels + BENCH_SPRITE_SIZE, pixels + BENCH_SPRITE_SIZE * 16, check_count)) {
+      SDL_LogWarn("Blit kernel '%s' does not match the scalar kernel, skipping", kernel->name);
+      continue;
+    }
+    hh_blit_row = kernel->row;
+    for (uint count_i = 0; count_i < ARRAY_SIZE(sprite_counts); ++count_i) {
+      BenchBlitData blit_data = {.pixel_buffer = &pixel_buffer, .bitmap = &bitmap, .positions = positions,
+                                 .sprite_count = sprite_counts[count_i]};
+      snprintf(name, sizeof(name), "blit/%s/%ux%u/%u", kernel->name, BENCH_SPRITE_SIZE, BENCH_SPRITE_SIZE,
+               sprite_counts[count_i]);
+      bench_run(options, name, bench_draw_sprites, &blit_data,
+                (u64)sprite_counts[count_i] * BENCH_SPRITE_SIZE * BENCH_SPRITE_SIZE);
+    }
+  }
+  hh_select_blit_kernels(sdl_info.cpu_features);
+
+  // NOTE(Ryan): Quads half as big again as the bitmap, axis aligned and turned 30 degrees, per covered pixel
+  float quad_size = BENCH_SPRITE_SIZE * 1.5f;
+  float quad_angles[] = {0.0f, 30.0f};
+  uint quad_counts[] = {1000, 4000};
+  for (uint kernel_i = 0; kernel_i < ARRAY_SIZE(bench_quad_kernels); ++kernel_i) {
+    BenchQuadKernel* kernel = &bench_quad_kernels[kernel_i];
+    if ((sdl_info.cpu_features & kernel->required_features) != kernel->required_features) {
+      continue;
+    }
+    if (!bench_check_quad_kernel(kernel->row, &bitmap, pixels + BENCH_SPRITE_SIZE * 16, BENCH_SPRITE_SIZE * 2 - 3)) {
+      SDL_LogWarn("Quad kernel '%s' does not match the scalar kernel, skipping", kernel->name);
+      continue;
+    }
+    hh_draw_quad_row = kernel->row;
+    for (uint angle_i = 0; angle_i < ARRAY_SIZE(quad_angles); ++angle_i) {
+      float radians = quad_angles[angle_i] * (3.14159265f / 180.0f);
+      for (uint count_i = 0; count_i < ARRAY_SIZE(quad_counts); ++count_i) {
+        BenchBlitData blit_data = {.pixel_buffer = &pixel_buffer, .bitmap = &bitmap, .positions = positions,
+                                   .sprite_count = quad_counts[count_i],
+                                   .x_axis = {quad_size * cosf(radians), quad_size * sinf(radians)},
+                                   .y_axis = {-quad_size * sinf(radians), quad_size * cosf(radians)}};
+        snprintf(name, sizeof(name), "quad/%s/%.0fx%.0f/r%.0f/%u", kernel->name, quad_size, quad_size,
+                 quad_angles[angle_i], quad_counts[count_i]);
+        bench_run(options, name, bench_draw_quads, &blit_data,
+                  (u64)quad_counts[count_i] * (u64)(quad_size * quad_size));
+      }
+    }
+  }
+  hh_select_quad_kernels(sdl_info.cpu_features);
+
+  // NOTE(Ryan): Direct against tiled render group, per frame pixel. Tiling pays off as overdraw grows, since a
+  // direct draw streams the frame through memory once per layer.
+  u64 arena_size = MEGABYTES(4);
+  void* arena_memory = aligned_alloc(64, arena_size);
+  if (arena_memory == NULL) {
+    SDL_LogWarn("Unable to allocate benchmark render group: %s", strerror(errno));
+  }
+  u64 frame_pixel_count = (u64)pixel_buffer.width * pixel_buffer.height;
+  for (uint count_i = 0; arena_memory != NULL && count_i < ARRAY_SIZE(sprite_counts); ++count_i) {
+    BenchBlitData blit_data = {.pixel_buffer = &pixel_buffer, .bitmap = &bitmap, .positions = positions,
+                               .sprite_count = sprite_counts[count_i]};
+    snprintf(name, sizeof(name), "frame/direct/%u", sprite_counts[count_i]);
+    bench_run(options, name, bench_draw_frame, &blit_data, frame_pixel_count);
+
+    for (uint thread_count = 1; ; thread_count *= 2) {
+      if (thread_count > (uint)sdl_info.num_logical_cores) {
+        thread_count = sdl_info.num_logical_cores;
+      }
+      HHMemory memory = {0};
+      memory.cache_line_size = sdl_info.l1_cache_line_size;
+      memory.platform_add_job = platform_add_job;
+      memory.platform_wait_for_jobs = platform_wait_for_jobs;
+      memory.platform_get_thread_index = platform_get_thread_index;
+      // NOTE(Ryan): One thread runs the tiles inline, so it measures tiling alone
+      if (thread_count > 1) {
+        memory.job_queue = sdl_create_job_queue(thread_count);
+        if (memory.job_queue == NULL) {
+          break;
+        }
+        memory.job_queue_thread_count = memory.job_queue->thread_count;
+      }
+      HHMemoryArena arena = {0};
+      hh_arena_init(&arena, "bench render group", arena_memory, arena_size);
+      blit_data.memory = &memory;
+      blit_data.arena = &arena;
+
+      snprintf(name, sizeof(name), "frame/render_group/%u/t%u", sprite_counts[count_i], thread_count);
+      bench_run(options, name, bench_draw_frame_grouped, &blit_data, frame_pixel_count);
+
+      if (memory.job_queue != NULL) {
+        sdl_destroy_job_queue(memory.job_queue);
+      }
+      if (thread_count >= (uint)sdl_info.num_logical_cores) {
+        break;
+      }
+    }
+  }
+
+  free(arena_memory);
+  free(positions);
+  free(pixels);
+  free(pixel_buffer.memory);
+}
+
+#if defined(LINUX)
+typedef struct {
+  Display* display;
+  Window window;
+  GC graphics_context;
+  XImage* image;
+  bool is_shared;
+  uint width;
+  uint height;
+} BenchPresentData;
+
+// NOTE(Ryan): XSync waits for the server to have consumed the image, so each iteration is a complete present
+INTERNAL void
+bench_present(void* data)
+{
+  BenchPresentData* present_data = (BenchPresentData *)data;
+  if (present_data->is_shared) {
+    XShmPutImage(present_data->display, present_data->window, present_data->graphics_context, present_data->image,
+                 0, 0, 0, 0, present_data->width, present_data->height, False);
+  } else {
+    XPutImage(present_data->display, present_data->window, present_data->graphics_context, present_data->image,
+              0, 0, 0, 0, present_data->width, present_data->height);
+  }
+  XSync(present_data->display, False);
+}
+
+INTERNAL void
+bench_presents(BenchOptions* options)
+{
+  Display* display = XOpenDisplay(NULL);
+  if (display == NULL) {
+    printf("present/*: skipped, no X display\n");
+    return;
+  }
+  int screen = DefaultScreen(display);
+  XVisualInfo visual_info = {0};
+  if (!XMatchVisualInfo(display, screen, 24, TrueColor, &visual_info)) {
+    printf("present/*: skipped, no 24-bit TrueColor visual\n");
+    XCloseDisplay(display);
+    return;
+  }
+  bool have_shm = XShmQueryExtension(display);
+  char name[128] = {0};
+
+  for (uint resolution_i = 0; resolution_i < ARRAY_SIZE(bench_resolutions); ++resolution_i) {
+    BenchResolution* resolution = &bench_resolutions[resolution_i];
+    BenchPresentData present_data = {.display = display, .width = resolution->width, .height = resolution->height};
+    present_data.window = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0,
+                                              resolution->width, resolution->height, 0, 0, 0);
+    XMapWindow(display, present_data.window);
+    present_data.graphics_context = DefaultGC(display, screen);
+    u64 pixel_count = (u64)resolution->width * resolution->height;
+
+    void* pixels = calloc(pixel_count, BYTES_PER_PIXEL);
+    present_data.image = XCreateImage(display, visual_info.visual, visual_info.depth, ZPixmap, 0, pixels,
+                                      resolution->width, resolution->height, 32, resolution->width * BYTES_PER_PIXEL);
+    if (present_data.image != NULL) {
+      snprintf(name, sizeof(name), "present/xputimage/%ux%u", resolution->width, resolution->height);
+      bench_run(options, name, bench_present, &present_data, pixel_count);
+      // NOTE(Ryan): XDestroyImage frees the pixels too
+      XDestroyImage(present_data.image);
+    }
+
+    if (have_shm) {
+      XShmSegmentInfo shm_info = {0};
+      present_data.image = XShmCreateImage(display, visual_info.visual, visual_info.depth, ZPixmap, NULL, &shm_info,
+                                           resolution->width, resolution->height);
+      shm_info.shmid = shmget(IPC_PRIVATE, pixel_count * BYTES_PER_PIXEL, IPC_CREAT | 0600);
+      if (present_data.image != NULL && shm_info.shmid >= 0) {
+        shm_info.shmaddr = present_data.image->data = shmat(shm_info.shmid, NULL, 0);
+        shm_info.readOnly = False;
+        XShmAttach(display, &shm_info);
+        XSync(display, False);
+        // NOTE(Ryan): Marked for removal now so the segment cannot leak if we die mid-run
+        shmctl(shm_info.shmid, IPC_RMID, NULL);
+
+        present_data.is_shared = true;
+        snprintf(name, sizeof(name), "present/xshm/%ux%u", resolution->width, resolution->height);
+        bench_run(options, name, bench_present, &present_data, pixel_count);
+
+        XShmDetach(display, &shm_info);
+        shmdt(shm_info.shmaddr);
+      }
+      if (present_data.image != NULL) {
+        present_data.image->data = NULL;
+        XDestroyImage(present_data.image);
+      }
+    }
+
+    XDestroyWindow(display, present_data.window);
+  }
+
+  XCloseDisplay(display);
+}
+#endif
+
+#define BENCH_STICK_COUNT 4096
+
+typedef struct {
+  int16 raw_values[BENCH_STICK_COUNT];
+  float normalized_values[BENCH_STICK_COUNT];
+} BenchStickData;
+
+INTERNAL void
+bench_normalize_sticks(void* data)
+{
+  BenchStickData* stick_data = (BenchStickData *)data;
+  for (uint stick_i = 0; stick_i < BENCH_STICK_COUNT; ++stick_i) {
+    stick_data->normalized_values[stick_i] = sdl_normalize_stick(stick_data->raw_values[stick_i]);
+  }
+}
+
+INTERNAL void
+bench_quantize_sticks(void* data)
+{
+  BenchStickData* stick_data = (BenchStickData *)data;
+  for (uint stick_i = 0; stick_i < BENCH_STICK_COUNT; ++stick_i) {
+    stick_data->normalized_values[stick_i] = sdl_dequantize_stick(sdl_quantize_stick(stick_data->normalized_values[stick_i]));
+  }
+}
+
+INTERNAL void
+bench_input(BenchOptions* options)
+{
+  BenchStickData* stick_data = calloc(1, sizeof(BenchStickData));
+  if (stick_data == NULL) {
+    return;
+  }
+  // NOTE(Ryan): Fixed pseudo-random sweep covering the deadzone and both extremes
+  u32 random_state = 0x12345678;
+  for (uint stick_i = 0; stick_i < BENCH_STICK_COUNT; ++stick_i) {
+    random_state = random_state * 1664525 + 1013904223;
+    stick_data->raw_values[stick_i] = (int16)(random_state >> 16);
+  }
+
+  bench_run(options, "input/normalize_stick", bench_normalize_sticks, stick_data, BENCH_STICK_COUNT);
+  bench_run(options, "input/quantize_stick", bench_quantize_sticks, stick_data, BENCH_STICK_COUNT);
+  free(stick_data);
+}
+
+typedef struct {
+  HHMixer mixer;
+  HHMemoryArena* scratch_arena;
+  HHSoundBuffer* sound_buffer;
+} BenchMixerData;
+
+INTERNAL void
+bench_mixer_output(void* data)
+{
+  BenchMixerData* mixer_data = (BenchMixerData *)data;
+  hh_mixer_output(&mixer_data->mixer, mixer_data->scratch_arena, mixer_data->sound_buffer);
+}
+
+typedef struct {
+  SDLAudioRing* ring;
+  int16* samples;
+  u32 frame_count;
+} BenchAudioRingData;
+
+INTERNAL void
+bench_audio_ring(void* data)
+{
+  BenchAudioRingData* ring_data = (BenchAudioRingData *)data;
+  sdl_audio_ring_write(ring_data->ring, ring_data->samples, ring_data->frame_count);
+  sdl_audio_ring_read(ring_data->ring, ring_data->samples, ring_data->frame_count);
+}
+
+INTERNAL void
+bench_audio(BenchOptions* options)
+{
+  uint samples_per_second = 48000;
+  // NOTE(Ryan): One 60Hz frame of output, from a 44.1kHz source so the resampler is on the path as in game
+  uint frame_sample_count = samples_per_second / 60;
+  HHSound sound = {.samples_per_second = 44100, .sample_count = 44100, .channel_count = 2};
+  sound.samples = calloc(sound.sample_count, sizeof(int16) * 2);
+  HHSoundBuffer sound_buffer = {.samples_per_second = samples_per_second, .sample_count = frame_sample_count};
+  sound_buffer.samples = calloc(frame_sample_count, sizeof(int16) * SDL_AUDIO_CHANNELS);
+
+  u64 arena_size = MEGABYTES(4);
+  void* arena_memory = malloc(arena_size * 2);
+  if (sound.samples == NULL || sound_buffer.samples == NULL || arena_memory == NULL) {
+    SDL_LogWarn("Unable to allocate benchmark audio buffers: %s", strerror(errno));
+    return;
+  }
+  for (uint sample_i = 0; sample_i < sound.sample_count * 2; ++sample_i) {
+    sound.samples[sample_i] = (int16)(sinf(sample_i * 0.01f) * 8000.0f);
+  }
+
+  struct {
+    char const* name;
+    u32 features;
+  } mixer_levels[] = {
+    {"scalar", 0},
+    {"sse2", HH_CPU_FEATURE_SSE2},
+    {"avx2", HH_CPU_FEATURE_SSE2 | HH_CPU_FEATURE_AVX2},
+  };
+  uint voice_counts[] = {1, 16, 64, 256};
+  char name[128] = {0};
+
+  for (uint level_i = 0; level_i < ARRAY_SIZE(mixer_levels); ++level_i) {
+    if ((sdl_info.cpu_features & mixer_levels[level_i].features) != mixer_levels[level_i].features) {
+      continue;
+    }
+    hh_select_mixer_kernels(mixer_levels[level_i].features);
+
+    for (uint count_i = 0; count_i < ARRAY_SIZE(voice_counts); ++count_i) {
+      HHMemoryArena voice_arena = {0};
+      HHMemoryArena scratch_arena = {0};
+      hh_arena_init(&voice_arena, "bench voices", arena_memory, arena_size);
+      hh_arena_init(&scratch_arena, "bench scratch", (u8 *)arena_memory + arena_size, arena_size);
+
+      BenchMixerData mixer_data = {.scratch_arena = &scratch_arena, .sound_buffer = &sound_buffer};
+      hh_init_mixer(&mixer_data.mixer, &voice_arena);
+      for (uint voice_i = 0; voice_i < voice_counts[count_i]; ++voice_i) {
+        float pan = (voice_i % 3) - 1.0f;
+        hh_mixer_play(&mixer_data.mixer, &sound, 1.0f / voice_counts[count_i], pan, true);
+      }
+
+      snprintf(name, sizeof(name), "audio/mix/%s/%uv", mixer_levels[level_i].name, voice_counts[count_i]);
+      bench_run(options, name, bench_mixer_output, &mixer_data, frame_sample_count);
+    }
+  }
+  hh_select_mixer_kernels(sdl_info.cpu_features);
+
+  SDLAudioRing ring = {0};
+  if (sdl_init_audio_ring(&ring, samples_per_second, SDL_AUDIO_TARGET_LATENCY_MS) == SUCCEEDED) {
+    BenchAudioRingData ring_data = {.ring = &ring, .samples = sound_buffer.samples, .frame_count = frame_sample_count};
+    bench_run(options, "audio/ring_write_read", bench_audio_ring, &ring_data, frame_sample_count);
+    free(ring.samples);
+  }
+
+  free(arena_memory);
+  free(sound_buffer.samples);
+  free(sound.samples);
+}
+
+int
+main(int argc, char* argv[argc + 1])
+{
+  BenchOptions options = {.repeats = 31};
+  for (int arg_i = 1; arg_i < argc; ++arg_i) {
+    if (strcmp(argv[arg_i], "--csv") == 0) {
+      options.print_csv = true;
+    } else if (strcmp(argv[arg_i], "--filter") == 0 && arg_i + 1 < argc) {
+      options.filter = argv[++arg_i];
+    } else if (strcmp(argv[arg_i], "--repeats") == 0 && arg_i + 1 < argc) {
+      options.repeats = (uint)strtoul(argv[++arg_i], NULL, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--filter substring] [--repeats n] [--csv]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (options.repeats == 0 || options.repeats > BENCH_MAX_REPEATS) {
+    fprintf(stderr, "--repeats must be in [1, %d]\n", BENCH_MAX_REPEATS);
+    return EXIT_FAILURE;
+  }
+
+  if (SDL_Init(0) < 0) {
+    SDL_LogCritical("Unable to initialize SDL: %s", SDL_GetError());
+    return EXIT_FAILURE;
+  }
+  sdl_get_info();
+
+  if (options.print_csv) {
+    printf("name,median_ns,min_ns,mad_ns,cycles_per_unit\n");
+  } else {
+    printf("%d logical cores, cpu features 0x%x, %d repeats; cycles are time stamp counter cycles\n",
+           sdl_info.num_logical_cores, sdl_info.cpu_features, options.repeats);
+  }
+
+  bench_renderer(&options);
+  bench_blitter(&options);
+#if defined(LINUX)
+  bench_presents(&options);
+#endif
+  bench_input(&options);
+  bench_audio(&options);
+
+  SDL_Quit();
+  return 0;
+}
@@ -0,0 +1,589 @@
+// NOTE(Ryan): Versioned .hmi input recording format.
+//
+// header: magic 'HHMI' u32 | version u16 | controller_count u8 | keyframe_interval u8 |
+//         frame_rate u32 | build_id u64 | frame_count u64 | index_offset u64
+// frames: one record per changed frame, each delta-encoded against the previous frame:
+//         varint change_mask (bit per controller, then mouse position, mouse buttons, frame_dt)
+//         each changed controller: varint buttons (connected, analog, then ended_down per HHButton),
+//         varint transition mask, varint half transition count per set bit, zigzag stick x and y deltas
+//         change_mask == 0 is followed by varint n, meaning n frames identical to the previous one.
+//         Every keyframe_interval frames the previous frame is reset to zero, so decoding can begin there.
+// index:  u64 offset per keyframe, written on close and located through index_offset.
+//
+// All multi-byte fields are little endian. Sticks are stored quantized to 16 bits, and the writer quantizes
+// the live input in place so that the game sees exactly the values a replay will later reproduce.
+
+#include <math.h>
+
+#define SDL_INPUT_STREAM_MAGIC 0x494d4848 // 'HHMI'
+#define SDL_INPUT_STREAM_VERSION 2
+#define SDL_INPUT_STREAM_KEYFRAME_INTERVAL 128
+#define SDL_INPUT_STREAM_HEADER_SIZE 36
+#define SDL_INPUT_STREAM_BUFFER_SIZE KILOBYTES(4)
+
+#define SDL_INPUT_STREAM_NUM_CONTROLLERS (NUM_GAME_CONTROLLERS_SUPPORTED + 1)
+#define SDL_INPUT_STREAM_MOUSE_POSITION_BIT (SDL_INPUT_STREAM_NUM_CONTROLLERS + 0)
+#define SDL_INPUT_STREAM_MOUSE_BUTTONS_BIT (SDL_INPUT_STREAM_NUM_CONTROLLERS + 1)
+#define SDL_INPUT_STREAM_FRAME_DT_BIT (SDL_INPUT_STREAM_NUM_CONTROLLERS + 2)
+
+typedef struct {
+  SDL_RWops* handle;
+  bool is_writing;
+
+  u32 frame_rate;
+  u64 build_id;
+  u64 frame_count;
+  u64 frame_index;
+
+  HHInput previous;
+  u64 unchanged_run;
+
+  u64* keyframe_offsets;
+  u64 keyframe_count;
+  u64 keyframe_capacity;
+
+  // NOTE(Ryan): Latched on the first failed write. Nothing more is written, the placeholder header is left
+  // alone, and close reports the failure.
+  bool has_failed;
+
+  // NOTE(Ryan): Buffered so a frame costs a handful of byte stores rather than an SDL_RWops call per field
+  u8 buffer[SDL_INPUT_STREAM_BUFFER_SIZE];
+  uint buffer_used;
+  uint buffer_read;
+  int64 buffer_file_offset;
+} SDLInputStream;
+
+INTERNAL int16
+sdl_quantize_stick(float stick_value)
+{
+  if (stick_value > 1.0f) stick_value = 1.0f;
+  if (stick_value < -1.0f) stick_value = -1.0f;
+  return (int16)lroundf(stick_value * 32767.0f);
+}
+
+INTERNAL float
+sdl_dequantize_stick(int16 quantized_value)
+{
+  return (float)quantized_value / 32767.0f;
+}
+
+// NOTE(Ryan): Connection flags in the low two bits, then one ended_down bit per HHButton
+INTERNAL u32
+sdl_pack_controller_buttons(HHController* controller)
+{
+  return (u32)controller->is_connected | ((u32)controller->is_analog << 1) | ((u32)controller->ended_down << 2);
+}
+
+INTERNAL void
+sdl_unpack_controller_buttons(HHController* controller, u32 packed_buttons)
+{
+  controller->is_connected = IS_BIT_SET(packed_buttons, 0);
+  controller->is_analog = IS_BIT_SET(packed_buttons, 1);
+  controller->ended_down = (u16)(packed_buttons >> 2);
+}
+
+// NOTE(Ryan): Bit per button with a nonzero half transition count; the counts themselves follow in button order
+INTERNAL u32
+sdl_pack_controller_transitions(HHController* controller)
+{
+  u32 transition_mask = 0;
+  for (uint button_i = 0; button_i < HH_BUTTON_COUNT; ++button_i) {
+    if (controller->half_transition_count[button_i] != 0) {
+      transition_mask |= (1U << button_i);
+    }
+  }
+  return transition_mask;
+}
+
+INTERNAL u32
+sdl_pack_mouse_buttons(HHInput* input)
+{
+  return (input->left_mouse_button << 0) | (input->middle_mouse_button << 1) | (input->right_mouse_button << 2);
+}
+
+INTERNAL u64
+sdl_zigzag_encode(int64 value)
+{
+  return ((u64)value << 1) ^ (u64)(value >> 63);
+}
+
+INTERNAL int64
+sdl_zigzag_decode(u64 value)
+{
+  return (int64)(value >> 1) ^ -(int64)(value & 1);
+}
+
+INTERNAL STATUS
+sdl_input_stream_flush(SDLInputStream* stream)
+{
+  if (stream->has_failed) {
+    stream->buffer_used = 0;
+    return FAILED;
+  }
+  if (stream->buffer_used > 0) {
+    if (SDL_RWwrite(stream->handle, stream->buffer, stream->buffer_used, 1) != 1) {
+      SDL_LogWarn("Unable to write input stream, recording stops here: %s", SDL_GetError());
+      stream->has_failed = true;
+      stream->buffer_used = 0;
+      return FAILED;
+    }
+    stream->buffer_file_offset += stream->buffer_used;
+    stream->buffer_used = 0;
+  }
+  return SUCCEEDED;
+}
+
+INTERNAL void
+sdl_input_stream_put_byte(SDLInputStream* stream, u8 byte)
+{
+  if (stream->buffer_used == SDL_INPUT_STREAM_BUFFER_SIZE) {
+    sdl_input_stream_flush(stream);
+  }
+  stream->buffer[stream->buffer_used++] = byte;
+}
+
+INTERNAL void
+sdl_input_stream_put_varint(SDLInputStream* stream, u64 value)
+{
+  while (value >= 0x80) {
+    sdl_input_stream_put_byte(stream, (u8)(value | 0x80));
+    value >>= 7;
+  }
+  sdl_input_stream_put_byte(stream, (u8)value);
+}
+
+INTERNAL void
+sdl_input_stream_put_u32(SDLInputStream* stream, u32 value)
+{
+  for (uint byte_i = 0; byte_i < 4; ++byte_i) {
+    sdl_input_stream_put_byte(stream, (u8)(value >> (byte_i * 8)));
+  }
+}
+
+INTERNAL bool
+sdl_input_stream_get_byte(SDLInputStream* stream, u8* byte)
+{
+  if (stream->buffer_read == stream->buffer_used) {
+    stream->buffer_file_offset += stream->buffer_used;
+    stream->buffer_used = SDL_RWread(stream->handle, stream->buffer, 1, SDL_INPUT_STREAM_BUFFER_SIZE);
+    stream->buffer_read = 0;
+    if (stream->buffer_used == 0) {
+      return false;
+    }
+  }
+  *byte = stream->buffer[stream->buffer_read++];
+  return true;
+}
+
+INTERNAL bool
+sdl_input_stream_get_varint(SDLInputStream* stream, u64* value)
+{
+  *value = 0;
+  for (uint shift = 0; shift < 64; shift += 7) {
+    u8 byte = 0;
+    if (!sdl_input_stream_get_byte(stream, &byte)) {
+      return false;
+    }
+    *value |= (u64)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+INTERNAL bool
+sdl_input_stream_get_u32(SDLInputStream* stream, u32* value)
+{
+  *value = 0;
+  for (uint byte_i = 0; byte_i < 4; ++byte_i) {
+    u8 byte = 0;
+    if (!sdl_input_stream_get_byte(stream, &byte)) {
+      return false;
+    }
+    *value |= (u32)byte << (byte_i * 8);
+  }
+  return true;
+}
+
+INTERNAL void
+sdl_input_stream_write_header(SDLInputStream* stream, u64 index_offset)
+{
+  u8 header[SDL_INPUT_STREAM_HEADER_SIZE] = {0};
+  u64 fields[] = {SDL_INPUT_STREAM_MAGIC, SDL_INPUT_STREAM_VERSION, SDL_INPUT_STREAM_NUM_CONTROLLERS, SDL_INPUT_STREAM_KEYFRAME_INTERVAL,
+                  stream->frame_rate, stream->build_id, stream->frame_count, index_offset};
+  uint field_sizes[] = {4, 2, 1, 1, 4, 8, 8, 8};
+  uint header_offset = 0;
+  for (uint field_i = 0; field_i < ARRAY_SIZE(fields); ++field_i) {
+    for (uint byte_i = 0; byte_i < field_sizes[field_i]; ++byte_i) {
+      header[header_offset++] = (u8)(fields[field_i] >> (byte_i * 8));
+    }
+  }
+
+  if (SDL_RWwrite(stream->handle, header, sizeof(header), 1) != 1) {
+    SDL_LogWarn("Unable to write input stream header: %s", SDL_GetError());
+    stream->has_failed = true;
+  }
+}
+
+INTERNAL STATUS
+sdl_open_input_stream_for_write(SDLInputStream* stream, char const* file_name, u32 frame_rate, u64 build_id)
+{
+  memset(stream, 0, offsetof(SDLInputStream, buffer));
+  stream->buffer_used = 0;
+  stream->buffer_read = 0;
+
+  stream->handle = SDL_RWFromFile(file_name, "wb");
+  if (stream->handle == NULL) {
+    SDL_LogWarn("Unable to open input stream '%s': %s", file_name, SDL_GetError());
+    return FAILED;
+  }
+  stream->is_writing = true;
+  stream->frame_rate = frame_rate;
+  stream->build_id = build_id;
+
+  // NOTE(Ryan): Enough for an hour at 60fps before the index has to grow
+  stream->keyframe_capacity = (60 * 60 * 60) / SDL_INPUT_STREAM_KEYFRAME_INTERVAL;
+  stream->keyframe_offsets = malloc(stream->keyframe_capacity * sizeof(u64));
+  if (stream->keyframe_offsets == NULL) {
+    SDL_LogWarn("Unable to allocate input stream index: %s", strerror(errno));
+    SDL_RWclose(stream->handle);
+    return FAILED;
+  }
+
+  // NOTE(Ryan): Placeholder until close, when frame_count and index_offset are known
+  sdl_input_stream_write_header(stream, 0);
+  if (stream->has_failed) {
+    free(stream->keyframe_offsets);
+    SDL_RWclose(stream->handle);
+    return FAILED;
+  }
+  stream->buffer_file_offset = SDL_INPUT_STREAM_HEADER_SIZE;
+
+  return SUCCEEDED;
+}
+
+INTERNAL void
+sdl_input_stream_flush_unchanged_run(SDLInputStream* stream)
+{
+  if (stream->unchanged_run > 0) {
+    sdl_input_stream_put_varint(stream, 0);
+    sdl_input_stream_put_varint(stream, stream->unchanged_run);
+    stream->unchanged_run = 0;
+  }
+}
+
+// NOTE(Ryan): FAILED once a write has failed, after which the stream only wants closing
+INTERNAL STATUS
+sdl_write_input_stream(SDLInputStream* stream, HHInput* input)
+{
+  if (stream->has_failed) {
+    return FAILED;
+  }
+
+  for (uint controller_i = 0; controller_i < SDL_INPUT_STREAM_NUM_CONTROLLERS; ++controller_i) {
+    HHController* controller = &input->controllers[controller_i];
+    controller->stick_x = sdl_dequantize_stick(sdl_quantize_stick(controller->stick_x));
+    controller->stick_y = sdl_dequantize_stick(sdl_quantize_stick(controller->stick_y));
+  }
+
+  if (stream->frame_index % SDL_INPUT_STREAM_KEYFRAME_INTERVAL == 0) {
+    sdl_input_stream_flush_unchanged_run(stream);
+    if (stream->keyframe_count == stream->keyframe_capacity) {
+      u64 new_capacity = stream->keyframe_capacity * 2;
+      u64* new_offsets = realloc(stream->keyframe_offsets, new_capacity * sizeof(u64));
+      if (new_offsets != NULL) {
+        stream->keyframe_offsets = new_offsets;
+        stream->keyframe_capacity = new_capacity;
+      }
+    }
+    if (stream->keyframe_count < stream->keyframe_capacity) {
+      stream->keyframe_offsets[stream->keyframe_count++] = stream->buffer_file_offset + stream->buffer_used;
+    }
+    memset(&stream->previous, 0, sizeof(stream->previous));
+  }
+
+  HHInput* previous = &stream->previous;
+  u64 change_mask = 0;
+  for (uint controller_i = 0; controller_i < SDL_INPUT_STREAM_NUM_CONTROLLERS; ++controller_i) {
+    HHController* controller = &input->controllers[controller_i];
+    HHController* previous_controller = &previous->controllers[controller_i];
+    if (sdl_pack_controller_buttons(controller) != sdl_pack_controller_buttons(previous_controller) ||
+        memcmp(controller->half_transition_count, previous_controller->half_transition_count,
+               sizeof(controller->half_transition_count)) != 0 ||
+        sdl_quantize_stick(controller->stick_x) != sdl_quantize_stick(previous_controller->stick_x) ||
+        sdl_quantize_stick(controller->stick_y) != sdl_quantize_stick(previous_controller->stick_y)) {
+      change_mask |= (1ULL << controller_i);
+    }
+  }
+  if (input->mouse_x != previous->mouse_x || input->mouse_y != previous->mouse_y) {
+    change_mask |= (1ULL << SDL_INPUT_STREAM_MOUSE_POSITION_BIT);
+  }
+  if (sdl_pack_mouse_buttons(input) != sdl_pack_mouse_buttons(previous)) {
+    change_mask |= (1ULL << SDL_INPUT_STREAM_MOUSE_BUTTONS_BIT);
+  }
+  if (memcmp(&input->frame_dt, &previous->frame_dt, sizeof(input->frame_dt)) != 0) {
+    change_mask |= (1ULL << SDL_INPUT_STREAM_FRAME_DT_BIT);
+  }
+
+  if (change_mask == 0) {
+    ++stream->unchanged_run;
+  } else {
+    sdl_input_stream_flush_unchanged_run(stream);
+    sdl_input_stream_put_varint(stream, change_mask);
+
+    for (uint controller_i = 0; controller_i < SDL_INPUT_STREAM_NUM_CONTROLLERS; ++controller_i) {
+      if (IS_BIT_SET(change_mask, controller_i)) {
+        HHController* controller = &input->controllers[controller_i];
+        HHController* previous_controller = &previous->controllers[controller_i];
+        sdl_input_stream_put_varint(stream, sdl_pack_controller_buttons(controller));
+        u32 transition_mask = sdl_pack_controller_transitions(controller);
+        sdl_input_stream_put_varint(stream, transition_mask);
+        for (uint button_i = 0; button_i < HH_BUTTON_COUNT; ++button_i) {
+          if (IS_BIT_SET(transition_mask, button_i)) {
+            sdl_input_stream_put_varint(stream, controller->half_transition_count[button_i]);
+          }
+        }
+        sdl_input_stream_put_varint(stream, sdl_zigzag_encode(sdl_quantize_stick(controller->stick_x) - 
+                                                              sdl_quantize_stick(previous_controller->stick_x)));
+        sdl_input_stream_put_varint(stream, sdl_zigzag_encode(sdl_quantize_stick(controller->stick_y) - 
+                                                              sdl_quantize_stick(previous_controller->stick_y)));
+      }
+    }
+    if (IS_BIT_SET(change_mask, SDL_INPUT_STREAM_MOUSE_POSITION_BIT)) {
+      sdl_input_stream_put_varint(stream, sdl_zigzag_encode((int64)input->mouse_x - previous->mouse_x));
+      sdl_input_stream_put_varint(stream, sdl_zigzag_encode((int64)input->mouse_y - previous->mouse_y));
+    }
+    if (IS_BIT_SET(change_mask, SDL_INPUT_STREAM_MOUSE_BUTTONS_BIT)) {
+      sdl_input_stream_put_varint(stream, sdl_pack_mouse_buttons(input));
+    }
+    if (IS_BIT_SET(change_mask, SDL_INPUT_STREAM_FRAME_DT_BIT)) {
+      u32 frame_dt_bits = 0;
+      memcpy(&frame_dt_bits, &input->frame_dt, sizeof(frame_dt_bits));
+      sdl_input_stream_put_u32(stream, frame_dt_bits);
+    }
+  }
+
+  stream->previous = *input;
+  ++stream->frame_index;
+  ++stream->frame_count;
+
+  return stream->has_failed ? FAILED : SUCCEEDED;
+}
+
+// NOTE(Ryan): For a written stream, FAILED if any write failed, in which case the file is cut short with a
+// placeholder header and no index
+INTERNAL STATUS
+sdl_close_input_stream(SDLInputStream* stream)
+{
+  STATUS result = SUCCEEDED;
+  if (stream->is_writing && !stream->has_failed) {
+    sdl_input_stream_flush_unchanged_run(stream);
+    u64 index_offset = stream->buffer_file_offset + stream->buffer_used;
+    for (u64 keyframe_i = 0; keyframe_i < stream->keyframe_count; ++keyframe_i) {
+      for (uint byte_i = 0; byte_i < 8; ++byte_i) {
+        sdl_input_stream_put_byte(stream, (u8)(stream->keyframe_offsets[keyframe_i] >> (byte_i * 8)));
+      }
+    }
+    sdl_input_stream_flush(stream);
+
+    // NOTE(Ryan): Header is patched last, so a recording cut short by a crash is still readable front to back
+    if (!stream->has_failed) {
+      SDL_RWseek(stream->handle, 0, RW_SEEK_SET);
+      sdl_input_stream_write_header(stream, index_offset);
+    }
+  }
+  if (stream->is_writing && stream->has_failed) {
+    result = FAILED;
+  }
+
+  free(stream->keyframe_offsets);
+  stream->keyframe_offsets = NULL;
+  if (SDL_RWclose(stream->handle) < 0 && stream->is_writing) {
+    SDL_LogWarn("Unable to close input stream: %s", SDL_GetError());
+    result = FAILED;
+  }
+  stream->handle = NULL;
+
+  return result;
+}
+
+INTERNAL u64
+sdl_input_stream_read_le(u8* bytes, uint size)
+{
+  u64 value = 0;
+  for (uint byte_i = 0; byte_i < size; ++byte_i) {
+    value |= (u64)bytes[byte_i] << (byte_i * 8);
+  }
+  return value;
+}
+
+INTERNAL STATUS
+sdl_open_input_stream_for_read(SDLInputStream* stream, char const* file_name)
+{
+  memset(stream, 0, offsetof(SDLInputStream, buffer));
+  stream->buffer_used = 0;
+  stream->buffer_read = 0;
+
+  stream->handle = SDL_RWFromFile(file_name, "rb");
+  if (stream->handle == NULL) {
+    SDL_LogWarn("Unable to open input stream '%s': %s", file_name, SDL_GetError());
+    return FAILED;
+  }
+
+  u8 header[SDL_INPUT_STREAM_HEADER_SIZE] = {0};
+  if (SDL_RWread(stream->handle, header, sizeof(header), 1) != 1 ||
+      sdl_input_stream_read_le(header + 0, 4) != SDL_INPUT_STREAM_MAGIC ||
+      sdl_input_stream_read_le(header + 4, 2) != SDL_INPUT_STREAM_VERSION ||
+      sdl_input_stream_read_le(header + 6, 1) != SDL_INPUT_STREAM_NUM_CONTROLLERS ||
+      sdl_input_stream_read_le(header + 7, 1) != SDL_INPUT_STREAM_KEYFRAME_INTERVAL) {
+    SDL_LogWarn("Input stream '%s' has an unsupported header", file_name);
+    SDL_RWclose(stream->handle);
+    return FAILED;
+  }
+  stream->frame_rate = sdl_input_stream_read_le(header + 8, 4);
+  stream->build_id = sdl_input_stream_read_le(header + 12, 8);
+  stream->frame_count = sdl_input_stream_read_le(header + 20, 8);
+  u64 index_offset = sdl_input_stream_read_le(header + 28, 8);
+
+  if (index_offset != 0) {
+    int64 file_size = SDL_RWsize(stream->handle);
+    stream->keyframe_count = (file_size - index_offset) / sizeof(u64);
+    stream->keyframe_offsets = malloc(stream->keyframe_count * sizeof(u64));
+    if (stream->keyframe_offsets != NULL) {
+      SDL_RWseek(stream->handle, index_offset, RW_SEEK_SET);
+      for (u64 keyframe_i = 0; keyframe_i < stream->keyframe_count; ++keyframe_i) {
+        u8 offset_bytes[8] = {0};
+        SDL_RWread(stream->handle, offset_bytes, sizeof(offset_bytes), 1);
+        stream->keyframe_offsets[keyframe_i] = sdl_input_stream_read_le(offset_bytes, 8);
+      }
+    } else {
+      stream->keyframe_count = 0;
+    }
+    SDL_RWseek(stream->handle, SDL_INPUT_STREAM_HEADER_SIZE, RW_SEEK_SET);
+  } else {
+    // NOTE(Ryan): Writer never closed the stream; frame count is unknown so read until the data runs out
+    stream->frame_count = UINT64_MAX;
+  }
+  stream->buffer_file_offset = SDL_INPUT_STREAM_HEADER_SIZE;
+
+  return SUCCEEDED;
+}
+
+INTERNAL bool
+sdl_read_input_stream(SDLInputStream* stream, HHInput* input)
+{
+  if (stream->frame_index >= stream->frame_count) {
+    return false;
+  }
+
+  if (stream->frame_index % SDL_INPUT_STREAM_KEYFRAME_INTERVAL == 0) {
+    memset(&stream->previous, 0, sizeof(stream->previous));
+  }
+
+  if (stream->unchanged_run == 0) {
+    u64 change_mask = 0;
+    if (!sdl_input_stream_get_varint(stream, &change_mask)) {
+      return false;
+    }
+
+    if (change_mask == 0) {
+      if (!sdl_input_stream_get_varint(stream, &stream->unchanged_run) || stream->unchanged_run == 0) {
+        return false;
+      }
+    } else {
+      HHInput* previous = &stream->previous;
+      for (uint controller_i = 0; controller_i < SDL_INPUT_STREAM_NUM_CONTROLLERS; ++controller_i) {
+        if (IS_BIT_SET(change_mask, controller_i)) {
+          HHController* controller = &previous->controllers[controller_i];
+          u64 packed_buttons = 0, transition_mask = 0, stick_x_delta = 0, stick_y_delta = 0;
+          if (!sdl_input_stream_get_varint(stream, &packed_buttons) ||
+              !sdl_input_stream_get_varint(stream, &transition_mask)) {
+            return false;
+          }
+          for (uint button_i = 0; button_i < HH_BUTTON_COUNT; ++button_i) {
+            u64 half_transition_count = 0;
+            if (IS_BIT_SET(transition_mask, button_i) &&
+                !sdl_input_stream_get_varint(stream, &half_transition_count)) {
+              return false;
+            }
+            controller->half_transition_count[button_i] = (u8)half_transition_count;
+          }
+          if (!sdl_input_stream_get_varint(stream, &stick_x_delta) ||
+              !sdl_input_stream_get_varint(stream, &stick_y_delta)) {
+            return false;
+          }
+          sdl_unpack_controller_buttons(controller, (u32)packed_buttons);
+          controller->stick_x = sdl_dequantize_stick(sdl_quantize_stick(controller->stick_x) + sdl_zigzag_decode(stick_x_delta));
+          controller->stick_y = sdl_dequantize_stick(sdl_quantize_stick(controller->stick_y) + sdl_zigzag_decode(stick_y_delta));
+        }
+      }
+      if (IS_BIT_SET(change_mask, SDL_INPUT_STREAM_MOUSE_POSITION_BIT)) {
+        u64 mouse_x_delta = 0, mouse_y_delta = 0;
+        if (!sdl_input_stream_get_varint(stream, &mouse_x_delta) || !sdl_input_stream_get_varint(stream, &mouse_y_delta)) {
+          return false;
+        }
+        previous->mouse_x += (int)sdl_zigzag_decode(mouse_x_delta);
+        previous->mouse_y += (int)sdl_zigzag_decode(mouse_y_delta);
+      }
+      if (IS_BIT_SET(change_mask, SDL_INPUT_STREAM_MOUSE_BUTTONS_BIT)) {
+        u64 mouse_buttons = 0;
+        if (!sdl_input_stream_get_varint(stream, &mouse_buttons)) {
+          return false;
+        }
+        previous->left_mouse_button = IS_BIT_SET(mouse_buttons, 0);
+        previous->middle_mouse_button = IS_BIT_SET(mouse_buttons, 1);
+        previous->right_mouse_button = IS_BIT_SET(mouse_buttons, 2);
+      }
+      if (IS_BIT_SET(change_mask, SDL_INPUT_STREAM_FRAME_DT_BIT)) {
+        u32 frame_dt_bits = 0;
+        if (!sdl_input_stream_get_u32(stream, &frame_dt_bits)) {
+          return false;
+        }
+        memcpy(&previous->frame_dt, &frame_dt_bits, sizeof(frame_dt_bits));
+      }
+    }
+  }
+
+  if (stream->unchanged_run > 0) {
+    --stream->unchanged_run;
+  }
+
+  *input = stream->previous;
+  ++stream->frame_index;
+  return true;
+}
+
+INTERNAL STATUS
+sdl_seek_input_stream(SDLInputStream* stream, u64 frame_index)
+{
+  u64 keyframe_i = frame_index / SDL_INPUT_STREAM_KEYFRAME_INTERVAL;
+  u64 keyframe_offset = SDL_INPUT_STREAM_HEADER_SIZE;
+  if (keyframe_i > 0) {
+    if (keyframe_i >= stream->keyframe_count) {
+      // NOTE(Ryan): No index (unfinished recording), so decode forward from the start
+      keyframe_i = 0;
+    } else {
+      keyframe_offset = stream->keyframe_offsets[keyframe_i];
+    }
+  }
+
+  if (SDL_RWseek(stream->handle, keyframe_offset, RW_SEEK_SET) < 0) {
+    SDL_LogWarn("Unable to seek input stream: %s", SDL_GetError());
+    return FAILED;
+  }
+  stream->buffer_file_offset = keyframe_offset;
+  stream->buffer_used = 0;
+  stream->buffer_read = 0;
+  stream->unchanged_run = 0;
+  stream->frame_index = keyframe_i * SDL_INPUT_STREAM_KEYFRAME_INTERVAL;
+
+  HHInput skipped_input = {0};
+  while (stream->frame_index < frame_index) {
+    if (!sdl_read_input_stream(stream, &skipped_input)) {
+      return FAILED;
+    }
+  }
+
+  return SUCCEEDED;
+}
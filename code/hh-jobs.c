@@ -0,0 +1,301 @@
+// NOTE(Ryan): Persistent worker pool with one Chase-Lev work-stealing deque per thread.
+// Thread 0 is the thread that created the queue; it pushes jobs and helps while waiting.
+// Only pool threads may add jobs, as a deque's bottom is owned by one thread and there is no shared injection
+// queue. The audio, input and asset stream threads never add any.
+// Workers pop LIFO from their own deque and steal FIFO from the others, sleeping on a semaphore when idle.
+// A waiting thread runs jobs while there are any, spins briefly once there are none, then sleeps until some
+// counter reaches zero.
+
+#include <stdalign.h>
+
+#define HH_JOB_DEQUE_CAPACITY 1024
+#define HH_JOB_DEQUE_MASK (HH_JOB_DEQUE_CAPACITY - 1)
+// NOTE(Ryan): Long enough to cover a short tail job without a trip through the scheduler
+#define HH_JOB_WAIT_SPIN_COUNT 256
+
+typedef struct {
+  HHJobCallback* callback;
+  void* data;
+  HHJobCounter* counter;
+} HHJob;
+
+typedef struct {
+  // NOTE(Ryan): Owner writes bottom, thieves write top, so keep them on separate cache lines.
+  alignas(64) _Atomic int64 top;
+  alignas(64) _Atomic int64 bottom;
+  alignas(64) HHJob jobs[HH_JOB_DEQUE_CAPACITY];
+} HHJobDeque;
+
+typedef struct {
+  HHJobQueue* queue;
+  uint thread_index;
+  SDL_Thread* thread;
+} HHJobWorker;
+
+struct HHJobQueue {
+  // NOTE(Ryan): Final before any worker starts, so workers read it without synchronisation
+  uint thread_count;
+  HHJobDeque* deques;
+  HHJobWorker* workers;
+  SDL_sem* work_semaphore;
+  // NOTE(Ryan): Workers block on this until thread_count is published
+  SDL_sem* start_semaphore;
+  _Atomic bool is_running;
+
+  SDL_mutex* completion_mutex;
+  SDL_cond* completion_condition;
+  _Atomic uint sleeping_waiter_count;
+};
+
+// NOTE(Ryan): Set on the creating thread and on each worker; anything else keeps this and has no deque
+#define HH_JOB_NO_THREAD_INDEX ((uint)-1)
+GLOBAL _Thread_local uint hh_job_thread_index = HH_JOB_NO_THREAD_INDEX;
+
+INTERNAL bool
+hh_job_deque_push(HHJobDeque* deque, HHJob* job)
+{
+  int64 bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  int64 top = atomic_load_explicit(&deque->top, memory_order_acquire);
+  if (bottom - top >= HH_JOB_DEQUE_CAPACITY) {
+    return false;
+  }
+
+  deque->jobs[bottom & HH_JOB_DEQUE_MASK] = *job;
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+  return true;
+}
+
+INTERNAL bool
+hh_job_deque_pop(HHJobDeque* deque, HHJob* job)
+{
+  int64 bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64 top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+  if (top > bottom) {
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return false;
+  }
+
+  *job = deque->jobs[bottom & HH_JOB_DEQUE_MASK];
+  if (top == bottom) {
+    // NOTE(Ryan): Last job, so race any thieves for it
+    bool won_race = atomic_compare_exchange_strong_explicit(
+                                                            &deque->top, &top, top + 1,
+                                                            memory_order_seq_cst, memory_order_relaxed
+                                                           );
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return won_race;
+  }
+
+  return true;
+}
+
+INTERNAL bool
+hh_job_deque_steal(HHJobDeque* deque, HHJob* job)
+{
+  int64 top = atomic_load_explicit(&deque->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64 bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+  if (top >= bottom) {
+    return false;
+  }
+
+  *job = deque->jobs[top & HH_JOB_DEQUE_MASK];
+  return atomic_compare_exchange_strong_explicit(
+                                                 &deque->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed
+                                                );
+}
+
+INTERNAL bool
+hh_job_queue_take(HHJobQueue* queue, uint thread_index, HHJob* job)
+{
+  // NOTE(Ryan): A thread outside the pool has no deque of its own, but stealing is safe from any thread
+  bool has_deque = (thread_index < queue->thread_count);
+  if (has_deque && hh_job_deque_pop(&queue->deques[thread_index], job)) {
+    return true;
+  }
+
+  for (uint victim_i = has_deque ? 1 : 0; victim_i < queue->thread_count; ++victim_i) {
+    uint victim_index = (thread_index + victim_i) % queue->thread_count;
+    if (hh_job_deque_steal(&queue->deques[victim_index], job)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+INTERNAL void
+hh_job_execute(HHJobQueue* queue, HHJob* job)
+{
+  job->callback(job->data);
+  // NOTE(Ryan): Sequentially consistent against the waiter's increment of sleeping_waiter_count and its reload
+  // of pending, so either the waiter sees zero or this sees the waiter
+  if (job->counter != NULL && atomic_fetch_sub(&job->counter->pending, 1) == 1 &&
+      atomic_load(&queue->sleeping_waiter_count) > 0) {
+    SDL_LockMutex(queue->completion_mutex);
+    SDL_CondBroadcast(queue->completion_condition);
+    SDL_UnlockMutex(queue->completion_mutex);
+  }
+}
+
+INTERNAL int
+hh_job_worker_thread(void* data)
+{
+  HHJobWorker* worker = (HHJobWorker *)data;
+  HHJobQueue* queue = worker->queue;
+  hh_job_thread_index = worker->thread_index;
+  SDL_SemWait(queue->start_semaphore);
+
+  while (atomic_load_explicit(&queue->is_running, memory_order_relaxed)) {
+    HHJob job = {0};
+    if (hh_job_queue_take(queue, worker->thread_index, &job)) {
+      hh_job_execute(queue, &job);
+    } else {
+      SDL_SemWait(queue->work_semaphore);
+    }
+  }
+
+  return 0;
+}
+
+void
+platform_add_job(HHJobQueue* queue, HHJobCallback* callback, void* data, HHJobCounter* counter)
+{
+  HH_ASSERT(hh_job_thread_index < queue->thread_count);
+  HHJob job = {.callback = callback, .data = data, .counter = counter};
+  if (counter != NULL) {
+    atomic_fetch_add_explicit(&counter->pending, 1, memory_order_relaxed);
+  }
+
+  // NOTE(Ryan): Outside the pool there is no deque to push to, so a release build runs the job here rather than
+  // race the owner of deque 0
+  if (hh_job_thread_index < queue->thread_count &&
+      hh_job_deque_push(&queue->deques[hh_job_thread_index], &job)) {
+    SDL_SemPost(queue->work_semaphore);
+  } else {
+    // NOTE(Ryan): Deque is full, so rather than grow it on a frame path just run the job here
+    hh_job_execute(queue, &job);
+  }
+}
+
+void
+platform_wait_for_jobs(HHJobQueue* queue, HHJobCounter* counter)
+{
+  uint spin_count = 0;
+  while (atomic_load_explicit(&counter->pending, memory_order_acquire) > 0) {
+    HHJob job = {0};
+    if (hh_job_queue_take(queue, hh_job_thread_index, &job)) {
+      hh_job_execute(queue, &job);
+      spin_count = 0;
+    } else if (spin_count < HH_JOB_WAIT_SPIN_COUNT) {
+      SDL_CPUPauseInstruction();
+      ++spin_count;
+    } else {
+      // NOTE(Ryan): Everything left is running on other threads, so stop burning this core until it finishes
+      SDL_LockMutex(queue->completion_mutex);
+      atomic_fetch_add(&queue->sleeping_waiter_count, 1);
+      if (atomic_load(&counter->pending) > 0) {
+        SDL_CondWait(queue->completion_condition, queue->completion_mutex);
+      }
+      atomic_fetch_sub(&queue->sleeping_waiter_count, 1);
+      SDL_UnlockMutex(queue->completion_mutex);
+    }
+  }
+}
+
+uint
+platform_get_thread_index(void)
+{
+  return hh_job_thread_index;
+}
+
+// NOTE(Ryan): thread_count includes the calling thread, which becomes thread 0 of the pool, so thread_count - 1
+// workers are spawned.
+// Clamped to [1, HH_MAX_JOB_THREADS]; read back queue->thread_count for the real figure.
+INTERNAL HHJobQueue*
+sdl_create_job_queue(uint thread_count)
+{
+  if (thread_count < 1) {
+    thread_count = 1;
+  }
+  if (thread_count > HH_MAX_JOB_THREADS) {
+    thread_count = HH_MAX_JOB_THREADS;
+  }
+
+  HHJobQueue* queue = SDL_calloc(1, sizeof(HHJobQueue));
+  if (queue == NULL) {
+    SDL_LogCritical("Unable to allocate job queue");
+    return NULL;
+  }
+
+  queue->deques = aligned_alloc(alignof(HHJobDeque), thread_count * sizeof(HHJobDeque));
+  queue->workers = SDL_calloc(thread_count, sizeof(HHJobWorker));
+  queue->work_semaphore = SDL_CreateSemaphore(0);
+  queue->start_semaphore = SDL_CreateSemaphore(0);
+  queue->completion_mutex = SDL_CreateMutex();
+  queue->completion_condition = SDL_CreateCond();
+  if (queue->deques == NULL || queue->workers == NULL || queue->work_semaphore == NULL ||
+      queue->start_semaphore == NULL || queue->completion_mutex == NULL || queue->completion_condition == NULL) {
+    SDL_LogCritical("Unable to allocate job queue resources: %s", SDL_GetError());
+    goto __JOB_QUEUE_INIT_ERROR__;
+  }
+  memset(queue->deques, 0, thread_count * sizeof(HHJobDeque));
+
+  atomic_store(&queue->is_running, true);
+  uint started_thread_count = 1;
+  for (; started_thread_count < thread_count; ++started_thread_count) {
+    HHJobWorker* worker = &queue->workers[started_thread_count];
+    worker->queue = queue;
+    worker->thread_index = started_thread_count;
+    worker->thread = SDL_CreateThread(hh_job_worker_thread, "hh-worker", worker);
+    if (worker->thread == NULL) {
+      // NOTE(Ryan): Deques past this point would never be drained by their owner
+      SDL_LogWarn("Unable to create worker thread %u: %s", started_thread_count, SDL_GetError());
+      break;
+    }
+  }
+  queue->thread_count = started_thread_count;
+  hh_job_thread_index = 0;
+  for (uint thread_i = 1; thread_i < started_thread_count; ++thread_i) {
+    SDL_SemPost(queue->start_semaphore);
+  }
+
+  return queue;
+
+__JOB_QUEUE_INIT_ERROR__:
+  if (queue->completion_condition != NULL) SDL_DestroyCond(queue->completion_condition);
+  if (queue->completion_mutex != NULL) SDL_DestroyMutex(queue->completion_mutex);
+  if (queue->start_semaphore != NULL) SDL_DestroySemaphore(queue->start_semaphore);
+  if (queue->work_semaphore != NULL) SDL_DestroySemaphore(queue->work_semaphore);
+  SDL_free(queue->workers);
+  free(queue->deques);
+  SDL_free(queue);
+  return NULL;
+}
+
+INTERNAL void
+sdl_destroy_job_queue(HHJobQueue* queue)
+{
+  atomic_store(&queue->is_running, false);
+  for (uint thread_i = 1; thread_i < queue->thread_count; ++thread_i) {
+    SDL_SemPost(queue->work_semaphore);
+  }
+  for (uint thread_i = 1; thread_i < queue->thread_count; ++thread_i) {
+    SDL_WaitThread(queue->workers[thread_i].thread, NULL);
+  }
+
+  SDL_DestroyCond(queue->completion_condition);
+  SDL_DestroyMutex(queue->completion_mutex);
+  SDL_DestroySemaphore(queue->start_semaphore);
+  SDL_DestroySemaphore(queue->work_semaphore);
+  SDL_free(queue->workers);
+  free(queue->deques);
+  SDL_free(queue);
+}
@@ -0,0 +1,420 @@
+// NOTE(Ryan): Software mixer. Voices are mixed in float into a pair of planar channel buffers, then clamped
+// to interleaved S16 in a single pass at the end.
+// Per voice, the sound is first resampled to the output rate into a float scratch chunk (linear
+// interpolation on a 32.32 fixed point position). The chunk is then accumulated with a per-sample volume
+// ramp, so fades and volume changes never click. The accumulate and clamp kernels are chosen at startup from
+// the cpu features, just like the render kernels.
+// All storage comes from arenas: voices from a permanent arena, and the per-call mix buffers from a
+// temporary scope on the scratch arena. Voices are recycled once they finish, so the game refers to one
+// through a generation-checked handle, which goes stale rather than pointing at whatever reused the slot.
+
+#include <math.h>
+
+#define HH_MIXER_CHUNK_FRAMES 256
+#define HH_MIXER_MAX_CHANNELS 2
+
+typedef struct {
+  uint samples_per_second;
+  uint sample_count;
+  uint channel_count;
+  // NOTE(Ryan): Interleaved when channel_count is 2
+  int16* samples;
+} HHSound;
+
+typedef struct HHMixerVoice {
+  HHSound* sound;
+  u64 position;
+  bool is_looping;
+
+  float volume[HH_MIXER_MAX_CHANNELS];
+  float target_volume[HH_MIXER_MAX_CHANNELS];
+  float volume_delta[HH_MIXER_MAX_CHANNELS];
+  uint fade_frames_remaining;
+  // NOTE(Ryan): Set only by hh_mixer_fade_out(); the voice is freed when that ramp ends. A voice that is merely
+  // quiet (started at 0, or faded to 0 with hh_mixer_set_voice_volume()) keeps playing.
+  bool is_fading_out;
+
+  // NOTE(Ryan): Bumped every time the voice is freed, which invalidates outstanding handles
+  u32 generation;
+  struct HHMixerVoice* next;
+} HHMixerVoice;
+
+typedef struct {
+  HHMixerVoice* voice;
+  u32 generation;
+} HHMixerVoiceHandle;
+
+typedef struct {
+  HHMemoryArena* arena;
+  HHMixerVoice* first_voice;
+  HHMixerVoice* first_free_voice;
+  float master_volume;
+} HHMixer;
+
+// NOTE(Ryan): dest += source * (volume + volume_delta * i) for both channels
+typedef void (HHMixerAccumulate)(float* restrict dest_left, float* restrict dest_right,
+                                  float const* restrict source_left, float const* restrict source_right, uint count,
+                                  float volume_left, float volume_right, float volume_delta_left, float volume_delta_right);
+
+// NOTE(Ryan): Round to nearest and saturate to S16, interleaving the two channels
+typedef void (HHMixerOutputS16)(int16* restrict samples, float const* restrict left, float const* restrict right, uint count);
+
+INTERNAL void
+hh_mixer_accumulate_scalar(float* restrict dest_left, float* restrict dest_right,
+                           float const* restrict source_left, float const* restrict source_right, uint count,
+                           float volume_left, float volume_right, float volume_delta_left, float volume_delta_right)
+{
+  for (uint i = 0; i < count; ++i) {
+    dest_left[i] += source_left[i] * (volume_left + volume_delta_left * i);
+    dest_right[i] += source_right[i] * (volume_right + volume_delta_right * i);
+  }
+}
+
+INTERNAL void
+hh_mixer_output_s16_scalar(int16* restrict samples, float const* restrict left, float const* restrict right, uint count)
+{
+  for (uint i = 0; i < count; ++i) {
+    float left_value = left[i] < -32768.0f ? -32768.0f : (left[i] > 32767.0f ? 32767.0f : left[i]);
+    float right_value = right[i] < -32768.0f ? -32768.0f : (right[i] > 32767.0f ? 32767.0f : right[i]);
+    *samples++ = (int16)lrintf(left_value);
+    *samples++ = (int16)lrintf(right_value);
+  }
+}
+
+#if defined(HH_X86)
+__attribute__((target("sse2"))) INTERNAL void
+hh_mixer_accumulate_sse2(float* restrict dest_left, float* restrict dest_right,
+                         float const* restrict source_left, float const* restrict source_right, uint count,
+                         float volume_left, float volume_right, float volume_delta_left, float volume_delta_right)
+{
+  __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  __m128 left_volume = _mm_add_ps(_mm_set1_ps(volume_left), _mm_mul_ps(_mm_set1_ps(volume_delta_left), lane));
+  __m128 right_volume = _mm_add_ps(_mm_set1_ps(volume_right), _mm_mul_ps(_mm_set1_ps(volume_delta_right), lane));
+  __m128 left_step = _mm_set1_ps(volume_delta_left * 4.0f);
+  __m128 right_step = _mm_set1_ps(volume_delta_right * 4.0f);
+
+  uint i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(dest_left + i, _mm_add_ps(_mm_loadu_ps(dest_left + i), _mm_mul_ps(_mm_loadu_ps(source_left + i), left_volume)));
+    _mm_storeu_ps(dest_right + i, _mm_add_ps(_mm_loadu_ps(dest_right + i), _mm_mul_ps(_mm_loadu_ps(source_right + i), right_volume)));
+    left_volume = _mm_add_ps(left_volume, left_step);
+    right_volume = _mm_add_ps(right_volume, right_step);
+  }
+
+  hh_mixer_accumulate_scalar(dest_left + i, dest_right + i, source_left + i, source_right + i, count - i,
+                             volume_left + volume_delta_left * i, volume_right + volume_delta_right * i,
+                             volume_delta_left, volume_delta_right);
+}
+
+__attribute__((target("avx2"))) INTERNAL void
+hh_mixer_accumulate_avx2(float* restrict dest_left, float* restrict dest_right,
+                         float const* restrict source_left, float const* restrict source_right, uint count,
+                         float volume_left, float volume_right, float volume_delta_left, float volume_delta_right)
+{
+  __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  __m256 left_volume = _mm256_add_ps(_mm256_set1_ps(volume_left), _mm256_mul_ps(_mm256_set1_ps(volume_delta_left), lane));
+  __m256 right_volume = _mm256_add_ps(_mm256_set1_ps(volume_right), _mm256_mul_ps(_mm256_set1_ps(volume_delta_right), lane));
+  __m256 left_step = _mm256_set1_ps(volume_delta_left * 8.0f);
+  __m256 right_step = _mm256_set1_ps(volume_delta_right * 8.0f);
+
+  uint i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(dest_left + i, _mm256_add_ps(_mm256_loadu_ps(dest_left + i), _mm256_mul_ps(_mm256_loadu_ps(source_left + i), left_volume)));
+    _mm256_storeu_ps(dest_right + i, _mm256_add_ps(_mm256_loadu_ps(dest_right + i), _mm256_mul_ps(_mm256_loadu_ps(source_right + i), right_volume)));
+    left_volume = _mm256_add_ps(left_volume, left_step);
+    right_volume = _mm256_add_ps(right_volume, right_step);
+  }
+
+  hh_mixer_accumulate_scalar(dest_left + i, dest_right + i, source_left + i, source_right + i, count - i,
+                             volume_left + volume_delta_left * i, volume_right + volume_delta_right * i,
+                             volume_delta_left, volume_delta_right);
+}
+
+// NOTE(Ryan): cvtps rounds to nearest and packs saturates, so no explicit clamp is needed
+__attribute__((target("sse2"))) INTERNAL void
+hh_mixer_output_s16_sse2(int16* restrict samples, float const* restrict left, float const* restrict right, uint count)
+{
+  uint i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i left_s16 = _mm_packs_epi32(_mm_cvtps_epi32(_mm_loadu_ps(left + i)), _mm_cvtps_epi32(_mm_loadu_ps(left + i + 4)));
+    __m128i right_s16 = _mm_packs_epi32(_mm_cvtps_epi32(_mm_loadu_ps(right + i)), _mm_cvtps_epi32(_mm_loadu_ps(right + i + 4)));
+    _mm_storeu_si128((__m128i *)(samples + 2 * i), _mm_unpacklo_epi16(left_s16, right_s16));
+    _mm_storeu_si128((__m128i *)(samples + 2 * i + 8), _mm_unpackhi_epi16(left_s16, right_s16));
+  }
+
+  hh_mixer_output_s16_scalar(samples + 2 * i, left + i, right + i, count - i);
+}
+
+__attribute__((target("avx2"))) INTERNAL void
+hh_mixer_output_s16_avx2(int16* restrict samples, float const* restrict left, float const* restrict right, uint count)
+{
+  uint i = 0;
+  for (; i + 16 <= count; i += 16) {
+    // NOTE(Ryan): 256-bit packs work per 128-bit lane, so restore sample order before interleaving
+    __m256i left_s16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_cvtps_epi32(_mm256_loadu_ps(left + i)),
+                                                                   _mm256_cvtps_epi32(_mm256_loadu_ps(left + i + 8))), 0xd8);
+    __m256i right_s16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_cvtps_epi32(_mm256_loadu_ps(right + i)),
+                                                                    _mm256_cvtps_epi32(_mm256_loadu_ps(right + i + 8))), 0xd8);
+    __m256i interleaved_lo = _mm256_unpacklo_epi16(left_s16, right_s16);
+    __m256i interleaved_hi = _mm256_unpackhi_epi16(left_s16, right_s16);
+    _mm256_storeu_si256((__m256i *)(samples + 2 * i), _mm256_permute2x128_si256(interleaved_lo, interleaved_hi, 0x20));
+    _mm256_storeu_si256((__m256i *)(samples + 2 * i + 16), _mm256_permute2x128_si256(interleaved_lo, interleaved_hi, 0x31));
+  }
+
+  hh_mixer_output_s16_scalar(samples + 2 * i, left + i, right + i, count - i);
+}
+#endif
+
+GLOBAL HHMixerAccumulate* hh_mixer_accumulate = hh_mixer_accumulate_scalar;
+GLOBAL HHMixerOutputS16* hh_mixer_output_s16 = hh_mixer_output_s16_scalar;
+
+INTERNAL void
+hh_select_mixer_kernels(u32 cpu_features)
+{
+  hh_mixer_accumulate = hh_mixer_accumulate_scalar;
+  hh_mixer_output_s16 = hh_mixer_output_s16_scalar;
+#if defined(HH_X86)
+  if (cpu_features & HH_CPU_FEATURE_SSE2) {
+    hh_mixer_accumulate = hh_mixer_accumulate_sse2;
+    hh_mixer_output_s16 = hh_mixer_output_s16_sse2;
+  }
+  if (cpu_features & HH_CPU_FEATURE_AVX2) {
+    hh_mixer_accumulate = hh_mixer_accumulate_avx2;
+    hh_mixer_output_s16 = hh_mixer_output_s16_avx2;
+  }
+#else
+  (void)cpu_features;
+#endif
+}
+
+INTERNAL void
+hh_init_mixer(HHMixer* mixer, HHMemoryArena* arena)
+{
+  mixer->arena = arena;
+  mixer->first_voice = NULL;
+  mixer->first_free_voice = NULL;
+  mixer->master_volume = 1.0f;
+}
+
+// NOTE(Ryan): pan is -1 (left) to 1 (right), using an equal power law so a centred voice is not louder
+INTERNAL void
+hh_mixer_pan_volume(float volume, float pan, float* channel_volumes)
+{
+  float angle = (pan + 1.0f) * 0.25f * 3.14159265f;
+  channel_volumes[0] = volume * cosf(angle);
+  channel_volumes[1] = volume * sinf(angle);
+}
+
+// NOTE(Ryan): Returns a handle with a NULL voice if the sound can't be played (empty, no rate, or more
+// channels than the mixer takes)
+INTERNAL HHMixerVoiceHandle
+hh_mixer_play(HHMixer* mixer, HHSound* sound, float volume, float pan, bool is_looping)
+{
+  HHMixerVoiceHandle handle = {0};
+  if (sound->samples == NULL || sound->sample_count == 0 || sound->samples_per_second == 0 ||
+      sound->channel_count == 0 || sound->channel_count > HH_MIXER_MAX_CHANNELS) {
+    return handle;
+  }
+
+  HHMixerVoice* voice = mixer->first_free_voice;
+  u32 generation = 0;
+  if (voice != NULL) {
+    mixer->first_free_voice = voice->next;
+    generation = voice->generation;
+  } else {
+    voice = HH_ARENA_PUSH_STRUCT(mixer->arena, HHMixerVoice);
+  }
+
+  memset(voice, 0, sizeof(*voice));
+  voice->generation = generation;
+  voice->sound = sound;
+  voice->is_looping = is_looping;
+  hh_mixer_pan_volume(volume, pan, voice->volume);
+  memcpy(voice->target_volume, voice->volume, sizeof(voice->volume));
+
+  voice->next = mixer->first_voice;
+  mixer->first_voice = voice;
+
+  handle.voice = voice;
+  handle.generation = generation;
+  return handle;
+}
+
+// NOTE(Ryan): NULL once the voice has finished or been stopped
+INTERNAL HHMixerVoice*
+hh_mixer_get_voice(HHMixerVoiceHandle handle)
+{
+  return (handle.voice != NULL && handle.voice->generation == handle.generation) ? handle.voice : NULL;
+}
+
+INTERNAL void
+hh_mixer_free_voice(HHMixer* mixer, HHMixerVoice* voice)
+{
+  ++voice->generation;
+  voice->next = mixer->first_free_voice;
+  mixer->first_free_voice = voice;
+}
+
+INTERNAL void
+hh_mixer_ramp_voice(HHMixerVoice* voice, float volume, float pan, float fade_seconds, uint output_samples_per_second)
+{
+  hh_mixer_pan_volume(volume, pan, voice->target_volume);
+  voice->fade_frames_remaining = (uint)(fade_seconds * output_samples_per_second);
+  if (voice->fade_frames_remaining == 0) {
+    memcpy(voice->volume, voice->target_volume, sizeof(voice->volume));
+    memset(voice->volume_delta, 0, sizeof(voice->volume_delta));
+  } else {
+    for (uint channel_i = 0; channel_i < HH_MIXER_MAX_CHANNELS; ++channel_i) {
+      voice->volume_delta[channel_i] = (voice->target_volume[channel_i] - voice->volume[channel_i]) / voice->fade_frames_remaining;
+    }
+  }
+}
+
+// NOTE(Ryan): Ramps linearly to the new volume over fade_seconds, cancelling any fade out in progress.
+// Does nothing if the voice has already finished.
+INTERNAL void
+hh_mixer_set_voice_volume(HHMixerVoiceHandle handle, float volume, float pan, float fade_seconds, uint output_samples_per_second)
+{
+  HHMixerVoice* voice = hh_mixer_get_voice(handle);
+  if (voice == NULL) {
+    return;
+  }
+  voice->is_fading_out = false;
+  hh_mixer_ramp_voice(voice, volume, pan, fade_seconds, output_samples_per_second);
+}
+
+// NOTE(Ryan): How a voice should be stopped without a click: ramps to silence, then frees the voice
+INTERNAL void
+hh_mixer_fade_out(HHMixerVoiceHandle handle, float fade_seconds, uint output_samples_per_second)
+{
+  HHMixerVoice* voice = hh_mixer_get_voice(handle);
+  if (voice == NULL) {
+    return;
+  }
+  voice->is_fading_out = true;
+  hh_mixer_ramp_voice(voice, 0.0f, 0.0f, fade_seconds, output_samples_per_second);
+}
+
+INTERNAL void
+hh_mixer_stop(HHMixer* mixer, HHMixerVoiceHandle handle)
+{
+  HHMixerVoice* voice = hh_mixer_get_voice(handle);
+  for (HHMixerVoice** voice_link = &mixer->first_voice; voice != NULL && *voice_link != NULL; voice_link = &(*voice_link)->next) {
+    if (*voice_link == voice) {
+      *voice_link = voice->next;
+      hh_mixer_free_voice(mixer, voice);
+      return;
+    }
+  }
+}
+
+// NOTE(Ryan): Resamples up to 'count' output frames of the voice's sound into planar float.
+// Returns the number produced, which is less than count only when a non-looping sound runs out.
+INTERNAL uint
+hh_mixer_resample_voice(HHMixerVoice* voice, float* restrict left, float* restrict right, uint count, u64 step)
+{
+  HHSound* sound = voice->sound;
+  u64 sound_end = (u64)sound->sample_count << 32;
+  uint channel_count = sound->channel_count;
+  int16 const* samples = sound->samples;
+
+  uint frame_i = 0;
+  for (; frame_i < count; ++frame_i) {
+    if (voice->position >= sound_end) {
+      if (!voice->is_looping) {
+        break;
+      }
+      // NOTE(Ryan): A step can be longer than the whole sound
+      voice->position %= sound_end;
+    }
+
+    uint sample_i = (uint)(voice->position >> 32);
+    uint next_sample_i = sample_i + 1;
+    if (next_sample_i == sound->sample_count) {
+      next_sample_i = voice->is_looping ? 0 : sample_i;
+    }
+    float t = (float)(voice->position & 0xffffffff) * (1.0f / 4294967296.0f);
+
+    float left_a = samples[sample_i * channel_count];
+    float left_b = samples[next_sample_i * channel_count];
+    left[frame_i] = left_a + (left_b - left_a) * t;
+    if (channel_count == 2) {
+      float right_a = samples[sample_i * 2 + 1];
+      float right_b = samples[next_sample_i * 2 + 1];
+      right[frame_i] = right_a + (right_b - right_a) * t;
+    }
+
+    voice->position += step;
+  }
+
+  return frame_i;
+}
+
+INTERNAL void
+hh_mixer_output(HHMixer* mixer, HHMemoryArena* scratch_arena, HHSoundBuffer* sound_buffer)
+{
+  TIMED_FUNCTION();
+  uint count = sound_buffer->sample_count;
+  if (count == 0) {
+    return;
+  }
+
+  HHTemporaryMemory mix_memory = hh_begin_temporary_memory(scratch_arena);
+
+  float* mix_left = hh_arena_push_size_aligned(scratch_arena, count * sizeof(float), 32);
+  float* mix_right = hh_arena_push_size_aligned(scratch_arena, count * sizeof(float), 32);
+  float* chunk_left = hh_arena_push_size_aligned(scratch_arena, HH_MIXER_CHUNK_FRAMES * sizeof(float), 32);
+  float* chunk_right = hh_arena_push_size_aligned(scratch_arena, HH_MIXER_CHUNK_FRAMES * sizeof(float), 32);
+  memset(mix_left, 0, count * sizeof(float));
+  memset(mix_right, 0, count * sizeof(float));
+
+  for (HHMixerVoice** voice_link = &mixer->first_voice; *voice_link != NULL; ) {
+    HHMixerVoice* voice = *voice_link;
+    HHSound* sound = voice->sound;
+    u64 step = ((u64)sound->samples_per_second << 32) / sound_buffer->samples_per_second;
+    // NOTE(Ryan): Mono sounds feed the same chunk to both channels
+    float* source_right = (sound->channel_count == 2) ? chunk_right : chunk_left;
+
+    bool is_finished = false;
+    for (uint frame_i = 0; frame_i < count && !is_finished; ) {
+      uint chunk_count = (count - frame_i < HH_MIXER_CHUNK_FRAMES) ? count - frame_i : HH_MIXER_CHUNK_FRAMES;
+      uint produced = hh_mixer_resample_voice(voice, chunk_left, chunk_right, chunk_count, step);
+      is_finished = (produced < chunk_count);
+
+      // NOTE(Ryan): Split into the ramping part and the constant part so each is a single kernel call
+      uint ramp_count = (voice->fade_frames_remaining < produced) ? voice->fade_frames_remaining : produced;
+      if (ramp_count > 0) {
+        hh_mixer_accumulate(mix_left + frame_i, mix_right + frame_i, chunk_left, source_right, ramp_count,
+                            voice->volume[0] * mixer->master_volume, voice->volume[1] * mixer->master_volume,
+                            voice->volume_delta[0] * mixer->master_volume, voice->volume_delta[1] * mixer->master_volume);
+        voice->fade_frames_remaining -= ramp_count;
+        for (uint channel_i = 0; channel_i < HH_MIXER_MAX_CHANNELS; ++channel_i) {
+          voice->volume[channel_i] = (voice->fade_frames_remaining == 0) ? voice->target_volume[channel_i] :
+                                     voice->volume[channel_i] + voice->volume_delta[channel_i] * ramp_count;
+        }
+      }
+      if (produced > ramp_count) {
+        hh_mixer_accumulate(mix_left + frame_i + ramp_count, mix_right + frame_i + ramp_count,
+                            chunk_left + ramp_count, source_right + ramp_count, produced - ramp_count,
+                            voice->volume[0] * mixer->master_volume, voice->volume[1] * mixer->master_volume, 0.0f, 0.0f);
+      }
+
+      frame_i += produced;
+    }
+
+    if (voice->is_fading_out && voice->fade_frames_remaining == 0) {
+      is_finished = true;
+    }
+
+    if (is_finished) {
+      *voice_link = voice->next;
+      hh_mixer_free_voice(mixer, voice);
+    } else {
+      voice_link = &voice->next;
+    }
+  }
+
+  hh_mixer_output_s16(sound_buffer->samples, mix_left, mix_right, count);
+
+  hh_end_temporary_memory(mix_memory);
+}
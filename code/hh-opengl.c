@@ -0,0 +1,67 @@
+// NOTE(Ryan): The game renders in software, so GL is only used to get a finished frame on screen.
+// Fixed function is plenty for one textured quad and works on any context SDL hands back.
+
+// NOTE(Ryan): Largest region of the window with the buffer's aspect ratio, centred, so the rest letterboxes
+INTERNAL SDL_Rect
+aspect_ratio_fit(uint src_width, uint src_height, uint dest_width, uint dest_height)
+{
+  SDL_Rect result = {0};
+  if (src_width == 0 || src_height == 0 || dest_width == 0 || dest_height == 0) {
+    return result;
+  }
+
+  float optimal_width = (float)dest_height * ((float)src_width / (float)src_height);
+  float optimal_height = (float)dest_width * ((float)src_height / (float)src_width);
+  if (optimal_width > (float)dest_width) {
+    result.w = dest_width;
+    result.h = (int)optimal_height;
+  } else {
+    result.w = (int)optimal_width;
+    result.h = dest_height;
+  }
+  result.x = ((int)dest_width - result.w) / 2;
+  result.y = ((int)dest_height - result.h) / 2;
+
+  return result;
+}
+
+INTERNAL void
+opengl_display_pixel_buffer(HHPixelBuffer* pixel_buffer, SDL_Rect* drawable_region)
+{
+  PERSIST GLuint texture_handle = 0;
+  if (texture_handle == 0) {
+    glGenTextures(1, &texture_handle);
+    glBindTexture(GL_TEXTURE_2D, texture_handle);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+  }
+
+  // NOTE(Ryan): glClear ignores the viewport, so this blacks out the letterbox bars as well
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glViewport(drawable_region->x, drawable_region->y, drawable_region->w, drawable_region->h);
+
+  // NOTE(Ryan): Pixels are 0xAARRGGBB words, which is BGRA in memory on little endian
+  glBindTexture(GL_TEXTURE_2D, texture_handle);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, pixel_buffer->pitch / BYTES_PER_PIXEL);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, pixel_buffer->width, pixel_buffer->height, 0,
+               GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pixel_buffer->memory);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+  glEnable(GL_TEXTURE_2D);
+  glMatrixMode(GL_PROJECTION);
+  glLoadIdentity();
+  glMatrixMode(GL_MODELVIEW);
+  glLoadIdentity();
+
+  // NOTE(Ryan): Row 0 of the buffer is the top of the screen, so the texture is flipped vertically
+  glBegin(GL_TRIANGLE_STRIP);
+  glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f, -1.0f);
+  glTexCoord2f(1.0f, 1.0f); glVertex2f(1.0f, -1.0f);
+  glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f, 1.0f);
+  glTexCoord2f(1.0f, 0.0f); glVertex2f(1.0f, 1.0f);
+  glEnd();
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+// NOTE(Ryan): Contract between a platform layer and the game code.
+// Anything in here must be usable from either side of the hot-reload boundary.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+typedef unsigned int uint;
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+
+#define GLOBAL static
+#define INTERNAL static
+#define PERSIST static
+
+typedef enum {
+  FAILED = 0,
+  SUCCEEDED = 1
+} STATUS;
+
+#define KILOBYTES(value) ((u64)(value) * 1024ULL)
+#define MEGABYTES(value) (KILOBYTES(value) * 1024ULL)
+#define GIGABYTES(value) (MEGABYTES(value) * 1024ULL)
+
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
+#define IS_BIT_SET(value, bit) (((value) >> (bit)) & 1)
+#define SWAP(a, b) do { __typeof__(a) swap_tmp = (a); (a) = (b); (b) = swap_tmp; } while (0)
+
+#if defined(DEBUG)
+  #define HH_ASSERT(expr) do { if (!(expr)) __builtin_trap(); } while (0)
+#else
+  #define HH_ASSERT(expr) ((void)0)
+#endif
+
+#define BYTES_PER_PIXEL 4
+#define NUM_GAME_CONTROLLERS_SUPPORTED 4
+
+// NOTE(Ryan): Instruction set extensions the platform detected at startup.
+// The game selects its kernels from these rather than issuing cpuid itself.
+#define HH_CPU_FEATURE_SSE2 (1 << 0)
+#define HH_CPU_FEATURE_AVX2 (1 << 1)
+#define HH_CPU_FEATURE_NEON (1 << 2)
+
+typedef struct {
+  void* memory;
+  uint width;
+  uint height;
+  uint pitch;
+} HHPixelBuffer;
+
+typedef struct {
+  uint samples_per_second;
+  uint sample_count;
+  int16* samples;
+} HHSoundBuffer;
+
+typedef enum {
+  HH_BUTTON_MOVE_UP,
+  HH_BUTTON_MOVE_LEFT,
+  HH_BUTTON_MOVE_DOWN,
+  HH_BUTTON_MOVE_RIGHT,
+
+  HH_BUTTON_ACTION_UP,
+  HH_BUTTON_ACTION_LEFT,
+  HH_BUTTON_ACTION_DOWN,
+  HH_BUTTON_ACTION_RIGHT,
+
+  HH_BUTTON_SPECIAL_LEFT,
+  HH_BUTTON_SPECIAL_RIGHT,
+
+  HH_BUTTON_START,
+  HH_BUTTON_BACK,
+
+  HH_BUTTON_COUNT
+} HHButton;
+
+// NOTE(Ryan): Per button, whether it ended the frame down (bit per HHButton) and how many times it changed
+// state during the frame. A press and release inside one frame is ended_down 0, half_transition_count 2,
+// so no press is lost however short.
+typedef struct {
+  bool is_connected;
+  bool is_analog;
+  float stick_x;
+  float stick_y;
+
+  u16 ended_down;
+  u8 half_transition_count[HH_BUTTON_COUNT];
+} HHController;
+
+static inline bool
+hh_is_button_down(HHController* controller, HHButton button)
+{
+  return IS_BIT_SET(controller->ended_down, button);
+}
+
+// NOTE(Ryan): True if the button went down at any point this frame
+static inline bool
+hh_was_button_pressed(HHController* controller, HHButton button)
+{
+  u8 half_transition_count = controller->half_transition_count[button];
+  return (half_transition_count > 1) || (half_transition_count == 1 && hh_is_button_down(controller, button));
+}
+
+typedef struct {
+  // NOTE(Ryan): Keyboard controller reserves 0th controller position.
+  HHController controllers[NUM_GAME_CONTROLLERS_SUPPORTED + 1];
+  int mouse_x;
+  int mouse_y;
+  bool left_mouse_button;
+  bool middle_mouse_button;
+  bool right_mouse_button;
+  float frame_dt;
+} HHInput;
+
+// NOTE(Ryan): Indexed like HHInput.controllers. The game only fills these in; the platform applies the last
+// request per controller once the frame's update has finished. Magnitudes are [0, 1], duration 0 stops rumble.
+typedef struct {
+  bool is_requested;
+  float strong_magnitude;
+  float weak_magnitude;
+  u32 duration_ms;
+} HHRumbleRequest;
+
+typedef void (HHPlatformDebugWriteEntireFile)(char const* file_name, void* memory, uint memory_size);
+
+#include "hh-asset-pack.h"
+#include "hh-profiler.h"
+
+typedef enum {
+  HH_ASSET_READ_IDLE,
+  HH_ASSET_READ_PENDING,
+  HH_ASSET_READ_SUCCEEDED,
+  HH_ASSET_READ_FAILED,
+  // NOTE(Ryan): Dropped by the platform before it started (e.g. around a replay snapshot); nothing wrong with it
+  HH_ASSET_READ_CANCELLED
+} HHAssetReadState;
+
+// NOTE(Ryan): Background copy of pack bytes [offset, offset + size) to dest. Owned by the game, which must keep
+// it alive and leave it alone until state is no longer HH_ASSET_READ_PENDING.
+typedef struct {
+  u64 offset;
+  u64 size;
+  void* dest;
+  _Atomic u32 state;
+
+  // NOTE(Ryan): Platform bookkeeping while pending
+  u64 completed_size;
+  u32 chunks_in_flight;
+  bool has_failed;
+} HHAssetRead;
+
+typedef struct HHAssetStream HHAssetStream;
+// NOTE(Ryan): False if the stream's queue is full, in which case try again next frame
+typedef bool (HHPlatformBeginAssetRead)(HHAssetStream* stream, HHAssetRead* read);
+
+typedef struct HHJobQueue HHJobQueue;
+typedef void (HHJobCallback)(void* data);
+// NOTE(Ryan): Platforms clamp their queues to this, so the game can size per-thread state statically
+#define HH_MAX_JOB_THREADS 64
+
+// NOTE(Ryan): Jobs added against a counter increment it and decrement on completion.
+// Waiting on a counter executes other jobs until it reaches zero, so jobs may wait on sub-jobs.
+typedef struct {
+  _Atomic int32 pending;
+} HHJobCounter;
+
+// IMPORTANT(Ryan): Only add jobs from the thread that created the queue or from inside a job. Each pool thread
+// pushes to its own deque, and a thread outside the pool (audio callback, input, asset stream) has none: DEBUG
+// builds trap, release builds run the job inline on the caller.
+typedef void (HHPlatformAddJob)(HHJobQueue* queue, HHJobCallback* callback, void* data, HHJobCounter* counter);
+typedef void (HHPlatformWaitForJobs)(HHJobQueue* queue, HHJobCounter* counter);
+// NOTE(Ryan): 0 for the thread that owns the queue, [1, job_queue_thread_count) for workers, (uint)-1 elsewhere
+typedef uint (HHPlatformGetThreadIndex)(void);
+
+typedef struct {
+  bool is_initialized;
+
+  u64 permanent_storage_size;
+  void* permanent_storage;
+  u64 transient_storage_size;
+  void* transient_storage;
+
+  u32 cpu_features;
+  uint cache_line_size;
+
+  HHJobQueue* job_queue;
+  uint job_queue_thread_count;
+  HHPlatformAddJob* platform_add_job;
+  HHPlatformWaitForJobs* platform_wait_for_jobs;
+  HHPlatformGetThreadIndex* platform_get_thread_index;
+
+  // NOTE(Ryan): Mapped read-only for the life of the process; an empty pack if none could be opened
+  HHAssetPack const* asset_pack;
+  // NOTE(Ryan): NULL if there is no pack or no stream could be started, in which case read the mapping directly
+  HHAssetStream* asset_stream;
+  HHPlatformBeginAssetRead* platform_begin_asset_read;
+  HHPlatformDebugWriteEntireFile* platform_debug_write_entire_file;
+
+  HHRumbleRequest rumble_requests[NUM_GAME_CONTROLLERS_SUPPORTED + 1];
+
+  // NOTE(Ryan): NULL unless the platform was built with HH_PROFILE
+  HHProfiler* profiler;
+} HHMemory;
+
+// NOTE(Ryan): Game calls this at the top of each frame; it is a pointer store, and a reloaded module starts unbound
+static inline void
+hh_bind_profiler(HHMemory* memory)
+{
+#if defined(HH_PROFILE)
+  hh_profiler = memory->profiler;
+#else
+  (void)memory;
+#endif
+}
+
+static inline void
+hh_request_rumble(HHMemory* memory, uint controller_i, float strong_magnitude, float weak_magnitude, u32 duration_ms)
+{
+  HHRumbleRequest* request = &memory->rumble_requests[controller_i];
+  request->is_requested = true;
+  request->strong_magnitude = strong_magnitude;
+  request->weak_magnitude = weak_magnitude;
+  request->duration_ms = duration_ms;
+}
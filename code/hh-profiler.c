@@ -0,0 +1,288 @@
+// NOTE(Ryan): Platform side of the profiler declared in hh-profiler.h.
+// At the end of every frame each thread's ring is drained into that frame's per-block cycle and hit totals,
+// kept for the last SDL_PROFILER_FRAME_HISTORY frames, and into a capture ring of raw events that
+// sdl_write_profiler_trace turns into Chrome trace JSON. Cycles are converted to time against the
+// performance counter over the whole run, so no calibration sleep is needed at startup.
+
+#include <stdarg.h>
+
+#if defined(HH_PROFILE)
+
+#define SDL_PROFILER_FRAME_HISTORY 128
+#define SDL_PROFILER_FRAME_CAPACITY 4096
+// NOTE(Ryan): Power of two; 4MiB of the most recent events
+#define SDL_PROFILER_CAPTURE_CAPACITY (1 << 18)
+
+typedef struct {
+  u64 cycles;
+  u64 hit_count;
+} SDLProfilerBlockFrame;
+
+typedef struct {
+  u64 begin_cycles;
+  u32 duration_cycles;
+  u16 block_id;
+  u16 thread_i;
+} SDLProfilerCaptureEvent;
+
+typedef struct {
+  u64 begin_cycles;
+  u64 end_cycles;
+} SDLProfilerFrame;
+
+typedef struct {
+  // NOTE(Ryan): First, so the HHProfiler handed to the game converts back to this
+  HHProfiler profiler;
+
+  u64 frame_index;
+  u64 frame_begin_cycles;
+  SDLProfilerFrame frames[SDL_PROFILER_FRAME_CAPACITY];
+  SDLProfilerBlockFrame block_frames[SDL_PROFILER_FRAME_HISTORY][HH_PROFILER_MAX_BLOCKS];
+
+  SDLProfilerCaptureEvent* capture;
+  u64 capture_count;
+  u64 dropped_event_count;
+
+  u64 start_cycles;
+  u64 start_counter;
+} SDLProfiler;
+
+GLOBAL _Thread_local HHProfilerThread* sdl_profiler_thread = NULL;
+
+INTERNAL HHProfilerThread*
+sdl_get_profiler_thread(HHProfiler* profiler)
+{
+  if (sdl_profiler_thread != NULL) {
+    return sdl_profiler_thread;
+  }
+
+  u32 thread_i = atomic_fetch_add_explicit(&profiler->thread_count, 1, memory_order_relaxed);
+  if (thread_i >= HH_PROFILER_MAX_THREADS) {
+    atomic_fetch_sub_explicit(&profiler->thread_count, 1, memory_order_relaxed);
+    return NULL;
+  }
+  HHProfilerThread* thread = aligned_alloc(alignof(HHProfilerThread), sizeof(HHProfilerThread));
+  if (thread == NULL) {
+    return NULL;
+  }
+  memset(thread, 0, sizeof(*thread));
+  atomic_store_explicit(&profiler->threads[thread_i], thread, memory_order_release);
+
+  sdl_profiler_thread = thread;
+  return thread;
+}
+
+INTERNAL SDLProfiler*
+sdl_create_profiler(void)
+{
+  SDLProfiler* profiler = calloc(1, sizeof(SDLProfiler));
+  if (profiler == NULL) {
+    SDL_LogWarn("Unable to allocate profiler: %s", strerror(errno));
+    return NULL;
+  }
+  profiler->capture = calloc(SDL_PROFILER_CAPTURE_CAPACITY, sizeof(SDLProfilerCaptureEvent));
+  if (profiler->capture == NULL) {
+    SDL_LogWarn("Unable to allocate profiler capture: %s", strerror(errno));
+    free(profiler);
+    return NULL;
+  }
+
+  profiler->profiler.platform_get_profiler_thread = sdl_get_profiler_thread;
+  atomic_flag_clear(&profiler->profiler.block_lock);
+  profiler->start_cycles = hh_read_cycle_counter();
+  profiler->start_counter = SDL_GetPerformanceCounter();
+  profiler->frame_begin_cycles = profiler->start_cycles;
+
+  return profiler;
+}
+
+// NOTE(Ryan): Call once per frame from the main thread, after the frame's jobs have been waited on.
+// Threads still recording (audio, input) are fine; their events land in whichever frame drains them.
+INTERNAL void
+sdl_profiler_end_frame(SDLProfiler* profiler)
+{
+  u64 end_cycles = hh_read_cycle_counter();
+  SDLProfilerBlockFrame* block_frames = profiler->block_frames[profiler->frame_index % SDL_PROFILER_FRAME_HISTORY];
+  memset(block_frames, 0, sizeof(profiler->block_frames[0]));
+
+  u32 thread_count = atomic_load_explicit(&profiler->profiler.thread_count, memory_order_relaxed);
+  for (u32 thread_i = 0; thread_i < thread_count; ++thread_i) {
+    HHProfilerThread* thread = atomic_load_explicit(&profiler->profiler.threads[thread_i], memory_order_acquire);
+    if (thread == NULL) {
+      continue;
+    }
+
+    u64 write_index = atomic_load_explicit(&thread->write_index, memory_order_acquire);
+    if (write_index - thread->read_index > HH_PROFILER_RING_CAPACITY) {
+      // NOTE(Ryan): Ring lapped since the last frame; the oldest events are gone
+      profiler->dropped_event_count += (write_index - thread->read_index) - HH_PROFILER_RING_CAPACITY;
+      thread->read_index = write_index - HH_PROFILER_RING_CAPACITY;
+    }
+
+    for (; thread->read_index < write_index; ++thread->read_index) {
+      HHProfilerEvent* event = &thread->events[thread->read_index & (HH_PROFILER_RING_CAPACITY - 1)];
+      if (event->block_id >= HH_PROFILER_MAX_BLOCKS) {
+        continue;
+      }
+      block_frames[event->block_id].cycles += event->duration_cycles;
+      block_frames[event->block_id].hit_count += 1;
+
+      SDLProfilerCaptureEvent* capture_event = &profiler->capture[profiler->capture_count++ & (SDL_PROFILER_CAPTURE_CAPACITY - 1)];
+      capture_event->begin_cycles = event->begin_cycles;
+      capture_event->duration_cycles = event->duration_cycles;
+      capture_event->block_id = (u16)event->block_id;
+      capture_event->thread_i = (u16)thread_i;
+    }
+  }
+
+  SDLProfilerFrame* frame = &profiler->frames[profiler->frame_index % SDL_PROFILER_FRAME_CAPACITY];
+  frame->begin_cycles = profiler->frame_begin_cycles;
+  frame->end_cycles = end_cycles;
+  profiler->frame_begin_cycles = end_cycles;
+  ++profiler->frame_index;
+}
+
+INTERNAL double
+sdl_profiler_cycles_per_microsecond(SDLProfiler* profiler)
+{
+  u64 elapsed_cycles = hh_read_cycle_counter() - profiler->start_cycles;
+  u64 elapsed_counter = SDL_GetPerformanceCounter() - profiler->start_counter;
+  double elapsed_microseconds = (1000000.0 * elapsed_counter) / SDL_GetPerformanceFrequency();
+  return (elapsed_microseconds > 0.0 && elapsed_cycles > 0) ? elapsed_cycles / elapsed_microseconds : 1.0;
+}
+
+// NOTE(Ryan): Average and worst per-frame cost of every block over the recorded history
+INTERNAL void
+sdl_log_profiler_summary(SDLProfiler* profiler)
+{
+  u64 frame_count = (profiler->frame_index < SDL_PROFILER_FRAME_HISTORY) ? profiler->frame_index : SDL_PROFILER_FRAME_HISTORY;
+  if (frame_count == 0) {
+    return;
+  }
+  double cycles_per_microsecond = sdl_profiler_cycles_per_microsecond(profiler);
+
+  SDL_Log("Profile over the last %llu frames (%llu events dropped):",
+          (unsigned long long)frame_count, (unsigned long long)profiler->dropped_event_count);
+  u32 block_count = atomic_load_explicit(&profiler->profiler.block_count, memory_order_acquire);
+  for (u32 block_i = 0; block_i < block_count; ++block_i) {
+    u64 total_cycles = 0, max_cycles = 0, total_hits = 0;
+    for (u64 frame_i = 0; frame_i < frame_count; ++frame_i) {
+      SDLProfilerBlockFrame* block_frame = &profiler->block_frames[frame_i][block_i];
+      total_cycles += block_frame->cycles;
+      total_hits += block_frame->hit_count;
+      if (block_frame->cycles > max_cycles) {
+        max_cycles = block_frame->cycles;
+      }
+    }
+    HHProfilerBlock* block = &profiler->profiler.blocks[block_i];
+    SDL_Log("  %-32s %10.1f us avg %10.1f us max %8.1f hits  (%s:%u)", block->name,
+            (total_cycles / (double)frame_count) / cycles_per_microsecond, max_cycles / cycles_per_microsecond,
+            total_hits / (double)frame_count, block->file_name, block->line);
+  }
+}
+
+typedef struct {
+  SDL_RWops* handle;
+  char buffer[KILOBYTES(64)];
+  uint buffer_used;
+  bool has_failed;
+} SDLTraceWriter;
+
+INTERNAL void
+sdl_trace_flush(SDLTraceWriter* writer)
+{
+  if (writer->buffer_used > 0 && SDL_RWwrite(writer->handle, writer->buffer, 1, writer->buffer_used) != writer->buffer_used) {
+    writer->has_failed = true;
+  }
+  writer->buffer_used = 0;
+}
+
+INTERNAL void __attribute__((format(printf, 2, 3)))
+sdl_trace_printf(SDLTraceWriter* writer, char const* format, ...)
+{
+  // NOTE(Ryan): No single event comes close to this, so flushing ahead of time means no retry
+  if (sizeof(writer->buffer) - writer->buffer_used < 512) {
+    sdl_trace_flush(writer);
+  }
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf(writer->buffer + writer->buffer_used, sizeof(writer->buffer) - writer->buffer_used, format, args);
+  va_end(args);
+  if (written > 0) {
+    writer->buffer_used += ((uint)written < sizeof(writer->buffer) - writer->buffer_used) ? (uint)written : 0;
+  }
+}
+
+// NOTE(Ryan): Block names are C identifiers or literals, so only quotes and backslashes need escaping
+INTERNAL void
+sdl_trace_escape(char* escaped, uint escaped_size, char const* name)
+{
+  uint escaped_i = 0;
+  for (; *name != '\0' && escaped_i + 2 < escaped_size; ++name) {
+    if (*name == '"' || *name == '\\') {
+      escaped[escaped_i++] = '\\';
+    }
+    escaped[escaped_i++] = *name;
+  }
+  escaped[escaped_i] = '\0';
+}
+
+// NOTE(Ryan): Chrome trace event format: complete ('X') events with microsecond timestamps. Each profiled
+// thread is its own track, and frames are drawn on a separate track so spikes line up with their blocks.
+INTERNAL STATUS
+sdl_write_profiler_trace(SDLProfiler* profiler, char const* file_name)
+{
+  SDLTraceWriter* writer = calloc(1, sizeof(SDLTraceWriter));
+  if (writer == NULL) {
+    return FAILED;
+  }
+  writer->handle = SDL_RWFromFile(file_name, "wb");
+  if (writer->handle == NULL) {
+    SDL_LogWarn("Unable to create profile trace '%s': %s", file_name, SDL_GetError());
+    free(writer);
+    return FAILED;
+  }
+
+  double cycles_per_microsecond = sdl_profiler_cycles_per_microsecond(profiler);
+  u64 first_event_i = (profiler->capture_count > SDL_PROFILER_CAPTURE_CAPACITY) ? profiler->capture_count - SDL_PROFILER_CAPTURE_CAPACITY : 0;
+  u64 first_frame_i = (profiler->frame_index > SDL_PROFILER_FRAME_CAPACITY) ? profiler->frame_index - SDL_PROFILER_FRAME_CAPACITY : 0;
+  u32 frame_track = HH_PROFILER_MAX_THREADS;
+
+  sdl_trace_printf(writer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  sdl_trace_printf(writer, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"frames\"}}", frame_track);
+  u32 thread_count = atomic_load_explicit(&profiler->profiler.thread_count, memory_order_relaxed);
+  for (u32 thread_i = 0; thread_i < thread_count; ++thread_i) {
+    sdl_trace_printf(writer, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", thread_i, thread_i);
+  }
+
+  for (u64 frame_i = first_frame_i; frame_i < profiler->frame_index; ++frame_i) {
+    SDLProfilerFrame* frame = &profiler->frames[frame_i % SDL_PROFILER_FRAME_CAPACITY];
+    sdl_trace_printf(writer, ",\n{\"name\":\"frame %llu\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     (unsigned long long)frame_i, frame_track,
+                     (int64)(frame->begin_cycles - profiler->start_cycles) / cycles_per_microsecond,
+                     (frame->end_cycles - frame->begin_cycles) / cycles_per_microsecond);
+  }
+
+  for (u64 event_i = first_event_i; event_i < profiler->capture_count; ++event_i) {
+    SDLProfilerCaptureEvent* event = &profiler->capture[event_i & (SDL_PROFILER_CAPTURE_CAPACITY - 1)];
+    HHProfilerBlock* block = &profiler->profiler.blocks[event->block_id];
+    char name[HH_PROFILER_BLOCK_NAME_LENGTH * 2] = {0};
+    sdl_trace_escape(name, sizeof(name), block->name);
+    sdl_trace_printf(writer, ",\n{\"name\":\"%s\",\"cat\":\"%s:%u\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     name, block->file_name, block->line, event->thread_i,
+                     (int64)(event->begin_cycles - profiler->start_cycles) / cycles_per_microsecond,
+                     event->duration_cycles / cycles_per_microsecond);
+  }
+  sdl_trace_printf(writer, "\n]}\n");
+  sdl_trace_flush(writer);
+
+  STATUS result = writer->has_failed ? FAILED : SUCCEEDED;
+  if (SDL_RWclose(writer->handle) < 0 || result == FAILED) {
+    SDL_LogWarn("Unable to write profile trace '%s': %s", file_name, SDL_GetError());
+    result = FAILED;
+  }
+  free(writer);
+  return result;
+}
+
+#endif
@@ -0,0 +1,171 @@
+#pragma once
+
+// NOTE(Ryan): Cycle-counter profiler shared by the platform and the game.
+// TIMED_BLOCK("name") / TIMED_FUNCTION() time the rest of the enclosing scope and append one event to the
+// calling thread's ring: a relaxed load, two stores and a release store, no locks. The HHProfiler itself is
+// owned by the platform and handed over through HHMemory, so recorded data and block names survive a hot
+// reload. The platform drains every ring at the end of a frame into per-block, per-frame totals and a
+// capture buffer that can be written out as a Chrome trace (chrome://tracing, Perfetto).
+//
+// Recording is only compiled in with HH_PROFILE, which DEBUG implies; otherwise the macros expand to nothing.
+// Define HH_PROFILE on its own for an optimised build that can still take captures.
+
+#include <stdalign.h>
+
+#if defined(DEBUG) && !defined(HH_PROFILE)
+  #define HH_PROFILE
+#endif
+
+#define HH_PROFILER_MAX_THREADS 64
+#define HH_PROFILER_MAX_BLOCKS 512
+#define HH_PROFILER_BLOCK_NAME_LENGTH 48
+// NOTE(Ryan): Power of two. Needs to hold one frame's events for the busiest thread.
+#define HH_PROFILER_RING_CAPACITY (1 << 14)
+
+typedef struct {
+  u64 begin_cycles;
+  u32 duration_cycles;
+  u32 block_id;
+} HHProfilerEvent;
+
+// NOTE(Ryan): Written by its thread only; the platform reads it at the end of the frame
+typedef struct {
+  alignas(64) _Atomic u64 write_index;
+  alignas(64) u64 read_index;
+  HHProfilerEvent events[HH_PROFILER_RING_CAPACITY];
+} HHProfilerThread;
+
+typedef struct {
+  char name[HH_PROFILER_BLOCK_NAME_LENGTH];
+  char file_name[HH_PROFILER_BLOCK_NAME_LENGTH];
+  u32 line;
+} HHProfilerBlock;
+
+typedef struct HHProfiler HHProfiler;
+typedef HHProfilerThread* (HHPlatformGetProfilerThread)(HHProfiler* profiler);
+
+struct HHProfiler {
+  HHPlatformGetProfilerThread* platform_get_profiler_thread;
+
+  atomic_flag block_lock;
+  _Atomic u32 block_count;
+  HHProfilerBlock blocks[HH_PROFILER_MAX_BLOCKS];
+
+  // NOTE(Ryan): Slots are claimed by count first, so a slot below thread_count may still read NULL briefly
+  _Atomic u32 thread_count;
+  _Atomic(HHProfilerThread*) threads[HH_PROFILER_MAX_THREADS];
+};
+
+static inline u64
+hh_read_cycle_counter(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+  u64 counter = 0;
+  __asm__ volatile("mrs %0, cntvct_el0" : "=r"(counter));
+  return counter;
+#else
+  return 0;
+#endif
+}
+
+#if defined(HH_PROFILE)
+
+// NOTE(Ryan): Per module, so each side of the hot-reload boundary binds its own copy
+static HHProfiler* hh_profiler = NULL;
+static _Thread_local HHProfilerThread* hh_profiler_thread = NULL;
+
+typedef struct {
+  HHProfilerThread* thread;
+  u32 block_id;
+  u64 begin_cycles;
+} HHTimedBlock;
+
+// NOTE(Ryan): Name and site are copied into the profiler so they outlive the module that registered them.
+// A reloaded module registering the same site gets the existing id back. Returns id + 1, 0 on failure.
+static inline u32
+hh_register_profiler_block(HHProfiler* profiler, char const* name, char const* file_name, u32 line)
+{
+  while (atomic_flag_test_and_set_explicit(&profiler->block_lock, memory_order_acquire)) {}
+
+  char const* base_name = strrchr(file_name, '/');
+  file_name = (base_name != NULL) ? base_name + 1 : file_name;
+
+  u32 block_count = atomic_load_explicit(&profiler->block_count, memory_order_relaxed);
+  u32 block_id = 0;
+  for (u32 block_i = 0; block_i < block_count; ++block_i) {
+    HHProfilerBlock* block = &profiler->blocks[block_i];
+    if (block->line == line && strncmp(block->name, name, HH_PROFILER_BLOCK_NAME_LENGTH - 1) == 0 &&
+        strncmp(block->file_name, file_name, HH_PROFILER_BLOCK_NAME_LENGTH - 1) == 0) {
+      block_id = block_i + 1;
+      break;
+    }
+  }
+  if (block_id == 0 && block_count < HH_PROFILER_MAX_BLOCKS) {
+    HHProfilerBlock* block = &profiler->blocks[block_count];
+    strncpy(block->name, name, HH_PROFILER_BLOCK_NAME_LENGTH - 1);
+    strncpy(block->file_name, file_name, HH_PROFILER_BLOCK_NAME_LENGTH - 1);
+    block->line = line;
+    atomic_store_explicit(&profiler->block_count, block_count + 1, memory_order_release);
+    block_id = block_count + 1;
+  }
+
+  atomic_flag_clear_explicit(&profiler->block_lock, memory_order_release);
+  return block_id;
+}
+
+static inline HHTimedBlock
+hh_begin_timed_block(_Atomic u32* site_block_id, char const* name, char const* file_name, u32 line)
+{
+  HHTimedBlock timed_block = {0};
+  if (hh_profiler == NULL) {
+    return timed_block;
+  }
+  u32 block_id = atomic_load_explicit(site_block_id, memory_order_relaxed);
+  if (block_id == 0) {
+    block_id = hh_register_profiler_block(hh_profiler, name, file_name, line);
+    atomic_store_explicit(site_block_id, block_id, memory_order_relaxed);
+  }
+  if (hh_profiler_thread == NULL) {
+    hh_profiler_thread = hh_profiler->platform_get_profiler_thread(hh_profiler);
+  }
+
+  timed_block.thread = (block_id != 0) ? hh_profiler_thread : NULL;
+  timed_block.block_id = block_id - 1;
+  timed_block.begin_cycles = hh_read_cycle_counter();
+  return timed_block;
+}
+
+static inline void
+hh_end_timed_block(HHTimedBlock* timed_block)
+{
+  HHProfilerThread* thread = timed_block->thread;
+  if (thread == NULL) {
+    return;
+  }
+  u64 end_cycles = hh_read_cycle_counter();
+  u64 write_index = atomic_load_explicit(&thread->write_index, memory_order_relaxed);
+  HHProfilerEvent* event = &thread->events[write_index & (HH_PROFILER_RING_CAPACITY - 1)];
+  event->begin_cycles = timed_block->begin_cycles;
+  u64 duration_cycles = end_cycles - timed_block->begin_cycles;
+  event->duration_cycles = (duration_cycles > UINT32_MAX) ? UINT32_MAX : (u32)duration_cycles;
+  event->block_id = timed_block->block_id;
+  atomic_store_explicit(&thread->write_index, write_index + 1, memory_order_release);
+}
+
+#define HH_PROFILER_CONCAT_(a, b) a##b
+#define HH_PROFILER_CONCAT(a, b) HH_PROFILER_CONCAT_(a, b)
+
+#define TIMED_BLOCK(name) \
+  PERSIST _Atomic u32 HH_PROFILER_CONCAT(hh_block_id_, __LINE__) = 0; \
+  HHTimedBlock HH_PROFILER_CONCAT(hh_timed_block_, __LINE__) __attribute__((cleanup(hh_end_timed_block))) = \
+    hh_begin_timed_block(&HH_PROFILER_CONCAT(hh_block_id_, __LINE__), (name), __FILE__, __LINE__)
+#define TIMED_FUNCTION() TIMED_BLOCK(__func__)
+
+#else
+
+#define TIMED_BLOCK(name)
+#define TIMED_FUNCTION()
+
+#endif
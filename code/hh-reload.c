@@ -0,0 +1,164 @@
+// NOTE(Ryan): Watches the game shared object for a finished rebuild.
+// On Linux a thread blocks on inotify for the object's directory and only flags a change once the file
+// has been fully written (IN_CLOSE_WRITE) or renamed into place (IN_MOVED_TO), so the main loop never
+// reloads a half-linked object and no longer stats the file every frame.
+// Elsewhere the main loop falls back to polling the modification time.
+
+#include <sys/stat.h>
+#if defined(LINUX)
+  #include <sys/inotify.h>
+  #include <unistd.h>
+  #include <limits.h>
+#endif
+
+typedef struct {
+  char file_name[256];
+  _Atomic bool has_changed;
+#if defined(LINUX)
+  int inotify_fd;
+  int watch_descriptor;
+  _Atomic bool is_running;
+  SDL_Thread* thread;
+#else
+  char file_path[256];
+  time_t last_modification_time;
+#endif
+} SDLFileWatcher;
+
+#if defined(LINUX)
+INTERNAL int
+sdl_file_watcher_thread(void* data)
+{
+  SDLFileWatcher* watcher = (SDLFileWatcher *)data;
+
+  // NOTE(Ryan): Large enough for at least one event with the longest possible name
+  alignas(struct inotify_event) char events[sizeof(struct inotify_event) + NAME_MAX + 1];
+  while (atomic_load_explicit(&watcher->is_running, memory_order_relaxed)) {
+    ssize_t events_size = read(watcher->inotify_fd, events, sizeof(events));
+    if (events_size <= 0) {
+      if (events_size < 0 && errno == EINTR) {
+        continue;
+      }
+      SDL_LogWarn("Unable to read hot reload events: %s", strerror(errno));
+      break;
+    }
+
+    for (char* event_cursor = events; event_cursor < events + events_size; ) {
+      struct inotify_event* event = (struct inotify_event *)event_cursor;
+      if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) && event->len > 0 &&
+          strcmp(event->name, watcher->file_name) == 0) {
+        atomic_store_explicit(&watcher->has_changed, true, memory_order_release);
+      }
+      event_cursor += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  return 0;
+}
+#endif
+
+INTERNAL STATUS
+sdl_start_file_watcher(SDLFileWatcher* watcher, char const* directory, char const* file_name)
+{
+  snprintf(watcher->file_name, sizeof(watcher->file_name), "%s", file_name);
+  atomic_store(&watcher->has_changed, false);
+
+#if defined(LINUX)
+  watcher->inotify_fd = inotify_init1(IN_CLOEXEC);
+  if (watcher->inotify_fd < 0) {
+    SDL_LogWarn("Unable to initialise inotify: %s", strerror(errno));
+    return FAILED;
+  }
+  // NOTE(Ryan): Directory rather than file, as linkers commonly replace the object with a new inode
+  watcher->watch_descriptor = inotify_add_watch(watcher->inotify_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (watcher->watch_descriptor < 0) {
+    SDL_LogWarn("Unable to watch '%s' for hot reload: %s", directory, strerror(errno));
+    close(watcher->inotify_fd);
+    return FAILED;
+  }
+
+  atomic_store(&watcher->is_running, true);
+  watcher->thread = SDL_CreateThread(sdl_file_watcher_thread, "hh-reload", watcher);
+  if (watcher->thread == NULL) {
+    SDL_LogWarn("Unable to create hot reload thread: %s", SDL_GetError());
+    close(watcher->inotify_fd);
+    return FAILED;
+  }
+#else
+  snprintf(watcher->file_path, sizeof(watcher->file_path), "%s%s", directory, file_name);
+  struct stat file_stat = {0};
+  stat(watcher->file_path, &file_stat);
+  watcher->last_modification_time = file_stat.st_mtime;
+#endif
+
+  return SUCCEEDED;
+}
+
+// NOTE(Ryan): Returns true once per completed rewrite of the watched file.
+INTERNAL bool
+sdl_file_watcher_has_changed(SDLFileWatcher* watcher)
+{
+#if defined(LINUX)
+  if (!atomic_load_explicit(&watcher->has_changed, memory_order_relaxed)) {
+    return false;
+  }
+  return atomic_exchange_explicit(&watcher->has_changed, false, memory_order_acquire);
+#else
+  struct stat file_stat = {0};
+  if (stat(watcher->file_path, &file_stat) == 0 && file_stat.st_mtime > watcher->last_modification_time) {
+    watcher->last_modification_time = file_stat.st_mtime;
+    return true;
+  }
+  return false;
+#endif
+}
+
+INTERNAL void
+sdl_stop_file_watcher(SDLFileWatcher* watcher)
+{
+#if defined(LINUX)
+  if (watcher->thread == NULL) {
+    return;
+  }
+  atomic_store(&watcher->is_running, false);
+  // NOTE(Ryan): Removing the watch queues an IN_IGNORED event, which wakes the blocked read
+  inotify_rm_watch(watcher->inotify_fd, watcher->watch_descriptor);
+  SDL_WaitThread(watcher->thread, NULL);
+  close(watcher->inotify_fd);
+#endif
+}
+
+// NOTE(Ryan): Loading a private copy means the original can be relinked while the old code is still mapped,
+// and the loader never sees a file that is still being written.
+INTERNAL STATUS
+sdl_copy_file(char const* source_file_name, char const* destination_file_name)
+{
+  SDL_RWops* source = SDL_RWFromFile(source_file_name, "rb");
+  if (source == NULL) {
+    SDL_LogWarn("Unable to open '%s' for copying: %s", source_file_name, SDL_GetError());
+    return FAILED;
+  }
+  SDL_RWops* destination = SDL_RWFromFile(destination_file_name, "wb");
+  if (destination == NULL) {
+    SDL_LogWarn("Unable to create '%s': %s", destination_file_name, SDL_GetError());
+    SDL_RWclose(source);
+    return FAILED;
+  }
+
+  STATUS result = SUCCEEDED;
+  u8 copy_buffer[KILOBYTES(64)];
+  size_t bytes_read = 0;
+  while ((bytes_read = SDL_RWread(source, copy_buffer, 1, sizeof(copy_buffer))) > 0) {
+    if (SDL_RWwrite(destination, copy_buffer, 1, bytes_read) != bytes_read) {
+      SDL_LogWarn("Unable to write '%s': %s", destination_file_name, SDL_GetError());
+      result = FAILED;
+      break;
+    }
+  }
+
+  SDL_RWclose(source);
+  if (SDL_RWclose(destination) < 0) {
+    result = FAILED;
+  }
+  return result;
+}
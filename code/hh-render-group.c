@@ -0,0 +1,335 @@
+// NOTE(Ryan): Deferred rendering. The game pushes compact commands (clear, rectangle, bitmap, quad) into a
+// render group each frame instead of touching pixels; hh_render_group_to_output() then sorts them and replays the
+// whole list once per screen tile, each tile a job on the platform queue. A tile is drawn start to finish while it
+// sits in L1/L2, so overdraw costs cache bandwidth rather than memory bandwidth, and tiles never share a cache
+// line so any number of threads can draw at once with no locking.
+//
+// Commands grow up from the start of the push buffer and their sort entries grow down from the end. A sort
+// entry is (sort_key << 32 | command offset), so lower keys draw first and equal keys keep push order. Each push
+// also holds back room for one more sort entry, which the radix sort uses as its scratch buffer.
+//
+// The buffer is meant to come from a temporary memory scope on transient storage, begun every frame. Anything a
+// command points at (bitmap pixels) must stay valid until the group has been output.
+//
+// IMPORTANT(Ryan): Colours and texels are all premultiplied sRGB, but the blend space differs by command.
+// Rectangles and bitmaps blend directly on the sRGB values, which is cheap and exact in integer SIMD. Quads blend
+// in linear light (see hh_draw_quad()), which costs float math per pixel and keeps edges and fades from darkening.
+// A translucent quad therefore comes out lighter than a bitmap of the same texels and alpha. Where the two must
+// match, as with a sprite that is sometimes rotated, push it as a quad either way.
+
+#include <limits.h>
+
+typedef enum {
+  HH_RENDER_ENTRY_CLEAR,
+  HH_RENDER_ENTRY_RECTANGLE,
+  HH_RENDER_ENTRY_BITMAP,
+  HH_RENDER_ENTRY_QUAD
+} HHRenderEntryType;
+
+typedef struct {
+  u32 type;
+  // NOTE(Ryan): Conservative pixel bounds, so a tile skips entries that miss it without decoding them
+  HHClipRect bounds;
+} HHRenderEntryHeader;
+
+typedef struct {
+  HHRenderEntryHeader header;
+  u32 color;
+} HHRenderEntryClear;
+
+typedef struct {
+  HHRenderEntryHeader header;
+  u32 color;
+  float min_x;
+  float min_y;
+  float max_x;
+  float max_y;
+} HHRenderEntryRectangle;
+
+typedef struct {
+  HHRenderEntryHeader header;
+  float x;
+  float y;
+  float alpha;
+  HHBitmap bitmap;
+} HHRenderEntryBitmap;
+
+typedef struct {
+  HHRenderEntryHeader header;
+  float origin_x;
+  float origin_y;
+  float x_axis_x;
+  float x_axis_y;
+  float y_axis_x;
+  float y_axis_y;
+  float alpha;
+  HHBitmap bitmap;
+} HHRenderEntryQuad;
+
+typedef struct {
+  u8* push_buffer_base;
+  u32 push_buffer_size;
+  u32 push_buffer_used;
+  // NOTE(Ryan): Sort entries occupy [sort_entries_offset, push_buffer_size)
+  u32 sort_entries_offset;
+  u32 entry_count;
+  // NOTE(Ryan): Pushes that didn't fit and were ignored, so a too-small buffer shows up rather than crashing
+  u32 dropped_entry_count;
+  // NOTE(Ryan): Valid after hh_sort_render_group(), in draw order
+  u64 const* sorted_entries;
+} HHRenderGroup;
+
+// NOTE(Ryan): Push buffers are limited to 4GiB so a command offset fits the low half of a sort entry
+INTERNAL void
+hh_begin_render_group(HHRenderGroup* group, HHMemoryArena* arena, size_t push_buffer_size)
+{
+  size_t size_remaining = hh_arena_size_remaining(arena, 64);
+  push_buffer_size = (push_buffer_size < size_remaining) ? push_buffer_size : size_remaining;
+  push_buffer_size = (push_buffer_size < UINT32_MAX) ? push_buffer_size : UINT32_MAX;
+  push_buffer_size &= ~(size_t)(sizeof(u64) - 1);
+
+  memset(group, 0, sizeof(*group));
+  group->push_buffer_base = (u8 *)hh_arena_push_size_aligned(arena, push_buffer_size, 64);
+  group->push_buffer_size = (u32)push_buffer_size;
+  group->sort_entries_offset = (u32)push_buffer_size;
+}
+
+// NOTE(Ryan): Widened by a pixel either side and clamped well inside int range, so any float is safe
+INTERNAL HHClipRect
+hh_get_render_entry_bounds(float min_x, float min_y, float max_x, float max_y)
+{
+  float limit = (float)(1 << 30);
+  HHClipRect result = {0};
+  result.min_x = (int)floorf(fmaxf(fminf(min_x, limit), -limit)) - 1;
+  result.min_y = (int)floorf(fmaxf(fminf(min_y, limit), -limit)) - 1;
+  result.max_x = (int)ceilf(fmaxf(fminf(max_x, limit), -limit)) + 1;
+  result.max_y = (int)ceilf(fmaxf(fminf(max_y, limit), -limit)) + 1;
+  return result;
+}
+
+INTERNAL void*
+hh_push_render_entry(HHRenderGroup* group, u32 sort_key, HHRenderEntryType type, u32 size, HHClipRect bounds)
+{
+  // NOTE(Ryan): Every entry type is 8 byte aligned and a multiple of 8 in size. Sorting reorders the sort entries
+  // in place, so a group can't be pushed to once it has been sorted.
+  HH_ASSERT(size % sizeof(u64) == 0);
+  HH_ASSERT(group->sorted_entries == NULL);
+  u64 size_needed = (u64)size + 2 * sizeof(u64);
+  if (group->push_buffer_used + size_needed > (u64)group->sort_entries_offset - (u64)group->entry_count * sizeof(u64)) {
+    ++group->dropped_entry_count;
+    return NULL;
+  }
+
+  HHRenderEntryHeader* header = (HHRenderEntryHeader *)(group->push_buffer_base + group->push_buffer_used);
+  header->type = type;
+  header->bounds = bounds;
+  group->sort_entries_offset -= sizeof(u64);
+  u64* sort_entry = (u64 *)(group->push_buffer_base + group->sort_entries_offset);
+  *sort_entry = (u64)sort_key << 32 | group->push_buffer_used;
+
+  group->push_buffer_used += size;
+  ++group->entry_count;
+  return header;
+}
+
+INTERNAL void
+hh_push_clear(HHRenderGroup* group, u32 sort_key, u32 color)
+{
+  HHClipRect bounds = {INT_MIN, INT_MIN, INT_MAX, INT_MAX};
+  HHRenderEntryClear* entry = (HHRenderEntryClear *)hh_push_render_entry(group, sort_key, HH_RENDER_ENTRY_CLEAR,
+                                                                         sizeof(HHRenderEntryClear), bounds);
+  if (entry != NULL) {
+    entry->color = color;
+  }
+}
+
+// NOTE(Ryan): 'color' is premultiplied 0xAARRGGBB
+INTERNAL void
+hh_push_rectangle(HHRenderGroup* group, u32 sort_key, float min_x, float min_y, float max_x, float max_y, u32 color)
+{
+  HHClipRect bounds = hh_get_render_entry_bounds(min_x, min_y, max_x, max_y);
+  HHRenderEntryRectangle* entry = (HHRenderEntryRectangle *)hh_push_render_entry(group, sort_key, HH_RENDER_ENTRY_RECTANGLE,
+                                                                                 sizeof(HHRenderEntryRectangle), bounds);
+  if (entry != NULL) {
+    entry->color = color;
+    entry->min_x = min_x;
+    entry->min_y = min_y;
+    entry->max_x = max_x;
+    entry->max_y = max_y;
+  }
+}
+
+// NOTE(Ryan): The HHBitmap is copied, its pixels are not. Blends in sRGB
+INTERNAL void
+hh_push_bitmap(HHRenderGroup* group, u32 sort_key, HHBitmap const* bitmap, float x, float y, float alpha)
+{
+  HHClipRect bounds = hh_get_render_entry_bounds(x, y, x + (float)bitmap->width, y + (float)bitmap->height);
+  HHRenderEntryBitmap* entry = (HHRenderEntryBitmap *)hh_push_render_entry(group, sort_key, HH_RENDER_ENTRY_BITMAP,
+                                                                           sizeof(HHRenderEntryBitmap), bounds);
+  if (entry != NULL) {
+    entry->x = x;
+    entry->y = y;
+    entry->alpha = alpha;
+    entry->bitmap = *bitmap;
+  }
+}
+
+// NOTE(Ryan): See hh_draw_quad(). The HHBitmap is copied, its pixels are not. Blends in linear light
+INTERNAL void
+hh_push_quad(HHRenderGroup* group, u32 sort_key, HHBitmap const* bitmap, float origin_x, float origin_y,
+             float x_axis_x, float x_axis_y, float y_axis_x, float y_axis_y, float alpha)
+{
+  float corners_x[3] = {origin_x + x_axis_x, origin_x + y_axis_x, origin_x + x_axis_x + y_axis_x};
+  float corners_y[3] = {origin_y + x_axis_y, origin_y + y_axis_y, origin_y + x_axis_y + y_axis_y};
+  float min_x = origin_x, max_x = origin_x, min_y = origin_y, max_y = origin_y;
+  for (uint corner_i = 0; corner_i < 3; ++corner_i) {
+    min_x = fminf(min_x, corners_x[corner_i]);
+    max_x = fmaxf(max_x, corners_x[corner_i]);
+    min_y = fminf(min_y, corners_y[corner_i]);
+    max_y = fmaxf(max_y, corners_y[corner_i]);
+  }
+  HHClipRect bounds = hh_get_render_entry_bounds(min_x, min_y, max_x, max_y);
+  HHRenderEntryQuad* entry = (HHRenderEntryQuad *)hh_push_render_entry(group, sort_key, HH_RENDER_ENTRY_QUAD,
+                                                                       sizeof(HHRenderEntryQuad), bounds);
+  if (entry != NULL) {
+    entry->origin_x = origin_x;
+    entry->origin_y = origin_y;
+    entry->x_axis_x = x_axis_x;
+    entry->x_axis_y = x_axis_y;
+    entry->y_axis_x = y_axis_x;
+    entry->y_axis_y = y_axis_y;
+    entry->alpha = alpha;
+    entry->bitmap = *bitmap;
+  }
+}
+
+// NOTE(Ryan): Stable LSD radix sort on the key half only, one byte per pass. A frame tends to use a handful of
+// layers, so passes where every key has the same byte are skipped, and a single layer costs one histogram pass.
+INTERNAL void
+hh_sort_render_group(HHRenderGroup* group)
+{
+  TIMED_FUNCTION();
+  if (group->sorted_entries != NULL) {
+    return;
+  }
+  u64* entries = (u64 *)(group->push_buffer_base + group->sort_entries_offset);
+  // NOTE(Ryan): Pushing held this much back, just past the commands
+  u64* scratch = (u64 *)(group->push_buffer_base + group->push_buffer_used);
+  u32 entry_count = group->entry_count;
+
+  // NOTE(Ryan): Entries were laid down backwards from the end of the buffer, so reverse into push order first
+  for (u32 entry_i = 0; entry_i < entry_count / 2; ++entry_i) {
+    u64 swap = entries[entry_i];
+    entries[entry_i] = entries[entry_count - 1 - entry_i];
+    entries[entry_count - 1 - entry_i] = swap;
+  }
+
+  u32 counts[4][256] = {0};
+  for (u32 entry_i = 0; entry_i < entry_count; ++entry_i) {
+    u32 sort_key = (u32)(entries[entry_i] >> 32);
+    for (uint pass_i = 0; pass_i < 4; ++pass_i) {
+      ++counts[pass_i][(sort_key >> (pass_i * 8)) & 0xff];
+    }
+  }
+
+  u64* source = entries;
+  u64* dest = scratch;
+  for (uint pass_i = 0; pass_i < 4; ++pass_i) {
+    uint shift = 32 + pass_i * 8;
+    if (entry_count == 0 || counts[pass_i][(source[0] >> shift) & 0xff] == entry_count) {
+      continue;
+    }
+    u32 offsets[256] = {0};
+    u32 offset = 0;
+    for (uint bucket_i = 0; bucket_i < 256; ++bucket_i) {
+      offsets[bucket_i] = offset;
+      offset += counts[pass_i][bucket_i];
+    }
+    for (u32 entry_i = 0; entry_i < entry_count; ++entry_i) {
+      dest[offsets[(source[entry_i] >> shift) & 0xff]++] = source[entry_i];
+    }
+    u64* swap = source;
+    source = dest;
+    dest = swap;
+  }
+
+  group->sorted_entries = source;
+}
+
+typedef struct {
+  HHRenderGroup* group;
+  HHPixelBuffer* pixel_buffer;
+  HHClipRect clip_rect;
+} HHRenderGroupTile;
+
+INTERNAL void
+hh_render_group_tile(void* data)
+{
+  TIMED_FUNCTION();
+  HHRenderGroupTile* tile = (HHRenderGroupTile *)data;
+  HHRenderGroup* group = tile->group;
+  HHClipRect clip_rect = tile->clip_rect;
+
+  for (u32 entry_i = 0; entry_i < group->entry_count; ++entry_i) {
+    HHRenderEntryHeader* header = (HHRenderEntryHeader *)(group->push_buffer_base + (u32)group->sorted_entries[entry_i]);
+    HHClipRect bounds = header->bounds;
+    if (bounds.min_x >= clip_rect.max_x || bounds.max_x <= clip_rect.min_x ||
+        bounds.min_y >= clip_rect.max_y || bounds.max_y <= clip_rect.min_y) {
+      continue;
+    }
+    switch (header->type) {
+      case HH_RENDER_ENTRY_CLEAR: {
+        HHRenderEntryClear* entry = (HHRenderEntryClear *)header;
+        hh_clear_clipped(tile->pixel_buffer, clip_rect, entry->color);
+      } break;
+      case HH_RENDER_ENTRY_RECTANGLE: {
+        HHRenderEntryRectangle* entry = (HHRenderEntryRectangle *)header;
+        hh_draw_rectangle_clipped(tile->pixel_buffer, clip_rect, entry->min_x, entry->min_y, entry->max_x,
+                                  entry->max_y, entry->color);
+      } break;
+      case HH_RENDER_ENTRY_BITMAP: {
+        HHRenderEntryBitmap* entry = (HHRenderEntryBitmap *)header;
+        hh_draw_bitmap_clipped(tile->pixel_buffer, clip_rect, &entry->bitmap, entry->x, entry->y, entry->alpha);
+      } break;
+      case HH_RENDER_ENTRY_QUAD: {
+        HHRenderEntryQuad* entry = (HHRenderEntryQuad *)header;
+        hh_draw_quad_clipped(tile->pixel_buffer, clip_rect, &entry->bitmap, entry->origin_x, entry->origin_y,
+                             entry->x_axis_x, entry->x_axis_y, entry->y_axis_x, entry->y_axis_y, entry->alpha);
+      } break;
+      default: {
+        HH_ASSERT(false);
+      } break;
+    }
+  }
+}
+
+// NOTE(Ryan): Output is identical with or without a job queue, and for any tile size
+INTERNAL void
+hh_render_group_to_output(HHMemory* memory, HHRenderGroup* group, HHPixelBuffer* pixel_buffer)
+{
+  TIMED_FUNCTION();
+  hh_sort_render_group(group);
+
+  if (memory->job_queue == NULL) {
+    HHRenderGroupTile tile = {group, pixel_buffer, hh_get_buffer_clip_rect(pixel_buffer)};
+    hh_render_group_tile(&tile);
+    return;
+  }
+
+  HHRenderTiles render_tiles = hh_get_render_tiles(memory, pixel_buffer);
+  HHRenderGroupTile tiles[HH_MAX_RENDER_TILES];
+  HHJobCounter counter = {0};
+  uint tile_i = 0;
+  for (uint tile_y = 0; tile_y < render_tiles.tile_count_y; ++tile_y) {
+    for (uint tile_x = 0; tile_x < render_tiles.tile_count_x; ++tile_x) {
+      HHRenderGroupTile* tile = &tiles[tile_i++];
+      tile->group = group;
+      tile->pixel_buffer = pixel_buffer;
+      tile->clip_rect = hh_get_render_tile_rect(&render_tiles, pixel_buffer, tile_x, tile_y);
+
+      memory->platform_add_job(memory->job_queue, hh_render_group_tile, tile, &counter);
+    }
+  }
+
+  memory->platform_wait_for_jobs(memory->job_queue, &counter);
+}
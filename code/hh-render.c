@@ -0,0 +1,906 @@
+// NOTE(Ryan): Software sprite drawing into an HHPixelBuffer.
+// Bitmaps are premultiplied alpha (the packer premultiplies), so blending is dest = source + dest * (1 - source_alpha)
+// on all four channels alike. Placement is sub-pixel: each destination pixel takes a bilinear mix of the 2x2 texels
+// around its sample point with weights that are the same for the whole blit, and a global alpha scales those weights
+// for free. Texels outside the bitmap count as transparent, so a blit at a fractional position is one pixel wider
+// and taller and its edges fade out rather than snap.
+//
+// Everything is 8 bit fixed point so the SIMD kernels are bit-identical to the scalar one:
+//   filtered = (sum(texel * weight) + 128) >> 8          weights sum to alpha * 256
+//   blended  = filtered + div255(dest * (255 - filtered_alpha))
+
+#include <math.h>
+
+typedef struct {
+  // NOTE(Ryan): For the texel up-left of the sample point, and so on. Sum is at most 256.
+  u16 top_left;
+  u16 top_right;
+  u16 bottom_left;
+  u16 bottom_right;
+} HHBlitWeights;
+
+// NOTE(Ryan): Blends 'count' pixels, where dest[i] samples top_row[i], top_row[i + 1], bottom_row[i], bottom_row[i + 1].
+// The two rows may be the same row. All kernels must produce identical output to the scalar one.
+typedef void (HHBlitRow)(u32* restrict dest, u32 const* top_row, u32 const* bottom_row, uint count, HHBlitWeights weights);
+
+// NOTE(Ryan): Premultiplied 'source' over 'dest'
+INTERNAL u32
+hh_blend_pixel(u32 dest, u32 source)
+{
+  u32 inverse_alpha = 255 - (source >> 24);
+  u32 result = 0;
+  for (uint channel_i = 0; channel_i < 4; ++channel_i) {
+    uint shift = channel_i * 8;
+    // NOTE(Ryan): Exact x / 255 rounded, for x in [0, 255 * 255]
+    u32 scaled = ((dest >> shift) & 0xff) * inverse_alpha + 128;
+    scaled = (scaled + (scaled >> 8)) >> 8;
+    // NOTE(Ryan): Only a colour above its alpha, i.e. not premultiplied, can overflow; saturate like the SIMD pack does
+    u32 blended = ((source >> shift) & 0xff) + scaled;
+    result |= ((blended < 255) ? blended : 255) << shift;
+  }
+  return result;
+}
+
+INTERNAL u32
+hh_blit_pixel(u32 dest, u32 top_left, u32 top_right, u32 bottom_left, u32 bottom_right, HHBlitWeights weights)
+{
+  u32 filtered = 0;
+  for (uint channel_i = 0; channel_i < 4; ++channel_i) {
+    uint shift = channel_i * 8;
+    u32 sum = ((top_left >> shift) & 0xff) * weights.top_left + ((top_right >> shift) & 0xff) * weights.top_right +
+              ((bottom_left >> shift) & 0xff) * weights.bottom_left + ((bottom_right >> shift) & 0xff) * weights.bottom_right;
+    filtered |= ((sum + 128) >> 8) << shift;
+  }
+  return hh_blend_pixel(dest, filtered);
+}
+
+INTERNAL void
+hh_blit_row_scalar(u32* restrict dest, u32 const* top_row, u32 const* bottom_row, uint count, HHBlitWeights weights)
+{
+  for (uint i = 0; i < count; ++i) {
+    dest[i] = hh_blit_pixel(dest[i], top_row[i], top_row[i + 1], bottom_row[i], bottom_row[i + 1], weights);
+  }
+}
+
+#if defined(HH_X86)
+// NOTE(Ryan): Two pixels per register as 16 bit channels, so a product and the rounding bias always fit
+__attribute__((target("sse2"))) INTERNAL __m128i
+hh_blit_filter_sse2(__m128i top_left, __m128i top_right, __m128i bottom_left, __m128i bottom_right, __m128i const weights[4])
+{
+  __m128i sum = _mm_mullo_epi16(top_left, weights[0]);
+  sum = _mm_add_epi16(sum, _mm_mullo_epi16(top_right, weights[1]));
+  sum = _mm_add_epi16(sum, _mm_mullo_epi16(bottom_left, weights[2]));
+  sum = _mm_add_epi16(sum, _mm_mullo_epi16(bottom_right, weights[3]));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+__attribute__((target("sse2"))) INTERNAL __m128i
+hh_blit_blend_sse2(__m128i dest, __m128i filtered)
+{
+  __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(filtered, 0xff), 0xff);
+  __m128i scaled = _mm_add_epi16(_mm_mullo_epi16(dest, _mm_sub_epi16(_mm_set1_epi16(255), alpha)), _mm_set1_epi16(128));
+  scaled = _mm_srli_epi16(_mm_add_epi16(scaled, _mm_srli_epi16(scaled, 8)), 8);
+  return _mm_add_epi16(filtered, scaled);
+}
+
+__attribute__((target("sse2"))) INTERNAL void
+hh_blit_pixels_sse2(u32* restrict dest, u32 const* top_row, u32 const* bottom_row, __m128i const weights[4])
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i top_left = _mm_loadu_si128((__m128i const *)top_row);
+  __m128i top_right = _mm_loadu_si128((__m128i const *)(top_row + 1));
+  __m128i bottom_left = _mm_loadu_si128((__m128i const *)bottom_row);
+  __m128i bottom_right = _mm_loadu_si128((__m128i const *)(bottom_row + 1));
+  __m128i dest_pixels = _mm_loadu_si128((__m128i const *)dest);
+
+  __m128i filtered_lo = hh_blit_filter_sse2(_mm_unpacklo_epi8(top_left, zero), _mm_unpacklo_epi8(top_right, zero),
+                                            _mm_unpacklo_epi8(bottom_left, zero), _mm_unpacklo_epi8(bottom_right, zero),
+                                            weights);
+  __m128i filtered_hi = hh_blit_filter_sse2(_mm_unpackhi_epi8(top_left, zero), _mm_unpackhi_epi8(top_right, zero),
+                                            _mm_unpackhi_epi8(bottom_left, zero), _mm_unpackhi_epi8(bottom_right, zero),
+                                            weights);
+  __m128i blended_lo = hh_blit_blend_sse2(_mm_unpacklo_epi8(dest_pixels, zero), filtered_lo);
+  __m128i blended_hi = hh_blit_blend_sse2(_mm_unpackhi_epi8(dest_pixels, zero), filtered_hi);
+  _mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(blended_lo, blended_hi));
+}
+
+__attribute__((target("sse2"))) INTERNAL void
+hh_blit_row_sse2(u32* restrict dest, u32 const* top_row, u32 const* bottom_row, uint count, HHBlitWeights weights)
+{
+  __m128i const weight_vectors[4] = {
+    _mm_set1_epi16(weights.top_left), _mm_set1_epi16(weights.top_right),
+    _mm_set1_epi16(weights.bottom_left), _mm_set1_epi16(weights.bottom_right)
+  };
+
+  uint i = 0;
+  for (; i + 4 <= count; i += 4) {
+    hh_blit_pixels_sse2(dest + i, top_row + i, bottom_row + i, weight_vectors);
+  }
+
+  // NOTE(Ryan): Sprite rows are short, so the tail goes through one padded vector rather than the scalar kernel
+  uint tail_count = count - i;
+  if (tail_count > 0) {
+    u32 top_tail[5] = {0};
+    u32 bottom_tail[5] = {0};
+    u32 dest_tail[4] = {0};
+    memcpy(top_tail, top_row + i, (tail_count + 1) * sizeof(u32));
+    memcpy(bottom_tail, bottom_row + i, (tail_count + 1) * sizeof(u32));
+    memcpy(dest_tail, dest + i, tail_count * sizeof(u32));
+    hh_blit_pixels_sse2(dest_tail, top_tail, bottom_tail, weight_vectors);
+    memcpy(dest + i, dest_tail, tail_count * sizeof(u32));
+  }
+}
+
+__attribute__((target("avx2"))) INTERNAL __m256i
+hh_blit_filter_avx2(__m256i top_left, __m256i top_right, __m256i bottom_left, __m256i bottom_right, __m256i const weights[4])
+{
+  __m256i sum = _mm256_mullo_epi16(top_left, weights[0]);
+  sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(top_right, weights[1]));
+  sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(bottom_left, weights[2]));
+  sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(bottom_right, weights[3]));
+  return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(128)), 8);
+}
+
+__attribute__((target("avx2"))) INTERNAL __m256i
+hh_blit_blend_avx2(__m256i dest, __m256i filtered)
+{
+  __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(filtered, 0xff), 0xff);
+  __m256i scaled = _mm256_add_epi16(_mm256_mullo_epi16(dest, _mm256_sub_epi16(_mm256_set1_epi16(255), alpha)),
+                                    _mm256_set1_epi16(128));
+  scaled = _mm256_srli_epi16(_mm256_add_epi16(scaled, _mm256_srli_epi16(scaled, 8)), 8);
+  return _mm256_add_epi16(filtered, scaled);
+}
+
+// NOTE(Ryan): Unpack and pack both work within 128-bit lanes, so pixel order survives without a permute
+__attribute__((target("avx2"))) INTERNAL void
+hh_blit_row_avx2(u32* restrict dest, u32 const* top_row, u32 const* bottom_row, uint count, HHBlitWeights weights)
+{
+  __m256i const weight_vectors[4] = {
+    _mm256_set1_epi16(weights.top_left), _mm256_set1_epi16(weights.top_right),
+    _mm256_set1_epi16(weights.bottom_left), _mm256_set1_epi16(weights.bottom_right)
+  };
+  __m256i zero = _mm256_setzero_si256();
+
+  uint i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i top_left = _mm256_loadu_si256((__m256i const *)(top_row + i));
+    __m256i top_right = _mm256_loadu_si256((__m256i const *)(top_row + i + 1));
+    __m256i bottom_left = _mm256_loadu_si256((__m256i const *)(bottom_row + i));
+    __m256i bottom_right = _mm256_loadu_si256((__m256i const *)(bottom_row + i + 1));
+    __m256i dest_pixels = _mm256_loadu_si256((__m256i const *)(dest + i));
+
+    __m256i filtered_lo = hh_blit_filter_avx2(_mm256_unpacklo_epi8(top_left, zero), _mm256_unpacklo_epi8(top_right, zero),
+                                              _mm256_unpacklo_epi8(bottom_left, zero), _mm256_unpacklo_epi8(bottom_right, zero),
+                                              weight_vectors);
+    __m256i filtered_hi = hh_blit_filter_avx2(_mm256_unpackhi_epi8(top_left, zero), _mm256_unpackhi_epi8(top_right, zero),
+                                              _mm256_unpackhi_epi8(bottom_left, zero), _mm256_unpackhi_epi8(bottom_right, zero),
+                                              weight_vectors);
+    __m256i blended_lo = hh_blit_blend_avx2(_mm256_unpacklo_epi8(dest_pixels, zero), filtered_lo);
+    __m256i blended_hi = hh_blit_blend_avx2(_mm256_unpackhi_epi8(dest_pixels, zero), filtered_hi);
+    _mm256_storeu_si256((__m256i *)(dest + i), _mm256_packus_epi16(blended_lo, blended_hi));
+  }
+
+  hh_blit_row_sse2(dest + i, top_row + i, bottom_row + i, count - i, weights);
+}
+#endif
+
+GLOBAL HHBlitRow* hh_blit_row = hh_blit_row_scalar;
+
+INTERNAL void
+hh_select_blit_kernels(u32 cpu_features)
+{
+  hh_blit_row = hh_blit_row_scalar;
+#if defined(HH_X86)
+  if (cpu_features & HH_CPU_FEATURE_SSE2) {
+    hh_blit_row = hh_blit_row_sse2;
+  }
+  if (cpu_features & HH_CPU_FEATURE_AVX2) {
+    hh_blit_row = hh_blit_row_avx2;
+  }
+#else
+  (void)cpu_features;
+#endif
+}
+
+// NOTE(Ryan): Bounds checked, for the one pixel wide fringe around a blit
+INTERNAL u32
+hh_get_texel(HHBitmap const* bitmap, int x, int y)
+{
+  if (x < 0 || y < 0 || x >= (int)bitmap->width || y >= (int)bitmap->height) {
+    return 0;
+  }
+  return *(u32 const *)((u8 const *)bitmap->pixels + y * bitmap->pitch + x * BYTES_PER_PIXEL);
+}
+
+// NOTE(Ryan): A half-open pixel rectangle that drawing is confined to, e.g. one screen tile
+typedef struct {
+  int min_x;
+  int min_y;
+  int max_x;
+  int max_y;
+} HHClipRect;
+
+INTERNAL HHClipRect
+hh_get_buffer_clip_rect(HHPixelBuffer* pixel_buffer)
+{
+  HHClipRect result = {0, 0, (int)pixel_buffer->width, (int)pixel_buffer->height};
+  return result;
+}
+
+// NOTE(Ryan): (x, y) is where the bitmap's top left corner lands, in pixels. alpha in [0, 1] fades the whole bitmap.
+// Output within the clip rect is identical however the buffer is split into clip rects. Blends in sRGB, unlike quads.
+INTERNAL void
+hh_draw_bitmap_clipped(HHPixelBuffer* pixel_buffer, HHClipRect clip_rect, HHBitmap const* bitmap, float x, float y, float alpha)
+{
+  if (!(alpha > 0.0f) || bitmap->width == 0 || bitmap->height == 0) {
+    return;
+  }
+  alpha = (alpha < 1.0f) ? alpha : 1.0f;
+  // NOTE(Ryan): Cheap reject, which also keeps the float to int conversions below defined far off screen
+  if (!(x > (float)clip_rect.min_x - (float)bitmap->width - 1.0f && x < (float)clip_rect.max_x + 1.0f &&
+        y > (float)clip_rect.min_y - (float)bitmap->height - 1.0f && y < (float)clip_rect.max_y + 1.0f)) {
+    return;
+  }
+
+  float floor_x = floorf(x);
+  float floor_y = floorf(y);
+  int origin_x = (int)floor_x;
+  int origin_y = (int)floor_y;
+  u32 fraction_x = (u32)lrintf((x - floor_x) * 256.0f);
+  u32 fraction_y = (u32)lrintf((y - floor_y) * 256.0f);
+  if (fraction_x == 256) {
+    fraction_x = 0;
+    ++origin_x;
+  }
+  if (fraction_y == 256) {
+    fraction_y = 0;
+    ++origin_y;
+  }
+
+  // NOTE(Ryan): The sample point sits 'fraction' of a texel right of / below the up-left texel, so that texel's
+  // weight is the fraction itself. Splitting rows then columns by subtraction keeps the four summing to exactly
+  // alpha_scale, so an opaque texel stays opaque.
+  u32 alpha_scale = (u32)lrintf(alpha * 256.0f);
+  u32 top_weight = (fraction_y * alpha_scale + 128) >> 8;
+  u32 bottom_weight = alpha_scale - top_weight;
+  HHBlitWeights weights = {0};
+  weights.top_left = (u16)((fraction_x * top_weight + 128) >> 8);
+  weights.top_right = (u16)(top_weight - weights.top_left);
+  weights.bottom_left = (u16)((fraction_x * bottom_weight + 128) >> 8);
+  weights.bottom_right = (u16)(bottom_weight - weights.bottom_left);
+
+  int min_x = origin_x;
+  int min_y = origin_y;
+  int max_x = origin_x + (int)bitmap->width + (fraction_x != 0);
+  int max_y = origin_y + (int)bitmap->height + (fraction_y != 0);
+  int clip_min_x = (min_x > clip_rect.min_x) ? min_x : clip_rect.min_x;
+  int clip_min_y = (min_y > clip_rect.min_y) ? min_y : clip_rect.min_y;
+  int clip_max_x = (max_x < clip_rect.max_x) ? max_x : clip_rect.max_x;
+  int clip_max_y = (max_y < clip_rect.max_y) ? max_y : clip_rect.max_y;
+  if (clip_min_x >= clip_max_x || clip_min_y >= clip_max_y) {
+    return;
+  }
+
+  // NOTE(Ryan): Columns whose two texels both lie inside the bitmap go to the row kernel
+  int inner_min_x = (origin_x + 1 > clip_min_x) ? origin_x + 1 : clip_min_x;
+  int inner_max_x = (origin_x + (int)bitmap->width < clip_max_x) ? origin_x + (int)bitmap->width : clip_max_x;
+
+  u8* dest_row = (u8 *)pixel_buffer->memory + clip_min_y * pixel_buffer->pitch;
+  for (int dest_y = clip_min_y; dest_y < clip_max_y; ++dest_y) {
+    u32* dest = (u32 *)dest_row;
+    int texel_y = dest_y - origin_y;
+
+    // NOTE(Ryan): On the top and bottom fringe the missing row gets zero weight and borrows the other row's pointer
+    HHBlitWeights row_weights = weights;
+    int top_y = texel_y - 1;
+    int bottom_y = texel_y;
+    if (top_y < 0) {
+      row_weights.top_left = row_weights.top_right = 0;
+      top_y = bottom_y;
+    }
+    if (bottom_y >= (int)bitmap->height) {
+      row_weights.bottom_left = row_weights.bottom_right = 0;
+      bottom_y = top_y;
+    }
+    u32 const* top_row = (u32 const *)((u8 const *)bitmap->pixels + top_y * bitmap->pitch);
+    u32 const* bottom_row = (u32 const *)((u8 const *)bitmap->pixels + bottom_y * bitmap->pitch);
+
+    if (inner_min_x < inner_max_x) {
+      int texel_x = inner_min_x - origin_x - 1;
+      hh_blit_row(dest + inner_min_x, top_row + texel_x, bottom_row + texel_x, inner_max_x - inner_min_x, row_weights);
+    }
+
+    // NOTE(Ryan): At most one fringe column either side
+    for (int dest_x = clip_min_x; dest_x < clip_max_x; ++dest_x) {
+      if (dest_x == inner_min_x && inner_min_x < inner_max_x) {
+        dest_x = inner_max_x - 1;
+        continue;
+      }
+      int texel_x = dest_x - origin_x;
+      dest[dest_x] = hh_blit_pixel(dest[dest_x],
+                                   hh_get_texel(bitmap, texel_x - 1, texel_y - 1), hh_get_texel(bitmap, texel_x, texel_y - 1),
+                                   hh_get_texel(bitmap, texel_x - 1, texel_y), hh_get_texel(bitmap, texel_x, texel_y),
+                                   weights);
+    }
+
+    dest_row += pixel_buffer->pitch;
+  }
+}
+
+INTERNAL void
+hh_draw_bitmap(HHPixelBuffer* pixel_buffer, HHBitmap const* bitmap, float x, float y, float alpha)
+{
+  TIMED_FUNCTION();
+  hh_draw_bitmap_clipped(pixel_buffer, hh_get_buffer_clip_rect(pixel_buffer), bitmap, x, y, alpha);
+}
+
+// NOTE(Ryan): Replaces rather than blends, so 'color' is stored as is
+INTERNAL void
+hh_clear_clipped(HHPixelBuffer* pixel_buffer, HHClipRect clip_rect, u32 color)
+{
+  u8* row = (u8 *)pixel_buffer->memory + clip_rect.min_y * pixel_buffer->pitch;
+  for (int y = clip_rect.min_y; y < clip_rect.max_y; ++y) {
+    u32* pixel = (u32 *)row;
+    for (int x = clip_rect.min_x; x < clip_rect.max_x; ++x) {
+      pixel[x] = color;
+    }
+    row += pixel_buffer->pitch;
+  }
+}
+
+// NOTE(Ryan): Covers the pixels whose centres lie in [min, max). 'color' is premultiplied 0xAARRGGBB; an opaque
+// colour is a plain fill.
+INTERNAL void
+hh_draw_rectangle_clipped(HHPixelBuffer* pixel_buffer, HHClipRect clip_rect, float min_x, float min_y, float max_x,
+                          float max_y, u32 color)
+{
+  // NOTE(Ryan): Clamped as floats first so the conversions stay defined for any input
+  float clamped_min_x = fmaxf(min_x - 0.5f, (float)clip_rect.min_x);
+  float clamped_min_y = fmaxf(min_y - 0.5f, (float)clip_rect.min_y);
+  float clamped_max_x = fminf(max_x - 0.5f, (float)clip_rect.max_x);
+  float clamped_max_y = fminf(max_y - 0.5f, (float)clip_rect.max_y);
+  if (!(clamped_min_x < clamped_max_x && clamped_min_y < clamped_max_y) || (color >> 24) == 0) {
+    return;
+  }
+  int start_x = (int)ceilf(clamped_min_x);
+  int start_y = (int)ceilf(clamped_min_y);
+  int end_x = (int)ceilf(clamped_max_x);
+  int end_y = (int)ceilf(clamped_max_y);
+
+  u8* row = (u8 *)pixel_buffer->memory + start_y * pixel_buffer->pitch;
+  for (int y = start_y; y < end_y; ++y) {
+    u32* pixel = (u32 *)row;
+    if ((color >> 24) == 255) {
+      for (int x = start_x; x < end_x; ++x) {
+        pixel[x] = color;
+      }
+    } else {
+      for (int x = start_x; x < end_x; ++x) {
+        pixel[x] = hh_blend_pixel(pixel[x], color);
+      }
+    }
+    row += pixel_buffer->pitch;
+  }
+}
+
+INTERNAL void
+hh_draw_rectangle(HHPixelBuffer* pixel_buffer, float min_x, float min_y, float max_x, float max_y, u32 color)
+{
+  TIMED_FUNCTION();
+  hh_draw_rectangle_clipped(pixel_buffer, hh_get_buffer_clip_rect(pixel_buffer), min_x, min_y, max_x, max_y, color);
+}
+
+// NOTE(Ryan): Textured quads. The bitmap is mapped onto the parallelogram origin + u * x_axis + v * y_axis,
+// u and v in [0, 1), so it can be rotated, scaled and sheared. Each row is solved for the span of pixels the
+// quad can touch, then walked in 16.16 fixed point texel coordinates. The edge test is a range check on those
+// coordinates, and their 8 fractional bits are the bilinear weights, filtered in 16 bit products.
+// Coordinates at a pixel don't depend on the clip rect, so tiled and untiled output match exactly.
+//
+// Blending is sRGB correct: it happens in linear light, using the gamma 2 approximation (linear = srgb^2).
+// A premultiplied sRGB texel t with alpha a is c * a, so its linear premultiplied value is t^2 / a, and the
+// blended result goes back through a square root. That colour math is float, so the SIMD kernels agree with
+// the scalar one to within one step per channel rather than bit for bit.
+// IMPORTANT(Ryan): hh_draw_bitmap() and hh_draw_rectangle() blend the same premultiplied pixels directly in sRGB,
+// so a quad and a bitmap with identical texels and alpha differ wherever they are translucent. Opaque texels match.
+//
+// Measured with quad/* in hh-bench, reported in cycles/unit. The runs used 96x96 quads of a 64x64 texture, with
+// one unit per covered pixel, and cover the axis aligned and rotated cases:
+//   Xeon with AVX2 (cpuid "Intel(R) Xeon(R) Processor"), gcc -Ofast: AVX2 17-23, SSE2 33-40, scalar 62-82
+//   same machine, gcc -O2:                                            AVX2 22-26, SSE2 44-49
+//   a second AVX2 machine, as reported in review:                     AVX2 21-24, SSE2 47-49
+// Rotated quads cost one to three cycles more than axis aligned ones. The per-lane texel fetches are most of the
+// SSE2 cost; AVX2 gathers them. Re-measure before relying on these for a different machine or compiler.
+
+// NOTE(Ryan): Keeps every 16.16 coordinate a span can reach inside int32
+#define HH_QUAD_MAX_BITMAP_SIZE (1 << 14)
+#define HH_QUAD_MAX_STEP (1 << 26)
+
+typedef struct {
+  u32 const* pixels;
+  u32 pitch;
+  u32 width;
+  u32 height;
+  // NOTE(Ryan): 16.16 texel coordinates of the first pixel's centre, and the step to the next pixel
+  int32 texel_x;
+  int32 texel_y;
+  int32 step_x;
+  int32 step_y;
+  // NOTE(Ryan): Global alpha, 256 is opaque
+  u32 alpha_scale;
+} HHQuadSpan;
+
+typedef void (HHQuadRow)(u32* restrict dest, uint count, HHQuadSpan const* span);
+
+INTERNAL int32
+hh_clamp_int32(int32 value, int32 min, int32 max)
+{
+  return (value < min) ? min : (value > max) ? max : value;
+}
+
+INTERNAL void
+hh_draw_quad_row_scalar(u32* restrict dest, uint count, HHQuadSpan const* span)
+{
+  int32 texel_x = span->texel_x;
+  int32 texel_y = span->texel_y;
+  for (uint i = 0; i < count; ++i, texel_x += span->step_x, texel_y += span->step_y) {
+    if (texel_x < 0 || texel_y < 0 || texel_x >= (int32)(span->width << 16) || texel_y >= (int32)(span->height << 16)) {
+      continue;
+    }
+
+    // NOTE(Ryan): Texel centres sit at +0.5, and the filter clamps to the edge texels
+    int32 sample_x = texel_x - 0x8000;
+    int32 sample_y = texel_y - 0x8000;
+    u32 fraction_x = (u32)(sample_x >> 8) & 0xff;
+    u32 fraction_y = (u32)(sample_y >> 8) & 0xff;
+    int32 x0 = hh_clamp_int32(sample_x >> 16, 0, span->width - 1);
+    int32 x1 = hh_clamp_int32((sample_x >> 16) + 1, 0, span->width - 1);
+    int32 y0 = hh_clamp_int32(sample_y >> 16, 0, span->height - 1);
+    int32 y1 = hh_clamp_int32((sample_y >> 16) + 1, 0, span->height - 1);
+    u32 const* row0 = (u32 const *)((u8 const *)span->pixels + y0 * span->pitch);
+    u32 const* row1 = (u32 const *)((u8 const *)span->pixels + y1 * span->pitch);
+    u32 texels[4] = {row0[x0], row0[x1], row1[x0], row1[x1]};
+
+    u32 filtered[4] = {0};
+    for (uint channel_i = 0; channel_i < 4; ++channel_i) {
+      uint shift = channel_i * 8;
+      u32 top = (((texels[0] >> shift) & 0xff) * (256 - fraction_x) + ((texels[1] >> shift) & 0xff) * fraction_x + 128) >> 8;
+      u32 bottom = (((texels[2] >> shift) & 0xff) * (256 - fraction_x) + ((texels[3] >> shift) & 0xff) * fraction_x + 128) >> 8;
+      u32 value = (top * (256 - fraction_y) + bottom * fraction_y + 128) >> 8;
+      filtered[channel_i] = (value * span->alpha_scale + 128) >> 8;
+    }
+
+    float alpha = (float)filtered[3];
+    float inverse_alpha = (filtered[3] > 0) ? 255.0f / alpha : 0.0f;
+    float dest_weight = (float)(255 - filtered[3]) * (1.0f / 255.0f);
+    u32 result = 0;
+    for (uint channel_i = 0; channel_i < 3; ++channel_i) {
+      uint shift = channel_i * 8;
+      float source = (float)filtered[channel_i];
+      float dest_value = (float)((dest[i] >> shift) & 0xff);
+      float linear = source * source * inverse_alpha + dest_value * dest_value * dest_weight;
+      u32 value = (u32)lrintf(sqrtf(linear));
+      result |= ((value < 255) ? value : 255) << shift;
+    }
+    u32 result_alpha = (u32)lrintf(alpha + (float)(dest[i] >> 24) * dest_weight);
+    dest[i] = result | ((result_alpha < 255) ? result_alpha : 255) << 24;
+  }
+}
+
+#if defined(HH_X86)
+// NOTE(Ryan): 32 bit lanes holding values up to 256, so the 16 bit multiply is exact
+__attribute__((target("sse2"))) INTERNAL __m128i
+hh_quad_lerp_sse2(__m128i a, __m128i b, __m128i fraction)
+{
+  __m128i inverse_fraction = _mm_sub_epi32(_mm_set1_epi32(256), fraction);
+  __m128i sum = _mm_add_epi32(_mm_mullo_epi16(a, inverse_fraction), _mm_mullo_epi16(b, fraction));
+  return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+}
+
+__attribute__((target("sse2"))) INTERNAL __m128i
+hh_quad_clamp_sse2(__m128i value, __m128i max)
+{
+  value = _mm_andnot_si128(_mm_cmplt_epi32(value, _mm_setzero_si128()), value);
+  __m128i is_over = _mm_cmpgt_epi32(value, max);
+  return _mm_or_si128(_mm_and_si128(is_over, max), _mm_andnot_si128(is_over, value));
+}
+
+__attribute__((target("sse2"))) INTERNAL __m128i
+hh_quad_channel_sse2(__m128i pixels, uint shift)
+{
+  return _mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xff));
+}
+
+// NOTE(Ryan): Four pixels at 'dest', each written only if its lane in 'lane_mask' is set and it is inside the quad
+__attribute__((target("sse2"))) INTERNAL void
+hh_draw_quad_pixels_sse2(u32* dest, __m128i texel_x, __m128i texel_y, __m128i lane_mask, HHQuadSpan const* span)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i is_outside = _mm_or_si128(_mm_cmplt_epi32(texel_x, zero), _mm_cmplt_epi32(texel_y, zero));
+  __m128i is_inside = _mm_and_si128(_mm_cmplt_epi32(texel_x, _mm_set1_epi32(span->width << 16)),
+                                    _mm_cmplt_epi32(texel_y, _mm_set1_epi32(span->height << 16)));
+  __m128i write_mask = _mm_and_si128(lane_mask, _mm_andnot_si128(is_outside, is_inside));
+  if (_mm_movemask_epi8(write_mask) == 0) {
+    return;
+  }
+
+  __m128i sample_x = _mm_sub_epi32(texel_x, _mm_set1_epi32(0x8000));
+  __m128i sample_y = _mm_sub_epi32(texel_y, _mm_set1_epi32(0x8000));
+  __m128i fraction_x = _mm_and_si128(_mm_srai_epi32(sample_x, 8), _mm_set1_epi32(0xff));
+  __m128i fraction_y = _mm_and_si128(_mm_srai_epi32(sample_y, 8), _mm_set1_epi32(0xff));
+  __m128i max_x = _mm_set1_epi32(span->width - 1);
+  __m128i max_y = _mm_set1_epi32(span->height - 1);
+  __m128i one = _mm_set1_epi32(1);
+  alignas(16) int32 x0[4];
+  alignas(16) int32 x1[4];
+  alignas(16) int32 y0[4];
+  alignas(16) int32 y1[4];
+  _mm_store_si128((__m128i *)x0, hh_quad_clamp_sse2(_mm_srai_epi32(sample_x, 16), max_x));
+  _mm_store_si128((__m128i *)x1, hh_quad_clamp_sse2(_mm_add_epi32(_mm_srai_epi32(sample_x, 16), one), max_x));
+  _mm_store_si128((__m128i *)y0, hh_quad_clamp_sse2(_mm_srai_epi32(sample_y, 16), max_y));
+  _mm_store_si128((__m128i *)y1, hh_quad_clamp_sse2(_mm_add_epi32(_mm_srai_epi32(sample_y, 16), one), max_y));
+
+  // NOTE(Ryan): No gather or 32 bit multiply in SSE2, so each lane's texels are fetched on their own
+  alignas(16) u32 texels[4][4];
+  for (uint lane_i = 0; lane_i < 4; ++lane_i) {
+    u32 const* row0 = (u32 const *)((u8 const *)span->pixels + y0[lane_i] * span->pitch);
+    u32 const* row1 = (u32 const *)((u8 const *)span->pixels + y1[lane_i] * span->pitch);
+    texels[0][lane_i] = row0[x0[lane_i]];
+    texels[1][lane_i] = row0[x1[lane_i]];
+    texels[2][lane_i] = row1[x0[lane_i]];
+    texels[3][lane_i] = row1[x1[lane_i]];
+  }
+  __m128i top_left = _mm_load_si128((__m128i const *)texels[0]);
+  __m128i top_right = _mm_load_si128((__m128i const *)texels[1]);
+  __m128i bottom_left = _mm_load_si128((__m128i const *)texels[2]);
+  __m128i bottom_right = _mm_load_si128((__m128i const *)texels[3]);
+  __m128i dest_pixels = _mm_loadu_si128((__m128i const *)dest);
+  __m128i alpha_scale = _mm_set1_epi32(span->alpha_scale);
+
+  __m128i filtered[4];
+  for (uint channel_i = 0; channel_i < 4; ++channel_i) {
+    uint shift = channel_i * 8;
+    __m128i top = hh_quad_lerp_sse2(hh_quad_channel_sse2(top_left, shift), hh_quad_channel_sse2(top_right, shift), fraction_x);
+    __m128i bottom = hh_quad_lerp_sse2(hh_quad_channel_sse2(bottom_left, shift), hh_quad_channel_sse2(bottom_right, shift),
+                                       fraction_x);
+    __m128i value = hh_quad_lerp_sse2(top, bottom, fraction_y);
+    filtered[channel_i] = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi16(value, alpha_scale), _mm_set1_epi32(128)), 8);
+  }
+
+  __m128 alpha = _mm_cvtepi32_ps(filtered[3]);
+  __m128 inverse_alpha = _mm_and_ps(_mm_cmpgt_ps(alpha, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(255.0f), alpha));
+  __m128 dest_weight = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_set1_epi32(255), filtered[3])), _mm_set1_ps(1.0f / 255.0f));
+  __m128i channel_max = _mm_set1_epi32(255);
+  __m128i result = zero;
+  for (uint channel_i = 0; channel_i < 3; ++channel_i) {
+    uint shift = channel_i * 8;
+    __m128 source = _mm_cvtepi32_ps(filtered[channel_i]);
+    __m128 dest_value = _mm_cvtepi32_ps(hh_quad_channel_sse2(dest_pixels, shift));
+    __m128 linear = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(source, source), inverse_alpha),
+                               _mm_mul_ps(_mm_mul_ps(dest_value, dest_value), dest_weight));
+    __m128i value = hh_quad_clamp_sse2(_mm_cvtps_epi32(_mm_sqrt_ps(linear)), channel_max);
+    result = _mm_or_si128(result, _mm_sll_epi32(value, _mm_cvtsi32_si128(shift)));
+  }
+  __m128 dest_alpha = _mm_cvtepi32_ps(_mm_srli_epi32(dest_pixels, 24));
+  __m128i result_alpha = hh_quad_clamp_sse2(_mm_cvtps_epi32(_mm_add_ps(alpha, _mm_mul_ps(dest_alpha, dest_weight))), channel_max);
+  result = _mm_or_si128(result, _mm_slli_epi32(result_alpha, 24));
+
+  result = _mm_or_si128(_mm_and_si128(write_mask, result), _mm_andnot_si128(write_mask, dest_pixels));
+  _mm_storeu_si128((__m128i *)dest, result);
+}
+
+__attribute__((target("sse2"))) INTERNAL void
+hh_draw_quad_row_sse2(u32* restrict dest, uint count, HHQuadSpan const* span)
+{
+  __m128i lane_index = _mm_setr_epi32(0, 1, 2, 3);
+  __m128i step_x = _mm_set1_epi32(span->step_x);
+  __m128i step_y = _mm_set1_epi32(span->step_y);
+  __m128i texel_x = _mm_add_epi32(_mm_set1_epi32(span->texel_x),
+                                  _mm_setr_epi32(0, span->step_x, 2 * span->step_x, 3 * span->step_x));
+  __m128i texel_y = _mm_add_epi32(_mm_set1_epi32(span->texel_y),
+                                  _mm_setr_epi32(0, span->step_y, 2 * span->step_y, 3 * span->step_y));
+  __m128i step4_x = _mm_slli_epi32(step_x, 2);
+  __m128i step4_y = _mm_slli_epi32(step_y, 2);
+
+  uint i = 0;
+  for (; i + 4 <= count; i += 4) {
+    hh_draw_quad_pixels_sse2(dest + i, texel_x, texel_y, _mm_set1_epi32(-1), span);
+    texel_x = _mm_add_epi32(texel_x, step4_x);
+    texel_y = _mm_add_epi32(texel_y, step4_y);
+  }
+
+  // NOTE(Ryan): Short spans are common at a quad's corners, so the tail is one masked vector
+  uint tail_count = count - i;
+  if (tail_count > 0) {
+    u32 dest_tail[4] = {0};
+    memcpy(dest_tail, dest + i, tail_count * sizeof(u32));
+    __m128i lane_mask = _mm_cmplt_epi32(lane_index, _mm_set1_epi32(tail_count));
+    hh_draw_quad_pixels_sse2(dest_tail, texel_x, texel_y, lane_mask, span);
+    memcpy(dest + i, dest_tail, tail_count * sizeof(u32));
+  }
+}
+
+__attribute__((target("avx2"))) INTERNAL __m256i
+hh_quad_lerp_avx2(__m256i a, __m256i b, __m256i fraction)
+{
+  __m256i inverse_fraction = _mm256_sub_epi32(_mm256_set1_epi32(256), fraction);
+  __m256i sum = _mm256_add_epi32(_mm256_mullo_epi16(a, inverse_fraction), _mm256_mullo_epi16(b, fraction));
+  return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(128)), 8);
+}
+
+__attribute__((target("avx2"))) INTERNAL __m256i
+hh_quad_channel_avx2(__m256i pixels, uint shift)
+{
+  return _mm256_and_si256(_mm256_srl_epi32(pixels, _mm_cvtsi32_si128(shift)), _mm256_set1_epi32(0xff));
+}
+
+__attribute__((target("avx2"))) INTERNAL void
+hh_draw_quad_pixels_avx2(u32* dest, __m256i texel_x, __m256i texel_y, HHQuadSpan const* span)
+{
+  __m256i minus_one = _mm256_set1_epi32(-1);
+  __m256i is_inside = _mm256_and_si256(_mm256_cmpgt_epi32(texel_x, minus_one), _mm256_cmpgt_epi32(texel_y, minus_one));
+  is_inside = _mm256_and_si256(is_inside, _mm256_cmpgt_epi32(_mm256_set1_epi32(span->width << 16), texel_x));
+  __m256i write_mask = _mm256_and_si256(is_inside, _mm256_cmpgt_epi32(_mm256_set1_epi32(span->height << 16), texel_y));
+  if (_mm256_testz_si256(write_mask, write_mask)) {
+    return;
+  }
+
+  __m256i sample_x = _mm256_sub_epi32(texel_x, _mm256_set1_epi32(0x8000));
+  __m256i sample_y = _mm256_sub_epi32(texel_y, _mm256_set1_epi32(0x8000));
+  __m256i fraction_x = _mm256_and_si256(_mm256_srai_epi32(sample_x, 8), _mm256_set1_epi32(0xff));
+  __m256i fraction_y = _mm256_and_si256(_mm256_srai_epi32(sample_y, 8), _mm256_set1_epi32(0xff));
+  __m256i zero = _mm256_setzero_si256();
+  __m256i one = _mm256_set1_epi32(1);
+  __m256i max_x = _mm256_set1_epi32(span->width - 1);
+  __m256i max_y = _mm256_set1_epi32(span->height - 1);
+  __m256i x0 = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(sample_x, 16), zero), max_x);
+  __m256i x1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(_mm256_srai_epi32(sample_x, 16), one), zero), max_x);
+  __m256i y0 = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(sample_y, 16), zero), max_y);
+  __m256i y1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(_mm256_srai_epi32(sample_y, 16), one), zero), max_y);
+
+  __m256i pitch = _mm256_set1_epi32(span->pitch);
+  __m256i row0 = _mm256_mullo_epi32(y0, pitch);
+  __m256i row1 = _mm256_mullo_epi32(y1, pitch);
+  x0 = _mm256_slli_epi32(x0, 2);
+  x1 = _mm256_slli_epi32(x1, 2);
+  int const* base = (int const *)span->pixels;
+  __m256i top_left = _mm256_i32gather_epi32(base, _mm256_add_epi32(row0, x0), 1);
+  __m256i top_right = _mm256_i32gather_epi32(base, _mm256_add_epi32(row0, x1), 1);
+  __m256i bottom_left = _mm256_i32gather_epi32(base, _mm256_add_epi32(row1, x0), 1);
+  __m256i bottom_right = _mm256_i32gather_epi32(base, _mm256_add_epi32(row1, x1), 1);
+  __m256i dest_pixels = _mm256_loadu_si256((__m256i const *)dest);
+  __m256i alpha_scale = _mm256_set1_epi32(span->alpha_scale);
+
+  __m256i filtered[4];
+  for (uint channel_i = 0; channel_i < 4; ++channel_i) {
+    uint shift = channel_i * 8;
+    __m256i top = hh_quad_lerp_avx2(hh_quad_channel_avx2(top_left, shift), hh_quad_channel_avx2(top_right, shift), fraction_x);
+    __m256i bottom = hh_quad_lerp_avx2(hh_quad_channel_avx2(bottom_left, shift), hh_quad_channel_avx2(bottom_right, shift),
+                                       fraction_x);
+    __m256i value = hh_quad_lerp_avx2(top, bottom, fraction_y);
+    filtered[channel_i] = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi16(value, alpha_scale), _mm256_set1_epi32(128)), 8);
+  }
+
+  __m256 alpha = _mm256_cvtepi32_ps(filtered[3]);
+  __m256 inverse_alpha = _mm256_and_ps(_mm256_cmp_ps(alpha, _mm256_setzero_ps(), _CMP_GT_OQ),
+                                       _mm256_div_ps(_mm256_set1_ps(255.0f), alpha));
+  __m256 dest_weight = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_set1_epi32(255), filtered[3])),
+                                     _mm256_set1_ps(1.0f / 255.0f));
+  __m256i channel_max = _mm256_set1_epi32(255);
+  __m256i result = zero;
+  for (uint channel_i = 0; channel_i < 3; ++channel_i) {
+    uint shift = channel_i * 8;
+    __m256 source = _mm256_cvtepi32_ps(filtered[channel_i]);
+    __m256 dest_value = _mm256_cvtepi32_ps(hh_quad_channel_avx2(dest_pixels, shift));
+    __m256 linear = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(source, source), inverse_alpha),
+                                  _mm256_mul_ps(_mm256_mul_ps(dest_value, dest_value), dest_weight));
+    __m256i value = _mm256_min_epi32(_mm256_cvtps_epi32(_mm256_sqrt_ps(linear)), channel_max);
+    result = _mm256_or_si256(result, _mm256_sll_epi32(value, _mm_cvtsi32_si128(shift)));
+  }
+  __m256 dest_alpha = _mm256_cvtepi32_ps(_mm256_srli_epi32(dest_pixels, 24));
+  __m256i result_alpha = _mm256_min_epi32(_mm256_cvtps_epi32(_mm256_add_ps(alpha, _mm256_mul_ps(dest_alpha, dest_weight))),
+                                          channel_max);
+  result = _mm256_or_si256(result, _mm256_slli_epi32(result_alpha, 24));
+
+  _mm256_storeu_si256((__m256i *)dest, _mm256_blendv_epi8(dest_pixels, result, write_mask));
+}
+
+__attribute__((target("avx2"))) INTERNAL void
+hh_draw_quad_row_avx2(u32* restrict dest, uint count, HHQuadSpan const* span)
+{
+  __m256i lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  __m256i texel_x = _mm256_add_epi32(_mm256_set1_epi32(span->texel_x), _mm256_mullo_epi32(lane_index, _mm256_set1_epi32(span->step_x)));
+  __m256i texel_y = _mm256_add_epi32(_mm256_set1_epi32(span->texel_y), _mm256_mullo_epi32(lane_index, _mm256_set1_epi32(span->step_y)));
+  __m256i step8_x = _mm256_set1_epi32(span->step_x * 8);
+  __m256i step8_y = _mm256_set1_epi32(span->step_y * 8);
+
+  uint i = 0;
+  for (; i + 8 <= count; i += 8) {
+    hh_draw_quad_pixels_avx2(dest + i, texel_x, texel_y, span);
+    texel_x = _mm256_add_epi32(texel_x, step8_x);
+    texel_y = _mm256_add_epi32(texel_y, step8_y);
+  }
+
+  HHQuadSpan tail_span = *span;
+  tail_span.texel_x = span->texel_x + (int32)i * span->step_x;
+  tail_span.texel_y = span->texel_y + (int32)i * span->step_y;
+  hh_draw_quad_row_sse2(dest + i, count - i, &tail_span);
+}
+#endif
+
+GLOBAL HHQuadRow* hh_draw_quad_row = hh_draw_quad_row_scalar;
+
+INTERNAL void
+hh_select_quad_kernels(u32 cpu_features)
+{
+  hh_draw_quad_row = hh_draw_quad_row_scalar;
+#if defined(HH_X86)
+  if (cpu_features & HH_CPU_FEATURE_SSE2) {
+    hh_draw_quad_row = hh_draw_quad_row_sse2;
+  }
+  if (cpu_features & HH_CPU_FEATURE_AVX2) {
+    hh_draw_quad_row = hh_draw_quad_row_avx2;
+  }
+#else
+  (void)cpu_features;
+#endif
+}
+
+// NOTE(Ryan): Narrows [*first, *last] to the steps i where start + i * step lies in [0, limit]
+INTERNAL void
+hh_narrow_quad_span(double start, double step, double limit, double* first, double* last)
+{
+  if (step > 0.0) {
+    *first = fmax(*first, -start / step);
+    *last = fmin(*last, (limit - start) / step);
+  } else if (step < 0.0) {
+    *first = fmax(*first, (limit - start) / step);
+    *last = fmin(*last, -start / step);
+  } else if (start < 0.0 || start > limit) {
+    *last = *first - 1.0;
+  }
+}
+
+// NOTE(Ryan): The bitmap's top left corner lands at 'origin', its top edge runs along x_axis and its left edge
+// along y_axis, both in pixels. alpha in [0, 1] fades the whole quad.
+INTERNAL void
+hh_draw_quad_clipped(HHPixelBuffer* pixel_buffer, HHClipRect clip_rect, HHBitmap const* bitmap, float origin_x,
+                     float origin_y, float x_axis_x, float x_axis_y, float y_axis_x, float y_axis_y, float alpha)
+{
+  if (!(alpha > 0.0f) || bitmap->width == 0 || bitmap->height == 0 ||
+      bitmap->width > HH_QUAD_MAX_BITMAP_SIZE || bitmap->height > HH_QUAD_MAX_BITMAP_SIZE ||
+      !isfinite(origin_x + origin_y + x_axis_x + x_axis_y + y_axis_x + y_axis_y)) {
+    return;
+  }
+  alpha = (alpha < 1.0f) ? alpha : 1.0f;
+  double determinant = (double)x_axis_x * y_axis_y - (double)x_axis_y * y_axis_x;
+  if (!(fabs(determinant) > 1e-6)) {
+    return;
+  }
+
+  float corner_x[4] = {origin_x, origin_x + x_axis_x, origin_x + y_axis_x, origin_x + x_axis_x + y_axis_x};
+  float corner_y[4] = {origin_y, origin_y + x_axis_y, origin_y + y_axis_y, origin_y + x_axis_y + y_axis_y};
+  float min_x = corner_x[0], max_x = corner_x[0], min_y = corner_y[0], max_y = corner_y[0];
+  for (uint corner_i = 1; corner_i < 4; ++corner_i) {
+    min_x = fminf(min_x, corner_x[corner_i]);
+    max_x = fmaxf(max_x, corner_x[corner_i]);
+    min_y = fminf(min_y, corner_y[corner_i]);
+    max_y = fmaxf(max_y, corner_y[corner_i]);
+  }
+  // NOTE(Ryan): Clamped as floats first so the conversions stay defined for any input
+  float clamped_min_x = fmaxf(min_x, (float)clip_rect.min_x);
+  float clamped_min_y = fmaxf(min_y, (float)clip_rect.min_y);
+  float clamped_max_x = fminf(max_x, (float)clip_rect.max_x);
+  float clamped_max_y = fminf(max_y, (float)clip_rect.max_y);
+  if (!(clamped_min_x < clamped_max_x && clamped_min_y < clamped_max_y)) {
+    return;
+  }
+  int start_x = (int)floorf(clamped_min_x);
+  int start_y = (int)floorf(clamped_min_y);
+  int end_x = (int)ceilf(clamped_max_x);
+  int end_y = (int)ceilf(clamped_max_y);
+
+  // NOTE(Ryan): Texel coordinates as a function of the pixel centre's offset from the origin
+  double width = bitmap->width;
+  double height = bitmap->height;
+  double texel_x_per_x = width * y_axis_y / determinant;
+  double texel_x_per_y = -width * y_axis_x / determinant;
+  double texel_y_per_x = -height * x_axis_y / determinant;
+  double texel_y_per_y = height * x_axis_x / determinant;
+  int64 step_x = llrint(texel_x_per_x * 65536.0);
+  int64 step_y = llrint(texel_y_per_x * 65536.0);
+  if (step_x < -HH_QUAD_MAX_STEP || step_x > HH_QUAD_MAX_STEP || step_y < -HH_QUAD_MAX_STEP || step_y > HH_QUAD_MAX_STEP) {
+    return;
+  }
+
+  HHQuadSpan span = {0};
+  span.pixels = bitmap->pixels;
+  span.pitch = bitmap->pitch;
+  span.width = bitmap->width;
+  span.height = bitmap->height;
+  span.step_x = (int32)step_x;
+  span.step_y = (int32)step_y;
+  span.alpha_scale = (u32)lrintf(alpha * 256.0f);
+
+  // NOTE(Ryan): Each row is anchored at the quad's own left edge rather than the clip rect's, so the coordinates
+  // at a pixel, and hence its colour, don't depend on how the buffer was split up
+  int anchor_x = (int)floorf(fmaxf(min_x, -(float)(1 << 30)));
+  double anchor_offset_x = anchor_x + 0.5 - (double)origin_x;
+  u8* dest_row = (u8 *)pixel_buffer->memory + start_y * pixel_buffer->pitch;
+  for (int y = start_y; y < end_y; ++y, dest_row += pixel_buffer->pitch) {
+    double offset_y = y + 0.5 - (double)origin_y;
+    double anchor_texel_x = anchor_offset_x * texel_x_per_x + offset_y * texel_x_per_y;
+    double anchor_texel_y = anchor_offset_x * texel_y_per_x + offset_y * texel_y_per_y;
+
+    // NOTE(Ryan): Conservative by a pixel each side; the fixed point test in the kernel decides exactly
+    double first = start_x - anchor_x;
+    double last = end_x - 1 - anchor_x;
+    hh_narrow_quad_span(anchor_texel_x, texel_x_per_x, width, &first, &last);
+    hh_narrow_quad_span(anchor_texel_y, texel_y_per_x, height, &first, &last);
+    if (!(first <= last + 2.0)) {
+      continue;
+    }
+    int span_start_x = anchor_x + (int)floor(first) - 1;
+    int span_end_x = anchor_x + (int)ceil(last) + 2;
+    span_start_x = (span_start_x > start_x) ? span_start_x : start_x;
+    span_end_x = (span_end_x < end_x) ? span_end_x : end_x;
+    if (span_start_x >= span_end_x) {
+      continue;
+    }
+
+    int64 anchor_fixed_x = llrint(anchor_texel_x * 65536.0);
+    int64 anchor_fixed_y = llrint(anchor_texel_y * 65536.0);
+    span.texel_x = (int32)(anchor_fixed_x + (int64)(span_start_x - anchor_x) * step_x);
+    span.texel_y = (int32)(anchor_fixed_y + (int64)(span_start_x - anchor_x) * step_y);
+    hh_draw_quad_row((u32 *)dest_row + span_start_x, span_end_x - span_start_x, &span);
+  }
+}
+
+INTERNAL void
+hh_draw_quad(HHPixelBuffer* pixel_buffer, HHBitmap const* bitmap, float origin_x, float origin_y, float x_axis_x,
+             float x_axis_y, float y_axis_x, float y_axis_y, float alpha)
+{
+  TIMED_FUNCTION();
+  hh_draw_quad_clipped(pixel_buffer, hh_get_buffer_clip_rect(pixel_buffer), bitmap, origin_x, origin_y, x_axis_x,
+                       x_axis_y, y_axis_x, y_axis_y, alpha);
+}
+
+// NOTE(Ryan): Tiles are a whole number of cache lines wide so no two threads write the same line
+// (assuming the buffer rows themselves start on a cache line). A tile row is 1KiB and a tile ~32-64KiB,
+// so a tile being drawn into stays in L1/L2 however many layers land on it.
+#define HH_MAX_RENDER_TILES 1024
+
+typedef struct {
+  uint tile_width;
+  uint tile_height;
+  uint tile_count_x;
+  uint tile_count_y;
+} HHRenderTiles;
+
+INTERNAL HHRenderTiles
+hh_get_render_tiles(HHMemory* memory, HHPixelBuffer* pixel_buffer)
+{
+  HHRenderTiles result = {0};
+  uint cache_line_size = (memory->cache_line_size != 0) ? memory->cache_line_size : 64;
+  uint pixels_per_cache_line = cache_line_size / BYTES_PER_PIXEL;
+  result.tile_width = pixels_per_cache_line * (1024 / cache_line_size);
+  result.tile_height = 32;
+
+  result.tile_count_x = (pixel_buffer->width + result.tile_width - 1) / result.tile_width;
+  result.tile_count_y = (pixel_buffer->height + result.tile_height - 1) / result.tile_height;
+  while (result.tile_count_x * result.tile_count_y > HH_MAX_RENDER_TILES) {
+    result.tile_height *= 2;
+    result.tile_count_y = (pixel_buffer->height + result.tile_height - 1) / result.tile_height;
+  }
+  return result;
+}
+
+INTERNAL HHClipRect
+hh_get_render_tile_rect(HHRenderTiles* tiles, HHPixelBuffer* pixel_buffer, uint tile_x, uint tile_y)
+{
+  uint min_x = tile_x * tiles->tile_width;
+  uint min_y = tile_y * tiles->tile_height;
+  uint max_x = (min_x + tiles->tile_width < pixel_buffer->width) ? min_x + tiles->tile_width : pixel_buffer->width;
+  uint max_y = (min_y + tiles->tile_height < pixel_buffer->height) ? min_y + tiles->tile_height : pixel_buffer->height;
+  HHClipRect result = {(int)min_x, (int)min_y, (int)max_x, (int)max_y};
+  return result;
+}
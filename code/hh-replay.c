@@ -0,0 +1,336 @@
+// NOTE(Ryan): Loop-edit snapshots of the HHMemory block.
+// On Linux each replay slot is a sparse memory-mapped file the size of the block, holding the snapshot-time
+// contents of only those pages that have since been written. Writes are caught by keeping the block
+// read-only and unprotecting a page from a SIGSEGV handler on its first write. So taking a snapshot is a
+// single mprotect, and restoring one copies back only the pages that diverged.
+//
+// Elsewhere a slot is a heap copy, allocated on its first snapshot. Only chunks holding something other than
+// zeros are copied, so a snapshot costs a read of the block plus a copy of what the game has actually used.
+//
+// IMPORTANT(Ryan): While a snapshot is live, the kernel writing into the block (read(2), io_uring, ...)
+// fails with EFAULT instead of faulting, so such writes must go through a user space copy.
+
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define NUM_REPLAY_BUFFERS 9
+#define SDL_REPLAY_CHUNK_SIZE KILOBYTES(64)
+
+typedef struct {
+  SDLInputStream input_stream;
+  char input_file_name[256];
+  char snapshot_file_name[256];
+  bool has_snapshot;
+#if defined(LINUX)
+  int snapshot_fd;
+  u8* snapshot;
+  // NOTE(Ryan): A set bit in saved_pages means the snapshot file holds that page's snapshot contents.
+  // A set bit in diverged_pages means the live page may differ from the snapshot.
+  _Atomic u64* saved_pages;
+  _Atomic u64* diverged_pages;
+#else
+  u8* memory_block;
+  // NOTE(Ryan): A set bit means the chunk was all zeros and is not held in memory_block
+  u64* zero_chunks;
+#endif
+} SDLReplayBuffer;
+
+typedef struct {
+  u8* memory_block;
+  u64 memory_block_size;
+  u64 page_size;
+  u64 page_count;
+  SDLReplayBuffer buffers[NUM_REPLAY_BUFFERS];
+#if defined(LINUX)
+  atomic_flag lock;
+  bool is_segv_handler_installed;
+  struct sigaction prev_segv_action;
+#endif
+} SDLReplayState;
+
+GLOBAL SDLReplayState sdl_replay_state;
+
+#if defined(LINUX)
+INTERNAL bool
+sdl_replay_test_page(_Atomic u64* bitmap, u64 page_i)
+{
+  return (atomic_load_explicit(&bitmap[page_i / 64], memory_order_relaxed) >> (page_i % 64)) & 1;
+}
+
+INTERNAL void
+sdl_replay_set_page(_Atomic u64* bitmap, u64 page_i)
+{
+  atomic_fetch_or_explicit(&bitmap[page_i / 64], (1ULL << (page_i % 64)), memory_order_relaxed);
+}
+
+INTERNAL void
+sdl_replay_clear_page(_Atomic u64* bitmap, u64 page_i)
+{
+  atomic_fetch_and_explicit(&bitmap[page_i / 64], ~(1ULL << (page_i % 64)), memory_order_relaxed);
+}
+
+// NOTE(Ryan): Must run before a page changes; saves its current contents into every snapshot that lacks it.
+// Caller holds the lock.
+INTERNAL void
+sdl_replay_prepare_page_write(u64 page_i)
+{
+  u64 page_offset = page_i * sdl_replay_state.page_size;
+  for (uint replay_i = 0; replay_i < NUM_REPLAY_BUFFERS; ++replay_i) {
+    SDLReplayBuffer* replay_buffer = &sdl_replay_state.buffers[replay_i];
+    if (replay_buffer->has_snapshot) {
+      if (!sdl_replay_test_page(replay_buffer->saved_pages, page_i)) {
+        memcpy(replay_buffer->snapshot + page_offset, sdl_replay_state.memory_block + page_offset, sdl_replay_state.page_size);
+        sdl_replay_set_page(replay_buffer->saved_pages, page_i);
+      }
+      sdl_replay_set_page(replay_buffer->diverged_pages, page_i);
+    }
+  }
+}
+
+INTERNAL void
+sdl_replay_segv_handler(int signal_number, siginfo_t* signal_info, void* context)
+{
+  u8* fault_address = (u8 *)signal_info->si_addr;
+  if (fault_address >= sdl_replay_state.memory_block &&
+      fault_address < sdl_replay_state.memory_block + sdl_replay_state.memory_block_size) {
+    u64 page_i = (fault_address - sdl_replay_state.memory_block) / sdl_replay_state.page_size;
+    u8* page = sdl_replay_state.memory_block + page_i * sdl_replay_state.page_size;
+
+    // NOTE(Ryan): Spin, as two workers may fault on the same page; the second must not copy
+    // the page after the first has unprotected it and resumed writing
+    while (atomic_flag_test_and_set_explicit(&sdl_replay_state.lock, memory_order_acquire)) {}
+    sdl_replay_prepare_page_write(page_i);
+    if (mprotect(page, sdl_replay_state.page_size, PROT_READ | PROT_WRITE) < 0) {
+      // NOTE(Ryan): Returning would retry the write forever, so let it fault for real
+      signal(SIGSEGV, SIG_DFL);
+    }
+    atomic_flag_clear_explicit(&sdl_replay_state.lock, memory_order_release);
+    return;
+  }
+
+  // NOTE(Ryan): Not ours, so hand it to whoever was installed before us (or crash as normal)
+  if (sdl_replay_state.prev_segv_action.sa_flags & SA_SIGINFO) {
+    sdl_replay_state.prev_segv_action.sa_sigaction(signal_number, signal_info, context);
+  } else if (sdl_replay_state.prev_segv_action.sa_handler != SIG_DFL &&
+             sdl_replay_state.prev_segv_action.sa_handler != SIG_IGN) {
+    sdl_replay_state.prev_segv_action.sa_handler(signal_number);
+  } else {
+    signal(SIGSEGV, SIG_DFL);
+  }
+}
+#endif
+
+INTERNAL void
+sdl_release_replay_buffers(void)
+{
+  for (uint replay_i = 0; replay_i < NUM_REPLAY_BUFFERS; ++replay_i) {
+    SDLReplayBuffer* replay_buffer = &sdl_replay_state.buffers[replay_i];
+#if defined(LINUX)
+    if (replay_buffer->snapshot != NULL) {
+      munmap(replay_buffer->snapshot, sdl_replay_state.memory_block_size);
+    }
+    if (replay_buffer->snapshot_fd >= 0) {
+      close(replay_buffer->snapshot_fd);
+    }
+    free(replay_buffer->saved_pages);
+    free(replay_buffer->diverged_pages);
+#else
+    free(replay_buffer->memory_block);
+    free(replay_buffer->zero_chunks);
+#endif
+    memset(replay_buffer, 0, sizeof(*replay_buffer));
+#if defined(LINUX)
+    replay_buffer->snapshot_fd = -1;
+#endif
+  }
+
+#if defined(LINUX)
+  if (sdl_replay_state.is_segv_handler_installed) {
+    sigaction(SIGSEGV, &sdl_replay_state.prev_segv_action, NULL);
+    sdl_replay_state.is_segv_handler_installed = false;
+  }
+#endif
+}
+
+// NOTE(Ryan): The write barrier works in base pages, so the block must not be a hugetlb mapping
+// (see sdl_reserve_memory_block()); mprotect() can't split one.
+INTERNAL STATUS
+sdl_init_replay_buffers(void* memory_block, u64 memory_block_size, char const* base_path)
+{
+  sdl_replay_state.memory_block = (u8 *)memory_block;
+  sdl_replay_state.memory_block_size = memory_block_size;
+
+#if defined(LINUX)
+  for (uint replay_i = 0; replay_i < NUM_REPLAY_BUFFERS; ++replay_i) {
+    sdl_replay_state.buffers[replay_i].snapshot_fd = -1;
+  }
+  sdl_replay_state.page_size = sysconf(_SC_PAGESIZE);
+  sdl_replay_state.page_count = (memory_block_size + sdl_replay_state.page_size - 1) / sdl_replay_state.page_size;
+  u64 bitmap_size = ((sdl_replay_state.page_count + 63) / 64) * sizeof(u64);
+  atomic_flag_clear(&sdl_replay_state.lock);
+
+  struct sigaction segv_action = {0};
+  segv_action.sa_sigaction = sdl_replay_segv_handler;
+  segv_action.sa_flags = SA_SIGINFO;
+  sigemptyset(&segv_action.sa_mask);
+  if (sigaction(SIGSEGV, &segv_action, &sdl_replay_state.prev_segv_action) < 0) {
+    SDL_LogWarn("Unable to install replay write barrier: %s", strerror(errno));
+    return FAILED;
+  }
+  sdl_replay_state.is_segv_handler_installed = true;
+#endif
+
+  for (uint replay_i = 0; replay_i < NUM_REPLAY_BUFFERS; ++replay_i) {
+    SDLReplayBuffer* replay_buffer = &sdl_replay_state.buffers[replay_i];
+    snprintf(replay_buffer->input_file_name, sizeof(replay_buffer->input_file_name),
+             "%sloop-edit-%u-input.hmi", base_path, replay_i);
+    snprintf(replay_buffer->snapshot_file_name, sizeof(replay_buffer->snapshot_file_name),
+             "%sloop-edit-%u-memory.hmm", base_path, replay_i);
+
+#if defined(LINUX)
+    // NOTE(Ryan): Sparse, so a slot only occupies disk for the pages it has actually saved
+    replay_buffer->snapshot_fd = open(replay_buffer->snapshot_file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (replay_buffer->snapshot_fd < 0 || ftruncate(replay_buffer->snapshot_fd, memory_block_size) < 0) {
+      SDL_LogWarn("Unable to create replay snapshot file '%s': %s", replay_buffer->snapshot_file_name, strerror(errno));
+      goto __REPLAY_INIT_ERROR__;
+    }
+    u8* snapshot = mmap(NULL, memory_block_size, PROT_READ | PROT_WRITE, MAP_SHARED, replay_buffer->snapshot_fd, 0);
+    if (snapshot == MAP_FAILED) {
+      SDL_LogWarn("Unable to map replay snapshot file '%s': %s", replay_buffer->snapshot_file_name, strerror(errno));
+      goto __REPLAY_INIT_ERROR__;
+    }
+    replay_buffer->snapshot = snapshot;
+    replay_buffer->saved_pages = calloc(1, bitmap_size);
+    replay_buffer->diverged_pages = calloc(1, bitmap_size);
+    if (replay_buffer->saved_pages == NULL || replay_buffer->diverged_pages == NULL) {
+      SDL_LogWarn("Unable to allocate replay page bitmaps: %s", strerror(errno));
+      goto __REPLAY_INIT_ERROR__;
+    }
+#endif
+  }
+
+  return SUCCEEDED;
+
+#if defined(LINUX)
+__REPLAY_INIT_ERROR__:
+  sdl_release_replay_buffers();
+  return FAILED;
+#endif
+}
+
+#if !defined(LINUX)
+INTERNAL bool
+sdl_replay_is_zero_chunk(u8 const* chunk, u64 size)
+{
+  u64 const* words = (u64 const *)chunk;
+  u64 word_count = size / sizeof(u64);
+  for (u64 word_i = 0; word_i < word_count; ++word_i) {
+    if (words[word_i] != 0) {
+      return false;
+    }
+  }
+  for (u64 byte_i = word_count * sizeof(u64); byte_i < size; ++byte_i) {
+    if (chunk[byte_i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+#endif
+
+// NOTE(Ryan): Job queue must be idle; nothing may be writing the block while the snapshot is taken or restored.
+INTERNAL STATUS
+sdl_take_replay_snapshot(uint replay_i)
+{
+  SDLReplayBuffer* replay_buffer = &sdl_replay_state.buffers[replay_i];
+
+#if defined(LINUX)
+  u64 bitmap_size = ((sdl_replay_state.page_count + 63) / 64) * sizeof(u64);
+  memset(replay_buffer->saved_pages, 0, bitmap_size);
+  memset(replay_buffer->diverged_pages, 0, bitmap_size);
+  replay_buffer->has_snapshot = true;
+
+  // NOTE(Ryan): Pages already writable would otherwise go unnoticed by this snapshot
+  mprotect(sdl_replay_state.memory_block, sdl_replay_state.memory_block_size, PROT_READ);
+#else
+  u64 chunk_count = (sdl_replay_state.memory_block_size + SDL_REPLAY_CHUNK_SIZE - 1) / SDL_REPLAY_CHUNK_SIZE;
+  if (replay_buffer->memory_block == NULL) {
+    // NOTE(Ryan): Only the chunks written below are ever committed
+    replay_buffer->memory_block = malloc(sdl_replay_state.memory_block_size);
+    replay_buffer->zero_chunks = calloc((chunk_count + 63) / 64, sizeof(u64));
+    if (replay_buffer->memory_block == NULL || replay_buffer->zero_chunks == NULL) {
+      SDL_LogWarn("Unable to allocate replay buffer memory: %s", strerror(errno));
+      free(replay_buffer->memory_block);
+      free(replay_buffer->zero_chunks);
+      replay_buffer->memory_block = NULL;
+      replay_buffer->zero_chunks = NULL;
+      return FAILED;
+    }
+  }
+
+  for (u64 chunk_i = 0; chunk_i < chunk_count; ++chunk_i) {
+    u64 offset = chunk_i * SDL_REPLAY_CHUNK_SIZE;
+    u64 size = sdl_replay_state.memory_block_size - offset;
+    size = (size < SDL_REPLAY_CHUNK_SIZE) ? size : SDL_REPLAY_CHUNK_SIZE;
+    u64 chunk_bit = 1ULL << (chunk_i % 64);
+    if (sdl_replay_is_zero_chunk(sdl_replay_state.memory_block + offset, size)) {
+      replay_buffer->zero_chunks[chunk_i / 64] |= chunk_bit;
+    } else {
+      replay_buffer->zero_chunks[chunk_i / 64] &= ~chunk_bit;
+      memcpy(replay_buffer->memory_block + offset, sdl_replay_state.memory_block + offset, size);
+    }
+  }
+  replay_buffer->has_snapshot = true;
+#endif
+
+  return SUCCEEDED;
+}
+
+INTERNAL void
+sdl_restore_replay_snapshot(uint replay_i)
+{
+  SDLReplayBuffer* replay_buffer = &sdl_replay_state.buffers[replay_i];
+  if (!replay_buffer->has_snapshot) {
+    return;
+  }
+
+#if defined(LINUX)
+  while (atomic_flag_test_and_set_explicit(&sdl_replay_state.lock, memory_order_acquire)) {}
+
+  u64 page_size = sdl_replay_state.page_size;
+  for (u64 word_i = 0; word_i < (sdl_replay_state.page_count + 63) / 64; ++word_i) {
+    if (atomic_load_explicit(&replay_buffer->diverged_pages[word_i], memory_order_relaxed) == 0) {
+      continue;
+    }
+
+    for (u64 page_i = word_i * 64; page_i < (word_i + 1) * 64 && page_i < sdl_replay_state.page_count; ++page_i) {
+      if (sdl_replay_test_page(replay_buffer->diverged_pages, page_i)) {
+        u8* page = sdl_replay_state.memory_block + page_i * page_size;
+        // NOTE(Ryan): Other snapshots still need this page's current contents before it is overwritten
+        sdl_replay_prepare_page_write(page_i);
+        mprotect(page, page_size, PROT_READ | PROT_WRITE);
+        memcpy(page, replay_buffer->snapshot + page_i * page_size, page_size);
+        mprotect(page, page_size, PROT_READ);
+        sdl_replay_clear_page(replay_buffer->diverged_pages, page_i);
+      }
+    }
+  }
+
+  atomic_flag_clear_explicit(&sdl_replay_state.lock, memory_order_release);
+#else
+  u64 chunk_count = (sdl_replay_state.memory_block_size + SDL_REPLAY_CHUNK_SIZE - 1) / SDL_REPLAY_CHUNK_SIZE;
+  for (u64 chunk_i = 0; chunk_i < chunk_count; ++chunk_i) {
+    u64 offset = chunk_i * SDL_REPLAY_CHUNK_SIZE;
+    u64 size = sdl_replay_state.memory_block_size - offset;
+    size = (size < SDL_REPLAY_CHUNK_SIZE) ? size : SDL_REPLAY_CHUNK_SIZE;
+    u8* chunk = sdl_replay_state.memory_block + offset;
+    if (!(replay_buffer->zero_chunks[chunk_i / 64] & (1ULL << (chunk_i % 64)))) {
+      memcpy(chunk, replay_buffer->memory_block + offset, size);
+    } else if (!sdl_replay_is_zero_chunk(chunk, size)) {
+      // NOTE(Ryan): Checked first so chunks that were never touched stay uncommitted
+      memset(chunk, 0, size);
+    }
+  }
+#endif
+}
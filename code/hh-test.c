@@ -0,0 +1,722 @@
+// NOTE(Ryan): Behaviour tests for the pieces whose failures don't show on screen until much later: the .hmi
+// recording round trip and seek, the Chase-Lev job deques and the pool built on them, the replay write barrier,
+// and asset cache eviction including an asset larger than the whole budget. Built by unix-build.bash as
+// hh-test and run by "unix-build.bash ci".
+//
+// Each test reports every failed check with its line, then one PASS or FAIL line. The exit status is the
+// number of failed tests. Scratch files are written next to the binary, prefixed hh-test-, and removed after.
+//
+// usage: hh-test [--filter substring]
+
+#define HH_HEADLESS
+#include "hh.c"
+
+#include <signal.h>
+#include <stdalign.h>
+
+#define TEST_INPUT_FRAME_COUNT 1000
+#define TEST_DEQUE_JOB_COUNT (1 << 18)
+#define TEST_DEQUE_THIEF_COUNT 3
+#define TEST_REPLAY_BLOCK_SIZE (MEGABYTES(8) + 12345)
+#define TEST_REPLAY_WRITER_COUNT 4
+#define TEST_ASSET_CACHE_MAX_FRAMES 1000
+
+typedef void (TestFunction)(void);
+
+typedef struct {
+  char const* filter;
+  uint failed_test_count;
+} TestOptions;
+
+GLOBAL uint test_failed_check_count;
+
+#define TEST_CHECK(expr) \
+  do { \
+    if (!(expr)) { \
+      fprintf(stderr, "  %s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+      ++test_failed_check_count; \
+    } \
+  } while (0)
+
+INTERNAL void
+test_run(TestOptions* options, char const* name, TestFunction* function)
+{
+  if (options->filter != NULL && strstr(name, options->filter) == NULL) {
+    return;
+  }
+
+  uint failed_check_count = test_failed_check_count;
+  function();
+  bool has_passed = (test_failed_check_count == failed_check_count);
+  if (!has_passed) {
+    ++options->failed_test_count;
+  }
+  printf("%s %s\n", has_passed ? "PASS" : "FAIL", name);
+  fflush(stdout);
+}
+
+// NOTE(Ryan): xorshift32, so runs are identical on every platform
+INTERNAL u32
+test_random(u32* state)
+{
+  u32 value = *state;
+  value ^= value << 13;
+  value ^= value >> 17;
+  value ^= value << 5;
+  *state = value;
+  return value;
+}
+
+INTERNAL void
+test_get_file_name(char* file_name, size_t file_name_size, char const* suffix)
+{
+  snprintf(file_name, file_name_size, "%shh-test-%s", sdl_info.base_path, suffix);
+}
+
+// NOTE(Ryan): Long runs of unchanged frames, bursts of stick and mouse movement and button transitions,
+// so every record kind in the format is exercised, including across keyframe boundaries
+INTERNAL HHInput
+test_make_input(uint frame_i, u32* random_state)
+{
+  HHInput input = {0};
+  for (uint controller_i = 0; controller_i < NUM_GAME_CONTROLLERS_SUPPORTED + 1; ++controller_i) {
+    HHController* controller = &input.controllers[controller_i];
+    controller->is_connected = (controller_i < 3);
+    controller->is_analog = (controller_i & 1);
+    if ((frame_i / 7) % 3 == 0) {
+      controller->ended_down = test_random(random_state) & ((1u << HH_BUTTON_COUNT) - 1);
+      for (uint button_i = 0; button_i < HH_BUTTON_COUNT; ++button_i) {
+        controller->half_transition_count[button_i] = test_random(random_state) % 3;
+      }
+    }
+    controller->stick_x = (frame_i % 50 < 10) ? (float)((int)(test_random(random_state) % 2001) - 1000) / 1000.0f : 0.25f;
+    controller->stick_y = -0.5f;
+  }
+  input.mouse_x = (frame_i % 30 < 5) ? (int)(test_random(random_state) % 1920) : 100;
+  input.mouse_y = -5;
+  input.left_mouse_button = (frame_i / 11) & 1;
+  input.right_mouse_button = (frame_i / 17) & 1;
+  input.frame_dt = (frame_i % 100 == 0) ? 0.02f : 1.0f / 60.0f;
+  return input;
+}
+
+// NOTE(Ryan): Field by field, as padding is not part of the recording
+INTERNAL bool
+test_is_same_input(HHInput* first, HHInput* second)
+{
+  for (uint controller_i = 0; controller_i < NUM_GAME_CONTROLLERS_SUPPORTED + 1; ++controller_i) {
+    HHController* first_controller = &first->controllers[controller_i];
+    HHController* second_controller = &second->controllers[controller_i];
+    if (first_controller->is_connected != second_controller->is_connected ||
+        first_controller->is_analog != second_controller->is_analog ||
+        memcmp(&first_controller->stick_x, &second_controller->stick_x, sizeof(float)) != 0 ||
+        memcmp(&first_controller->stick_y, &second_controller->stick_y, sizeof(float)) != 0 ||
+        first_controller->ended_down != second_controller->ended_down ||
+        memcmp(first_controller->half_transition_count, second_controller->half_transition_count, HH_BUTTON_COUNT) != 0) {
+      return false;
+    }
+  }
+  return first->mouse_x == second->mouse_x && first->mouse_y == second->mouse_y &&
+         first->left_mouse_button == second->left_mouse_button &&
+         first->middle_mouse_button == second->middle_mouse_button &&
+         first->right_mouse_button == second->right_mouse_button &&
+         memcmp(&first->frame_dt, &second->frame_dt, sizeof(float)) == 0;
+}
+
+INTERNAL void
+test_input_stream(void)
+{
+  char file_name[512] = {0};
+  test_get_file_name(file_name, sizeof(file_name), "input.hmi");
+
+  HHInput* written_inputs = malloc(TEST_INPUT_FRAME_COUNT * sizeof(HHInput));
+  SDLInputStream* stream = malloc(sizeof(SDLInputStream));
+  if (written_inputs == NULL || stream == NULL) {
+    TEST_CHECK(!"allocation");
+    free(written_inputs);
+    free(stream);
+    return;
+  }
+
+  u32 random_state = 1;
+  TEST_CHECK(sdl_open_input_stream_for_write(stream, file_name, 60, 1234) == SUCCEEDED);
+  for (uint frame_i = 0; frame_i < TEST_INPUT_FRAME_COUNT; ++frame_i) {
+    // NOTE(Ryan): The writer quantizes sticks in place, so what it leaves behind is what a replay must produce
+    written_inputs[frame_i] = test_make_input(frame_i, &random_state);
+    TEST_CHECK(sdl_write_input_stream(stream, &written_inputs[frame_i]) == SUCCEEDED);
+  }
+  TEST_CHECK(sdl_close_input_stream(stream) == SUCCEEDED);
+
+  if (sdl_open_input_stream_for_read(stream, file_name) == FAILED) {
+    TEST_CHECK(!"reopen for read");
+  } else {
+    TEST_CHECK(stream->frame_rate == 60);
+    TEST_CHECK(stream->build_id == 1234);
+    TEST_CHECK(stream->frame_count == TEST_INPUT_FRAME_COUNT);
+    TEST_CHECK(stream->keyframe_count ==
+               (TEST_INPUT_FRAME_COUNT + SDL_INPUT_STREAM_KEYFRAME_INTERVAL - 1) / SDL_INPUT_STREAM_KEYFRAME_INTERVAL);
+
+    uint mismatch_count = 0;
+    for (uint frame_i = 0; frame_i < TEST_INPUT_FRAME_COUNT; ++frame_i) {
+      HHInput input = {0};
+      if (!sdl_read_input_stream(stream, &input)) {
+        TEST_CHECK(!"recording ended early");
+        break;
+      }
+      mismatch_count += !test_is_same_input(&input, &written_inputs[frame_i]);
+    }
+    TEST_CHECK(mismatch_count == 0);
+    HHInput past_end_input = {0};
+    TEST_CHECK(!sdl_read_input_stream(stream, &past_end_input));
+
+    // NOTE(Ryan): Either side of each keyframe, the first and last frames, and backwards
+    uint seek_frames[] = {0, 1, 127, 128, 129, 255, 256, TEST_INPUT_FRAME_COUNT / 2, TEST_INPUT_FRAME_COUNT - 1, 3};
+    for (uint seek_i = 0; seek_i < ARRAY_SIZE(seek_frames); ++seek_i) {
+      uint seek_frame = seek_frames[seek_i];
+      TEST_CHECK(sdl_seek_input_stream(stream, seek_frame) == SUCCEEDED);
+      for (uint frame_i = seek_frame; frame_i < seek_frame + 3 && frame_i < TEST_INPUT_FRAME_COUNT; ++frame_i) {
+        HHInput input = {0};
+        TEST_CHECK(sdl_read_input_stream(stream, &input));
+        TEST_CHECK(test_is_same_input(&input, &written_inputs[frame_i]));
+      }
+    }
+    TEST_CHECK(sdl_seek_input_stream(stream, TEST_INPUT_FRAME_COUNT + 1) == FAILED);
+    sdl_close_input_stream(stream);
+  }
+  remove(file_name);
+
+#if defined(LINUX)
+  // NOTE(Ryan): A full disk must latch the failure, keep failing and be reported again on close
+  if (sdl_open_input_stream_for_write(stream, "/dev/full", 60, 1) == SUCCEEDED) {
+    STATUS write_status = SUCCEEDED;
+    for (uint frame_i = 0; frame_i < TEST_INPUT_FRAME_COUNT && write_status == SUCCEEDED; ++frame_i) {
+      HHInput input = test_make_input(frame_i, &random_state);
+      write_status = sdl_write_input_stream(stream, &input);
+    }
+    TEST_CHECK(write_status == FAILED);
+    TEST_CHECK(sdl_write_input_stream(stream, &written_inputs[0]) == FAILED);
+    TEST_CHECK(sdl_close_input_stream(stream) == FAILED);
+  }
+#endif
+
+  free(stream);
+  free(written_inputs);
+}
+
+INTERNAL HHJob
+test_make_job(uint job_index)
+{
+  HHJob job = {.data = (void *)(uintptr_t)job_index};
+  return job;
+}
+
+INTERNAL void
+test_job_deque_order(void)
+{
+  HHJobDeque* deque = aligned_alloc(alignof(HHJobDeque), sizeof(HHJobDeque));
+  if (deque == NULL) {
+    TEST_CHECK(!"allocation");
+    return;
+  }
+  memset(deque, 0, sizeof(HHJobDeque));
+
+  // NOTE(Ryan): Owner pops newest first, thieves take oldest first
+  for (uint job_i = 1; job_i <= 5; ++job_i) {
+    HHJob job = test_make_job(job_i);
+    TEST_CHECK(hh_job_deque_push(deque, &job));
+  }
+  HHJob job = {0};
+  TEST_CHECK(hh_job_deque_pop(deque, &job) && (uintptr_t)job.data == 5);
+  TEST_CHECK(hh_job_deque_pop(deque, &job) && (uintptr_t)job.data == 4);
+  TEST_CHECK(hh_job_deque_steal(deque, &job) && (uintptr_t)job.data == 1);
+  TEST_CHECK(hh_job_deque_steal(deque, &job) && (uintptr_t)job.data == 2);
+  TEST_CHECK(hh_job_deque_pop(deque, &job) && (uintptr_t)job.data == 3);
+  TEST_CHECK(!hh_job_deque_pop(deque, &job));
+  TEST_CHECK(!hh_job_deque_steal(deque, &job));
+
+  // NOTE(Ryan): Full at capacity, and the indices keep wrapping correctly after it drains
+  uint pushed_count = 0;
+  for (uint job_i = 0; job_i < HH_JOB_DEQUE_CAPACITY + 1; ++job_i) {
+    HHJob pushed_job = test_make_job(job_i);
+    pushed_count += hh_job_deque_push(deque, &pushed_job);
+  }
+  TEST_CHECK(pushed_count == HH_JOB_DEQUE_CAPACITY);
+  uint popped_count = 0;
+  while (hh_job_deque_pop(deque, &job)) {
+    TEST_CHECK((uintptr_t)job.data == HH_JOB_DEQUE_CAPACITY - 1 - popped_count);
+    ++popped_count;
+  }
+  TEST_CHECK(popped_count == HH_JOB_DEQUE_CAPACITY);
+
+  free(deque);
+}
+
+typedef struct {
+  HHJobDeque* deque;
+  _Atomic u8* run_counts;
+  _Atomic bool is_done;
+} TestStealData;
+
+INTERNAL int
+test_thief_thread(void* data)
+{
+  TestStealData* steal_data = (TestStealData *)data;
+  for (;;) {
+    HHJob job = {0};
+    if (hh_job_deque_steal(steal_data->deque, &job)) {
+      atomic_fetch_add(&steal_data->run_counts[(uintptr_t)job.data], 1);
+    } else if (atomic_load(&steal_data->is_done)) {
+      break;
+    }
+  }
+  return 0;
+}
+
+// NOTE(Ryan): Owner pushing and popping against several thieves; every job must be taken exactly once
+INTERNAL void
+test_job_deque_steal(void)
+{
+  TestStealData steal_data = {0};
+  steal_data.deque = aligned_alloc(alignof(HHJobDeque), sizeof(HHJobDeque));
+  steal_data.run_counts = calloc(TEST_DEQUE_JOB_COUNT, sizeof(_Atomic u8));
+  if (steal_data.deque == NULL || steal_data.run_counts == NULL) {
+    TEST_CHECK(!"allocation");
+    free(steal_data.deque);
+    free(steal_data.run_counts);
+    return;
+  }
+  memset(steal_data.deque, 0, sizeof(HHJobDeque));
+
+  SDL_Thread* thieves[TEST_DEQUE_THIEF_COUNT] = {0};
+  for (uint thief_i = 0; thief_i < TEST_DEQUE_THIEF_COUNT; ++thief_i) {
+    thieves[thief_i] = SDL_CreateThread(test_thief_thread, "hh-test-thief", &steal_data);
+    TEST_CHECK(thieves[thief_i] != NULL);
+  }
+
+  HHJob job = {0};
+  for (uint job_i = 0; job_i < TEST_DEQUE_JOB_COUNT; ++job_i) {
+    HHJob pushed_job = test_make_job(job_i);
+    while (!hh_job_deque_push(steal_data.deque, &pushed_job)) {
+      if (hh_job_deque_pop(steal_data.deque, &job)) {
+        atomic_fetch_add(&steal_data.run_counts[(uintptr_t)job.data], 1);
+      }
+    }
+    // NOTE(Ryan): Popping nearly every push keeps the deque at a job or two, so pops race thieves for the last one
+    if (job_i % 8 != 0 && hh_job_deque_pop(steal_data.deque, &job)) {
+      atomic_fetch_add(&steal_data.run_counts[(uintptr_t)job.data], 1);
+    }
+  }
+  while (hh_job_deque_pop(steal_data.deque, &job)) {
+    atomic_fetch_add(&steal_data.run_counts[(uintptr_t)job.data], 1);
+  }
+  atomic_store(&steal_data.is_done, true);
+  for (uint thief_i = 0; thief_i < TEST_DEQUE_THIEF_COUNT; ++thief_i) {
+    if (thieves[thief_i] != NULL) {
+      SDL_WaitThread(thieves[thief_i], NULL);
+    }
+  }
+
+  uint wrong_count = 0;
+  for (uint job_i = 0; job_i < TEST_DEQUE_JOB_COUNT; ++job_i) {
+    wrong_count += (atomic_load(&steal_data.run_counts[job_i]) != 1);
+  }
+  TEST_CHECK(wrong_count == 0);
+
+  free(steal_data.deque);
+  free((void *)steal_data.run_counts);
+}
+
+typedef struct {
+  HHJobQueue* queue;
+  _Atomic u32 leaf_count;
+  _Atomic u32 parent_count;
+} TestJobTree;
+
+INTERNAL void
+test_leaf_job(void* data)
+{
+  TestJobTree* tree = (TestJobTree *)data;
+  atomic_fetch_add(&tree->leaf_count, 1);
+}
+
+// NOTE(Ryan): Waits on its own sub-jobs from inside a job, as the render group's tiles do
+INTERNAL void
+test_parent_job(void* data)
+{
+  TestJobTree* tree = (TestJobTree *)data;
+  HHJobCounter counter = {0};
+  for (uint child_i = 0; child_i < 8; ++child_i) {
+    platform_add_job(tree->queue, test_leaf_job, tree, &counter);
+  }
+  platform_wait_for_jobs(tree->queue, &counter);
+  atomic_fetch_add(&tree->parent_count, 1);
+}
+
+INTERNAL void
+test_job_queue(void)
+{
+  uint thread_counts[] = {1, 2, 4, 8};
+  for (uint count_i = 0; count_i < ARRAY_SIZE(thread_counts); ++count_i) {
+    TestJobTree tree = {0};
+    tree.queue = sdl_create_job_queue(thread_counts[count_i]);
+    if (tree.queue == NULL) {
+      TEST_CHECK(!"create job queue");
+      continue;
+    }
+    TEST_CHECK(platform_get_thread_index() == 0);
+
+    for (uint frame_i = 0; frame_i < 50; ++frame_i) {
+      HHJobCounter counter = {0};
+      for (uint job_i = 0; job_i < 64; ++job_i) {
+        platform_add_job(tree.queue, (job_i & 1) ? test_parent_job : test_leaf_job, &tree, &counter);
+      }
+      platform_wait_for_jobs(tree.queue, &counter);
+      TEST_CHECK(atomic_load(&counter.pending) == 0);
+    }
+    TEST_CHECK(atomic_load(&tree.parent_count) == 50 * 32);
+    TEST_CHECK(atomic_load(&tree.leaf_count) == 50 * (32 + 32 * 8));
+
+    // NOTE(Ryan): More than a deque holds, so the overflow runs inline on the adding thread
+    HHJobCounter flood_counter = {0};
+    atomic_store(&tree.leaf_count, 0);
+    for (uint job_i = 0; job_i < 3 * HH_JOB_DEQUE_CAPACITY; ++job_i) {
+      platform_add_job(tree.queue, test_leaf_job, &tree, &flood_counter);
+    }
+    platform_wait_for_jobs(tree.queue, &flood_counter);
+    TEST_CHECK(atomic_load(&tree.leaf_count) == 3 * HH_JOB_DEQUE_CAPACITY);
+
+    sdl_destroy_job_queue(tree.queue);
+  }
+}
+
+typedef struct {
+  u8* block;
+  uint writer_index;
+} TestReplayWriter;
+
+// NOTE(Ryan): Writers share every page, so several fault on the same page at once
+INTERNAL int
+test_replay_writer_thread(void* data)
+{
+  TestReplayWriter* writer = (TestReplayWriter *)data;
+  for (u64 byte_i = writer->writer_index * 64; byte_i < TEST_REPLAY_BLOCK_SIZE; byte_i += TEST_REPLAY_WRITER_COUNT * 64) {
+    writer->block[byte_i] = (u8)(0xa0 + writer->writer_index);
+  }
+  return 0;
+}
+
+INTERNAL void
+test_replay_scribble(u8* block, u8 value)
+{
+  for (u64 byte_i = 0; byte_i < TEST_REPLAY_BLOCK_SIZE; byte_i += 4093) {
+    block[byte_i] ^= value;
+  }
+  memset(block + MEGABYTES(5), value, MEGABYTES(1));
+  block[TEST_REPLAY_BLOCK_SIZE - 1] = value;
+}
+
+INTERNAL void
+test_replay(void)
+{
+  char base_path[512] = {0};
+  test_get_file_name(base_path, sizeof(base_path), "");
+
+  u8* block = sdl_reserve_memory_block(TEST_REPLAY_BLOCK_SIZE, NULL);
+  u8* first_expected = malloc(TEST_REPLAY_BLOCK_SIZE);
+  u8* second_expected = malloc(TEST_REPLAY_BLOCK_SIZE);
+  if (block == NULL || first_expected == NULL || second_expected == NULL) {
+    TEST_CHECK(!"allocation");
+    free(first_expected);
+    free(second_expected);
+    return;
+  }
+#if defined(LINUX)
+  struct sigaction prev_segv_action = {0};
+  sigaction(SIGSEGV, NULL, &prev_segv_action);
+#endif
+  if (sdl_init_replay_buffers(block, TEST_REPLAY_BLOCK_SIZE, base_path) == FAILED) {
+    TEST_CHECK(!"init replay buffers");
+    free(first_expected);
+    free(second_expected);
+    return;
+  }
+
+  for (u64 byte_i = 0; byte_i < MEGABYTES(1); ++byte_i) {
+    block[byte_i] = (u8)byte_i;
+  }
+  memcpy(first_expected, block, TEST_REPLAY_BLOCK_SIZE);
+  TEST_CHECK(sdl_take_replay_snapshot(2) == SUCCEEDED);
+
+  // NOTE(Ryan): Restoring repeatedly must catch the pages written since the previous restore too
+  for (uint restore_i = 0; restore_i < 3; ++restore_i) {
+    test_replay_scribble(block, (u8)(0x5a + restore_i));
+    sdl_restore_replay_snapshot(2);
+    TEST_CHECK(memcmp(block, first_expected, TEST_REPLAY_BLOCK_SIZE) == 0);
+  }
+
+  // NOTE(Ryan): A second live snapshot. Restoring 2 straight away rewrites pages 5 has not saved yet, so the
+  // restore itself has to save them first.
+  test_replay_scribble(block, 0x11);
+  memcpy(second_expected, block, TEST_REPLAY_BLOCK_SIZE);
+  TEST_CHECK(sdl_take_replay_snapshot(5) == SUCCEEDED);
+  sdl_restore_replay_snapshot(2);
+  TEST_CHECK(memcmp(block, first_expected, TEST_REPLAY_BLOCK_SIZE) == 0);
+  sdl_restore_replay_snapshot(5);
+  TEST_CHECK(memcmp(block, second_expected, TEST_REPLAY_BLOCK_SIZE) == 0);
+  test_replay_scribble(block, 0x22);
+  sdl_restore_replay_snapshot(2);
+  TEST_CHECK(memcmp(block, first_expected, TEST_REPLAY_BLOCK_SIZE) == 0);
+  sdl_restore_replay_snapshot(5);
+  TEST_CHECK(memcmp(block, second_expected, TEST_REPLAY_BLOCK_SIZE) == 0);
+
+  // NOTE(Ryan): Faults from several threads at once, as job queue workers take them
+  SDL_Thread* writer_threads[TEST_REPLAY_WRITER_COUNT] = {0};
+  TestReplayWriter writers[TEST_REPLAY_WRITER_COUNT] = {0};
+  for (uint writer_i = 0; writer_i < TEST_REPLAY_WRITER_COUNT; ++writer_i) {
+    writers[writer_i].block = block;
+    writers[writer_i].writer_index = writer_i;
+    writer_threads[writer_i] = SDL_CreateThread(test_replay_writer_thread, "hh-test-writer", &writers[writer_i]);
+    TEST_CHECK(writer_threads[writer_i] != NULL);
+  }
+  for (uint writer_i = 0; writer_i < TEST_REPLAY_WRITER_COUNT; ++writer_i) {
+    if (writer_threads[writer_i] != NULL) {
+      SDL_WaitThread(writer_threads[writer_i], NULL);
+    }
+  }
+  TEST_CHECK(block[64] == 0xa1);
+  sdl_restore_replay_snapshot(5);
+  TEST_CHECK(memcmp(block, second_expected, TEST_REPLAY_BLOCK_SIZE) == 0);
+  sdl_restore_replay_snapshot(2);
+  TEST_CHECK(memcmp(block, first_expected, TEST_REPLAY_BLOCK_SIZE) == 0);
+
+  // NOTE(Ryan): Release forgets the file names, and the mappings outlive the unlink
+  for (uint replay_i = 0; replay_i < NUM_REPLAY_BUFFERS; ++replay_i) {
+    remove(sdl_replay_state.buffers[replay_i].snapshot_file_name);
+  }
+  sdl_release_replay_buffers();
+#if defined(LINUX)
+  // NOTE(Ryan): Whatever was there before comes back, which under a sanitizer is not SIG_DFL
+  struct sigaction segv_action = {0};
+  sigaction(SIGSEGV, NULL, &segv_action);
+  TEST_CHECK(segv_action.sa_handler == prev_segv_action.sa_handler);
+#endif
+
+  // NOTE(Ryan): Left read-only by the barrier and never written again, so it is simply leaked
+  free(first_expected);
+  free(second_expected);
+}
+
+// NOTE(Ryan): Bitmap i is a square of side sizes[i], each pixel (i << 24 | pixel index), so a payload copied
+// into the wrong place or from the wrong offset shows up
+INTERNAL STATUS
+test_write_asset_pack(char const* file_name, u32 const* sizes, u32 asset_count)
+{
+  HHAssetEntry* entries = calloc(asset_count, sizeof(HHAssetEntry));
+  if (entries == NULL) {
+    return FAILED;
+  }
+  u64 payload_offset = sizeof(HHAssetPackHeader) + asset_count * sizeof(HHAssetEntry);
+  for (u32 asset_i = 0; asset_i < asset_count; ++asset_i) {
+    HHAssetEntry* entry = &entries[asset_i];
+    snprintf(entry->name, sizeof(entry->name), "test-bitmap-%u", asset_i);
+    entry->name_hash = hh_hash_asset_name(entry->name);
+    entry->type = HH_ASSET_TYPE_BITMAP;
+    entry->bitmap.width = entry->bitmap.height = sizes[asset_i];
+    entry->bitmap.pitch = sizes[asset_i] * BYTES_PER_PIXEL;
+    entry->payload_size = (u64)entry->bitmap.pitch * entry->bitmap.height;
+    payload_offset = (payload_offset + HH_ASSET_PAYLOAD_ALIGNMENT - 1) & ~(u64)(HH_ASSET_PAYLOAD_ALIGNMENT - 1);
+    entry->payload_offset = payload_offset;
+    payload_offset += entry->payload_size;
+  }
+  // NOTE(Ryan): The loader binary searches on the hash, so the table goes out in hash order
+  for (u32 asset_i = 1; asset_i < asset_count; ++asset_i) {
+    for (u32 other_i = asset_i; other_i > 0 && entries[other_i - 1].name_hash > entries[other_i].name_hash; --other_i) {
+      HHAssetEntry swapped_entry = entries[other_i];
+      entries[other_i] = entries[other_i - 1];
+      entries[other_i - 1] = swapped_entry;
+    }
+  }
+
+  HHAssetPackHeader header = {.magic = HH_ASSET_PACK_MAGIC, .version = HH_ASSET_PACK_VERSION,
+                              .asset_count = asset_count, .file_size = payload_offset};
+  FILE* file = fopen(file_name, "wb");
+  bool has_written = (file != NULL) && fwrite(&header, sizeof(header), 1, file) == 1 &&
+                     fwrite(entries, sizeof(HHAssetEntry), asset_count, file) == asset_count;
+  for (u32 asset_i = 0; has_written && asset_i < asset_count; ++asset_i) {
+    HHAssetEntry* entry = &entries[asset_i];
+    u32 asset_index = (u32)strtoul(entry->name + strlen("test-bitmap-"), NULL, 10);
+    has_written = (fseek(file, (long)entry->payload_offset, SEEK_SET) == 0);
+    for (u64 pixel_i = 0; has_written && pixel_i < entry->payload_size / BYTES_PER_PIXEL; ++pixel_i) {
+      u32 pixel = (asset_index << 24) | (u32)pixel_i;
+      has_written = (fwrite(&pixel, sizeof(pixel), 1, file) == 1);
+    }
+  }
+  if (file != NULL && fclose(file) != 0) {
+    has_written = false;
+  }
+  free(entries);
+
+  return has_written ? SUCCEEDED : FAILED;
+}
+
+// NOTE(Ryan): Every block accounted for, used bytes matching the used blocks, no two free neighbours unmerged
+INTERNAL bool
+test_is_asset_cache_consistent(HHAssetCache* cache)
+{
+  u64 total_size = 0;
+  u64 used_size = 0;
+  for (HHAssetBlock* block = cache->sentinel.next; block != &cache->sentinel; block = block->next) {
+    total_size += block->size;
+    used_size += block->is_used ? block->size : 0;
+    if (!block->is_used && block->next != &cache->sentinel && !block->next->is_used) {
+      return false;
+    }
+  }
+  return total_size == cache->budget && used_size == cache->used_bytes && cache->used_bytes <= cache->budget;
+}
+
+// NOTE(Ryan): Runs frames until the bitmap arrives, checking its pixels against the pack
+INTERNAL bool
+test_load_bitmap(HHAssetCache* cache, u32 asset_id, HHBitmap* bitmap)
+{
+  for (uint frame_i = 0; frame_i < TEST_ASSET_CACHE_MAX_FRAMES; ++frame_i) {
+    hh_update_asset_cache(cache);
+    if (hh_request_bitmap(cache, asset_id, HH_ASSET_PRIORITY_NORMAL, bitmap)) {
+      HHAssetEntry const* entry = &cache->pack->entries[asset_id];
+      return memcmp(bitmap->pixels, hh_get_asset_payload(cache->pack, entry), entry->payload_size) == 0 &&
+             ((uintptr_t)bitmap->pixels % HH_ASSET_PAYLOAD_ALIGNMENT) == 0;
+    }
+    SDL_Delay(1);
+  }
+  return false;
+}
+
+INTERNAL void
+test_asset_cache(void)
+{
+  char file_name[512] = {0};
+  test_get_file_name(file_name, sizeof(file_name), "assets.hha");
+  // NOTE(Ryan): Four that fit three at a time, then one bigger than the whole budget
+  u32 sizes[] = {32, 32, 32, 32, 128};
+  if (test_write_asset_pack(file_name, sizes, ARRAY_SIZE(sizes)) == FAILED) {
+    TEST_CHECK(!"write asset pack");
+    remove(file_name);
+    return;
+  }
+
+  HHAssetPack pack = {0};
+  HHMemory memory = {0};
+  TEST_CHECK(sdl_open_asset_pack(&pack, file_name) == SUCCEEDED);
+  memory.asset_pack = &pack;
+  memory.asset_stream = sdl_create_asset_stream(&pack, file_name);
+  memory.platform_begin_asset_read = platform_begin_asset_read;
+  TEST_CHECK(memory.asset_stream != NULL);
+
+  size_t arena_size = MEGABYTES(1);
+  void* arena_base = aligned_alloc(HH_ASSET_CACHE_ALIGNMENT, arena_size);
+  HHAssetCache* cache = malloc(sizeof(HHAssetCache));
+  if (memory.asset_stream == NULL || arena_base == NULL || cache == NULL) {
+    TEST_CHECK(!"allocation");
+    goto __TEST_ASSET_CACHE_CLEANUP__;
+  }
+  HHMemoryArena arena = {0};
+  hh_arena_init(&arena, "test-assets", arena_base, arena_size);
+  u64 block_size = hh_asset_cache_block_size(32 * 32 * BYTES_PER_PIXEL);
+  TEST_CHECK(hh_init_asset_cache(cache, &memory, &arena, 3 * block_size));
+  TEST_CHECK(cache->budget == 3 * block_size);
+
+  u32 asset_ids[ARRAY_SIZE(sizes)] = {0};
+  for (u32 asset_i = 0; asset_i < ARRAY_SIZE(sizes); ++asset_i) {
+    char name[HH_ASSET_NAME_LENGTH] = {0};
+    snprintf(name, sizeof(name), "test-bitmap-%u", asset_i);
+    asset_ids[asset_i] = hh_get_asset_id(&pack, name);
+    TEST_CHECK(asset_ids[asset_i] != HH_ASSET_ID_NONE);
+  }
+
+  HHBitmap bitmap = {0};
+  for (u32 asset_i = 0; asset_i < 3; ++asset_i) {
+    TEST_CHECK(test_load_bitmap(cache, asset_ids[asset_i], &bitmap));
+  }
+  TEST_CHECK(cache->used_bytes == cache->budget);
+  TEST_CHECK(cache->stats.eviction_count == 0);
+  TEST_CHECK(test_is_asset_cache_consistent(cache));
+
+  // NOTE(Ryan): Touching 0 leaves 1 least recently used, so loading 3 must evict 1 and nothing else
+  hh_update_asset_cache(cache);
+  TEST_CHECK(hh_request_bitmap(cache, asset_ids[0], HH_ASSET_PRIORITY_NORMAL, &bitmap));
+  TEST_CHECK(test_load_bitmap(cache, asset_ids[3], &bitmap));
+  TEST_CHECK(cache->stats.eviction_count == 1);
+  TEST_CHECK(cache->assets[asset_ids[1]].state == HH_ASSET_STATE_UNLOADED);
+  TEST_CHECK(cache->assets[asset_ids[0]].state == HH_ASSET_STATE_LOADED);
+  TEST_CHECK(cache->assets[asset_ids[2]].state == HH_ASSET_STATE_LOADED);
+  TEST_CHECK(test_is_asset_cache_consistent(cache));
+
+  // NOTE(Ryan): The oversized asset is failed without evicting anything, and without blocking the
+  // lower priority request queued behind it
+  hh_update_asset_cache(cache);
+  TEST_CHECK(!hh_request_bitmap(cache, asset_ids[4], HH_ASSET_PRIORITY_HIGH, &bitmap));
+  TEST_CHECK(!hh_request_bitmap(cache, asset_ids[1], HH_ASSET_PRIORITY_LOW, &bitmap));
+  u64 eviction_count = cache->stats.eviction_count;
+  hh_update_asset_cache(cache);
+  TEST_CHECK(cache->stats.failed_load_count == 1);
+  TEST_CHECK(cache->assets[asset_ids[4]].state == HH_ASSET_STATE_UNLOADED);
+  TEST_CHECK(cache->stats.eviction_count == eviction_count + 1);
+  TEST_CHECK(test_load_bitmap(cache, asset_ids[1], &bitmap));
+  TEST_CHECK(test_is_asset_cache_consistent(cache));
+
+  // NOTE(Ryan): Asking again retries, and fails again the same way
+  TEST_CHECK(!hh_request_bitmap(cache, asset_ids[4], HH_ASSET_PRIORITY_NORMAL, &bitmap));
+  hh_update_asset_cache(cache);
+  TEST_CHECK(cache->stats.failed_load_count == 2);
+
+  // NOTE(Ryan): Cycling through more than fits keeps the accounting straight and every pixel right
+  u32 random_state = 7;
+  for (uint request_i = 0; request_i < 200; ++request_i) {
+    u32 asset_i = test_random(&random_state) % 4;
+    if (!test_load_bitmap(cache, asset_ids[asset_i], &bitmap)) {
+      TEST_CHECK(!"load while cycling");
+      break;
+    }
+    TEST_CHECK(test_is_asset_cache_consistent(cache));
+  }
+  TEST_CHECK(cache->stats.failed_load_count == 2);
+
+__TEST_ASSET_CACHE_CLEANUP__:
+  if (memory.asset_stream != NULL) {
+    sdl_destroy_asset_stream(memory.asset_stream);
+  }
+  sdl_close_asset_pack(&pack);
+  free(cache);
+  free(arena_base);
+  remove(file_name);
+}
+
+int
+main(int argc, char* argv[argc + 1])
+{
+  TestOptions options = {0};
+  for (int arg_i = 1; arg_i < argc; ++arg_i) {
+    if (strcmp(argv[arg_i], "--filter") == 0 && arg_i + 1 < argc) {
+      options.filter = argv[++arg_i];
+    } else {
+      fprintf(stderr, "usage: %s [--filter substring]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (SDL_Init(0) < 0) {
+    SDL_LogCritical("Unable to initialize SDL: %s", SDL_GetError());
+    return EXIT_FAILURE;
+  }
+  sdl_get_info();
+
+  test_run(&options, "input-stream/round-trip-and-seek", test_input_stream);
+  test_run(&options, "jobs/deque-order", test_job_deque_order);
+  test_run(&options, "jobs/deque-steal", test_job_deque_steal);
+  test_run(&options, "jobs/queue", test_job_queue);
+  test_run(&options, "replay/write-barrier", test_replay);
+  test_run(&options, "assets/cache-eviction", test_asset_cache);
+
+  SDL_Quit();
+  return (int)options.failed_test_count;
+}
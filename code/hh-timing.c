@@ -0,0 +1,107 @@
+// NOTE(Ryan): Frame pacing on the performance counter.
+// Each frame has a fixed boundary, target_frame_ticks after the previous one. After the frame's work, the
+// thread sleeps coarsely until just before the boundary and spins on the counter for the remainder. The
+// margin left for the spin tracks how far sleeps have recently overshot, so it adapts to the scheduler
+// rather than relying on a fixed guess. A frame that finishes after its boundary counts as missed, and the
+// next boundary is realigned to the frame grid rather than to 'now', so a late frame causes no drift.
+
+#if defined(LINUX)
+  #include <time.h>
+#endif
+
+typedef struct {
+  u64 counter_frequency;
+  u64 target_frame_ticks;
+  u64 frame_boundary;
+  u64 last_frame_start;
+  u64 work_ticks;
+  // NOTE(Ryan): Current estimate of the worst sleep overshoot, i.e. how early to stop sleeping and spin
+  u64 sleep_margin_ticks;
+  u64 missed_frame_count;
+  float frame_dt;
+} SDLFrameTimer;
+
+INTERNAL void
+sdl_sleep_ticks(SDLFrameTimer* frame_timer, u64 ticks)
+{
+#if defined(LINUX)
+  u64 nanoseconds = (ticks * 1000000000ULL) / frame_timer->counter_frequency;
+  struct timespec sleep_time = {.tv_sec = nanoseconds / 1000000000ULL, .tv_nsec = nanoseconds % 1000000000ULL};
+  while (nanosleep(&sleep_time, &sleep_time) < 0 && errno == EINTR) {}
+#else
+  SDL_Delay((u32)((ticks * 1000) / frame_timer->counter_frequency));
+#endif
+}
+
+INTERNAL void
+sdl_set_frame_timer_rate(SDLFrameTimer* frame_timer, uint frames_per_second)
+{
+  frame_timer->target_frame_ticks = frame_timer->counter_frequency / frames_per_second;
+  frame_timer->frame_dt = 1.0f / frames_per_second;
+}
+
+INTERNAL void
+sdl_init_frame_timer(SDLFrameTimer* frame_timer, uint frames_per_second)
+{
+  frame_timer->counter_frequency = SDL_GetPerformanceFrequency();
+  sdl_set_frame_timer_rate(frame_timer, frames_per_second);
+
+  // NOTE(Ryan): Seed the margin with the worst of a few short sleeps; it is refined every frame after this
+  u64 requested_ticks = frame_timer->counter_frequency / 2000;
+  for (uint calibration_i = 0; calibration_i < 8; ++calibration_i) {
+    u64 sleep_start = SDL_GetPerformanceCounter();
+    sdl_sleep_ticks(frame_timer, requested_ticks);
+    u64 slept_ticks = SDL_GetPerformanceCounter() - sleep_start;
+    if (slept_ticks > requested_ticks && slept_ticks - requested_ticks > frame_timer->sleep_margin_ticks) {
+      frame_timer->sleep_margin_ticks = slept_ticks - requested_ticks;
+    }
+  }
+
+  frame_timer->last_frame_start = SDL_GetPerformanceCounter();
+  frame_timer->frame_boundary = frame_timer->last_frame_start + frame_timer->target_frame_ticks;
+}
+
+// NOTE(Ryan): Call once the frame's work is done. Returns at the frame boundary and updates frame_dt to
+// the measured length of the frame that just ended.
+INTERNAL void
+sdl_wait_for_frame_boundary(SDLFrameTimer* frame_timer)
+{
+  u64 now = SDL_GetPerformanceCounter();
+  frame_timer->work_ticks = now - frame_timer->last_frame_start;
+
+  if (now >= frame_timer->frame_boundary) {
+    u64 boundaries_missed = (now - frame_timer->frame_boundary) / frame_timer->target_frame_ticks + 1;
+    frame_timer->missed_frame_count += boundaries_missed;
+    // NOTE(Ryan): Start the next frame immediately, ending on the first boundary still ahead of us
+    frame_timer->frame_boundary += boundaries_missed * frame_timer->target_frame_ticks;
+#if defined(DEBUG)
+    SDL_LogDebug("Missed %llu frame(s): work took %.3fms", (unsigned long long)boundaries_missed,
+                 (1000.0 * frame_timer->work_ticks) / frame_timer->counter_frequency);
+#endif
+  } else {
+    u64 remaining_ticks = frame_timer->frame_boundary - now;
+    if (remaining_ticks > frame_timer->sleep_margin_ticks) {
+      u64 requested_ticks = remaining_ticks - frame_timer->sleep_margin_ticks;
+      u64 sleep_start = now;
+      sdl_sleep_ticks(frame_timer, requested_ticks);
+      now = SDL_GetPerformanceCounter();
+
+      u64 overshoot_ticks = (now - sleep_start > requested_ticks) ? (now - sleep_start) - requested_ticks : 0;
+      if (overshoot_ticks > frame_timer->sleep_margin_ticks) {
+        frame_timer->sleep_margin_ticks = overshoot_ticks;
+      } else {
+        // NOTE(Ryan): Decay slowly, so one lucky sleep does not shrink the margin into a missed frame
+        frame_timer->sleep_margin_ticks -= (frame_timer->sleep_margin_ticks - overshoot_ticks) / 64;
+      }
+    }
+
+    while (SDL_GetPerformanceCounter() < frame_timer->frame_boundary) {
+      SDL_CPUPauseInstruction();
+    }
+    frame_timer->frame_boundary += frame_timer->target_frame_ticks;
+  }
+
+  now = SDL_GetPerformanceCounter();
+  frame_timer->frame_dt = (float)(now - frame_timer->last_frame_start) / frame_timer->counter_frequency;
+  frame_timer->last_frame_start = now;
+}
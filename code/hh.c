@@ -1,16 +1,326 @@
 #include "hh.h"
+#include "hh-arena.c"
 
-void 
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>
+  #define HH_X86 1
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define HH_NEON 1
+#endif
+
+#include "hh-mixer.c"
+#include "hh-assets.c"
+#include "hh-asset-cache.c"
+#include "hh-render.c"
+#include "hh-render-group.c"
+
+// NOTE(Ryan): A row kernel fills 'width' pixels of a single row, where pixel x is
+// ((x + green_offset) << 8 | blue_value). All kernels must produce identical output to the scalar one.
+typedef void (HHRenderGradientRow)(u32* restrict pixel, uint width, u32 green_offset, u32 blue_value);
+
+INTERNAL void
+hh_render_gradient_row_scalar(u32* restrict pixel, uint width, u32 green_offset, u32 blue_value)
+{
+  for (uint x = 0; x < width; ++x) {
+    u32 green_value = x + green_offset;
+    *pixel++ = (green_value << 8 | blue_value);
+  }
+}
+
+#if defined(HH_X86)
+// NOTE(Ryan): Target attributes allow the wider kernels to be compiled without raising the baseline ISA.
+// They are only ever called after the platform has confirmed support.
+__attribute__((target("sse2"))) INTERNAL void
+hh_render_gradient_row_sse2(u32* restrict pixel, uint width, u32 green_offset, u32 blue_value)
+{
+  __m128i green = _mm_add_epi32(_mm_set1_epi32(green_offset), _mm_setr_epi32(0, 1, 2, 3));
+  __m128i blue = _mm_set1_epi32(blue_value);
+  __m128i four = _mm_set1_epi32(4);
+
+  uint x = 0;
+  for (; x + 4 <= width; x += 4) {
+    _mm_storeu_si128((__m128i *)(pixel + x), _mm_or_si128(_mm_slli_epi32(green, 8), blue));
+    green = _mm_add_epi32(green, four);
+  }
+
+  hh_render_gradient_row_scalar(pixel + x, width - x, green_offset + x, blue_value);
+}
+
+__attribute__((target("avx2"))) INTERNAL void
+hh_render_gradient_row_avx2(u32* restrict pixel, uint width, u32 green_offset, u32 blue_value)
+{
+  __m256i green_lo = _mm256_add_epi32(_mm256_set1_epi32(green_offset), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  __m256i green_hi = _mm256_add_epi32(green_lo, _mm256_set1_epi32(8));
+  __m256i blue = _mm256_set1_epi32(blue_value);
+  __m256i sixteen = _mm256_set1_epi32(16);
+
+  // NOTE(Ryan): Two independent 8-wide chains per iteration keep both store ports busy.
+  uint x = 0;
+  for (; x + 16 <= width; x += 16) {
+    _mm256_storeu_si256((__m256i *)(pixel + x), _mm256_or_si256(_mm256_slli_epi32(green_lo, 8), blue));
+    _mm256_storeu_si256((__m256i *)(pixel + x + 8), _mm256_or_si256(_mm256_slli_epi32(green_hi, 8), blue));
+    green_lo = _mm256_add_epi32(green_lo, sixteen);
+    green_hi = _mm256_add_epi32(green_hi, sixteen);
+  }
+
+  hh_render_gradient_row_scalar(pixel + x, width - x, green_offset + x, blue_value);
+}
+#endif
+
+#if defined(HH_NEON)
+INTERNAL void
+hh_render_gradient_row_neon(u32* restrict pixel, uint width, u32 green_offset, u32 blue_value)
+{
+  u32 const lane_offsets[4] = {0, 1, 2, 3};
+  uint32x4_t green = vaddq_u32(vdupq_n_u32(green_offset), vld1q_u32(lane_offsets));
+  uint32x4_t blue = vdupq_n_u32(blue_value);
+  uint32x4_t four = vdupq_n_u32(4);
+
+  uint x = 0;
+  for (; x + 4 <= width; x += 4) {
+    vst1q_u32(pixel + x, vorrq_u32(vshlq_n_u32(green, 8), blue));
+    green = vaddq_u32(green, four);
+  }
+
+  hh_render_gradient_row_scalar(pixel + x, width - x, green_offset + x, blue_value);
+}
+#endif
+
+GLOBAL HHRenderGradientRow* hh_render_gradient_row = hh_render_gradient_row_scalar;
+// NOTE(Ryan): Kernel pointers are per module, so a freshly loaded or reloaded module starts out scalar
+GLOBAL bool hh_are_render_kernels_selected;
+
+// NOTE(Ryan): Called by a platform that links the game directly; a loaded module selects its own through
+// hh_bind_render_kernels() instead.
+void
+hh_select_render_kernels(u32 cpu_features)
+{
+  hh_are_render_kernels_selected = true;
+  hh_select_mixer_kernels(cpu_features);
+  hh_select_blit_kernels(cpu_features);
+  hh_select_quad_kernels(cpu_features);
+
+  hh_render_gradient_row = hh_render_gradient_row_scalar;
+#if defined(HH_X86)
+  if (cpu_features & HH_CPU_FEATURE_SSE2) {
+    hh_render_gradient_row = hh_render_gradient_row_sse2;
+  }
+  if (cpu_features & HH_CPU_FEATURE_AVX2) {
+    hh_render_gradient_row = hh_render_gradient_row_avx2;
+  }
+#endif
+#if defined(HH_NEON)
+  if (cpu_features & HH_CPU_FEATURE_NEON) {
+    hh_render_gradient_row = hh_render_gradient_row_neon;
+  }
+#endif
+}
+
+// NOTE(Ryan): Game calls this at the top of each frame alongside hh_bind_profiler(); a flag test once selected
+INTERNAL void
+hh_bind_render_kernels(HHMemory* memory)
+{
+  if (!hh_are_render_kernels_selected) {
+    hh_select_render_kernels(memory->cpu_features);
+  }
+}
+
+void
 hh_render_gradient(HHPixelBuffer* restrict pixel_buffer, uint green_offset, uint blue_offset)
 {
   u8* row = (u8 *)pixel_buffer->memory;
   for (uint y = 0; y < pixel_buffer->height; ++y) {
-    u32* pixel = (u32 *)row;
-    for (uint x = 0; x < pixel_buffer->width; ++x) {
-      u32 green_value = x + green_offset;
-      u32 blue_value = y + blue_offset;
-      *pixel++ = (green_value << 8 | blue_value); 
-    }
+    u32 blue_value = y + blue_offset;
+    hh_render_gradient_row((u32 *)row, pixel_buffer->width, green_offset, blue_value);
     row += pixel_buffer->pitch;
   }
 }
+
+typedef struct {
+  HHPixelBuffer* pixel_buffer;
+  uint min_x;
+  uint min_y;
+  uint max_x;
+  uint max_y;
+  uint green_offset;
+  uint blue_offset;
+} HHRenderGradientTile;
+
+INTERNAL void
+hh_render_gradient_tile(void* data)
+{
+  TIMED_FUNCTION();
+  HHRenderGradientTile* tile = (HHRenderGradientTile *)data;
+  HHPixelBuffer* pixel_buffer = tile->pixel_buffer;
+
+  u8* row = (u8 *)pixel_buffer->memory + tile->min_y * pixel_buffer->pitch + tile->min_x * BYTES_PER_PIXEL;
+  for (uint y = tile->min_y; y < tile->max_y; ++y) {
+    u32 blue_value = y + tile->blue_offset;
+    hh_render_gradient_row((u32 *)row, tile->max_x - tile->min_x, tile->green_offset + tile->min_x, blue_value);
+    row += pixel_buffer->pitch;
+  }
+}
+
+void
+hh_render_gradient_tiled(HHMemory* memory, HHPixelBuffer* restrict pixel_buffer, uint green_offset, uint blue_offset)
+{
+  hh_bind_profiler(memory);
+  hh_bind_render_kernels(memory);
+  TIMED_FUNCTION();
+
+  if (memory->job_queue == NULL) {
+    hh_render_gradient(pixel_buffer, green_offset, blue_offset);
+    return;
+  }
+
+  HHRenderTiles render_tiles = hh_get_render_tiles(memory, pixel_buffer);
+  HHRenderGradientTile tiles[HH_MAX_RENDER_TILES];
+  HHJobCounter counter = {0};
+  uint tile_i = 0;
+  for (uint tile_y = 0; tile_y < render_tiles.tile_count_y; ++tile_y) {
+    for (uint tile_x = 0; tile_x < render_tiles.tile_count_x; ++tile_x) {
+      HHRenderGradientTile* tile = &tiles[tile_i++];
+      HHClipRect tile_rect = hh_get_render_tile_rect(&render_tiles, pixel_buffer, tile_x, tile_y);
+      tile->pixel_buffer = pixel_buffer;
+      tile->min_x = tile_rect.min_x;
+      tile->min_y = tile_rect.min_y;
+      tile->max_x = tile_rect.max_x;
+      tile->max_y = tile_rect.max_y;
+      tile->green_offset = green_offset;
+      tile->blue_offset = blue_offset;
+
+      memory->platform_add_job(memory->job_queue, hh_render_gradient_tile, tile, &counter);
+    }
+  }
+
+  memory->platform_wait_for_jobs(memory->job_queue, &counter);
+}
+
+// NOTE(Ryan): Lives at the start of permanent storage, so it survives hot reloads and is captured by replays.
+// Everything it points at is in the same memory block or in the platform's asset pack mapping.
+typedef struct {
+  HHMemoryArena permanent_arena;
+  HHMemoryArena asset_arena;
+  // NOTE(Ryan): Render group and mixer buffers, reset every frame through temporary memory scopes
+  HHMemoryArena frame_arena;
+
+  HHAssetCache asset_cache;
+  u32 hero_bitmap_id;
+  u32 music_sound_id;
+
+  HHMixer mixer;
+  // NOTE(Ryan): The mixer voice points here, so it must not move; refreshed from the cache every frame
+  HHSound music;
+  HHMixerVoiceHandle music_voice;
+
+  float hero_x;
+  float hero_y;
+  float hero_angle;
+} HHState;
+
+#define HH_ASSET_CACHE_BUDGET MEGABYTES(256)
+#define HH_RENDER_GROUP_SIZE MEGABYTES(4)
+#define HH_HERO_SPEED 400.0f
+
+INTERNAL void
+hh_init_state(HHState* state, HHMemory* memory)
+{
+  hh_arena_init(&state->permanent_arena, "permanent", (u8 *)memory->permanent_storage + sizeof(HHState),
+                memory->permanent_storage_size - sizeof(HHState));
+  hh_arena_init(&state->asset_arena, "asset", memory->transient_storage, HH_ASSET_CACHE_BUDGET);
+  hh_arena_init(&state->frame_arena, "frame", (u8 *)memory->transient_storage + HH_ASSET_CACHE_BUDGET,
+                memory->transient_storage_size - HH_ASSET_CACHE_BUDGET);
+
+  if (!hh_init_asset_cache(&state->asset_cache, memory, &state->asset_arena, HH_ASSET_CACHE_BUDGET)) {
+    // NOTE(Ryan): Nothing streams in, so requests keep coming back empty and the game draws without assets
+    memset(&state->asset_cache, 0, sizeof(state->asset_cache));
+  }
+  state->hero_bitmap_id = hh_get_asset_id(memory->asset_pack, "hero");
+  state->music_sound_id = hh_get_asset_id(memory->asset_pack, "music");
+
+  hh_init_mixer(&state->mixer, &state->permanent_arena);
+
+  state->hero_x = 100.0f;
+  state->hero_y = 100.0f;
+}
+
+// NOTE(Ryan): Starts the music once it has streamed in and stops it if it is ever not resident, as the voice
+// reads the samples straight out of the cache
+INTERNAL void
+hh_update_music(HHState* state, HHSoundBuffer* sound_buffer)
+{
+  HHSound music = {0};
+  bool is_resident = hh_request_sound(&state->asset_cache, state->music_sound_id, HH_ASSET_PRIORITY_HIGH, &music);
+  bool is_playing = (hh_mixer_get_voice(state->music_voice) != NULL);
+  if (is_resident) {
+    state->music = music;
+    if (!is_playing) {
+      state->music_voice = hh_mixer_play(&state->mixer, &state->music, 0.0f, 0.0f, true);
+      hh_mixer_set_voice_volume(state->music_voice, 0.5f, 0.0f, 1.0f, sound_buffer->samples_per_second);
+    }
+  } else if (is_playing) {
+    hh_mixer_stop(&state->mixer, state->music_voice);
+  }
+}
+
+void
+hh_update_and_render(HHPixelBuffer* pixel_buffer, HHInput* input, HHSoundBuffer* sound_buffer, HHMemory* memory)
+{
+  hh_bind_profiler(memory);
+  hh_bind_render_kernels(memory);
+  TIMED_FUNCTION();
+
+  HH_ASSERT(sizeof(HHState) <= memory->permanent_storage_size);
+  HHState* state = (HHState *)memory->permanent_storage;
+  if (!memory->is_initialized) {
+    hh_init_state(state, memory);
+    memory->is_initialized = true;
+  }
+
+  HHController* keyboard = &input->controllers[0];
+  float move_x = (float)hh_is_button_down(keyboard, HH_BUTTON_MOVE_RIGHT) - (float)hh_is_button_down(keyboard, HH_BUTTON_MOVE_LEFT);
+  float move_y = (float)hh_is_button_down(keyboard, HH_BUTTON_MOVE_DOWN) - (float)hh_is_button_down(keyboard, HH_BUTTON_MOVE_UP);
+  for (uint controller_i = 1; controller_i < NUM_GAME_CONTROLLERS_SUPPORTED + 1; ++controller_i) {
+    HHController* controller = &input->controllers[controller_i];
+    if (controller->is_connected && controller->is_analog) {
+      move_x += controller->stick_x;
+      move_y += controller->stick_y;
+    }
+  }
+  state->hero_x += move_x * HH_HERO_SPEED * input->frame_dt;
+  state->hero_y += move_y * HH_HERO_SPEED * input->frame_dt;
+  state->hero_angle += input->frame_dt;
+
+  hh_update_asset_cache(&state->asset_cache);
+  hh_update_music(state, sound_buffer);
+
+  HHTemporaryMemory render_memory = hh_begin_temporary_memory(&state->frame_arena);
+  HHRenderGroup group = {0};
+  hh_begin_render_group(&group, &state->frame_arena, HH_RENDER_GROUP_SIZE);
+  hh_push_clear(&group, 0, 0xFF202020);
+  hh_push_rectangle(&group, 1, state->hero_x - 40.0f, state->hero_y - 40.0f, state->hero_x + 40.0f,
+                    state->hero_y + 40.0f, 0xFF3060C0);
+
+  HHBitmap hero = {0};
+  if (hh_request_bitmap(&state->asset_cache, state->hero_bitmap_id, HH_ASSET_PRIORITY_NORMAL, &hero)) {
+    hh_push_bitmap(&group, 2, &hero, state->hero_x - hero.width * 0.5f, state->hero_y - hero.height * 0.5f, 1.0f);
+
+    float centre_x = pixel_buffer->width * 0.5f;
+    float centre_y = pixel_buffer->height * 0.5f;
+    float x_axis_x = cosf(state->hero_angle) * hero.width;
+    float x_axis_y = sinf(state->hero_angle) * hero.width;
+    float y_axis_x = -sinf(state->hero_angle) * hero.height;
+    float y_axis_y = cosf(state->hero_angle) * hero.height;
+    hh_push_quad(&group, 2, &hero, centre_x - 0.5f * (x_axis_x + y_axis_x), centre_y - 0.5f * (x_axis_y + y_axis_y),
+                 x_axis_x, x_axis_y, y_axis_x, y_axis_y, 0.75f);
+  }
+  hh_render_group_to_output(memory, &group, pixel_buffer);
+  hh_end_temporary_memory(render_memory);
+
+  hh_mixer_output(&state->mixer, &state->frame_arena, sound_buffer);
+
+  hh_arena_check(&state->frame_arena);
+  hh_arena_check(&state->permanent_arena);
+}
@@ -10,9 +10,21 @@
 #include <SDL2/SDL_opengl.h>
 #include <stddef.h>
 
+#if defined(LINUX)
+  #include <sys/mman.h>
+#endif
+
 #include "hh-platform.h"
 #include "hh-opengl.c"
-#include "hh-common.c"
+#include "hh-jobs.c"
+#include "hh-profiler.c"
+#include "hh-input-stream.c"
+#include "hh-replay.c"
+#include "hh-reload.c"
+#include "hh-timing.c"
+#include "hh-audio.c"
+#include "hh-asset-pack.c"
+#include "hh-asset-stream.c"
 
 #define INT32_MIN_VALUE -2147483648
 #define UNUSED_SDL_INSTANCE_JOYSTICK_ID INT32_MIN_VALUE
@@ -21,32 +33,18 @@ typedef struct {
   SDL_JoystickID instance_joystick_id;
   SDL_GameController* controller;
   SDL_Haptic* haptic;
+  // NOTE(Ryan): -1 when the device has no left/right effect and rumble goes through SDL_HapticRumblePlay
+  int rumble_effect_id;
+  SDL_HapticEffect rumble_effect;
 } SDLGameController;
 
 GLOBAL SDLGameController sdl_game_controllers[NUM_GAME_CONTROLLERS_SUPPORTED] = {0};
 
-INTERNAL void
-sdl_find_game_controllers(void)
-{
-  int num_joysticks = SDL_NumJoysticks(); 
-
-  for (int joystick_i = 0; joystick_i < num_joysticks; ++joystick_i) {
-    if (sdl_game_controllers[NUM_GAME_CONTROLLERS_SUPPORTED - 1].controller != NULL) {
-      break; 
-    }
-    if (!SDL_IsGameController(joystick_i)) {
-      continue; 
-    }
-
-    sdl_open_game_controller(joystick_i);
-  }
-}
-
 INTERNAL void
 sdl_open_game_controller(int device_joystick_id) 
 {
   for (uint controller_i = 0; controller_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++controller_i) {
-    if (sdl_game_controllers[controller_i].controller != NULL) {
+    if (sdl_game_controllers[controller_i].controller == NULL) {
       sdl_game_controllers[controller_i].controller = SDL_GameControllerOpen(device_joystick_id);
       if (sdl_game_controllers[controller_i].controller == NULL) {
         SDL_LogWarn("Unable to open SDL game controller: %s", SDL_GetError());
@@ -57,21 +55,50 @@ sdl_open_game_controller(int device_joystick_id)
 
       sdl_game_controllers[controller_i].instance_joystick_id = SDL_JoystickInstanceID(joystick);
 
+      sdl_game_controllers[controller_i].rumble_effect_id = -1;
       sdl_game_controllers[controller_i].haptic = SDL_HapticOpenFromJoystick(joystick);
       if (sdl_game_controllers[controller_i].haptic == NULL) {
         SDL_LogWarn("Unable to open SDL haptic from SDL game controller: %s", SDL_GetError());
-      } else {
+      } else if (SDL_HapticQuery(sdl_game_controllers[controller_i].haptic) & SDL_HAPTIC_LEFTRIGHT) {
+        // NOTE(Ryan): Created once here; later requests only update it when the parameters change
+        SDL_HapticEffect* rumble_effect = &sdl_game_controllers[controller_i].rumble_effect;
+        memset(rumble_effect, 0, sizeof(*rumble_effect));
+        rumble_effect->type = SDL_HAPTIC_LEFTRIGHT;
+        sdl_game_controllers[controller_i].rumble_effect_id = SDL_HapticNewEffect(sdl_game_controllers[controller_i].haptic, rumble_effect);
+        if (sdl_game_controllers[controller_i].rumble_effect_id < 0) {
+          SDL_LogWarn("Unable to create rumble effect from SDL haptic: %s", SDL_GetError());
+        }
+      }
+      if (sdl_game_controllers[controller_i].haptic != NULL && sdl_game_controllers[controller_i].rumble_effect_id < 0) {
         if (SDL_HapticRumbleInit(sdl_game_controllers[controller_i].haptic) < 0) {
           SDL_LogWarn("Unable to initialize rumble from SDL haptic: %s", SDL_GetError());
           SDL_HapticClose(sdl_game_controllers[controller_i].haptic);
           sdl_game_controllers[controller_i].haptic = NULL;
         }
       }
+      return;
     } 
   }
 }
 
 
+INTERNAL void
+sdl_find_game_controllers(void)
+{
+  int num_joysticks = SDL_NumJoysticks(); 
+
+  for (int joystick_i = 0; joystick_i < num_joysticks; ++joystick_i) {
+    if (sdl_game_controllers[NUM_GAME_CONTROLLERS_SUPPORTED - 1].controller != NULL) {
+      break; 
+    }
+    if (!SDL_IsGameController(joystick_i)) {
+      continue; 
+    }
+
+    sdl_open_game_controller(joystick_i);
+  }
+}
+
 INTERNAL void
 sdl_close_game_controller(SDL_JoystickID instance_joystick_id) 
 {
@@ -90,72 +117,364 @@ sdl_close_game_controller(SDL_JoystickID instance_joystick_id)
   }
 }
 
+// NOTE(Ryan): Applies the frame's rumble requests. The left/right effect is only re-uploaded when a request
+// differs from the one it holds, otherwise it is just run again.
+INTERNAL void
+sdl_apply_rumble_requests(HHMemory* memory)
+{
+  for (uint controller_i = 0; controller_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++controller_i) {
+    HHRumbleRequest* request = &memory->rumble_requests[controller_i + 1];
+    SDLGameController* game_controller = &sdl_game_controllers[controller_i];
+    if (!request->is_requested) {
+      continue;
+    }
+    request->is_requested = false;
+    if (game_controller->haptic == NULL) {
+      continue;
+    }
+
+    float strong_magnitude = request->strong_magnitude < 0.0f ? 0.0f : (request->strong_magnitude > 1.0f ? 1.0f : request->strong_magnitude);
+    float weak_magnitude = request->weak_magnitude < 0.0f ? 0.0f : (request->weak_magnitude > 1.0f ? 1.0f : request->weak_magnitude);
+    if (request->duration_ms == 0) {
+      if (game_controller->rumble_effect_id >= 0) {
+        SDL_HapticStopEffect(game_controller->haptic, game_controller->rumble_effect_id);
+      } else {
+        SDL_HapticRumbleStop(game_controller->haptic);
+      }
+    } else if (game_controller->rumble_effect_id >= 0) {
+      SDL_HapticLeftRight* left_right = &game_controller->rumble_effect.leftright;
+      u16 large_magnitude = (u16)(strong_magnitude * UINT16_MAX + 0.5f);
+      u16 small_magnitude = (u16)(weak_magnitude * UINT16_MAX + 0.5f);
+      if (left_right->large_magnitude != large_magnitude || left_right->small_magnitude != small_magnitude ||
+          left_right->length != request->duration_ms) {
+        left_right->large_magnitude = large_magnitude;
+        left_right->small_magnitude = small_magnitude;
+        left_right->length = request->duration_ms;
+        if (SDL_HapticUpdateEffect(game_controller->haptic, game_controller->rumble_effect_id, &game_controller->rumble_effect) < 0) {
+          SDL_LogWarn("Unable to update SDL rumble effect: %s", SDL_GetError());
+          continue;
+        }
+      }
+      if (SDL_HapticRunEffect(game_controller->haptic, game_controller->rumble_effect_id, 1) < 0) {
+        SDL_LogWarn("Unable to run SDL rumble effect: %s", SDL_GetError());
+      }
+    } else {
+      float strength = (strong_magnitude > weak_magnitude) ? strong_magnitude : weak_magnitude;
+      if (SDL_HapticRumblePlay(game_controller->haptic, strength, request->duration_ms) < 0) {
+        SDL_LogWarn("Unable to play SDL rumble: %s", SDL_GetError());
+      }
+    }
+  }
+}
+
 INTERNAL float
 sdl_normalize_stick(int16 stick_value)
 {
-  if (stick_value < -SDL_GAME_CONTROLLER_DEADZONE) {
-    return (float)(stick_value + SDL_GAME_CONTROLLER_DEADZONE) / (32768.0f - SDL_GAME_CONTROLLER_DEADZONE);
-  } else if (stick_value > SDL_GAME_CONTROLLER_DEADZONE) {
-    return (float)(stick_value - SDL_GAME_CONTROLLER_DEADZONE) / (32767.0f - SDL_GAME_CONTROLLER_DEADZONE);
+  if (stick_value < -SDL_GAME_CONTROLLER_STICK_DEADZONE) {
+    return (float)(stick_value + SDL_GAME_CONTROLLER_STICK_DEADZONE) / (32768.0f - SDL_GAME_CONTROLLER_STICK_DEADZONE);
+  } else if (stick_value > SDL_GAME_CONTROLLER_STICK_DEADZONE) {
+    return (float)(stick_value - SDL_GAME_CONTROLLER_STICK_DEADZONE) / (32767.0f - SDL_GAME_CONTROLLER_STICK_DEADZONE);
   } else {
     return 0.0f;
   }
 }
 
+// NOTE(Ryan): Input mapping tables. Events are looked up here rather than each button being hand-copied,
+// so adding a binding is a one-line change.
 typedef struct {
-  void* handle;
-  void (*update_and_render)(HHPixelBuffer*, HHInput*, HHSoundBuffer*, HHMemory*);
-  // perhaps also pass in logging functions
-  uint last_modification_time;
-} SDLHHApi;
+  SDL_Scancode scancode;
+  HHButton button;
+} SDLKeyboardBinding;
+
+GLOBAL SDLKeyboardBinding sdl_keyboard_bindings[] = {
+  {SDL_SCANCODE_W, HH_BUTTON_MOVE_UP},
+  {SDL_SCANCODE_A, HH_BUTTON_MOVE_LEFT},
+  {SDL_SCANCODE_S, HH_BUTTON_MOVE_DOWN},
+  {SDL_SCANCODE_D, HH_BUTTON_MOVE_RIGHT},
+  {SDL_SCANCODE_UP, HH_BUTTON_ACTION_UP},
+  {SDL_SCANCODE_LEFT, HH_BUTTON_ACTION_LEFT},
+  {SDL_SCANCODE_DOWN, HH_BUTTON_ACTION_DOWN},
+  {SDL_SCANCODE_RIGHT, HH_BUTTON_ACTION_RIGHT},
+  {SDL_SCANCODE_Q, HH_BUTTON_SPECIAL_LEFT},
+  {SDL_SCANCODE_E, HH_BUTTON_SPECIAL_RIGHT},
+  {SDL_SCANCODE_RETURN, HH_BUTTON_START},
+  {SDL_SCANCODE_ESCAPE, HH_BUTTON_BACK},
+};
 
+typedef struct {
+  SDL_GameControllerButton sdl_button;
+  HHButton button;
+} SDLControllerBinding;
+
+GLOBAL SDLControllerBinding sdl_controller_bindings[] = {
+  {SDL_CONTROLLER_BUTTON_DPAD_UP, HH_BUTTON_MOVE_UP},
+  {SDL_CONTROLLER_BUTTON_DPAD_LEFT, HH_BUTTON_MOVE_LEFT},
+  {SDL_CONTROLLER_BUTTON_DPAD_DOWN, HH_BUTTON_MOVE_DOWN},
+  {SDL_CONTROLLER_BUTTON_DPAD_RIGHT, HH_BUTTON_MOVE_RIGHT},
+  {SDL_CONTROLLER_BUTTON_Y, HH_BUTTON_ACTION_UP},
+  {SDL_CONTROLLER_BUTTON_X, HH_BUTTON_ACTION_LEFT},
+  {SDL_CONTROLLER_BUTTON_A, HH_BUTTON_ACTION_DOWN},
+  {SDL_CONTROLLER_BUTTON_B, HH_BUTTON_ACTION_RIGHT},
+  {SDL_CONTROLLER_BUTTON_LEFTSHOULDER, HH_BUTTON_SPECIAL_LEFT},
+  {SDL_CONTROLLER_BUTTON_RIGHTSHOULDER, HH_BUTTON_SPECIAL_RIGHT},
+  {SDL_CONTROLLER_BUTTON_START, HH_BUTTON_START},
+  {SDL_CONTROLLER_BUTTON_BACK, HH_BUTTON_BACK},
+};
+
+#define SDL_STICK_MOVE_THRESHOLD 0.5f
+
+// NOTE(Ryan): Called before the frame's events are processed; ended_down carries over, transitions do not
 INTERNAL void
-sdl_load_hh_api(SDLHHApi* hh_api)
+sdl_begin_input_frame(HHInput* input)
 {
-  hh_api->handle = SDL_LoadObject(sdl_info.abs_object_file_name);
-  if (code->handle == NULL) {
-    SDL_LogCritical("Unable to load hh api handle: %s", SDL_GetError());
-    hh_api->update_and_render = NULL;
-    hh_api->last_modification_time = 0;
+  for (uint controller_i = 0; controller_i < NUM_GAME_CONTROLLERS_SUPPORTED + 1; ++controller_i) {
+    memset(input->controllers[controller_i].half_transition_count, 0, HH_BUTTON_COUNT);
+  }
+}
+
+INTERNAL void
+sdl_process_button(HHController* controller, HHButton button, bool is_down)
+{
+  if (IS_BIT_SET(controller->ended_down, button) != is_down) {
+    controller->ended_down ^= (1 << button);
+    if (controller->half_transition_count[button] < UINT8_MAX) {
+      ++controller->half_transition_count[button];
+    }
+  }
+}
+
+INTERNAL void
+sdl_process_keyboard_event(HHController* keyboard_controller, SDL_KeyboardEvent* key_event)
+{
+  if (key_event->repeat) {
     return;
-  } else {
-    hh_api->update_and_render = \
-      (void (*)(HHPixelBuffer*, HHInput*, HHSoundBuffer*, HHMemory*))SDL_LoadFunction(hh_code, "hh_update_and_render");
-    if (hh_api->update_and_render == NULL) {
-      SDL_LogCritical("Unable to load hh api render and update function: %s", SDL_GetError());
-      hh_api->last_modification_time = 0;
+  }
+  for (uint binding_i = 0; binding_i < ARRAY_SIZE(sdl_keyboard_bindings); ++binding_i) {
+    if (sdl_keyboard_bindings[binding_i].scancode == key_event->keysym.scancode) {
+      sdl_process_button(keyboard_controller, sdl_keyboard_bindings[binding_i].button, key_event->state == SDL_PRESSED);
       return;
     }
+  }
+}
+
+// NOTE(Ryan): Returns the HHInput controller index, which is one past the sdl_game_controllers[] slot
+INTERNAL int
+sdl_find_game_controller_index(SDL_JoystickID instance_joystick_id)
+{
+  for (uint controller_i = 0; controller_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++controller_i) {
+    if (sdl_game_controllers[controller_i].controller != NULL &&
+        sdl_game_controllers[controller_i].instance_joystick_id == instance_joystick_id) {
+      return controller_i + 1;
+    }
+  }
+  return -1;
+}
 
-    struct stat api_stat = {0};
-    stat(sdl_info.abs_object_file_name, &api_stat);
-    hh_api->last_modification_time = api_stat.st_mtime;
+INTERNAL void
+sdl_process_controller_button_event(HHInput* input, SDL_ControllerButtonEvent* button_event)
+{
+  int controller_index = sdl_find_game_controller_index(button_event->which);
+  if (controller_index < 0) {
+    return;
+  }
+  for (uint binding_i = 0; binding_i < ARRAY_SIZE(sdl_controller_bindings); ++binding_i) {
+    if (sdl_controller_bindings[binding_i].sdl_button == button_event->button) {
+      HHController* controller = &input->controllers[controller_index];
+      HHButton button = sdl_controller_bindings[binding_i].button;
+      sdl_process_button(controller, button, button_event->state == SDL_PRESSED);
+      if (button <= HH_BUTTON_MOVE_RIGHT) {
+        controller->is_analog = false;
+      }
+      return;
+    }
   }
 }
 
+INTERNAL void
+sdl_process_controller_axis_event(HHInput* input, SDL_ControllerAxisEvent* axis_event)
+{
+  int controller_index = sdl_find_game_controller_index(axis_event->which);
+  if (controller_index < 0) {
+    return;
+  }
+
+  HHController* controller = &input->controllers[controller_index];
+  float value = sdl_normalize_stick(axis_event->value);
+  if (axis_event->axis == SDL_CONTROLLER_AXIS_LEFTX) {
+    controller->stick_x = value;
+    sdl_process_button(controller, HH_BUTTON_MOVE_LEFT, value < -SDL_STICK_MOVE_THRESHOLD);
+    sdl_process_button(controller, HH_BUTTON_MOVE_RIGHT, value > SDL_STICK_MOVE_THRESHOLD);
+  } else if (axis_event->axis == SDL_CONTROLLER_AXIS_LEFTY) {
+    // NOTE(Ryan): SDL's y axis points down, the game's up
+    controller->stick_y = -value;
+    sdl_process_button(controller, HH_BUTTON_MOVE_UP, -value > SDL_STICK_MOVE_THRESHOLD);
+    sdl_process_button(controller, HH_BUTTON_MOVE_DOWN, -value < -SDL_STICK_MOVE_THRESHOLD);
+  } else {
+    return;
+  }
+  if (value < 0.0f || value > 0.0f) {
+    controller->is_analog = true;
+  }
+}
+
+PERSIST struct {
+  char const* os;
+  char const* video_driver;
+  char const* audio_driver;
+  SDL_Version version;
+  int num_logical_cores;
+  int ram_mb;
+  int l1_cache_line_size;
+  u32 cpu_features;
+  // TODO(Ryan): Include power management info.
+  char* base_path;
+  int gl_major_version;
+  int gl_minor_version;
+  char abs_object_file_name[256];
+} sdl_info;
+
+#if defined(LINUX)
+  #define SDL_HH_OBJECT_FILE_NAME "x86_64-desktop-sdl-hh.so"
+#elif defined(WINDOWS)
+  #define SDL_HH_OBJECT_FILE_NAME "x86_64-desktop-sdl-hh.dll"
+#elif defined(MAC)
+  #define SDL_HH_OBJECT_FILE_NAME "x86_64-desktop-sdl-hh.dylib"
+#endif
+
+typedef void (SDLHHUpdateAndRender)(HHPixelBuffer*, HHInput*, HHSoundBuffer*, HHMemory*);
+
+typedef struct {
+  void* handle;
+  SDLHHUpdateAndRender* update_and_render;
+  // perhaps also pass in logging functions
+  uint last_modification_time;
+  uint version;
+  char loaded_file_name[256];
+} SDLHHApi;
+
 INTERNAL void
 sdl_unload_hh_api(SDLHHApi* hh_api)
 {
-  SDL_UnloadObject(hh_api->handle);
+  if (hh_api->handle != NULL) {
+    SDL_UnloadObject(hh_api->handle);
+    remove(hh_api->loaded_file_name);
+  }
+  hh_api->handle = NULL;
   hh_api->update_and_render = NULL;
 }
 
-// TODO(Ryan): Implement memory map for persistent replay buffers.
+// NOTE(Ryan): Loads a versioned copy of the object and only replaces the current api once the copy
+// has loaded and exports everything we need, so a bad build leaves the running code untouched.
+// Job queue must be idle, as the old code is unmapped here.
+INTERNAL STATUS
+sdl_load_hh_api(SDLHHApi* hh_api)
+{
+  char loaded_file_name[256] = {0};
+  snprintf(loaded_file_name, sizeof(loaded_file_name), "%s.%u.loaded", sdl_info.abs_object_file_name, hh_api->version + 1);
+  if (sdl_copy_file(sdl_info.abs_object_file_name, loaded_file_name) == FAILED) {
+    return FAILED;
+  }
+
+  void* handle = SDL_LoadObject(loaded_file_name);
+  if (handle == NULL) {
+    SDL_LogCritical("Unable to load hh api handle: %s", SDL_GetError());
+    remove(loaded_file_name);
+    return FAILED;
+  }
+
+  SDLHHUpdateAndRender* update_and_render = (SDLHHUpdateAndRender *)SDL_LoadFunction(handle, "hh_update_and_render");
+  if (update_and_render == NULL) {
+    SDL_LogCritical("Unable to load hh api render and update function: %s", SDL_GetError());
+    SDL_UnloadObject(handle);
+    remove(loaded_file_name);
+    return FAILED;
+  }
+
+  sdl_unload_hh_api(hh_api);
+  hh_api->handle = handle;
+  hh_api->update_and_render = update_and_render;
+  hh_api->version += 1;
+  strcpy(hh_api->loaded_file_name, loaded_file_name);
+
+  struct stat api_stat = {0};
+  stat(sdl_info.abs_object_file_name, &api_stat);
+  hh_api->last_modification_time = api_stat.st_mtime;
+
+  return SUCCEEDED;
+}
+
+INTERNAL uint
+sdl_get_window_refresh_rate(SDL_Window* window)
+{
+  SDL_DisplayMode display_mode = {0};
+  int display_index = SDL_GetWindowDisplayIndex(window);
+  SDL_GetCurrentDisplayMode(display_index, &display_mode);
+  // NOTE(Ryan): This handles the case of variable refresh rate.
+  return (display_mode.refresh_rate == 0) ? 60 : display_mode.refresh_rate;
+}
+
+#define SDL_SWAPCHAIN_LENGTH 2
+
+// NOTE(Ryan): Only called between frames, when no update is rendering into any buffer. All or nothing, so on
+// failure the old buffers are kept and the frame is letterboxed from them as before
+INTERNAL STATUS
+sdl_resize_pixel_buffers(HHPixelBuffer* pixel_buffers, uint width, uint height)
+{
+  void* memory[SDL_SWAPCHAIN_LENGTH] = {0};
+  for (uint buffer_i = 0; buffer_i < SDL_SWAPCHAIN_LENGTH; ++buffer_i) {
+    memory[buffer_i] = calloc((size_t)width * BYTES_PER_PIXEL * height, 1);
+    if (memory[buffer_i] == NULL) {
+      SDL_LogWarn("Unable to allocate %ux%u hh pixel buffer: %s", width, height, strerror(errno));
+      for (uint free_i = 0; free_i < buffer_i; ++free_i) {
+        free(memory[free_i]);
+      }
+      return FAILED;
+    }
+  }
+
+  for (uint buffer_i = 0; buffer_i < SDL_SWAPCHAIN_LENGTH; ++buffer_i) {
+    HHPixelBuffer* pixel_buffer = &pixel_buffers[buffer_i];
+    free(pixel_buffer->memory);
+    pixel_buffer->memory = memory[buffer_i];
+    pixel_buffer->width = width;
+    pixel_buffer->height = height;
+    pixel_buffer->pitch = width * BYTES_PER_PIXEL;
+  }
+  return SUCCEEDED;
+}
+
 typedef struct {
-  SDL_RWops* input_handle;
-  char input_file_name[256];
-  void* memory_block; 
-} SDLReplayBuffer; 
+  SDLHHApi* hh_api;
+  HHPixelBuffer* pixel_buffer;
+  // NOTE(Ryan): Copied so the main thread can start sampling the next frame's input
+  HHInput input;
+  HHSoundBuffer* sound_buffer;
+  HHMemory* memory;
+} SDLUpdateAndRenderJob;
+
+INTERNAL void
+sdl_update_and_render_job(void* data)
+{
+  SDLUpdateAndRenderJob* job = (SDLUpdateAndRenderJob *)data;
+  TIMED_BLOCK("update_and_render");
+  job->hh_api->update_and_render(job->pixel_buffer, &job->input, job->sound_buffer, job->memory);
+}
 
 
 INTERNAL STATUS
-sdl_init_audio(u32 samples_per_second)
+sdl_init_audio(SDLAudioRing* audio_ring)
 {
   SDL_AudioSpec audio_spec = {0};
-  audio_spec.freq = samples_per_second;
+  audio_spec.freq = audio_ring->samples_per_second;
   audio_spec.format = AUDIO_S16LSB;
-  audio_spec.channels = 2;
-  audio_spec.samples = sizeof(int16) * 2 * samples_per_second / 60;
+  audio_spec.channels = SDL_AUDIO_CHANNELS;
+  // NOTE(Ryan): Device period of at most half the target latency, so the ring rather than the device holds the latency
+  audio_spec.samples = 1;
+  while (audio_spec.samples * 4 <= audio_ring->target_latency_frames) {
+    audio_spec.samples <<= 1;
+  }
+  audio_spec.callback = sdl_audio_callback;
+  audio_spec.userdata = audio_ring;
 
   if (SDL_OpenAudio(&audio_spec, NULL) < 0) {
     SDL_LogWarn("Unable to open SDL audio: %s", SDL_GetError());
@@ -171,20 +490,69 @@ sdl_init_audio(u32 samples_per_second)
   return SUCCEEDED;
 }
 
-PERSIST struct {
-  char const* os;
-  char const* video_driver;
-  char const* audio_driver;
-  SDL_Version version;
-  int num_logical_cores;
-  int ram_mb;
-  int l1_cache_line_size;
-  // TODO(Ryan): Include power management info.
-  char* base_path;
-  int gl_major_version;
-  int gl_minor_version;
-  char abs_object_file_name[256];
-} sdl_info;
+#if defined(DEBUG)
+  // NOTE(Ryan): Fixed base keeps game pointers identical across runs, so replays and
+  // debugger watches remain valid. 2TiB is well clear of the heap, stacks and shared objects.
+  #define SDL_HH_MEMORY_BASE_ADDRESS ((void *)(uintptr_t)GIGABYTES(2048))
+#else
+  #define SDL_HH_MEMORY_BASE_ADDRESS NULL
+#endif
+
+#if defined(LINUX) && !defined(MAP_FIXED_NOREPLACE)
+  #define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+// NOTE(Ryan): Address space is reserved for the whole block up front, but physical pages are only
+// committed as the game first touches them, so resident size tracks actual use rather than the reservation.
+INTERNAL void*
+sdl_reserve_memory_block(u64 size, void* base_address)
+{
+#if defined(LINUX)
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+  if (base_address != NULL) {
+    flags |= MAP_FIXED_NOREPLACE;
+  }
+
+  void* block = MAP_FAILED;
+#if defined(HH_USE_HUGETLB) && !defined(DEBUG)
+  // NOTE(Ryan): Explicit huge pages need a reserved hugetlb pool and a size that is a multiple of 2MiB.
+  // MAP_NORESERVE is dropped here, otherwise an exhausted pool surfaces as SIGBUS on first touch
+  // rather than as a failed mmap. Debug builds never take this path: the replay write barrier mprotects
+  // single base pages, which fails inside a hugetlb mapping.
+  u64 huge_page_size = MEGABYTES(2);
+  u64 huge_size = (size + huge_page_size - 1) & ~(huge_page_size - 1);
+  block = mmap(base_address, huge_size, PROT_READ | PROT_WRITE, (flags & ~MAP_NORESERVE) | MAP_HUGETLB, -1, 0);
+  if (block == MAP_FAILED) {
+    SDL_LogWarn("Unable to map hh memory with MAP_HUGETLB, falling back to transparent huge pages: %s", strerror(errno));
+  }
+#endif
+  if (block == MAP_FAILED) {
+    block = mmap(base_address, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (block != MAP_FAILED) {
+      madvise(block, size, MADV_HUGEPAGE);
+    }
+  }
+
+  if (block == MAP_FAILED && base_address != NULL) {
+    SDL_LogWarn("Unable to map hh memory at %p, using any address: %s", base_address, strerror(errno));
+    return sdl_reserve_memory_block(size, NULL);
+  }
+  // NOTE(Ryan): Kernels before 4.17 treat MAP_FIXED_NOREPLACE as a hint, so check we actually got the base
+  if (block != MAP_FAILED && base_address != NULL && block != base_address) {
+    SDL_LogWarn("Kernel placed hh memory at %p rather than %p", block, base_address);
+  }
+
+  return (block == MAP_FAILED) ? NULL : block;
+#elif defined(WINDOWS)
+  void* block = VirtualAlloc(base_address, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  if (block == NULL && base_address != NULL) {
+    block = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  }
+  return block;
+#else
+  return calloc(1, size);
+#endif
+}
 
 INTERNAL void
 sdl_get_info(void)
@@ -196,6 +564,9 @@ sdl_get_info(void)
   sdl_info.num_logical_cores = SDL_GetCPUCount();
   sdl_info.ram_mb = SDL_GetSystemRAM();
   sdl_info.l1_cache_line_size = SDL_GetCPUCacheLineSize();
+  if (SDL_HasSSE2()) sdl_info.cpu_features |= HH_CPU_FEATURE_SSE2;
+  if (SDL_HasAVX2()) sdl_info.cpu_features |= HH_CPU_FEATURE_AVX2;
+  if (SDL_HasNEON()) sdl_info.cpu_features |= HH_CPU_FEATURE_NEON;
   sdl_info.base_path = SDL_GetBasePath();
   if (SDL_GL_GetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, &sdl_info.gl_major_version) < 0) {
     SDL_LogWarn("Unable to obtain opengl major version: %s", SDL_GetError());
@@ -205,23 +576,38 @@ sdl_get_info(void)
   };
 
   strcpy(sdl_info.abs_object_file_name, sdl_info.base_path);
-#if defined(LINUX)
-  strcat(sdl_info.abs_object_file_name, "x86_64-desktop-sdl-hh.so");
-#elif defined(WINDOWS)
-  strcat(sdl_info.abs_object_file_name, "x86_64-desktop-sdl-hh.dll");
-#elif defined(MAC)
-  strcat(sdl_info.abs_object_file_name, "x86_64-desktop-sdl-hh.dylib");
-#endif
+  strcat(sdl_info.abs_object_file_name, SDL_HH_OBJECT_FILE_NAME);
 }
 
 void
 sdl_debug_log_function(void* user_data, int category, SDL_LogPriority priority, char const* msg)
 {
+  (void)user_data; (void)category; (void)priority;
   puts(msg); fflush(stdout);
 }
 
+void 
+platform_debug_write_entire_file(char const* file_name, void* memory, uint memory_size)
+{
+  SDL_RWops* handle = SDL_RWFromFile(file_name, "wb"); 
+  if (handle != NULL) {
+    if (SDL_RWwrite(handle, memory, memory_size, 1) != 1) {
+      SDL_LogWarn("Unable to write %u bytes to file '%s': %s", memory_size, file_name, SDL_GetError());
+    }
+    SDL_RWclose(handle);
+    return;
+  } else {
+    SDL_LogWarn("Unable to open file '%s': %s", file_name, SDL_GetError());
+  }
+} 
+
 GLOBAL bool want_to_run = false;
 
+// NOTE(Ryan): headless-hh.c reuses everything above with its own entry point
+#if !defined(HH_HEADLESS)
+// NOTE(Ryan): Defined in hh.c, which includes this file first
+void hh_select_render_kernels(u32 cpu_features);
+
 int 
 main(int argc, char* argv[argc + 1])
 {
@@ -237,12 +623,15 @@ main(int argc, char* argv[argc + 1])
     SDL_LogCritical("Unable to initialize SDL: %s", SDL_GetError());
     return EXIT_FAILURE;
   }
+  // NOTE(Ryan): Before anything reads sdl_info (cpu features, base path)
+  sdl_get_info();
+  hh_select_render_kernels(sdl_info.cpu_features);
 
   uint window_width = 1920;
   uint window_height = 1080;
   u32 window_flags = SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_OPENGL;
 #if defined(DEBUG)
-  if (strcmp(info.video_driver, "x11")) {
+  if (strcmp(sdl_info.video_driver, "x11")) {
     window_flags |= SDL_WINDOW_ALWAYS_ON_TOP;
   }
 #endif
@@ -263,86 +652,95 @@ main(int argc, char* argv[argc + 1])
   SDL_ShowCursor(SDL_DISABLE);
 #endif
 
-  bool need_to_compute_refresh_rate = true;
-  uint refresh_rate = 0;
-
-  if (need_to_compute_refresh_rate) {
-    SDL_DisplayMode display_mode = {0};
-    int display_index = SDL_GetWindowDisplayIndex(window);
-    SDL_GetCurrentDisplayMode(display_index, &display_mode);
-    // NOTE(Ryan): This handles the case of variable refresh rate.
-    refresh_rate = (display_mode.refresh_rate == 0) ? 60 : display_mode.refresh_rate;
-  }
+  bool need_to_compute_refresh_rate = false;
+  uint refresh_rate = sdl_get_window_refresh_rate(window);
 
   SDL_GLContext context = SDL_GL_CreateContext(window);
   if (SDL_GL_SetSwapInterval(-1) < 0) {
     SDL_LogDebug("Unable to enable adaptive vsync for sdl opengl context: %s", SDL_GetError());
     if (SDL_GL_SetSwapInterval(1) < 0) {
-      SDL_LogCritical("Unable to enable vsync for sdl opengl context: %s", SDL_GetError());
-      // TODO(Ryan): Investigate if this occurs frequently enough to merit a fallback.
-      return EXIT_FAILURE;
+      SDL_LogWarn("Unable to enable vsync for sdl opengl context, frames will be paced by timer only: %s", SDL_GetError());
     }
   }
 
-  HHPixelBuffer pixel_buffer = {0};
-  pixel_buffer.width = window_width;
-  pixel_buffer.height = window_height;
-  pixel_buffer.pitch = window_width * BYTES_PER_PIXEL;
-  pixel_buffer.memory = calloc(pixel_buffer.pitch * pixel_buffer.height, 1);
-  if (pixel_buffer.memory == NULL) {
-    SDL_LogCritical("Unable to allocate memory for hh pixel buffer: %s", strerror(errno));
+  HHPixelBuffer pixel_buffers[SDL_SWAPCHAIN_LENGTH] = {0};
+  if (sdl_resize_pixel_buffers(pixel_buffers, window_width, window_height) == FAILED) {
+    SDL_LogCritical("Unable to allocate memory for hh pixel buffers");
     return EXIT_FAILURE;
   }
+  uint frame_index = 0;
+  SDLUpdateAndRenderJob update_and_render_job = {0};
 
   uint samples_per_second = 48000;
-  STATUS have_sound = sdl_init_audio(samples_per_second);
+  SDLAudioRing audio_ring = {0};
   HHSoundBuffer sound_buffer = {0};
-
-  if (have_sound) {
-    // NOTE(Ryan): At 60fps, this will be 4 frames worth of audio data.
-    uint latency_fraction = 15;
-    uint num_game_samples = samples_per_second / latency_fraction; 
-
+  bool have_sound = false;
+  if (sdl_init_audio_ring(&audio_ring, samples_per_second, SDL_AUDIO_TARGET_LATENCY_MS) == SUCCEEDED) {
+    // NOTE(Ryan): Game never needs to produce more than the ring can hold
     sound_buffer.samples_per_second = samples_per_second;
-    sound_buffer.samples = calloc(num_game_samples, sizeof(int16) * 2);
-    sound_buffer.sample_count = num_game_samples;
+    sound_buffer.samples = calloc(audio_ring.capacity, sizeof(int16) * SDL_AUDIO_CHANNELS);
+    have_sound = (sound_buffer.samples != NULL) && sdl_init_audio(&audio_ring) == SUCCEEDED;
   }
 
   HHMemory memory = {0};
   memory.permanent_storage_size = MEGABYTES(64);
   memory.transient_storage_size = GIGABYTES(1);
-  uint total_memory_size = memory.permanent_storage_size + memory.transient_storage_size; 
-  memory.permanent_storage = malloc(total_memory_size);
+  u64 total_memory_size = memory.permanent_storage_size + memory.transient_storage_size; 
+  memory.permanent_storage = sdl_reserve_memory_block(total_memory_size, SDL_HH_MEMORY_BASE_ADDRESS);
   if (memory.permanent_storage == NULL) {
-    SDL_LogCritical("Unable to allocate hh memory: %s", strerror(ernno));
+    SDL_LogCritical("Unable to allocate %llu bytes of hh memory: %s", (unsigned long long)total_memory_size, strerror(errno));
     return EXIT_FAILURE;
   }
   memory.transient_storage = ((u8 *)memory.permanent_storage + memory.permanent_storage_size);
-  memory.platform_debug_read_entire_file = platform_debug_read_entire_file;
+  memory.cpu_features = sdl_info.cpu_features;
   memory.platform_debug_write_entire_file = platform_debug_write_entire_file;
 
+  // NOTE(Ryan): Mapped outside the memory block, so replays neither snapshot it nor invalidate pointers into it
+  HHAssetPack asset_pack = {0};
+  char asset_pack_file_name[512] = {0};
+  snprintf(asset_pack_file_name, sizeof(asset_pack_file_name), "%s%s", sdl_info.base_path, SDL_HH_ASSET_PACK_FILE_NAME);
+  if (sdl_open_asset_pack(&asset_pack, asset_pack_file_name) == FAILED) {
+    SDL_LogWarn("Running without assets");
+  }
+  memory.asset_pack = &asset_pack;
+  memory.asset_stream = sdl_create_asset_stream(&asset_pack, asset_pack_file_name);
+  memory.platform_begin_asset_read = platform_begin_asset_read;
+
   SDLHHApi hh_api = {0};
-  sdl_load_hh_api(&hh_api);
 
 #if defined(DEBUG)
-  // IMPORTANT(Ryan): As each replay buffer allocates approx. 1Gb of memory on startup, limit amount.
-  //                  However, unlikely to exceed virtual memory size.
-  #define NUM_REPLAY_BUFFERS 1
+  // NOTE(Ryan): Replay slots only cost the pages written since their snapshot, so all 9 are available
   SDL_assert(NUM_REPLAY_BUFFERS <= 9);
-  SDLReplayBuffer replay_buffers[NUM_REPLAY_BUFFERS] = {0};
+  bool have_replay_buffers = sdl_init_replay_buffers(memory.permanent_storage, total_memory_size, sdl_info.base_path);
   bool are_recording_state = false;
   bool are_looping_state = false;
   uint replay_buffer_i = -1;
+#endif
 
-  // Need to check if file exists for memory map
-  for (uint replay_i = 0; replay_i < NUM_REPLAY_BUFFERS; ++replay_i) {
-    SDLReplayBuffer* replay_buffer = &replay_buffers[replay_i];
-    sprintf(replay_buffer->input_file_name, "%sloop-edit-%u-input.hmi", sdl_info.base_path, replay_i);
-    replay_buffer->memory = malloc(hh_memory.total_memory_size); 
+  sdl_load_hh_api(&hh_api);
+  SDLFileWatcher hh_api_watcher = {0};
+  if (sdl_start_file_watcher(&hh_api_watcher, sdl_info.base_path, SDL_HH_OBJECT_FILE_NAME) == FAILED) {
+    SDL_LogWarn("Hot reloading disabled");
   }
-#endif
 
-  sdl_populate_info();
+  memory.cache_line_size = sdl_info.l1_cache_line_size;
+  memory.job_queue = sdl_create_job_queue(sdl_info.num_logical_cores);
+  if (memory.job_queue == NULL) {
+    SDL_LogWarn("Unable to create job queue, rendering will be single threaded");
+  } else {
+    memory.job_queue_thread_count = memory.job_queue->thread_count;
+  }
+  memory.platform_add_job = platform_add_job;
+  memory.platform_wait_for_jobs = platform_wait_for_jobs;
+  memory.platform_get_thread_index = platform_get_thread_index;
+
+#if defined(HH_PROFILE)
+  SDLProfiler* profiler = sdl_create_profiler();
+  if (profiler != NULL) {
+    memory.profiler = &profiler->profiler;
+  }
+  hh_bind_profiler(&memory);
+#endif
 
   sdl_find_game_controllers();
 
@@ -352,14 +750,18 @@ main(int argc, char* argv[argc + 1])
 
   u8 const* keyboard_state = SDL_GetKeyboardState(NULL);
 
-  // TODO(Ryan): Timing
+  SDLFrameTimer frame_timer = {0};
+  sdl_init_frame_timer(&frame_timer, refresh_rate);
 
   want_to_run = true;
   while (want_to_run) {
     if (need_to_compute_refresh_rate) {
-    
-      input.frame_dt = 1 / refresh_rate;
+      refresh_rate = sdl_get_window_refresh_rate(window);
+      sdl_set_frame_timer_rate(&frame_timer, refresh_rate);
+      need_to_compute_refresh_rate = false;
     }
+    input.frame_dt = frame_timer.frame_dt;
+    sdl_begin_input_frame(&input);
     SDL_Event event = {0};
     while (SDL_PollEvent(&event) != 0) {
      switch (event.type) {
@@ -370,18 +772,24 @@ main(int argc, char* argv[argc + 1])
          if (event.window.event == SDL_WINDOWEVENT_CLOSE) {
            want_to_run = false;             
          }
-         if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
+         // NOTE(Ryan): Also sent for size changes the program makes itself (fullscreen), unlike RESIZED.
+         // Last frame's update has been waited on, so neither buffer is in use; its unpresented frame is dropped
+         if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
            window_width = event.window.data1; 
            window_height = event.window.data2; 
+           if (window_width > 0 && window_height > 0 &&
+               sdl_resize_pixel_buffers(pixel_buffers, window_width, window_height) == SUCCEEDED) {
+             frame_index = 0;
+           }
          }
 #if defined(DEBUG) 
          if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
-           if (strcmp(info.video_driver, "x11")) {
+           if (strcmp(sdl_info.video_driver, "x11")) {
              SDL_SetWindowOpacity(window, 0.5f);
            }
          }
          if (event.window.event == SDL_WINDOWEVENT_FOCUS_GAINED) {
-           if (strcmp(info.video_driver, "x11")) {
+           if (strcmp(sdl_info.video_driver, "x11")) {
              SDL_SetWindowOpacity(window, 1.0f);
            }
          }
@@ -391,25 +799,25 @@ main(int argc, char* argv[argc + 1])
          sdl_open_game_controller(event.cdevice.which);
        } break;
        case SDL_CONTROLLERDEVICEREMOVED: {
+         int controller_index = sdl_find_game_controller_index(event.cdevice.which);
+         if (controller_index > 0) {
+           memset(&input.controllers[controller_index], 0, sizeof(input.controllers[controller_index]));
+         }
          sdl_close_game_controller(event.cdevice.which);
        } break;
+       case SDL_KEYDOWN:
+       case SDL_KEYUP: {
+         sdl_process_keyboard_event(&input.controllers[0], &event.key);
+       } break;
+       case SDL_CONTROLLERBUTTONDOWN:
+       case SDL_CONTROLLERBUTTONUP: {
+         sdl_process_controller_button_event(&input, &event.cbutton);
+       } break;
+       case SDL_CONTROLLERAXISMOTION: {
+         sdl_process_controller_axis_event(&input, &event.caxis);
+       } break;
      }
-
-    input.controllers[0].move_up = keyboard_state[SDL_SCANCODE_W];
-    input.controllers[0].move_left = keyboard_state[SDL_SCANCODE_A];
-    input.controllers[0].move_down = keyboard_state[SDL_SCANCODE_S];
-    input.controllers[0].move_right = keyboard_state[SDL_SCANCODE_D];
-
-    input.controllers[0].action_up = keyboard_state[SDL_SCANCODE_UP];
-    input.controllers[0].action_left = keyboard_state[SDL_SCANCODE_LEFT];
-    input.controllers[0].action_down = keyboard_state[SDL_SCANCODE_DOWN];
-    input.controllers[0].action_right = keyboard_state[SDL_SCANCODE_RIGHT];
-
-    input.controllers[0].special_left = keyboard_state[SDL_SCANCODE_Q];
-    input.controllers[0].special_right = keyboard_state[SDL_SCANCODE_E];
-
-    input.controllers[0].start = keyboard_state[SDL_SCANCODE_RETURN];
-    input.controllers[0].back = keyboard_state[SDL_SCANCODE_ESCAPE];
+    }
 
     u32 mouse_state = SDL_GetMouseState(&input.mouse_x, &input.mouse_y);
     input.left_mouse_button = mouse_state & SDL_BUTTON(SDL_BUTTON_LEFT);
@@ -417,68 +825,8 @@ main(int argc, char* argv[argc + 1])
     input.right_mouse_button = mouse_state & SDL_BUTTON(SDL_BUTTON_RIGHT);
          
     // NOTE(Ryan): Keyboard controller reserves 0th controller position.
-    for (uint game_controller_i = 1; game_controller_i < NUM_GAME_CONTROLLERS_SUPPORTED + 1; ++game_controller_i) {
-      SDL_GameController* sdl_game_controller = &sdl_game_controllers[game_controller_i - 1].controller;
-      if (sdl_game_controller != NULL) {
-        input.controllers[game_controller_i].is_connected = true; 
-
-        int16 normalized_stick_x = \ 
-          sdl_normalize_stick(SDL_GameControllerGetAxis(sdl_game_controller, SDL_CONTROLLER_AXIS_LEFTX)); 
-        int16 normalized_stick_y = \
-          sdl_normalize_stick(SDL_GameControllerGetAxis(sdl_game_controller, SDL_CONTROLLER_AXIS_LEFTY)); 
-        if (normalized_stick_x != 0.0f || normalized_stick_y != 0.0f) {
-          input.controllers[game_controller_i].is_analog = true; 
-        } 
-
-        if (SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_DPAD_UP)) {
-          normalized_stick_y = 1.0f; 
-          input.controllers[game_controller_i].is_analog = false; 
-        }
-        if (SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_DPAD_LEFT)) {
-          normalized_stick_x = -1.0f; 
-          input.controllers[game_controller_i].is_analog = false; 
-        }
-        if (SDL_GameControllerGetButton(sdl_controller, SDL_CONTROLLER_BUTTON_DPAD_DOWN)) {
-          normalized_stick_y = -1.0f; 
-          input.controllers[game_controller_i].is_analog = false; 
-        }
-        if (SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_DPAD_RIGHT)) {
-          normalized_stick_x = 1.0f; 
-          input.controllers[game_controller_i].is_analog = false; 
-        }
-
-        float threshold = 0.5f; 
-        input.controllers[game_controller_i].move_up = (normalized_stick_y > threshold); 
-        input.controllers[game_controller_i].move_left = (normalized_stick_x < -threshold); 
-        input.controllers[game_controller_i].move_down = (normalized_stick_y < -threshold); 
-        input.controllers[game_controller_i].move_right = (normalized_stick_x > threshold); 
-
-        input.controllers[game_controller_i].stick_x = normalized_stick_x; 
-        input.controllers[game_controller_i].stick_y = normalized_stick_y; 
-
-        input.controllers[game_controller_i].action_up = \ 
-          SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_Y);
-        input.controllers[game_controller_i].action_left = \ 
-          SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_X);
-        input.controllers[game_controller_i].action_down = \ 
-          SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_A);
-        input.controllers[game_controller_i].action_right = \ 
-          SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_B);
-
-        input.controllers[game_controller_i].special_left = \ 
-          SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_LEFTSHOULDER);
-        input.controllers[game_controller_i].special_right = \ 
-          SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_RIGHTSHOULDER);
-
-        input.controllers[game_controller_i].start = \ 
-          SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_START);
-        input.controllers[game_controller_i].back = \ 
-          SDL_GameControllerGetButton(sdl_game_controller, SDL_CONTROLLER_BUTTON_BACK);
-      } else {
-        input.controllers[game_controller_i].is_connected = false; 
-        input.controllers[game_controller_i].is_analog = false; 
-      }
-      // SDL_HapticRumblePlay(controllers[controller_i].haptic, 0.5f, 2000);
+    for (uint controller_i = 0; controller_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++controller_i) {
+      input.controllers[controller_i + 1].is_connected = (sdl_game_controllers[controller_i].controller != NULL);
     }
 
     if (keyboard_state[SDL_SCANCODE_LALT] && keyboard_state[SDL_SCANCODE_RETURN]) {
@@ -495,7 +843,7 @@ main(int argc, char* argv[argc + 1])
     for (uint sdl_scancode = SDL_SCANCODE_1; sdl_scancode < SDL_SCANCODE_1 + NUM_REPLAY_BUFFERS; ++sdl_scancode) {
       if (keyboard_state[sdl_scancode]) replay_buffer_i = sdl_scancode - SDL_SCANCODE_1;
     }
-    bool have_selected_replay_buffer = (replay_buffer_i != -1);
+    bool have_selected_replay_buffer = (replay_buffer_i != (uint)-1);
 
     // INFO(Ryan):
     // **** RECORDING ****
@@ -505,191 +853,162 @@ main(int argc, char* argv[argc + 1])
     // * Start looping by pressing 'l' and replay buffer index to read recording info from, e.g. l1.
     // * Finish looping by pressing 'l' again.
     
-    if (keyboard_state[SDL_SCANCODE_R] && !are_looping_state) {
+    if (keyboard_state[SDL_SCANCODE_R] && !are_looping_state && have_replay_buffers) {
       if (!are_recording_state) {
         if (have_selected_replay_buffer) {
-          // start recording
-          are_recording_state = true;
-          SDLReplayBuffer* replay_buffer =  &replay_buffers[replay_buffer_i];
-          memcpy(replay_buffer->memory_block, hh_memory.complete, hh_memory.total_size);
-          SDL_RWopen();
+          SDLReplayBuffer* replay_buffer = &sdl_replay_state.buffers[replay_buffer_i];
+          if (sdl_open_input_stream_for_write(&replay_buffer->input_stream, replay_buffer->input_file_name,
+                                              refresh_rate, hh_api.last_modification_time) == SUCCEEDED) {
+            sdl_quiesce_asset_stream(memory.asset_stream);
+            if (sdl_take_replay_snapshot(replay_buffer_i) == SUCCEEDED) {
+              are_recording_state = true;
+            } else {
+              sdl_close_input_stream(&replay_buffer->input_stream);
+            }
+          }
         }
       } else {
-        // stop recording 
+        sdl_close_input_stream(&sdl_replay_state.buffers[replay_buffer_i].input_stream);
         are_recording_state = false;
         replay_buffer_i = -1;
-        SDL_RWclose(replay_buffer->input_file_name);
       }
     }
 
-    if (keyboard_state[SDL_SCANCODE_L] && !are_recording_state) {
+    if (keyboard_state[SDL_SCANCODE_L] && !are_recording_state && have_replay_buffers) {
       if (!are_looping_state) {
-        if (have_selected_replay_buffer) {
-          // start looping 
-          are_looping_state = true;
-          memcpy(hh_memory.complete, replay_buffer->memory_block, hh_memory.total_size);
-          replay_buffer->input_file_handle = SDL_RWOpen();
+        if (have_selected_replay_buffer && sdl_replay_state.buffers[replay_buffer_i].has_snapshot) {
+          SDLReplayBuffer* replay_buffer = &sdl_replay_state.buffers[replay_buffer_i];
+          if (sdl_open_input_stream_for_read(&replay_buffer->input_stream, replay_buffer->input_file_name) == SUCCEEDED) {
+            if (replay_buffer->input_stream.build_id != hh_api.last_modification_time) {
+              SDL_LogWarn("Recording '%s' was made with a different game build", replay_buffer->input_file_name);
+            }
+            sdl_quiesce_asset_stream(memory.asset_stream);
+            sdl_restore_replay_snapshot(replay_buffer_i);
+            are_looping_state = true;
+          }
         }
       } else {
-        // stop looping replay_buffer_i 
-        SDL_RWclose();
+        sdl_close_input_stream(&sdl_replay_state.buffers[replay_buffer_i].input_stream);
         are_looping_state = false;
         replay_buffer_i = -1;
       }
     }
 
     if (are_recording_state) {
-      uint bytes_written = 0;
-      if (SDL_RWwrite())
-      write_file(input); 
+      SDLReplayBuffer* replay_buffer = &sdl_replay_state.buffers[replay_buffer_i];
+      if (sdl_write_input_stream(&replay_buffer->input_stream, &input) == FAILED) {
+        // NOTE(Ryan): The write has already been logged; stop rather than keep appending frames that are lost
+        sdl_close_input_stream(&replay_buffer->input_stream);
+        are_recording_state = false;
+        replay_buffer_i = -1;
+      }
     }
+
     if (are_looping_state) {
-      read_file(input); 
+      SDLReplayBuffer* replay_buffer = &sdl_replay_state.buffers[replay_buffer_i];
+      if (!sdl_read_input_stream(&replay_buffer->input_stream, &input)) {
+        // NOTE(Ryan): Reached end of recording, so jump back to its start
+        sdl_quiesce_asset_stream(memory.asset_stream);
+        sdl_restore_replay_snapshot(replay_buffer_i);
+        sdl_seek_input_stream(&replay_buffer->input_stream, 0);
+        sdl_read_input_stream(&replay_buffer->input_stream, &input);
+      }
     }
+#endif
 
-      if (sdl_state->input_playing_index == 0) {
-        if (sdl_state->input_recording_index == 0) {
-          // sdl_begin_recording_input(sdl_state, 1);
-          SDLReplayBuffer* replay_buffer =  &sdl_state.replay_buffers[1];
-          if (replay_buffer->memory_block != NULL) {
-            sdl_state->input_recording_index = 1; 
-            char* file_name = "c:asdasd/asdas/dasd/loop_edit<slot><input>.hmi";
-            sdl_state->recording_handle = file_name;
-            memcpy(replay_buffer->memory_block, sdl_state->game_memory_block, sdl_state->total_size);  
-          }
-        } else {
-          // sdl_end_recording_input(state);
-          close_file(sdl_state->recording_handle);
-          sdl_state->input_recording_index = 0;
-          // sdl_begin_input_playback(state, 1);
-          SDLReplayBuffer* replay_buffer =  &sdl_state.replay_buffers[1];
-          if (replay_buffer->memory_block != NULL) {
-            sdl_state->input_playing_index = 1; 
-            char* file_name = "c:asdasd/asdas/dasd/loop_edit<slot><input>.hmi";
-            sdl_state->playback_handle = file_name;
-            memcpy(sdl_state->game_memory_block, replay_buffer->memory_block, sdl_state->total_size);  
-          }
-        }
+    HHPixelBuffer* render_buffer = &pixel_buffers[frame_index % SDL_SWAPCHAIN_LENGTH];
+    HHPixelBuffer* present_buffer = &pixel_buffers[(frame_index + SDL_SWAPCHAIN_LENGTH - 1) % SDL_SWAPCHAIN_LENGTH];
+    HHJobCounter render_fence = {0};
+
+    // NOTE(Ryan): Exactly what the device will have consumed by the time the next frame is written
+    sound_buffer.sample_count = have_sound ? sdl_audio_ring_frames_to_write(&audio_ring, frame_timer.frame_dt) : 0;
+
+    if (hh_api.update_and_render != NULL) {
+      update_and_render_job.hh_api = &hh_api;
+      update_and_render_job.pixel_buffer = render_buffer;
+      update_and_render_job.input = input;
+      update_and_render_job.sound_buffer = &sound_buffer;
+      update_and_render_job.memory = &memory;
+      if (memory.job_queue != NULL) {
+        platform_add_job(memory.job_queue, sdl_update_and_render_job, &update_and_render_job, &render_fence);
       } else {
-        // sdl_end_input_playback(state); 
-        close_file(sdl_state->playback_handle);
-        sdl_state->input_playing_index = 0;
+        sdl_update_and_render_job(&update_and_render_job);
       }
-    } 
-#endif
-
-    if (sdl_state.input_recording_index) {
-      // sdl_record_input(&sdl_state, input); 
-      write_file(sdl_state->recording_handle, input, sizeof(input));
     }
 
-    if (sdl_state.input_playing_index) {
-      // sdl_playback_input(&sdl_state, input); 
-      read_file(sdl_state->playback_handle, input, sizeof(input));
-      // reached end of stream
-      if (bytes_read == 0) {
-        sdl_end_input_playback(sdl_state);
-        sdl_begin_input_playback(sdl_state, sdl_state->input_playing_index;
-        read_file(sdl_state->playback_handle, input, sizeof(input));
-      }
+    // NOTE(Ryan): Upload the previous frame while this one renders on the job queue.
+    // The fence is waited on before anything else touches game memory or the sound buffer.
+    if (frame_index > 0) {
+      TIMED_BLOCK("present");
+      SDL_Rect drawable_region = aspect_ratio_fit(present_buffer->width, present_buffer->height, window_width, window_height);
+      opengl_display_pixel_buffer(present_buffer, &drawable_region);
+      SDL_GL_SwapWindow(window);
     }
 
-    if (hh_api->update_and_render != NULL) {
-      hh_api->update_and_render(&hh_pixel_buffer, &hh_input, &hh_sound);
+    if (memory.job_queue != NULL) {
+      TIMED_BLOCK("wait_for_render");
+      platform_wait_for_jobs(memory.job_queue, &render_fence);
     }
-    
-
-    SDL_Rect drawable_region = aspect_ratio_fit(pixel_buffer->width, pixel_buffer->height, window_width, window_height);
-    opengl_display_pixel_buffer(&pixel_buffer, &drawable_region);
-    SDL_GL_SwapWindow(window);
+    ++frame_index;
 
-    uint target_queue_bytes = sound_buffer.sample_count * sizeof(int16) * 2;
-    // NOTE(Ryan): As some frames will run longer than expected, have extra padding bytes to ensure no silence.
-    // However, we need to prevent a build up of queued audio data.
-    uint bytes_to_write = 0;
-    if (SDL_GetQueuedAudioSize(1) < target_queue_bytes) {
-      bytes_to_write = target_queue_bytes - SDL_GetQueuedAudioSize(1); 
-    }
+    sdl_apply_rumble_requests(&memory);
 
     if (have_sound) {
-      SDL_QueueAudio(1, sound_buffer.samples, bytes_to_write);
+      sdl_audio_ring_write(&audio_ring, sound_buffer.samples, sound_buffer.sample_count);
 
       if (SDL_GetAudioStatus() != SDL_AUDIO_PLAYING) {
         SDL_PauseAudio(0); 
       }
     }
 
-    for (uint controller_i = 0; controller_i < NUM_GAME_CONTROLLERS_SUPPORTED + 1; ++controller_i) {
-      input.controllers[controller_i].stick_x = 0.0f;
-      input.controllers[controller_i].stick_y = 0.0f;
-    } 
+    // NOTE(Ryan): Render fence has been waited on, so no job is still running the old code
+    if (sdl_file_watcher_has_changed(&hh_api_watcher)) {
+      sdl_load_hh_api(&hh_api);
+    }
 
-    struct stat hh_api_stat = {0};
-    stat(sdl_info.abs_object_file_name, &hh_api_stat);
-    if (hh_api_stat.st_mtime > hh_api->last_modification_time) {
-      sdl_unload_hh_api(&hh_api); 
-      sdl_reload_hh_api(&hh_api); 
-      hh_api->last_modification_time = hh_api_stat.st_mtime;
+#if defined(HH_PROFILE)
+    // NOTE(Ryan): Frame boundary wait is left out, so a frame's length in the trace is its actual work
+    if (profiler != NULL) {
+      sdl_profiler_end_frame(profiler);
     }
+#endif
 
+    sdl_wait_for_frame_boundary(&frame_timer);
   }
 
-  return 0;
-}
-
-void
-platform_debug_read_entire_file(char const* file_name, HHDebugPlatformReadFileResult* read_file_result)
-{
-  SDL_RWops* handle = SDL_RWFromFile(file_name, "rb"); 
-  if (handle != NULL) {
-    int64 file_size = SDL_RWSeek(handle, 0, RW_SEEK_END);
-    if (file_size == -1) {
-      SDL_LogWarn("Unable to obtain file size of '%s': %s", file_name, SDL_GetError());
-      goto __RETURN_FREE_FILE__;
-    }
-    if (SDL_RWSeek(handle, 0, RW_SEEK_SET) == -1) {
-      SDL_LogWarn("Unable to seek to start of file '%s': %s", file_name, SDL_GetError());
-      goto __RETURN_FREE_FILE__;
-    }
-
-    void* data = malloc(file_size);
-    if (data == NULL) {
-      SDL_LogWarn("Unable to allocate file '%s' memory: %s", file_name, strerror(errno));
-      goto __RETURN_FREE_FILE__;
-    }
+  // NOTE(Ryan): The loop always leaves the frame it just rendered unpresented
+  if (frame_index > 0) {
+    HHPixelBuffer* last_buffer = &pixel_buffers[(frame_index - 1) % SDL_SWAPCHAIN_LENGTH];
+    SDL_Rect drawable_region = aspect_ratio_fit(last_buffer->width, last_buffer->height, window_width, window_height);
+    opengl_display_pixel_buffer(last_buffer, &drawable_region);
+    SDL_GL_SwapWindow(window);
+  }
 
-    // CHECK THIS RETURN VALUE
-    if (SDL_RWread(handle, data, file_size, 1) > 0) {
-      read_file_result->size = file_size;
-      read_file_result->data = data;
-      goto __RETURN_FREE_FILE__;
-    } else {
-      SDL_LogWarn("File '%s' empty or at EOF: %s", file_name, SDL_GetError());
-      goto __RETURN_FREE_FILE__;
+#if defined(HH_PROFILE)
+  // NOTE(Ryan): HH_PROFILE_TRACE=file.json writes a Chrome trace of the last few seconds on exit
+  if (profiler != NULL) {
+    sdl_log_profiler_summary(profiler);
+    char const* trace_file_name = SDL_getenv("HH_PROFILE_TRACE");
+    if (trace_file_name != NULL) {
+      sdl_write_profiler_trace(profiler, trace_file_name);
     }
-  } else {
-    SDL_LogWarn("Unable to open file '%s': %s", file_name, SDL_GetError());
-    return;
   }
-__RETURN_FREE_FILE__:
-  SDL_RWclose(handle);
-  return;
-} 
+#endif
 
-void 
-platform_debug_write_entire_file(char const* file_name, void* memory, uint memory_size)
-{
-  SDL_RWops* handle = SDL_RWFromFile(file_name, "rb"); 
-  if (handle != NULL) {
-    if (SDL_RWwrite(handle, memory, memory_size, 1) != memory_size) {
-      SDL_LogWarn("Unable to write %u bytes to file '%s': %s", memory_size, file_name, SDL_GetError());
-    }
-    SDL_RWclose(handle);
-    return;
-  } else {
-    SDL_LogWarn("Unable to open file '%s': %s", file_name, SDL_GetError());
+  sdl_stop_file_watcher(&hh_api_watcher);
+  sdl_unload_hh_api(&hh_api);
+  if (memory.asset_stream != NULL) {
+    sdl_destroy_asset_stream(memory.asset_stream);
   }
-} 
+  if (memory.job_queue != NULL) {
+    sdl_destroy_job_queue(memory.job_queue);
+  }
+  sdl_close_asset_pack(&asset_pack);
+
+  return 0;
+}
+#endif
+
 
 
 // internal tile map, rendering disguises this, procedural generation
@@ -1,8 +1,15 @@
-#include "hh.h"
+// NOTE(Ryan): Links the game directly. hh.c brings in hh.h, whose SDL entry point is compiled out here
+#define HH_HEADLESS
 #include "hh.c"
 
 #include <X11/Xlib.h>
+#include <X11/XKBlib.h>
 #include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/mman.h>
 
 #include <alsa/asoundlib.h>
 
@@ -12,21 +19,474 @@
 #include <fcntl.h>
 
 #include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <stdalign.h>
 
 /*
  * -DCMAKE_BUILD_TYPE=Debug -DSDL_TEST=ON
  */
 
+// NOTE(Ryan): Controller input thread. One epoll set holds the udev monitor and every joystick's evdev fd, so
+// hot-plug is handled the moment udev announces it and key/axis events are picked up as soon as the kernel
+// delivers them. Events are pushed with their kernel timestamp (CLOCK_MONOTONIC) onto a single producer/
+// single consumer queue; the frame then consumes everything up to its chosen sample time.
+// Virtual pads created through /dev/uinput with BTN_SOUTH and ABS_X are picked up like real ones.
+// Rumble runs the other way: the frame posts the latest request per pad and pokes the wake eventfd, and this
+// thread does the uploads and plays. Each distinct effect is uploaded once and then replayed by id.
+#define LINUX_INPUT_QUEUE_CAPACITY 4096
+#define LINUX_INPUT_EVENT_CONNECTED 0xfe
+#define LINUX_INPUT_EVENT_DISCONNECTED 0xff
+
+typedef struct {
+  u64 timestamp_ns;
+  u16 type;
+  u16 code;
+  int32 value;
+  uint controller_i;
+} LinuxInputEvent;
+
+typedef struct {
+  alignas(64) _Atomic u64 write_index;
+  alignas(64) _Atomic u64 read_index;
+  alignas(64) LinuxInputEvent events[LINUX_INPUT_QUEUE_CAPACITY];
+} LinuxInputQueue;
+
+#define LINUX_RUMBLE_EFFECT_SLOTS 4
+// NOTE(Ryan): Request packed as strong | weak << 16 | duration_ms << 32, with this bit marking it pending
+#define LINUX_RUMBLE_REQUEST_PENDING (1ULL << 63)
+
+typedef struct {
+  int16 id;
+  u16 strong_magnitude;
+  u16 weak_magnitude;
+  u16 duration_ms;
+  u64 last_played_ns;
+} LinuxRumbleEffect;
+
+typedef struct {
+  int fd;
+  char devnode[64];
+  struct input_absinfo abs_info[ABS_HAT0Y + 1];
+  // NOTE(Ryan): False if the kernel refused EVIOCSCLOCKID, so its event timestamps are wall clock and unusable
+  bool has_monotonic_timestamps;
+
+  // NOTE(Ryan): Only touched by the input thread, except rumble_request which the frame stores into
+  uint rumble_effect_count;
+  LinuxRumbleEffect rumble_effects[LINUX_RUMBLE_EFFECT_SLOTS];
+  int16 playing_effect_id;
+  _Atomic u64 rumble_request;
+} LinuxInputDevice;
+
+typedef struct {
+  struct udev* udev_handle;
+  struct udev_monitor* monitor;
+  int epoll_fd;
+  int wake_fd;
+  LinuxInputDevice devices[NUM_GAME_CONTROLLERS_SUPPORTED];
+  LinuxInputQueue queue;
+  SDL_Thread* thread;
+  _Atomic bool is_running;
+  _Atomic u64 dropped_event_count;
+} LinuxInput;
+
+// NOTE(Ryan): epoll data for device fds is the slot index; these mark the two non-device fds
+#define LINUX_INPUT_MONITOR_TAG 0xfffffff0
+#define LINUX_INPUT_WAKE_TAG 0xfffffff1
+
+INTERNAL u64
+linux_get_monotonic_ns(void)
+{
+  struct timespec now = {0};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (u64)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+INTERNAL void
+linux_push_input_event(LinuxInput* input, LinuxInputEvent* event)
+{
+  u64 write_index = atomic_load_explicit(&input->queue.write_index, memory_order_relaxed);
+  u64 read_index = atomic_load_explicit(&input->queue.read_index, memory_order_acquire);
+  if (write_index - read_index == LINUX_INPUT_QUEUE_CAPACITY) {
+    // NOTE(Ryan): Frame has not sampled for a very long time (debugger break); newest input is the least useful
+    atomic_fetch_add_explicit(&input->dropped_event_count, 1, memory_order_relaxed);
+    return;
+  }
+  input->queue.events[write_index % LINUX_INPUT_QUEUE_CAPACITY] = *event;
+  atomic_store_explicit(&input->queue.write_index, write_index + 1, memory_order_release);
+}
+
+INTERNAL void
+linux_init_rumble(LinuxInputDevice* device, int fd)
+{
+  device->rumble_effect_count = 0;
+  device->playing_effect_id = -1;
+  atomic_store_explicit(&device->rumble_request, 0, memory_order_relaxed);
+
+  u8 ff_bits[(FF_CNT + 7) / 8] = {0};
+  int max_effect_count = 0;
+  if ((fcntl(fd, F_GETFL) & O_ACCMODE) != O_RDWR || ioctl(fd, EVIOCGBIT(EV_FF, sizeof(ff_bits)), ff_bits) < 0 || !IS_BIT_SET(ff_bits[FF_RUMBLE / 8], FF_RUMBLE % 8) ||
+      ioctl(fd, EVIOCGEFFECTS, &max_effect_count) < 0) {
+    return;
+  }
+  device->rumble_effect_count = (max_effect_count < LINUX_RUMBLE_EFFECT_SLOTS) ? (uint)max_effect_count : LINUX_RUMBLE_EFFECT_SLOTS;
+  for (uint effect_i = 0; effect_i < device->rumble_effect_count; ++effect_i) {
+    device->rumble_effects[effect_i].id = -1;
+  }
+}
 
-void software_renderer(void)
+INTERNAL void
+linux_write_ff_event(LinuxInputDevice* device, int16 effect_id, int32 value)
 {
-  SDL_VideoInit(NULL);
-  XGCValues gcv;
+  struct input_event play_event = {.type = EV_FF, .code = (u16)effect_id, .value = value};
+  if (write(device->fd, &play_event, sizeof(play_event)) < 0) {
+    SDL_LogWarn("Unable to play rumble on '%s': %s", device->devnode, strerror(errno));
+  }
 }
 
-void destroy(void)
+INTERNAL void
+linux_play_rumble(LinuxInputDevice* device, u64 request)
 {
-  XDestroyImage();
+  u16 strong_magnitude = (u16)request;
+  u16 weak_magnitude = (u16)(request >> 16);
+  u16 duration_ms = (u16)(request >> 32);
+
+  if (duration_ms == 0 || (strong_magnitude == 0 && weak_magnitude == 0)) {
+    if (device->playing_effect_id >= 0) {
+      linux_write_ff_event(device, device->playing_effect_id, 0);
+      device->playing_effect_id = -1;
+    }
+    return;
+  }
+
+  // NOTE(Ryan): Replay an identical effect by id; otherwise reuse the least recently played slot
+  LinuxRumbleEffect* effect = &device->rumble_effects[0];
+  bool is_uploaded = false;
+  for (uint effect_i = 0; effect_i < device->rumble_effect_count; ++effect_i) {
+    LinuxRumbleEffect* candidate = &device->rumble_effects[effect_i];
+    if (candidate->id >= 0 && candidate->strong_magnitude == strong_magnitude &&
+        candidate->weak_magnitude == weak_magnitude && candidate->duration_ms == duration_ms) {
+      effect = candidate;
+      is_uploaded = true;
+      break;
+    }
+    if (candidate->last_played_ns < effect->last_played_ns) {
+      effect = candidate;
+    }
+  }
+
+  if (!is_uploaded) {
+    // NOTE(Ryan): Passing the slot's existing id makes the kernel replace that effect rather than allocate another
+    struct ff_effect ff_effect = {0};
+    ff_effect.type = FF_RUMBLE;
+    ff_effect.id = effect->id;
+    ff_effect.u.rumble.strong_magnitude = strong_magnitude;
+    ff_effect.u.rumble.weak_magnitude = weak_magnitude;
+    ff_effect.replay.length = duration_ms;
+    if (ioctl(device->fd, EVIOCSFF, &ff_effect) < 0) {
+      SDL_LogWarn("Unable to upload rumble effect to '%s': %s", device->devnode, strerror(errno));
+      effect->id = -1;
+      return;
+    }
+    effect->id = ff_effect.id;
+    effect->strong_magnitude = strong_magnitude;
+    effect->weak_magnitude = weak_magnitude;
+    effect->duration_ms = duration_ms;
+  }
+
+  if (device->playing_effect_id >= 0 && device->playing_effect_id != effect->id) {
+    linux_write_ff_event(device, device->playing_effect_id, 0);
+  }
+  linux_write_ff_event(device, effect->id, 1);
+  device->playing_effect_id = effect->id;
+  effect->last_played_ns = linux_get_monotonic_ns();
+}
+
+INTERNAL void
+linux_play_rumble_requests(LinuxInput* input)
+{
+  for (uint device_i = 0; device_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++device_i) {
+    LinuxInputDevice* device = &input->devices[device_i];
+    u64 request = atomic_exchange_explicit(&device->rumble_request, 0, memory_order_acquire);
+    if ((request & LINUX_RUMBLE_REQUEST_PENDING) && device->fd >= 0 && device->rumble_effect_count > 0) {
+      linux_play_rumble(device, request);
+    }
+  }
+}
+
+// NOTE(Ryan): Frame side. Hands this frame's rumble requests to the input thread with a single wake.
+INTERNAL void
+linux_submit_rumble_requests(LinuxInput* input, HHMemory* memory)
+{
+  bool have_requests = false;
+  for (uint device_i = 0; device_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++device_i) {
+    HHRumbleRequest* rumble_request = &memory->rumble_requests[device_i + 1];
+    if (!rumble_request->is_requested) {
+      continue;
+    }
+    rumble_request->is_requested = false;
+
+    float strong_magnitude = rumble_request->strong_magnitude < 0.0f ? 0.0f : (rumble_request->strong_magnitude > 1.0f ? 1.0f : rumble_request->strong_magnitude);
+    float weak_magnitude = rumble_request->weak_magnitude < 0.0f ? 0.0f : (rumble_request->weak_magnitude > 1.0f ? 1.0f : rumble_request->weak_magnitude);
+    u64 duration_ms = (rumble_request->duration_ms > UINT16_MAX) ? UINT16_MAX : rumble_request->duration_ms;
+    u64 request = (u64)(strong_magnitude * UINT16_MAX + 0.5f) | ((u64)(weak_magnitude * UINT16_MAX + 0.5f) << 16) |
+                  (duration_ms << 32) | LINUX_RUMBLE_REQUEST_PENDING;
+    atomic_store_explicit(&input->devices[device_i].rumble_request, request, memory_order_release);
+    have_requests = true;
+  }
+
+  if (have_requests && input->thread != NULL) {
+    u64 wake_value = 1;
+    write(input->wake_fd, &wake_value, sizeof(wake_value));
+  }
+}
+
+INTERNAL void
+linux_add_input_device(LinuxInput* input, struct udev_device* udev_device)
+{
+  char const* devnode = udev_device_get_devnode(udev_device);
+  char const* is_joystick = udev_device_get_property_value(udev_device, "ID_INPUT_JOYSTICK");
+  // NOTE(Ryan): Only evdev nodes; the legacy /dev/input/js* nodes report the same pads
+  if (devnode == NULL || is_joystick == NULL || strcmp(is_joystick, "1") != 0 || strstr(devnode, "/event") == NULL) {
+    return;
+  }
+
+  uint free_i = NUM_GAME_CONTROLLERS_SUPPORTED;
+  for (uint device_i = 0; device_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++device_i) {
+    if (input->devices[device_i].fd >= 0 && strcmp(input->devices[device_i].devnode, devnode) == 0) {
+      return;
+    }
+    if (input->devices[device_i].fd < 0 && free_i == NUM_GAME_CONTROLLERS_SUPPORTED) {
+      free_i = device_i;
+    }
+  }
+  if (free_i == NUM_GAME_CONTROLLERS_SUPPORTED) {
+    SDL_LogWarn("Ignoring controller '%s', all %d slots in use", devnode, NUM_GAME_CONTROLLERS_SUPPORTED);
+    return;
+  }
+
+  LinuxInputDevice* device = &input->devices[free_i];
+  // NOTE(Ryan): Write access is only needed to upload and play rumble effects
+  int fd = open(devnode, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0 && errno == EACCES) {
+    fd = open(devnode, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  }
+  if (fd < 0) {
+    SDL_LogWarn("Unable to open controller '%s': %s", devnode, strerror(errno));
+    return;
+  }
+
+  // NOTE(Ryan): Default evdev timestamps are wall clock; the frame samples against the monotonic clock.
+  // If the switch is refused, events are stamped when this thread reads them instead, a little late but ordered
+  int clock_id = CLOCK_MONOTONIC;
+  device->has_monotonic_timestamps = (ioctl(fd, EVIOCSCLOCKID, &clock_id) == 0);
+  if (!device->has_monotonic_timestamps) {
+    SDL_LogWarn("Unable to get monotonic timestamps from controller '%s', using read time: %s", devnode, strerror(errno));
+  }
+  for (uint abs_code = 0; abs_code <= ABS_HAT0Y; ++abs_code) {
+    if (ioctl(fd, EVIOCGABS(abs_code), &device->abs_info[abs_code]) < 0) {
+      memset(&device->abs_info[abs_code], 0, sizeof(device->abs_info[abs_code]));
+    }
+  }
+
+  linux_init_rumble(device, fd);
+
+  struct epoll_event epoll_event = {.events = EPOLLIN, .data.u32 = free_i};
+  if (epoll_ctl(input->epoll_fd, EPOLL_CTL_ADD, fd, &epoll_event) < 0) {
+    SDL_LogWarn("Unable to poll controller '%s': %s", devnode, strerror(errno));
+    close(fd);
+    return;
+  }
+  device->fd = fd;
+  snprintf(device->devnode, sizeof(device->devnode), "%s", devnode);
+
+  LinuxInputEvent event = {.timestamp_ns = linux_get_monotonic_ns(), .type = LINUX_INPUT_EVENT_CONNECTED, .controller_i = free_i};
+  linux_push_input_event(input, &event);
+}
+
+INTERNAL void
+linux_remove_input_device(LinuxInput* input, uint device_i)
+{
+  LinuxInputDevice* device = &input->devices[device_i];
+  epoll_ctl(input->epoll_fd, EPOLL_CTL_DEL, device->fd, NULL);
+  // NOTE(Ryan): Closing the fd frees every effect uploaded through it
+  close(device->fd);
+  device->fd = -1;
+  device->devnode[0] = '\0';
+  device->rumble_effect_count = 0;
+  atomic_store_explicit(&device->rumble_request, 0, memory_order_relaxed);
+
+  LinuxInputEvent event = {.timestamp_ns = linux_get_monotonic_ns(), .type = LINUX_INPUT_EVENT_DISCONNECTED, .controller_i = device_i};
+  linux_push_input_event(input, &event);
+}
+
+INTERNAL void
+linux_read_input_device(LinuxInput* input, uint device_i)
+{
+  LinuxInputDevice* device = &input->devices[device_i];
+  struct input_event events[64];
+  while (true) {
+    ssize_t bytes_read = read(device->fd, events, sizeof(events));
+    u64 read_time_ns = device->has_monotonic_timestamps ? 0 : linux_get_monotonic_ns();
+    if (bytes_read < 0) {
+      if (errno == ENODEV) {
+        // NOTE(Ryan): Unplugged; udev's remove may arrive later or not at all if we lost the race
+        linux_remove_input_device(input, device_i);
+      }
+      return;
+    }
+
+    for (uint event_i = 0; event_i < bytes_read / sizeof(struct input_event); ++event_i) {
+      struct input_event* evdev_event = &events[event_i];
+      if (evdev_event->type == EV_KEY || evdev_event->type == EV_ABS) {
+        LinuxInputEvent event = {0};
+        if (device->has_monotonic_timestamps) {
+          event.timestamp_ns = (u64)evdev_event->input_event_sec * 1000000000ULL + (u64)evdev_event->input_event_usec * 1000ULL;
+        } else {
+          event.timestamp_ns = read_time_ns;
+        }
+        event.type = evdev_event->type;
+        event.code = evdev_event->code;
+        event.value = evdev_event->value;
+        event.controller_i = device_i;
+        linux_push_input_event(input, &event);
+      }
+    }
+  }
+}
+
+INTERNAL int
+linux_input_thread(void* data)
+{
+  LinuxInput* input = (LinuxInput *)data;
+
+  while (atomic_load_explicit(&input->is_running, memory_order_relaxed)) {
+    struct epoll_event ready_events[NUM_GAME_CONTROLLERS_SUPPORTED + 2];
+    int ready_count = epoll_wait(input->epoll_fd, ready_events, ARRAY_SIZE(ready_events), -1);
+    if (ready_count < 0) {
+      if (errno == EINTR) continue;
+      SDL_LogWarn("Unable to wait for controller input: %s", strerror(errno));
+      break;
+    }
+
+    for (int ready_i = 0; ready_i < ready_count; ++ready_i) {
+      u32 tag = ready_events[ready_i].data.u32;
+      if (tag == LINUX_INPUT_WAKE_TAG) {
+        u64 wake_count = 0;
+        read(input->wake_fd, &wake_count, sizeof(wake_count));
+        linux_play_rumble_requests(input);
+      } else if (tag == LINUX_INPUT_MONITOR_TAG) {
+        struct udev_device* udev_device = udev_monitor_receive_device(input->monitor);
+        if (udev_device == NULL) continue;
+
+        char const* action = udev_device_get_action(udev_device);
+        char const* devnode = udev_device_get_devnode(udev_device);
+        if (action != NULL && strcmp(action, "add") == 0) {
+          linux_add_input_device(input, udev_device);
+        } else if (action != NULL && strcmp(action, "remove") == 0 && devnode != NULL) {
+          for (uint device_i = 0; device_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++device_i) {
+            if (input->devices[device_i].fd >= 0 && strcmp(input->devices[device_i].devnode, devnode) == 0) {
+              linux_remove_input_device(input, device_i);
+            }
+          }
+        }
+        udev_device_unref(udev_device);
+      } else if (tag < NUM_GAME_CONTROLLERS_SUPPORTED && input->devices[tag].fd >= 0) {
+        linux_read_input_device(input, tag);
+      }
+    }
+  }
+
+  return 0;
+}
+
+INTERNAL STATUS
+linux_init_input(LinuxInput* input)
+{
+  for (uint device_i = 0; device_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++device_i) {
+    input->devices[device_i].fd = -1;
+  }
+
+  input->udev_handle = udev_new();
+  if (input->udev_handle == NULL) {
+    SDL_LogWarn("Unable to open udev");
+    return FAILED;
+  }
+
+  input->monitor = udev_monitor_new_from_netlink(input->udev_handle, "udev");
+  input->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  input->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (input->monitor == NULL || input->epoll_fd < 0 || input->wake_fd < 0) {
+    SDL_LogWarn("Unable to create controller monitor: %s", strerror(errno));
+    return FAILED;
+  }
+  udev_monitor_filter_add_match_subsystem_devtype(input->monitor, "input", NULL);
+  udev_monitor_enable_receiving(input->monitor);
+
+  struct epoll_event monitor_event = {.events = EPOLLIN, .data.u32 = LINUX_INPUT_MONITOR_TAG};
+  struct epoll_event wake_event = {.events = EPOLLIN, .data.u32 = LINUX_INPUT_WAKE_TAG};
+  epoll_ctl(input->epoll_fd, EPOLL_CTL_ADD, udev_monitor_get_fd(input->monitor), &monitor_event);
+  epoll_ctl(input->epoll_fd, EPOLL_CTL_ADD, input->wake_fd, &wake_event);
+
+  // NOTE(Ryan): Monitor is enabled before enumerating so a pad plugged in between is not missed
+  struct udev_enumerate* enumerate = udev_enumerate_new(input->udev_handle);
+  udev_enumerate_add_match_subsystem(enumerate, "input");
+  udev_enumerate_scan_devices(enumerate);
+  struct udev_list_entry* device_entry = NULL;
+  udev_list_entry_foreach(device_entry, udev_enumerate_get_list_entry(enumerate)) {
+    struct udev_device* udev_device = udev_device_new_from_syspath(input->udev_handle, udev_list_entry_get_name(device_entry));
+    if (udev_device != NULL) {
+      linux_add_input_device(input, udev_device);
+      udev_device_unref(udev_device);
+    }
+  }
+  udev_enumerate_unref(enumerate);
+
+  atomic_store(&input->is_running, true);
+  input->thread = SDL_CreateThread(linux_input_thread, "hh-input", input);
+  if (input->thread == NULL) {
+    SDL_LogWarn("Unable to create controller input thread: %s", SDL_GetError());
+    return FAILED;
+  }
+
+  return SUCCEEDED;
+}
+
+INTERNAL void
+linux_destroy_input(LinuxInput* input)
+{
+  if (input->thread != NULL) {
+    atomic_store(&input->is_running, false);
+    u64 wake_value = 1;
+    write(input->wake_fd, &wake_value, sizeof(wake_value));
+    SDL_WaitThread(input->thread, NULL);
+  }
+  for (uint device_i = 0; device_i < NUM_GAME_CONTROLLERS_SUPPORTED; ++device_i) {
+    if (input->devices[device_i].fd >= 0) close(input->devices[device_i].fd);
+  }
+  if (input->wake_fd >= 0) close(input->wake_fd);
+  if (input->epoll_fd >= 0) close(input->epoll_fd);
+  if (input->monitor != NULL) udev_monitor_unref(input->monitor);
+  if (input->udev_handle != NULL) udev_unref(input->udev_handle);
+}
+
+INTERNAL float
+linux_normalize_axis(struct input_absinfo* abs_info, int32 value)
+{
+  if (abs_info->maximum <= abs_info->minimum) {
+    return 0.0f;
+  }
+  float centre = 0.5f * (abs_info->minimum + abs_info->maximum);
+  float half_range = 0.5f * (abs_info->maximum - abs_info->minimum);
+  float offset = value - centre;
+  // NOTE(Ryan): 'flat' is the driver's own deadzone
+  if (offset > -abs_info->flat && offset < abs_info->flat) {
+    return 0.0f;
+  }
+  float normalized = offset / half_range;
+  return normalized < -1.0f ? -1.0f : (normalized > 1.0f ? 1.0f : normalized);
 }
 
 /* SDL_sysjoystick
@@ -40,122 +500,329 @@ void destroy(void)
  * bottom right trigger --> ABS_HAT2X
  * BTN_SELECT/BTN_MODE/BTN_START
  */
-struct input_event event; 
-
-switch (event_type) {
-  case EV_KEY: {
-    // for buttons       
-  } break;
-  case EV_ABS: {
-    // analog
-  } break;
+INTERNAL int
+linux_get_controller_button(u16 code)
+{
+  switch (code) {
+    case BTN_NORTH: return HH_BUTTON_ACTION_UP;
+    case BTN_WEST: return HH_BUTTON_ACTION_LEFT;
+    case BTN_SOUTH: return HH_BUTTON_ACTION_DOWN;
+    case BTN_EAST: return HH_BUTTON_ACTION_RIGHT;
+    case BTN_DPAD_UP: return HH_BUTTON_MOVE_UP;
+    case BTN_DPAD_LEFT: return HH_BUTTON_MOVE_LEFT;
+    case BTN_DPAD_DOWN: return HH_BUTTON_MOVE_DOWN;
+    case BTN_DPAD_RIGHT: return HH_BUTTON_MOVE_RIGHT;
+    case BTN_TL: return HH_BUTTON_SPECIAL_LEFT;
+    case BTN_TR: return HH_BUTTON_SPECIAL_RIGHT;
+    case BTN_START: return HH_BUTTON_START;
+    case BTN_SELECT: return HH_BUTTON_BACK;
+    default: return -1;
+  }
 }
 
-INTERNAL u32
-linux_joysticks(void)
+// NOTE(Ryan): Applies queued events stamped at or before sample_time_ns to the game controllers.
+// Every transition is counted, so a tap shorter than a frame shows up as two half transitions in this sample.
+INTERNAL void
+linux_sample_input(LinuxInput* input, HHInput* hh_input, u64 sample_time_ns)
 {
-  struct udev* udev_handle = udev_new();
-  if (udev_handle == NULL) {
-    // TODO(Ryan): unable to open udev   
+  u64 read_index = atomic_load_explicit(&input->queue.read_index, memory_order_relaxed);
+  u64 write_index = atomic_load_explicit(&input->queue.write_index, memory_order_acquire);
+
+  for (; read_index < write_index; ++read_index) {
+    LinuxInputEvent* event = &input->queue.events[read_index % LINUX_INPUT_QUEUE_CAPACITY];
+    if (event->timestamp_ns > sample_time_ns) {
+      break;
+    }
+
+    LinuxInputDevice* device = &input->devices[event->controller_i];
+    HHController* controller = &hh_input->controllers[event->controller_i + 1];
+    if (event->type == LINUX_INPUT_EVENT_CONNECTED) {
+      memset(controller, 0, sizeof(*controller));
+      controller->is_connected = true;
+      controller->is_analog = true;
+    } else if (event->type == LINUX_INPUT_EVENT_DISCONNECTED) {
+      memset(controller, 0, sizeof(*controller));
+    } else if (event->type == EV_KEY) {
+      int button = linux_get_controller_button(event->code);
+      if (button >= 0) {
+        sdl_process_button(controller, (HHButton)button, event->value != 0);
+      }
+    } else if (event->type == EV_ABS && event->code <= ABS_HAT0Y) {
+      // NOTE(Ryan): abs_info is written only before the device's connected event is published
+      float value = linux_normalize_axis(&device->abs_info[event->code], event->value);
+      switch (event->code) {
+        case ABS_X: controller->stick_x = value; break;
+        case ABS_Y: controller->stick_y = -value; break;
+        case ABS_HAT0X: {
+          sdl_process_button(controller, HH_BUTTON_MOVE_LEFT, event->value < 0);
+          sdl_process_button(controller, HH_BUTTON_MOVE_RIGHT, event->value > 0);
+        } break;
+        case ABS_HAT0Y: {
+          sdl_process_button(controller, HH_BUTTON_MOVE_UP, event->value < 0);
+          sdl_process_button(controller, HH_BUTTON_MOVE_DOWN, event->value > 0);
+        } break;
+      }
+    }
   }
 
-  struct udev_monitor* monitor = udev_monitor_new_from_netlink(udev_handle, "udev");
-  udev_monitor_filter_add_match_subsystem_devtype(monitor, "input", NULL);
-  udev_monitor_enable_recieving(monitor);
-  int monitor_fd = udev_monitor_get_fd(monitor); 
+  atomic_store_explicit(&input->queue.read_index, read_index, memory_order_release);
+}
 
-  struct udev_enumerate* enumerate = udev_enumerate_new(udev_handle);
-  udev_enumerate_add_match_subsystem(enumerate, "input");
-  udev_enumerate_scan_devices(enumerate);
+// NOTE(Ryan): ALSA output fed from the platform audio ring by its own thread.
+// With MMAP_INTERLEAVED access the ring is read straight into the device's DMA area, so there is no staging
+// copy. Devices that cannot map (some plugins) fall back to RW_INTERLEAVED through a period-sized buffer.
+// Latency = ring target + device buffer; the device buffer is period_frames * period_count and is what
+// HH_ALSA_PERIOD_FRAMES / HH_ALSA_PERIOD_COUNT tune. HH_ALSA_DEVICE=null runs without a sound card.
+typedef struct {
+  snd_pcm_t* pcm_handle;
+  bool is_mmap;
+  uint samples_per_second;
+  snd_pcm_uframes_t period_frames;
+  snd_pcm_uframes_t buffer_frames;
+  int16* period_samples;
 
-  struct udev_list_entry* devices = udev_enumerate_get_list_entry(enumerate); 
-  struct udev_list_entry* device = NULL;
-  udev_list_entry_foreach(device, devices) {
-    char const* device_sysfs_path = udev_list_entry_get_name(device);
-    struct udev_device* udev_device = udev_device_new_from_syspath(udev, device_sysfs_path);
-    
-    while (!udev_device_get_sysattr_value(udev_device, "capabilites/ev")) {
-      udev_device_get_parent_with_subsystem_devtype(udev_device, "input", NULL); 
+  SDLAudioRing* ring;
+  SDL_Thread* thread;
+  _Atomic bool is_running;
+
+  _Atomic u64 xrun_count;
+  // NOTE(Ryan): Device delay sampled once per period, in frames
+  _Atomic u64 delay_sample_count;
+  _Atomic u64 delay_sum;
+  _Atomic u64 delay_max;
+} LinuxAudio;
+
+INTERNAL bool
+linux_alsa_recover(LinuxAudio* audio, int error)
+{
+  atomic_fetch_add_explicit(&audio->xrun_count, 1, memory_order_relaxed);
+  if (snd_pcm_recover(audio->pcm_handle, error, 1) < 0) {
+    SDL_LogWarn("Unable to recover alsa pcm: %s", snd_strerror(error));
+    return false;
+  }
+  return true;
+}
+
+INTERNAL void
+linux_alsa_sample_delay(LinuxAudio* audio)
+{
+  snd_pcm_sframes_t delay_frames = 0;
+  if (snd_pcm_delay(audio->pcm_handle, &delay_frames) == 0 && delay_frames >= 0) {
+    atomic_fetch_add_explicit(&audio->delay_sample_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&audio->delay_sum, delay_frames, memory_order_relaxed);
+    if ((u64)delay_frames > atomic_load_explicit(&audio->delay_max, memory_order_relaxed)) {
+      atomic_store_explicit(&audio->delay_max, delay_frames, memory_order_relaxed);
     }
+  }
+}
 
-    char const* val = udev_device_get_property_value(dev, "ID_INPUT_JOYSTICK");
-    if (val != NULL && strcmp(val, "1") == 0) {
-      char const* devfs_path = udev_device_get_devnode(udev_device);
-      // add to global list of controllers
+INTERNAL int
+linux_alsa_thread(void* data)
+{
+  LinuxAudio* audio = (LinuxAudio *)data;
+
+  while (atomic_load_explicit(&audio->is_running, memory_order_relaxed)) {
+    snd_pcm_sframes_t avail_frames = snd_pcm_avail_update(audio->pcm_handle);
+    if (avail_frames < 0) {
+      if (!linux_alsa_recover(audio, avail_frames)) break;
+      continue;
+    }
+    if ((snd_pcm_uframes_t)avail_frames < audio->period_frames) {
+      // NOTE(Ryan): Only the read/write transfer calls act on start_threshold, so an mmap stream is started by
+      // hand once its buffer is full: on the first fill, and again after a recovery leaves it PREPARED
+      if (audio->is_mmap && snd_pcm_state(audio->pcm_handle) == SND_PCM_STATE_PREPARED) {
+        int start_result = snd_pcm_start(audio->pcm_handle);
+        if (start_result < 0 && !linux_alsa_recover(audio, start_result)) break;
+        continue;
+      }
+      int wait_result = snd_pcm_wait(audio->pcm_handle, 100);
+      if (wait_result < 0 && !linux_alsa_recover(audio, wait_result)) break;
+      continue;
     }
 
-      // this will be in event loop
-  }
+    if (audio->is_mmap) {
+      snd_pcm_channel_area_t const* areas = NULL;
+      snd_pcm_uframes_t offset = 0;
+      snd_pcm_uframes_t frames = audio->period_frames;
+      int begin_result = snd_pcm_mmap_begin(audio->pcm_handle, &areas, &offset, &frames);
+      if (begin_result < 0) {
+        if (!linux_alsa_recover(audio, begin_result)) break;
+        continue;
+      }
 
-  udev_enumerate_unref(enumerate);
+      // NOTE(Ryan): Interleaved, so channel 0's area describes the whole frame
+      int16* samples = (int16 *)((u8 *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8);
+      sdl_audio_ring_read(audio->ring, samples, frames);
 
-  while (true) {
-    fd_set fds;  
-    FD_ZERO(&fds);
-    FD_SET(monitor_fd, &fds);
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = 0;
-
-    int ret = select(monitor_fd + 1, &fds, NULL, NULL, &tv);
-    if (ret > 0 && FD_ISSET(monitor_fd, &fds)) {
-      struct udev_device* device = udev_monitor_recieve_device(udev_monitor); 
-      char const* action = udev_device_get_action(device);
-      if (strcmp(action, "add") == 0) {
-      
+      snd_pcm_sframes_t committed_frames = snd_pcm_mmap_commit(audio->pcm_handle, offset, frames);
+      if (committed_frames < 0 || (snd_pcm_uframes_t)committed_frames != frames) {
+        if (!linux_alsa_recover(audio, committed_frames >= 0 ? -EPIPE : committed_frames)) break;
+        continue;
       }
-      if (strcmp(action, "remove") == 0) {
-      
+    } else {
+      sdl_audio_ring_read(audio->ring, audio->period_samples, audio->period_frames);
+      snd_pcm_sframes_t written_frames = snd_pcm_writei(audio->pcm_handle, audio->period_samples, audio->period_frames);
+      if (written_frames < 0) {
+        if (!linux_alsa_recover(audio, written_frames)) break;
+        continue;
       }
     }
-    // control the polling rate ??
-    usleep(250 * 1000);
+
+    linux_alsa_sample_delay(audio);
   }
+
+  return 0;
 }
 
-GLOBAL struct ff_effect global_force_feedback_effect = {0};
-force_feedback_effect.type = FF_RUMBLE;
-force_feedback_effect.u.rumble.strong_magnitude = 60000;
-force_feedback_effect.u.rumble.weak_magnitude = 0;
-force_feedback_effect.replay.length = 200;
-force_feedback_effect.replay.delay = 0;
-force_feedback_effect.id = -1;
+INTERNAL uint
+linux_get_env_uint(char const* name, uint default_value)
+{
+  char const* value = getenv(name);
+  return (value != NULL && atoi(value) > 0) ? (uint)atoi(value) : default_value;
+}
 
-INTERNAL void
-alsa_audio(void)
+INTERNAL STATUS
+linux_init_alsa(LinuxAudio* audio, SDLAudioRing* ring, char const* device_name, uint period_frames, uint period_count)
 {
-  snd_pcm_t* pcm_handle = NULL;
+  audio->ring = ring;
+  audio->samples_per_second = ring->samples_per_second;
+
   snd_pcm_hw_params_t* hw_params = NULL;
+  snd_pcm_sw_params_t* sw_params = NULL;
+  int result = 0;
 
-  // sound card <-> device
-  // 48000, 4p, 512ps
-  // TODO(Ryan): Investigate on implications of 'default'
-  if (snd_pcm_open(&pcm_handle, "default", SND_PCM_STREAM_PLAYBACK, 0) < 0) {
-    // unable to open sound card
+  if ((result = snd_pcm_open(&audio->pcm_handle, device_name, SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
+    SDL_LogWarn("Unable to open alsa device '%s': %s", device_name, snd_strerror(result));
+    return FAILED;
   }
 
-  if (snd_pcm_hw_params_malloc(&hw_params) < 0) {
-    // unable to obtain memory for hw configuration 
+  if ((result = snd_pcm_hw_params_malloc(&hw_params)) < 0) {
+    SDL_LogWarn("Unable to allocate alsa hw params: %s", snd_strerror(result));
+    goto __ALSA_INIT_ERROR__;
   }
 
-  if (snd_pcm_hw_params_any(pcm_handle, hw_params) < 0) {
-    // unable to load hw configuration
+  if ((result = snd_pcm_hw_params_any(audio->pcm_handle, hw_params)) < 0) {
+    SDL_LogWarn("Unable to load alsa hw configuration: %s", snd_strerror(result));
     goto __ALSA_INIT_ERROR__;
   }
 
-  if (snd_pcm_hw_params_set_access(pcm_handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED) < 0) {
-    // unable to set sound buffer to consecutive alternate channel data
+  audio->is_mmap = (snd_pcm_hw_params_set_access(audio->pcm_handle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0);
+  if (!audio->is_mmap) {
+    SDL_LogWarn("Alsa device '%s' cannot be mapped, falling back to copied writes", device_name);
+    if ((result = snd_pcm_hw_params_set_access(audio->pcm_handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+      SDL_LogWarn("Unable to set alsa interleaved access: %s", snd_strerror(result));
+      goto __ALSA_INIT_ERROR__;
+    }
+  }
+
+  if ((result = snd_pcm_hw_params_set_format(audio->pcm_handle, hw_params, SND_PCM_FORMAT_S16_LE)) < 0) {
+    SDL_LogWarn("Unable to set alsa format: %s", snd_strerror(result));
     goto __ALSA_INIT_ERROR__;
   } 
 
-  if (snd_pcm_hw_params_set_format(pcm_handle, hw_params, SND_PCM_FORMAT_S16_LE) < 0) {
+  if ((result = snd_pcm_hw_params_set_channels(audio->pcm_handle, hw_params, SDL_AUDIO_CHANNELS)) < 0) {
+    SDL_LogWarn("Unable to set alsa channels: %s", snd_strerror(result));
     goto __ALSA_INIT_ERROR__;
-  } 
+  }
+
+  // NOTE(Ryan): Ring is filled at its own rate, so the device must run at exactly that rate rather than near it
+  if ((result = snd_pcm_hw_params_set_rate_resample(audio->pcm_handle, hw_params, 1)) < 0 ||
+      (result = snd_pcm_hw_params_set_rate(audio->pcm_handle, hw_params, audio->samples_per_second, 0)) < 0) {
+    SDL_LogWarn("Unable to set alsa rate to %u: %s", audio->samples_per_second, snd_strerror(result));
+    goto __ALSA_INIT_ERROR__;
+  }
+
+  audio->period_frames = period_frames;
+  if ((result = snd_pcm_hw_params_set_period_size_near(audio->pcm_handle, hw_params, &audio->period_frames, NULL)) < 0) {
+    SDL_LogWarn("Unable to set alsa period size: %s", snd_strerror(result));
+    goto __ALSA_INIT_ERROR__;
+  }
+  audio->buffer_frames = audio->period_frames * period_count;
+  if ((result = snd_pcm_hw_params_set_buffer_size_near(audio->pcm_handle, hw_params, &audio->buffer_frames)) < 0) {
+    SDL_LogWarn("Unable to set alsa buffer size: %s", snd_strerror(result));
+    goto __ALSA_INIT_ERROR__;
+  }
+
+  if ((result = snd_pcm_hw_params(audio->pcm_handle, hw_params)) < 0) {
+    SDL_LogWarn("Unable to apply alsa hw configuration: %s", snd_strerror(result));
+    goto __ALSA_INIT_ERROR__;
+  }
+
+  if ((result = snd_pcm_sw_params_malloc(&sw_params)) < 0 ||
+      (result = snd_pcm_sw_params_current(audio->pcm_handle, sw_params)) < 0 ||
+      (result = snd_pcm_sw_params_set_avail_min(audio->pcm_handle, sw_params, audio->period_frames)) < 0 ||
+      // NOTE(Ryan): Only start (and restart after an xrun) once the whole buffer is queued
+      (result = snd_pcm_sw_params_set_start_threshold(audio->pcm_handle, sw_params, audio->buffer_frames)) < 0 ||
+      (result = snd_pcm_sw_params(audio->pcm_handle, sw_params)) < 0) {
+    SDL_LogWarn("Unable to apply alsa sw configuration: %s", snd_strerror(result));
+    goto __ALSA_INIT_ERROR__;
+  }
+
+  if ((result = snd_pcm_prepare(audio->pcm_handle)) < 0) {
+    SDL_LogWarn("Unable to prepare alsa pcm: %s", snd_strerror(result));
+    goto __ALSA_INIT_ERROR__;
+  }
+
+  if (!audio->is_mmap) {
+    audio->period_samples = calloc(audio->period_frames, sizeof(int16) * SDL_AUDIO_CHANNELS);
+    if (audio->period_samples == NULL) {
+      SDL_LogWarn("Unable to allocate alsa period buffer: %s", strerror(errno));
+      goto __ALSA_INIT_ERROR__;
+    }
+  }
+
+  SDL_Log("Alsa '%s': %s, period %lu frames (%.2fms), buffer %lu frames (%.2fms), ring target %.2fms",
+          device_name, audio->is_mmap ? "mmap" : "rw",
+          (unsigned long)audio->period_frames, (1000.0 * audio->period_frames) / audio->samples_per_second,
+          (unsigned long)audio->buffer_frames, (1000.0 * audio->buffer_frames) / audio->samples_per_second,
+          (1000.0 * ring->target_latency_frames) / audio->samples_per_second);
+
+  atomic_store(&audio->is_running, true);
+  audio->thread = SDL_CreateThread(linux_alsa_thread, "hh-alsa", audio);
+  if (audio->thread == NULL) {
+    SDL_LogWarn("Unable to create alsa thread: %s", SDL_GetError());
+    goto __ALSA_INIT_ERROR__;
+  }
+
+  snd_pcm_sw_params_free(sw_params);
+  snd_pcm_hw_params_free(hw_params);
+  return SUCCEEDED;
 
 __ALSA_INIT_ERROR__:
+  if (sw_params != NULL) {
+    snd_pcm_sw_params_free(sw_params);
+  }
   if (hw_params != NULL) {
     snd_pcm_hw_params_free(hw_params);
   }
+  free(audio->period_samples);
+  snd_pcm_close(audio->pcm_handle);
+  audio->pcm_handle = NULL;
+  return FAILED;
+}
+
+// NOTE(Ryan): Measured output latency: what is queued in the ring plus the device's own delay
+INTERNAL void
+linux_report_alsa_latency(LinuxAudio* audio)
+{
+  u64 delay_sample_count = atomic_load(&audio->delay_sample_count);
+  double frames_to_ms = 1000.0 / audio->samples_per_second;
+  double mean_delay_ms = delay_sample_count ? (atomic_load(&audio->delay_sum) * frames_to_ms) / delay_sample_count : 0.0;
+  SDL_Log("Alsa latency: device mean %.2fms max %.2fms, ring %.2fms queued, %llu xruns, %llu ring underruns",
+          mean_delay_ms, atomic_load(&audio->delay_max) * frames_to_ms,
+          sdl_audio_ring_queued_frames(audio->ring) * frames_to_ms,
+          (unsigned long long)atomic_load(&audio->xrun_count),
+          (unsigned long long)atomic_load(&audio->ring->underrun_count));
+}
+
+INTERNAL void
+linux_destroy_alsa(LinuxAudio* audio)
+{
+  atomic_store(&audio->is_running, false);
+  SDL_WaitThread(audio->thread, NULL);
+  snd_pcm_drop(audio->pcm_handle);
+  snd_pcm_close(audio->pcm_handle);
+  free(audio->period_samples);
 }
 
 // dpkg internally installs .deb packages, while apt handles dependency management
@@ -165,28 +832,167 @@ __ALSA_INIT_ERROR__:
 
 typedef struct {
   XImage* info;
+  // NOTE(Ryan): When the MIT-SHM extension is usable the image memory is a SysV segment the X server
+  // reads directly, so presenting is a request rather than a copy of every pixel through the socket.
+  XShmSegmentInfo shm_info;
+  bool is_shared;
+  bool is_present_pending;
   void* memory;
+  // NOTE(Ryan): Storage is reserved once for the largest window the screen can hold.
+  // Resizing only changes the logical width and height; pitch stays at the capacity stride.
+  uint capacity_width;
+  uint capacity_height;
   uint width;
   uint height;
   uint pitch;
 } LinuxPixelBuffer;
 
+GLOBAL bool global_x11_request_failed;
+
+// NOTE(Ryan): Expected on remote displays, hence debug only. XGetErrorText makes no protocol request, so it is
+// safe inside the handler
+INTERNAL int
+linux_x11_record_error(Display* display, XErrorEvent* error)
+{
+  char error_text[128] = {0};
+  XGetErrorText(display, error->error_code, error_text, sizeof(error_text));
+  SDL_LogDebug("X request %u.%u failed: %s", error->request_code, error->minor_code, error_text);
+  global_x11_request_failed = true;
+  return 0;
+}
+
+// NOTE(Ryan): XShmQueryExtension succeeds for remote displays too; only a round trip through XShmAttach
+// tells us whether the server can actually map our segment.
+INTERNAL bool
+linux_attach_shm_segment(Display* display, XShmSegmentInfo* shm_info)
+{
+  global_x11_request_failed = false;
+  int (*prev_error_handler)(Display*, XErrorEvent*) = XSetErrorHandler(linux_x11_record_error);
+
+  shm_info->readOnly = False;
+  XShmAttach(display, shm_info);
+  XSync(display, False);
+
+  XSetErrorHandler(prev_error_handler);
+  return !global_x11_request_failed;
+}
+
+INTERNAL bool
+linux_create_shared_pixel_buffer(LinuxPixelBuffer* restrict pixel_buffer, Display* display, XVisualInfo* restrict visual_info)
+{
+  pixel_buffer->info = XShmCreateImage(
+                                       display,
+                                       visual_info->visual,
+                                       visual_info->depth,
+                                       ZPixmap,
+                                       NULL,
+                                       &pixel_buffer->shm_info,
+                                       pixel_buffer->capacity_width,
+                                       pixel_buffer->capacity_height
+                                      );
+  if (pixel_buffer->info == NULL) {
+    return false;
+  }
+
+  size_t pixel_buffer_size = (size_t)pixel_buffer->info->bytes_per_line * pixel_buffer->capacity_height;
+  // NOTE(Ryan): Huge pages only succeed if the admin has reserved a hugetlb pool, so try then fall back.
+  // Either way pages are only committed as the renderer first touches them.
+  size_t huge_page_size = MEGABYTES(2);
+  size_t huge_pixel_buffer_size = (pixel_buffer_size + huge_page_size - 1) & ~(huge_page_size - 1);
+  pixel_buffer->shm_info.shmid = shmget(IPC_PRIVATE, huge_pixel_buffer_size, IPC_CREAT | SHM_HUGETLB | 0600);
+  if (pixel_buffer->shm_info.shmid < 0) {
+    pixel_buffer->shm_info.shmid = shmget(IPC_PRIVATE, pixel_buffer_size, IPC_CREAT | 0600);
+  }
+  if (pixel_buffer->shm_info.shmid < 0) {
+    XDestroyImage(pixel_buffer->info);
+    return false;
+  }
+
+  pixel_buffer->shm_info.shmaddr = shmat(pixel_buffer->shm_info.shmid, NULL, 0);
+  if (pixel_buffer->shm_info.shmaddr == (char *)-1) {
+    shmctl(pixel_buffer->shm_info.shmid, IPC_RMID, NULL);
+    XDestroyImage(pixel_buffer->info);
+    return false;
+  }
+
+  bool is_attached = linux_attach_shm_segment(display, &pixel_buffer->shm_info);
+  // NOTE(Ryan): Segment is freed by the kernel once both we and the server detach, even if we crash
+  shmctl(pixel_buffer->shm_info.shmid, IPC_RMID, NULL);
+  if (!is_attached) {
+    shmdt(pixel_buffer->shm_info.shmaddr);
+    XDestroyImage(pixel_buffer->info);
+    return false;
+  }
+
+  pixel_buffer->info->data = pixel_buffer->shm_info.shmaddr;
+  pixel_buffer->memory = pixel_buffer->shm_info.shmaddr;
+  pixel_buffer->pitch = pixel_buffer->info->bytes_per_line;
+  pixel_buffer->is_shared = true;
+
+  return true;
+}
+
+INTERNAL Bool
+linux_is_shm_completion_event_for(Display* display, XEvent* event, XPointer pixel_buffer)
+{
+  int shm_completion_event = XShmGetEventBase(display) + ShmCompletion;
+  return (event->type == shm_completion_event && 
+          ((XShmCompletionEvent *)event)->shmseg == ((LinuxPixelBuffer *)pixel_buffer)->shm_info.shmseg);
+}
+
 INTERNAL void
-linux_resize_or_create_pixel_buffer(LinuxPixelBuffer* restrict pixel_buffer, Display* display, XVisualInfo* restrict visual_info, uint width, uint height)
+linux_wait_for_pixel_buffer_present(LinuxPixelBuffer* restrict pixel_buffer, Display* display)
 {
-  if (pixel_buffer->memory != NULL) {
+  if (pixel_buffer->is_present_pending) {
+    // NOTE(Ryan): XIfEvent leaves the other queued events for the main event loop
+    XEvent event = {0};
+    XIfEvent(display, &event, linux_is_shm_completion_event_for, (XPointer)pixel_buffer);
+    pixel_buffer->is_present_pending = false;
+  }
+}
+
+INTERNAL void
+linux_destroy_pixel_buffer(LinuxPixelBuffer* restrict pixel_buffer, Display* display)
+{
+  if (pixel_buffer->is_shared) {
+    linux_wait_for_pixel_buffer_present(pixel_buffer, display);
+    XShmDetach(display, &pixel_buffer->shm_info);
     XDestroyImage(pixel_buffer->info);
+    shmdt(pixel_buffer->shm_info.shmaddr);
+    pixel_buffer->is_shared = false;
+  } else {
+    // NOTE(Ryan): XDestroyImage would free() the data pointer, which is an mmap here
+    pixel_buffer->info->data = NULL;
+    XDestroyImage(pixel_buffer->info);
+    munmap(pixel_buffer->memory, (size_t)pixel_buffer->pitch * pixel_buffer->capacity_height);
   }
+  pixel_buffer->info = NULL;
+  pixel_buffer->memory = NULL;
+}
 
-  pixel_buffer->width = width;
-  pixel_buffer->height = height;
+INTERNAL bool
+linux_create_pixel_buffer(LinuxPixelBuffer* restrict pixel_buffer, Display* display, XVisualInfo* restrict visual_info, uint capacity_width, uint capacity_height)
+{
+  pixel_buffer->capacity_width = capacity_width;
+  pixel_buffer->capacity_height = capacity_height;
+  pixel_buffer->width = capacity_width;
+  pixel_buffer->height = capacity_height;
 
-  uint bytes_per_pixel = 4; 
-  uint pixel_buffer_size = pixel_buffer->width * bytes_per_pixel * pixel_buffer->height;
+  if (XShmQueryExtension(display) && linux_create_shared_pixel_buffer(pixel_buffer, display, visual_info)) {
+    return true;
+  }
 
-  pixel_buffer->memory = malloc(pixel_buffer_size);
+  uint bytes_per_pixel = 4; 
+  pixel_buffer->pitch = pixel_buffer->capacity_width * bytes_per_pixel;
+  size_t pixel_buffer_size = (size_t)pixel_buffer->pitch * pixel_buffer->capacity_height;
 
-  pixel_buffer->pitch = pixel_buffer->width * bytes_per_pixel;
+  // NOTE(Ryan): MAP_NORESERVE so the untouched tail beyond the current window size costs nothing
+  pixel_buffer->memory = mmap(NULL, pixel_buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (pixel_buffer->memory == MAP_FAILED) {
+    pixel_buffer->memory = NULL;
+    return false;
+  }
+  madvise(pixel_buffer->memory, pixel_buffer_size, MADV_HUGEPAGE);
 
   pixel_buffer->info = XCreateImage(
 		                                display, 
@@ -195,25 +1001,230 @@ linux_resize_or_create_pixel_buffer(LinuxPixelBuffer* restrict pixel_buffer, Dis
 				                            ZPixmap, 
 				                            0, 
 				                            pixel_buffer->memory, 
-				                            pixel_buffer->width, 
-				                            pixel_buffer->height, 
+				                            pixel_buffer->capacity_width, 
+				                            pixel_buffer->capacity_height, 
 				                            bytes_per_pixel * 8, 
-				                            0
+				                            pixel_buffer->pitch
 				                           );
+  if (pixel_buffer->info == NULL) {
+    munmap(pixel_buffer->memory, pixel_buffer_size);
+    pixel_buffer->memory = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+INTERNAL void
+linux_resize_pixel_buffer(LinuxPixelBuffer* restrict pixel_buffer, uint width, uint height)
+{
+  pixel_buffer->width = (width < pixel_buffer->capacity_width) ? width : pixel_buffer->capacity_width;
+  pixel_buffer->height = (height < pixel_buffer->capacity_height) ? height : pixel_buffer->capacity_height;
 }
 
 INTERNAL void
 linux_display_pixel_buffer_in_window(LinuxPixelBuffer* restrict pixel_buffer, Display* restrict display, Window window, int screen)
 {
-  XPutImage(
-            display, 
-	          window, 
-	          DefaultGC(display, screen), 
-	          pixel_buffer->info, 
-	          0, 0, 0, 0,
-	          pixel_buffer->width,
-	          pixel_buffer->height
-	         );
+  if (pixel_buffer->is_shared) {
+    // NOTE(Ryan): Server reads the segment asynchronously; ask for a completion event so we
+    // know when the memory is safe to render into again
+    XShmPutImage(
+                 display,
+                 window,
+                 DefaultGC(display, screen),
+                 pixel_buffer->info,
+                 0, 0, 0, 0,
+                 pixel_buffer->width,
+                 pixel_buffer->height,
+                 True
+                );
+    pixel_buffer->is_present_pending = true;
+    XFlush(display);
+  } else {
+    XPutImage(
+              display, 
+	            window, 
+	            DefaultGC(display, screen), 
+	            pixel_buffer->info, 
+	            0, 0, 0, 0,
+	            pixel_buffer->width,
+	            pixel_buffer->height
+	           );
+  }
+}
+
+// NOTE(Ryan): Frame N+1 is rendered on the job queue while frame N is presented on the main thread.
+// A buffer is only rendered into once its previous present has completed (shm completion event),
+// and only presented once its render fence has dropped to zero.
+#define LINUX_SWAPCHAIN_LENGTH 3
+
+typedef struct {
+  HHMemory* memory;
+  HHPixelBuffer* pixel_buffer;
+  // NOTE(Ryan): Copied, as the main thread samples the next frame's input while this one updates
+  HHInput input;
+  HHSoundBuffer* sound_buffer;
+} LinuxRenderJob;
+
+typedef struct {
+  LinuxPixelBuffer buffers[LINUX_SWAPCHAIN_LENGTH];
+  HHPixelBuffer hh_buffers[LINUX_SWAPCHAIN_LENGTH];
+  HHJobCounter render_fences[LINUX_SWAPCHAIN_LENGTH];
+  LinuxRenderJob render_jobs[LINUX_SWAPCHAIN_LENGTH];
+  uint frame_index;
+} LinuxSwapchain;
+
+INTERNAL void
+linux_render_job(void* data)
+{
+  LinuxRenderJob* job = (LinuxRenderJob *)data;
+  hh_update_and_render(job->pixel_buffer, &job->input, job->sound_buffer, job->memory);
+}
+
+INTERNAL void
+linux_wait_for_swapchain_idle(LinuxSwapchain* swapchain, HHMemory* memory, Display* display)
+{
+  for (uint buffer_i = 0; buffer_i < LINUX_SWAPCHAIN_LENGTH; ++buffer_i) {
+    if (memory->job_queue != NULL) {
+      memory->platform_wait_for_jobs(memory->job_queue, &swapchain->render_fences[buffer_i]);
+    }
+    linux_wait_for_pixel_buffer_present(&swapchain->buffers[buffer_i], display);
+  }
+}
+
+INTERNAL void
+linux_update_swapchain_views(LinuxSwapchain* swapchain)
+{
+  for (uint buffer_i = 0; buffer_i < LINUX_SWAPCHAIN_LENGTH; ++buffer_i) {
+    LinuxPixelBuffer* pixel_buffer = &swapchain->buffers[buffer_i];
+    swapchain->hh_buffers[buffer_i].memory = pixel_buffer->memory;
+    swapchain->hh_buffers[buffer_i].width = pixel_buffer->width;
+    swapchain->hh_buffers[buffer_i].height = pixel_buffer->height;
+    swapchain->hh_buffers[buffer_i].pitch = pixel_buffer->pitch;
+  }
+}
+
+INTERNAL bool
+linux_create_swapchain(LinuxSwapchain* swapchain, Display* display, XVisualInfo* restrict visual_info, uint capacity_width, uint capacity_height, uint width, uint height)
+{
+  for (uint buffer_i = 0; buffer_i < LINUX_SWAPCHAIN_LENGTH; ++buffer_i) {
+    LinuxPixelBuffer* pixel_buffer = &swapchain->buffers[buffer_i];
+    if (!linux_create_pixel_buffer(pixel_buffer, display, visual_info, capacity_width, capacity_height)) {
+      return false;
+    }
+    linux_resize_pixel_buffer(pixel_buffer, width, height);
+  }
+
+  linux_update_swapchain_views(swapchain);
+  swapchain->frame_index = 0;
+
+  return true;
+}
+
+// NOTE(Ryan): Allocation free; the buffers were sized for the whole screen up front
+INTERNAL void
+linux_resize_swapchain(LinuxSwapchain* swapchain, HHMemory* memory, Display* display, uint width, uint height)
+{
+  LinuxPixelBuffer* first_buffer = &swapchain->buffers[0];
+  if (width == first_buffer->width && height == first_buffer->height) {
+    return;
+  }
+
+  linux_wait_for_swapchain_idle(swapchain, memory, display);
+
+  for (uint buffer_i = 0; buffer_i < LINUX_SWAPCHAIN_LENGTH; ++buffer_i) {
+    linux_resize_pixel_buffer(&swapchain->buffers[buffer_i], width, height);
+  }
+  linux_update_swapchain_views(swapchain);
+
+  // NOTE(Ryan): Newly exposed regions of the buffers are stale, so don't present anything rendered at the old size
+  swapchain->frame_index = 0;
+}
+
+INTERNAL void
+linux_swapchain_on_shm_completion(LinuxSwapchain* swapchain, XShmCompletionEvent* event)
+{
+  for (uint buffer_i = 0; buffer_i < LINUX_SWAPCHAIN_LENGTH; ++buffer_i) {
+    LinuxPixelBuffer* pixel_buffer = &swapchain->buffers[buffer_i];
+    if (pixel_buffer->is_shared && pixel_buffer->shm_info.shmseg == event->shmseg) {
+      pixel_buffer->is_present_pending = false;
+    }
+  }
+}
+
+// NOTE(Ryan): Game state is shared between frames, so one frame's update must finish before the next one starts.
+// Also the point after which that frame's sound buffer and rumble requests are complete.
+INTERNAL void
+linux_swapchain_wait_for_update(LinuxSwapchain* swapchain, HHMemory* memory)
+{
+  if (swapchain->frame_index > 0 && memory->job_queue != NULL) {
+    uint buffer_i = (swapchain->frame_index - 1) % LINUX_SWAPCHAIN_LENGTH;
+    memory->platform_wait_for_jobs(memory->job_queue, &swapchain->render_fences[buffer_i]);
+  }
+}
+
+INTERNAL void
+linux_swapchain_begin_render(LinuxSwapchain* swapchain, HHMemory* memory, Display* display, HHInput* input, HHSoundBuffer* sound_buffer)
+{
+  uint buffer_i = swapchain->frame_index % LINUX_SWAPCHAIN_LENGTH;
+  linux_wait_for_pixel_buffer_present(&swapchain->buffers[buffer_i], display);
+
+  LinuxRenderJob* job = &swapchain->render_jobs[buffer_i];
+  job->memory = memory;
+  job->pixel_buffer = &swapchain->hh_buffers[buffer_i];
+  job->input = *input;
+  job->sound_buffer = sound_buffer;
+
+  if (memory->job_queue != NULL) {
+    memory->platform_add_job(memory->job_queue, linux_render_job, job, &swapchain->render_fences[buffer_i]);
+  } else {
+    linux_render_job(job);
+  }
+}
+
+INTERNAL void
+linux_swapchain_present(LinuxSwapchain* swapchain, HHMemory* memory, Display* display, Window window, int screen)
+{
+  if (swapchain->frame_index > 0) {
+    uint buffer_i = (swapchain->frame_index - 1) % LINUX_SWAPCHAIN_LENGTH;
+    if (memory->job_queue != NULL) {
+      // NOTE(Ryan): Main thread helps with outstanding tiles rather than sitting idle
+      memory->platform_wait_for_jobs(memory->job_queue, &swapchain->render_fences[buffer_i]);
+    }
+    linux_display_pixel_buffer_in_window(&swapchain->buffers[buffer_i], display, window, screen);
+  }
+
+  ++swapchain->frame_index;
+}
+
+INTERNAL void
+linux_process_key_event(HHController* keyboard_controller, Display* display, uint keycode, bool is_down)
+{
+  KeySym key_sym = XkbKeycodeToKeysym(display, keycode, 0, 0);
+  switch (key_sym) {
+    case XK_w: case XK_Up: sdl_process_button(keyboard_controller, HH_BUTTON_MOVE_UP, is_down); break;
+    case XK_a: case XK_Left: sdl_process_button(keyboard_controller, HH_BUTTON_MOVE_LEFT, is_down); break;
+    case XK_s: case XK_Down: sdl_process_button(keyboard_controller, HH_BUTTON_MOVE_DOWN, is_down); break;
+    case XK_d: case XK_Right: sdl_process_button(keyboard_controller, HH_BUTTON_MOVE_RIGHT, is_down); break;
+    case XK_space: sdl_process_button(keyboard_controller, HH_BUTTON_START, is_down); break;
+    case XK_Escape: sdl_process_button(keyboard_controller, HH_BUTTON_BACK, is_down); break;
+    default: break;
+  }
+}
+
+INTERNAL u32
+linux_get_cpu_features(void)
+{
+  u32 cpu_features = 0;
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) cpu_features |= HH_CPU_FEATURE_SSE2;
+  if (__builtin_cpu_supports("avx2")) cpu_features |= HH_CPU_FEATURE_AVX2;
+#elif defined(__aarch64__)
+  // NOTE(Ryan): Advanced SIMD is mandatory on aarch64
+  cpu_features |= HH_CPU_FEATURE_NEON;
+#endif
+  return cpu_features;
 }
 
 GLOBAL bool global_want_to_run;
@@ -221,7 +1232,60 @@ GLOBAL bool global_want_to_run;
 int 
 main(int argc, char* argv[argc + 1])
 {
-  Display* display = XOpenDisplay(":0.0");
+  HHMemory hh_memory = {0};
+  hh_memory.permanent_storage_size = MEGABYTES(64);
+  hh_memory.transient_storage_size = GIGABYTES(1);
+  u64 total_memory_size = hh_memory.permanent_storage_size + hh_memory.transient_storage_size;
+  hh_memory.permanent_storage = sdl_reserve_memory_block(total_memory_size, SDL_HH_MEMORY_BASE_ADDRESS);
+  if (hh_memory.permanent_storage == NULL) {
+    SDL_LogCritical("Unable to allocate %llu bytes of hh memory: %s", (unsigned long long)total_memory_size, strerror(errno));
+    return 1;
+  }
+  hh_memory.transient_storage = ((u8 *)hh_memory.permanent_storage + hh_memory.permanent_storage_size);
+  hh_memory.platform_debug_write_entire_file = platform_debug_write_entire_file;
+  hh_memory.cpu_features = linux_get_cpu_features();
+  hh_select_render_kernels(hh_memory.cpu_features);
+  hh_memory.cache_line_size = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+  hh_memory.job_queue = sdl_create_job_queue(sysconf(_SC_NPROCESSORS_ONLN));
+  if (hh_memory.job_queue != NULL) {
+    hh_memory.job_queue_thread_count = hh_memory.job_queue->thread_count;
+  }
+  hh_memory.platform_add_job = platform_add_job;
+  hh_memory.platform_wait_for_jobs = platform_wait_for_jobs;
+  hh_memory.platform_get_thread_index = platform_get_thread_index;
+
+  // NOTE(Ryan): HH_ASSET_PACK overrides the pack in the working directory
+  HHAssetPack asset_pack = {0};
+  char const* asset_pack_file_name = getenv("HH_ASSET_PACK");
+  asset_pack_file_name = (asset_pack_file_name != NULL) ? asset_pack_file_name : SDL_HH_ASSET_PACK_FILE_NAME;
+  sdl_open_asset_pack(&asset_pack, asset_pack_file_name);
+  hh_memory.asset_pack = &asset_pack;
+  hh_memory.asset_stream = sdl_create_asset_stream(&asset_pack, asset_pack_file_name);
+  hh_memory.platform_begin_asset_read = platform_begin_asset_read;
+
+  SDLAudioRing audio_ring = {0};
+  LinuxAudio audio = {0};
+  HHSoundBuffer sound_buffer = {0};
+  bool have_sound = false;
+  if (sdl_init_audio_ring(&audio_ring, 48000, SDL_AUDIO_TARGET_LATENCY_MS) == SUCCEEDED) {
+    sound_buffer.samples_per_second = audio_ring.samples_per_second;
+    sound_buffer.samples = calloc(audio_ring.capacity, sizeof(int16) * SDL_AUDIO_CHANNELS);
+    char const* alsa_device_name = getenv("HH_ALSA_DEVICE");
+    have_sound = (sound_buffer.samples != NULL) &&
+                 linux_init_alsa(&audio, &audio_ring, (alsa_device_name != NULL) ? alsa_device_name : "default",
+                                 linux_get_env_uint("HH_ALSA_PERIOD_FRAMES", 256),
+                                 linux_get_env_uint("HH_ALSA_PERIOD_COUNT", 3)) == SUCCEEDED;
+  }
+
+  LinuxInput input = {0};
+  if (linux_init_input(&input) == FAILED) {
+    SDL_LogWarn("Controller input disabled");
+  }
+  HHInput hh_input = {0};
+  hh_input.controllers[0].is_connected = true;
+
+  // NOTE(Ryan): Honour $DISPLAY so this can run under Xvfb or forwarded displays
+  Display* display = XOpenDisplay(NULL);
   if (display != NULL) {
     Window root_window = DefaultRootWindow(display);
     int screen = DefaultScreen(display); 
@@ -238,15 +1302,16 @@ main(int argc, char* argv[argc + 1])
 					                                               ); 
     if (screen_has_desired_properties) {
       // NOTE(Ryan): C does not support assignment of values to struct, rather initialisation
-      LinuxPixelBuffer linux_pixel_buffer = {0}; 
-      linux_resize_or_create_pixel_buffer(&linux_pixel_buffer, display, &visual_info, 1280, 720);
-
-      HHPixelBuffer hh_pixel_buffer = {
-         .memory = linux_pixel_buffer.memory,
-         .width = linux_pixel_buffer.width,
-         .height = linux_pixel_buffer.height,
-         .pitch = linux_pixel_buffer.pitch
-      };
+      LinuxSwapchain swapchain = {0}; 
+      // NOTE(Ryan): Sized once from the root window, which covers every monitor at startup. RandR changes are not
+      // tracked, so if the screen later grows (monitor added, resolution raised) a larger window is drawn clipped
+      // to this size rather than reallocating
+      uint max_width = DisplayWidth(display, screen);
+      uint max_height = DisplayHeight(display, screen);
+      if (!linux_create_swapchain(&swapchain, display, &visual_info, max_width, max_height, 1280, 720)) {
+        SDL_LogCritical("Unable to create %ux%u pixel buffers for the swapchain", max_width, max_height);
+        return 1;
+      }
    
       XSetWindowAttributes window_attr = {0};
       window_attr.bit_gravity = StaticGravity;
@@ -277,7 +1342,7 @@ main(int argc, char* argv[argc + 1])
         // NOTE(Ryan): This because the window manager fails to correctly close the window, so we tell WM we want access to this
 	      Atom WM_DELETE_WINDOW = XInternAtom(display, "WM_DELETE_WINDOW", False);
 	      if (!XSetWMProtocols(display, window, &WM_DELETE_WINDOW, 1)) {
-          // TODO(Ryan): Logging
+          SDL_LogWarn("Unable to register for WM_DELETE_WINDOW, closing the window may not exit cleanly");
 	      }
 
         XMapWindow(display, window);
@@ -286,22 +1351,19 @@ main(int argc, char* argv[argc + 1])
 
 	      global_want_to_run = true;
 	      XEvent event = {0};
-        uint x_offset = 0;
-        uint y_offset = 0;
+        u64 last_frame_ns = linux_get_monotonic_ns();
 	      while (global_want_to_run) {
           while (XPending(display) > 0) {
 	          XNextEvent(display, &event);
 	          switch (event.type) {
-              case KeyPress: {
-                XKeyPressedEvent* ev = (XKeyPressedEvent *)&event; 
-                if (ev->keycode == XKeysymToKeycode(display, XK_Left)) puts("left key was pressed");
-              } break;
+              case KeyPress:
               case KeyRelease: {
-                 
+                XKeyEvent* ev = (XKeyEvent *)&event;
+                linux_process_key_event(&hh_input.controllers[0], display, ev->keycode, event.type == KeyPress);
               } break;
 	            case ConfigureNotify: {
 	              XConfigureEvent* ev = (XConfigureEvent *)&event;		    
-	      	      linux_resize_or_create_pixel_buffer(&linux_pixel_buffer, display, &visual_info, ev->width, ev->height);
+	      	      linux_resize_swapchain(&swapchain, &hh_memory, display, ev->width, ev->height);
 	            } break;
 	            case ClientMessage: {
                 XClientMessageEvent* ev = (XClientMessageEvent *)&event;
@@ -316,27 +1378,71 @@ main(int argc, char* argv[argc + 1])
 	                global_want_to_run = false;	
 	      	      }
 	            } break;
+              default: {
+                if (event.type == XShmGetEventBase(display) + ShmCompletion) {
+                  linux_swapchain_on_shm_completion(&swapchain, (XShmCompletionEvent *)&event);
+                }
+              } break;
 	          } 
 	        }
 
-          hh_render_gradient(&hh_pixel_buffer, x_offset, y_offset);
+          // NOTE(Ryan): Previous frame's update is done, so hand on what it produced before the next one starts
+          linux_swapchain_wait_for_update(&swapchain, &hh_memory);
+          if (have_sound && swapchain.frame_index > 0) {
+            sdl_audio_ring_write(&audio_ring, sound_buffer.samples, sound_buffer.sample_count);
+          }
+          linux_submit_rumble_requests(&input, &hh_memory);
 
-	        linux_display_pixel_buffer_in_window(&linux_pixel_buffer, display, window, screen);
+          // NOTE(Ryan): Sampled once X events are drained, so the frame sees everything delivered up to now
+          u64 frame_start_ns = linux_get_monotonic_ns();
+          sdl_begin_input_frame(&hh_input);
+          linux_sample_input(&input, &hh_input, frame_start_ns);
+          // NOTE(Ryan): No vsync here, so the frame lasts however long the last one took, capped for debugger breaks
+          hh_input.frame_dt = (frame_start_ns - last_frame_ns) / 1000000000.0f;
+          hh_input.frame_dt = (hh_input.frame_dt < 0.1f) ? hh_input.frame_dt : 0.1f;
+          last_frame_ns = frame_start_ns;
+          if (have_sound) {
+            sound_buffer.sample_count = sdl_audio_ring_frames_to_write(&audio_ring, hh_input.frame_dt);
+          }
+
+          linux_swapchain_begin_render(&swapchain, &hh_memory, display, &hh_input, &sound_buffer);
+
+	        linux_swapchain_present(&swapchain, &hh_memory, display, window, screen);
+        }
 
-          ++x_offset;
-          y_offset += 2;
+        // NOTE(Ryan): Window is gone, so no further shm completions will arrive; only drain the renders
+        for (uint buffer_i = 0; buffer_i < LINUX_SWAPCHAIN_LENGTH; ++buffer_i) {
+          if (hh_memory.job_queue != NULL) {
+            hh_memory.platform_wait_for_jobs(hh_memory.job_queue, &swapchain.render_fences[buffer_i]);
+          }
+          swapchain.buffers[buffer_i].is_present_pending = false;
+          linux_destroy_pixel_buffer(&swapchain.buffers[buffer_i], display);
         }
       } else {
-        // TODO(Ryan): Error Logging (window)
+        SDL_LogCritical("Unable to create x11 window");
       }
 
     } else {
-      // TODO(Ryan): Error Logging (screen props)
+      SDL_LogCritical("Unable to find a %u bit TrueColor visual on screen %d", desired_bits_per_pixel, screen);
     }
 
   } else {
-    // TODO(Ryan): Error Logging (display)
+    SDL_LogCritical("Unable to open x11 display '%s'", XDisplayName(NULL));
+  }
+
+  linux_destroy_input(&input);
+
+  if (have_sound) {
+    linux_report_alsa_latency(&audio);
+    linux_destroy_alsa(&audio);
+  }
+  if (hh_memory.asset_stream != NULL) {
+    sdl_destroy_asset_stream(hh_memory.asset_stream);
+  }
+  if (hh_memory.job_queue != NULL) {
+    sdl_destroy_job_queue(hh_memory.job_queue);
   }
+  sdl_close_asset_pack(&asset_pack);
 
   return 0;
 }
@@ -9,6 +9,32 @@ release_compiler_flags="-Ofast"
 [ ! -d "build" ] && mkdir build
 pushd build
 
-clang $common_compiler_flags $debug_compiler_flags ../code/hh.c -o hh
+clang $common_compiler_flags $debug_compiler_flags -DLINUX -DDEBUG ../code/hh.c -o hh -lGL
+
+# NOTE(Ryan): Game module the platform loads and hot reloads. Unsanitised, so headless-hh can load it too
+clang $common_compiler_flags -g -fno-omit-frame-pointer -shared -fPIC -DHH_HEADLESS -DLINUX -DDEBUG ../code/hh.c -o x86_64-desktop-sdl-hh.so
+
+# NOTE(Ryan): Native X11/ALSA/evdev platform with the game linked in; HH_ALSA_DEVICE=null runs it without a sound card
+clang $common_compiler_flags $debug_compiler_flags -DLINUX -DDEBUG ../code/linux-hh.c -o linux-hh -lX11 -lXext -lasound -ludev
+
+# NOTE(Ryan): Headless runner for CI and batch rendering, optimised as it is there to go fast.
+# DEBUG for the same fixed memory base as hh and for HH_ASSERT traps while it drives the game module
+clang $common_compiler_flags $release_compiler_flags -DLINUX -DDEBUG ../code/headless-hh.c -o headless-hh
+
+# NOTE(Ryan): Kernel micro-benchmarks, release flags so the numbers mean something
+clang $common_compiler_flags $release_compiler_flags -DLINUX ../code/hh-bench.c -o hh-bench -lX11 -lXext
+
+# NOTE(Ryan): Behaviour tests, sanitised like hh since they exercise its platform code; exit status is the failure count
+clang $common_compiler_flags $debug_compiler_flags -DLINUX -DDEBUG ../code/hh-test.c -o hh-test
+
+# NOTE(Ryan): Offline asset packer, run as: hh-asset-packer manifest.txt hh.hha
+clang $common_compiler_flags $release_compiler_flags ../code/hh-asset-packer.c -o hh-asset-packer
+
+# NOTE(Ryan): bash unix-build.bash ci also runs the tests and renders a short headless run of the freshly built
+# game module, so a failed test, crash, assert or failed load fails the script
+if [ "$1" == "ci" ]; then
+  ./hh-test || exit 1
+  ./headless-hh --game ./x86_64-desktop-sdl-hh.so --frames 120 || exit 1
+fi
 
 popd